@@ -0,0 +1,60 @@
+// Tests the analyze command, which gathers index statistics for the query planner.
+
+var t = db.jstests_analyze;
+t.drop();
+
+for (var i = 0; i < 1000; i++) {
+    t.insert({ a: i, b: i % 2 });
+}
+t.ensureIndex({ a: 1 });
+t.ensureIndex({ b: 1 });
+
+function statsFor(res, name) {
+    for (var i = 0; i < res.indexes.length; i++) {
+        if (res.indexes[i].name == name) {
+            return res.indexes[i];
+        }
+    }
+    return null;
+}
+
+// Without statistics both indexes are tried and the winner is cached.  New statistics
+// replan query shapes that are already in the plan cache.
+assert.eq(1, t.find({ a: 5, b: 1 }).itcount());
+assert.eq(1, t.runCommand("planCacheListQueryShapes").shapes.length);
+
+var res = db.runCommand({ analyze: t.getName() });
+assert.commandWorked(res);
+assert.eq(0, t.runCommand("planCacheListQueryShapes").shapes.length);
+assert.eq(3, res.indexes.length);
+var bStats = statsFor(res, "b_1");
+assert.eq(1000, bStats.numKeys);
+assert.eq(2, bStats.numDistinct);
+assert.eq(2, bStats.buckets.length);
+assert.eq(100, statsFor(res, "a_1").buckets.length);
+
+// One index, by name or key pattern, and a chosen number of buckets.
+res = db.runCommand({ analyze: t.getName(), index: "a_1", buckets: 4 });
+assert.commandWorked(res);
+assert.eq(1, res.indexes.length);
+assert.eq(4, res.indexes[0].buckets.length);
+assert.eq(1000, res.indexes[0].numDistinct);
+res = db.runCommand({ analyze: t.getName(), index: { b: 1 } });
+assert.commandWorked(res);
+assert.eq(1, res.indexes.length);
+
+assert.commandFailed(db.runCommand({ analyze: t.getName(), index: "nope" }));
+assert.commandFailed(db.runCommand({ analyze: t.getName(), buckets: 0 }));
+assert.commandFailed(db.runCommand({ analyze: "jstests_analyze_missing" }));
+
+// Multikey documents count once per key.
+t.insert({ a: [ 2000, 2001, 2002 ], b: 0 });
+res = db.runCommand({ analyze: t.getName(), index: "a_1" });
+assert.eq(1003, res.indexes[0].numKeys);
+
+// With statistics the planner goes straight to the selective index, and answers don't change.
+var explain = t.find({ a: 5, b: 1 }).explain();
+assert.eq("BtreeCursor a_1", explain.cursor);
+assert.eq(1, explain.n);
+assert.eq(500, t.find({ a: { $gte: 0 }, b: 1 }).itcount());
+assert.eq(2, t.find({ $or: [ { a: 5, b: 1 }, { a: 2000 } ] }).itcount());
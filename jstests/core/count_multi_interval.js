@@ -0,0 +1,28 @@
+// Counts over $in, several ranges and predicates the index can answer are counted from the
+// index without fetching, and give the same answers as fetching does.
+
+var t = db.jstests_count_multi_interval;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ a: i % 10, b: i, c: "s" + i });
+}
+t.insert({ a: [ 1, 2 ], b: 1000 });
+t.ensureIndex({ a: 1, b: 1 });
+t.ensureIndex({ c: 1 });
+
+function check(query, hint, expected) {
+    // Counting with $where forces the query to fetch every document it counts.
+    var fetched = t.find({ $and: [ query, { $where: "true" } ] }).hint(hint).itcount();
+    assert.eq(expected, fetched, tojson(query));
+    assert.eq(expected, t.find(query).hint(hint).count(), tojson(query));
+}
+
+check({ a: { $in: [ 1, 3, 5 ] } }, { a: 1, b: 1 }, 31);
+check({ a: { $in: [ 1, 2 ] } }, { a: 1, b: 1 }, 21);
+check({ $or: [ { a: { $lt: 2 } }, { a: { $gt: 7 } } ] }, { a: 1, b: 1 }, 41);
+check({ a: { $in: [ 4, 6 ] }, b: { $in: [ 4, 16, 26, 36 ] } }, { a: 1, b: 1 }, 4);
+check({ a: { $in: [ 4, 6 ] }, b: { $gt: 50 } }, { a: 1, b: 1 }, 10);
+check({ c: /^s1/ }, { c: 1 }, 11);
+check({ c: { $in: [ "s1", /^s2/ ] } }, { c: 1 }, 12);
+check({ a: { $in: [] } }, { a: 1, b: 1 }, 0);
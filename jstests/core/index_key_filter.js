@@ -0,0 +1,28 @@
+// Predicates on indexed fields that can't be turned into index bounds are checked against the
+// index keys, so documents that can't match are never fetched.
+
+var t = db.jstests_index_key_filter;
+t.drop();
+
+for (var i = 0; i < 100; i++) {
+    t.insert({ a: i % 2, b: "str" + i, c: i });
+}
+t.ensureIndex({ a: 1, b: 1, c: 1 });
+
+function check(query, expected) {
+    var explain = t.find(query).hint({ a: 1, b: 1, c: 1 }).explain();
+    assert.eq(expected, explain.n, tojson(query));
+    assert.eq(expected, explain.nscannedObjects, tojson(query));
+    assert.eq(expected, t.find(query).itcount(), tojson(query));
+}
+
+check({ a: 0, b: { $not: /^str1/ } }, 45);
+check({ a: 0, c: { $mod: [ 10, 2 ] } }, 10);
+check({ a: 1, $nor: [ { c: { $lt: 50 } }, { b: /7$/ } ] }, 20);
+check({ a: 1, $or: [ { c: 3 }, { b: "str5" } ] }, 2);
+
+// A field that's missing from the document is null in the index key, so whether it exists
+// still has to be checked on the document.
+t.insert({ a: 0 });
+assert.eq(1, t.find({ a: 0, b: { $exists: false } }).itcount());
+assert.eq(1, t.find({ a: 0, b: { $exists: false } }).hint({ a: 1, b: 1, c: 1 }).itcount());
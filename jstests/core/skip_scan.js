@@ -0,0 +1,36 @@
+// Queries that don't constrain the leading field of a compound index can still use the index
+// by skipping between the distinct values of that field.
+
+var t = db.jstests_skip_scan;
+t.drop();
+
+for (var i = 0; i < 1000; i++) {
+    t.insert({ a: i % 4, b: i % 100, c: i });
+}
+t.ensureIndex({ a: 1, b: 1, c: 1 });
+
+function check(query, expected) {
+    assert.eq(expected, t.find(query).itcount(), tojson(query));
+    assert.eq(expected, t.find(query).count(), tojson(query));
+}
+
+check({ b: 5 }, 10);
+check({ b: { $gte: 10, $lt: 12 } }, 20);
+check({ b: 5, c: { $lt: 500 } }, 5);
+check({ b: 5, c: 105 }, 1);
+check({ c: 999 }, 1);
+check({ b: 1000 }, 0);
+
+// Each $or branch gets a scan of its own, even on the same index.
+check({ $or: [ { a: 1 }, { b: 6 } ] }, 260);
+
+// Documents missing the leading field are indexed under null and still match.
+t.insert({ b: 5 });
+check({ b: 5 }, 11);
+
+// Results come back sorted when asked for, whatever plan is chosen.
+var res = t.find({ b: 7 }).sort({ c: 1 }).toArray();
+assert.eq(10, res.length);
+for (i = 1; i < res.length; i++) {
+    assert.lt(res[i - 1].c, res[i].c);
+}
@@ -0,0 +1,92 @@
+/**
+ * Recovery decompresses and applies journal sections on several threads.  Recover the same
+ * journal in parallel and serially (--durOptions dump applies a section at a time) and check the
+ * data files come out the same, both for a clean journal and for one with a corrupt section.
+ */
+
+var testname = "dur_parallel_recover";
+var step = 1;
+var conn = null;
+
+function log(str) {
+    print();
+    if(str)
+        print(testname+" step " + step++ + " " + str);
+    else
+        print(testname+" step " + step++);
+}
+
+// several databases, so writes go to several files, and many group commits, so the journal has
+// more sections than recovery hands to its workers at once
+function work() {
+    log("work");
+    for (var i = 0; i < 100; i++) {
+        for (var d = 0; d < 3; d++) {
+            var coll = conn.getDB("test" + d).foo;
+            coll.insert({ _id: i, x: i * d, s: new Array(100 + i).join("x") });
+            if (i % 10 == 0)
+                coll.update({ _id: { $lt: i } }, { $inc: { x: 1 } }, false, true);
+        }
+        if (i == 50)
+            conn.getDB("test1").createCollection("bar");
+        // end the group commit here
+        assert.isnull(conn.getDB("test0").runCommand({ getlasterror: 1, j: true }).err);
+    }
+    log("endwork");
+}
+
+function dataFileSums(path) {
+    var sums = {};
+    listFiles(path).forEach(function(f) {
+        if (!f.isDirectory && f.name.indexOf("mongod.lock") < 0)
+            sums[f.name.substring(path.length)] = md5sumFile(f.name);
+    });
+    return sums;
+}
+
+/** @return mongod's exit code after recovering 'path' and stopping */
+function recover(path, port, serial) {
+    log("recover " + path + (serial ? " serially" : ""));
+    // DurRecoverOnly, and DurDumpJournal for serial
+    return runMongoProgram("mongod", "--port", port, "--dbpath", path, "--dur", "--smallfiles",
+                           "--durOptions", serial ? 5 : 4);
+}
+
+var path = MongoRunner.dataPath + testname;
+var pathSerial = MongoRunner.dataPath + testname + "serial";
+var pathBad = MongoRunner.dataPath + testname + "bad";
+var pathBadSerial = MongoRunner.dataPath + testname + "badserial";
+
+log();
+conn = startMongodEmpty("--port", 30001, "--dbpath", path, "--dur", "--smallfiles",
+                        "--durOptions", 8);
+work();
+
+log("kill -9");
+stopMongod(30001, /*signal*/9);
+
+copyDbpath(path, pathSerial);
+copyDbpath(path, pathBad);
+copyDbpath(path, pathBadSerial);
+
+// the journal header is 8192 bytes and each of these small sections is padded to 8192 bytes, so
+// this is in the data of a section half way through.  its checksum no longer matches.
+var fuzzAt = 8192 * 60 + 20 + 8;
+fuzzFile(pathBad + "/journal/j._0", fuzzAt);
+fuzzFile(pathBadSerial + "/journal/j._0", fuzzAt);
+
+assert.eq(0, recover(path, 30002, false));
+assert.eq(0, recover(pathSerial, 30003, true));
+assert.eq(dataFileSums(pathSerial), dataFileSums(path), "parallel and serial recovery differ");
+
+// recovery stops at the bad section either way, with everything before it applied
+var exitCode = recover(pathBad, 30004, false);
+assert.neq(0, exitCode, "recovery with a corrupt section should fail");
+assert.eq(exitCode, recover(pathBadSerial, 30005, true));
+assert.eq(dataFileSums(pathBadSerial), dataFileSums(pathBad),
+          "parallel and serial recovery differ up to a corrupt section");
+
+// and the journal is kept
+assert(listFiles(pathBad + "/journal").some(function(f) { return /j\._0$/.test(f.name); }));
+
+print("SUCCESS " + testname);
@@ -0,0 +1,55 @@
+// Tests the bulkLoad command: documents go into a collection without indexes, then all the
+// indexes are built at once.
+
+var conn = MongoRunner.runMongod({});
+var testDB = conn.getDB("bulk_load");
+var t = testDB.coll;
+
+var docs = [];
+for (var i = 0; i < 1000; i++) {
+    docs.push({ _id: i, a: i % 10, b: "x" + i });
+}
+
+// Creates the collection without an _id index.
+var res = testDB.runCommand({ bulkLoad: "coll", documents: docs.slice(0, 500) });
+assert.commandWorked(res);
+assert.eq(500, res.nInserted);
+assert(res.createdCollectionAutomatically);
+assert.eq(0, t.getIndexes().length);
+
+// Documents without an _id get one.
+assert.commandWorked(testDB.runCommand({ bulkLoad: "coll",
+                                         documents: docs.slice(500).concat([ { a: 100 } ]) }));
+assert.eq(1001, t.count());
+
+// Builds the _id index along with the ones asked for.
+res = testDB.runCommand({ bulkLoad: "coll",
+                          indexes: [ { key: { a: 1 }, name: "a_1" },
+                                     { key: { b: 1 }, name: "b_1", unique: true } ] });
+assert.commandWorked(res);
+assert.eq(0, res.numIndexesBefore);
+assert.eq(3, res.numIndexesAfter);
+assert.eq(100, t.find({ a: 3 }).hint({ a: 1 }).itcount());
+assert.eq(1, t.find({ b: "x42" }).hint({ b: 1 }).itcount());
+assert.eq(1, t.find({ _id: 42 }).hint({ _id: 1 }).itcount());
+assert.commandWorked(t.validate(true));
+
+// Once there are indexes documents have to go in the normal way.
+assert.commandFailed(testDB.runCommand({ bulkLoad: "coll", documents: [ { _id: 2000 } ] }));
+
+// Unique indexes are checked when they are built.
+t = testDB.dups;
+assert.commandWorked(testDB.runCommand({ bulkLoad: "dups",
+                                         documents: [ { _id: 1 }, { _id: 1 } ] }));
+assert.commandFailed(testDB.runCommand({ bulkLoad: "dups", indexes: [] }));
+assert.eq(0, t.getIndexes().length);
+
+// Capped collections keep their options.
+assert.commandWorked(testDB.runCommand({ bulkLoad: "capped",
+                                         options: { capped: true, size: 100000 },
+                                         documents: docs.slice(0, 10),
+                                         indexes: [] }));
+assert(testDB.capped.isCapped());
+assert.eq(10, testDB.capped.count());
+
+MongoRunner.stopMongod(conn);
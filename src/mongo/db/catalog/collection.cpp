@@ -165,6 +165,20 @@ namespace mongo {
         return StatusWith<DiskLoc>( loc );
     }
 
+    Status Collection::insertDocuments( OperationContext* txn,
+                                        const DocWriter* const* docs,
+                                        size_t nDocs,
+                                        DiskLoc* locsOut,
+                                        bool enforceQuota ) {
+        verify( _indexCatalog.numIndexesTotal() == 0 ); // as for a single DocWriter
+
+        return _recordStore->insertRecords( txn,
+                                            docs,
+                                            nDocs,
+                                            locsOut,
+                                            _enforceQuota( enforceQuota ) );
+    }
+
     StatusWith<DiskLoc> Collection::insertDocument( OperationContext* txn,
                                                     const BSONObj& docToInsert,
                                                     bool enforceQuota ) {
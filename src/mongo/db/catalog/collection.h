@@ -91,9 +91,15 @@ namespace mongo {
     struct CompactStats {
         CompactStats() {
             corruptDocuments = 0;
+            recordsMoved = 0;
+            extentsFreed = 0;
         }
 
         long long corruptDocuments;
+
+        // online compaction only
+        long long recordsMoved;
+        long long extentsFreed;
     };
 
     /**
@@ -174,6 +180,17 @@ namespace mongo {
                                             const DocWriter* doc,
                                             bool enforceQuota );
 
+        /**
+         * Like the DocWriter insertDocument, for nDocs documents at once, so the record store
+         * can allocate space for them together.  Only for collections without indexes.
+         * @param locsOut - see RecordStore::insertRecords
+         */
+        Status insertDocuments( OperationContext* txn,
+                                const DocWriter* const* docs,
+                                size_t nDocs,
+                                DiskLoc* locsOut,
+                                bool enforceQuota );
+
         StatusWith<DiskLoc> insertDocument( OperationContext* txn,
                                             const BSONObj& doc,
                                             MultiIndexBlock& indexBlock );
@@ -202,6 +219,23 @@ namespace mongo {
 
         StatusWith<CompactStats> compact(OperationContext* txn, const CompactOptions* options);
 
+        /**
+         * One step of online compaction: moves up to 'maxRecords' documents out of the end of
+         * the collection, keeping indexes and cursors up to date, and adds to 'stats'.  Run
+         * steps under the database write lock, yielding between them.
+         * @return true once there is nothing left worth compacting
+         */
+        StatusWith<bool> compactIncremental( OperationContext* txn,
+                                             const CompactOptions* options,
+                                             int maxRecords,
+                                             CompactStats* stats );
+
+        /**
+         * Undoes what an unfinished run of compactIncremental() steps left behind.  Call it if
+         * online compaction stops before a step returned true.
+         */
+        void abortCompactIncremental( OperationContext* txn );
+
         /**
          * removes all documents as fast as possible
          * indexes before and after will be the same
@@ -48,11 +48,13 @@ namespace mongo {
         : _collection( collection ),
           _keysComputed( false ),
           _planCache(new PlanCache(collection->ns().ns())),
-          _querySettings(new QuerySettings()) { }
+          _querySettings(new QuerySettings()),
+          _indexStats(new IndexStatsCache()) { }
 
     void CollectionInfoCache::reset() {
         LOG(1) << _collection->ns().ns() << ": clearing plan cache - collection info cache reset";
         clearQueryCache();
+        _indexStats->clear();
         _keysComputed = false;
         // query settings is not affected by info cache reset.
         // index filters should persist throughout life of collection
@@ -95,4 +97,8 @@ namespace mongo {
         return _querySettings.get();
     }
 
+    IndexStatsCache* CollectionInfoCache::getIndexStats() const {
+        return _indexStats.get();
+    }
+
 }
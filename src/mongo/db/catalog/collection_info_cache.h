@@ -33,6 +33,7 @@
 #include <boost/scoped_ptr.hpp>
 
 #include "mongo/db/index_set.h"
+#include "mongo/db/query/index_stats.h"
 #include "mongo/db/query/query_settings.h"
 #include "mongo/db/query/plan_cache.h"
 
@@ -68,6 +69,11 @@ namespace mongo {
          */
         QuerySettings* getQuerySettings() const;
 
+        /**
+         * Get the statistics gathered by analyze for this collection's indexes.
+         */
+        IndexStatsCache* getIndexStats() const;
+
         // -------------------
 
         /* get set of index keys for this namespace.  handy to quickly check if a given
@@ -106,6 +112,9 @@ namespace mongo {
         // Includes index filters.
         boost::scoped_ptr<QuerySettings> _querySettings;
 
+        // Index statistics, cleared whenever the indexes change.
+        boost::scoped_ptr<IndexStatsCache> _indexStats;
+
         /**
          * Must be called under exclusive DB lock.
          */
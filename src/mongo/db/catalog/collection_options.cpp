@@ -30,8 +30,19 @@
 
 #include "mongo/db/catalog/collection_options.h"
 
+#include "mongo/util/mongoutils/str.h"
+
 namespace mongo {
 
+    namespace {
+        /**
+         * The engines that take per collection options under storageEngine.<name>.
+         */
+        bool isStorageEngineWithOptions( const StringData& name ) {
+            return name == "rocks";
+        }
+    }
+
     // static
     bool CollectionOptions::validMaxCappedDocs( long long* max ) {
         if ( *max <= 0 ||
@@ -57,6 +68,7 @@ namespace mongo {
         flags = 0;
         flagsSet = false;
         temp = false;
+        storageEngine = BSONObj();
     }
 
     Status CollectionOptions::parse( const BSONObj& options ) {
@@ -118,6 +130,26 @@ namespace mongo {
             else if ( fieldName == "temp" ) {
                 temp = e.trueValue();
             }
+            else if ( fieldName == "storageEngine" ) {
+                if ( e.type() != Object )
+                    return Status( ErrorCodes::BadValue, "storageEngine has to be a document" );
+
+                // The engine itself checks its options when the collection is created, but only
+                // the engine that is running sees them, so catch names no engine would claim.
+                BSONObjIterator engines( e.Obj() );
+                while ( engines.more() ) {
+                    BSONElement engine = engines.next();
+                    if ( !isStorageEngineWithOptions( engine.fieldNameStringData() ) )
+                        return Status( ErrorCodes::BadValue,
+                                       str::stream() << "unknown storage engine in storageEngine: "
+                                                     << engine.fieldName() );
+                    if ( engine.type() != Object )
+                        return Status( ErrorCodes::BadValue,
+                                       str::stream() << "storageEngine." << engine.fieldName()
+                                                     << " has to be a document" );
+                }
+                storageEngine = e.Obj().getOwned();
+            }
         }
 
         return Status::OK();
@@ -147,6 +179,9 @@ namespace mongo {
         if ( temp )
             b.appendBool( "temp", true );
 
+        if ( !storageEngine.isEmpty() )
+            b.append( "storageEngine", storageEngine );
+
         return b.obj();
     }
 
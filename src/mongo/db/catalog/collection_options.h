@@ -72,6 +72,10 @@ namespace mongo {
         bool flagsSet;
 
         bool temp;
+
+        // per storage engine settings, by engine name: { <engine>: { ... } }
+        // parse() rejects engines that take no options, each engine checks its own part
+        BSONObj storageEngine;
     };
 
 }
@@ -55,6 +55,21 @@ namespace mongo {
         checkRoundTrip( options );
     }
 
+    TEST( CollectionOptions, StorageEngine ) {
+        CollectionOptions options;
+        ASSERT_OK( options.parse( fromjson( "{storageEngine: {rocks: {blockSize: 4096}}}" ) ) );
+        ASSERT_EQUALS( fromjson( "{rocks: {blockSize: 4096}}" ), options.storageEngine );
+        checkRoundTrip( options );
+
+        ASSERT_NOT_OK( CollectionOptions().parse( fromjson( "{storageEngine: 1}" ) ) );
+        ASSERT_NOT_OK( CollectionOptions().parse( fromjson( "{storageEngine: {rocks: 1}}" ) ) );
+
+        // typos and engines without options are rejected rather than stored
+        ASSERT_NOT_OK( CollectionOptions().parse(
+                           fromjson( "{storageEngine: {rokcs: {blockSize: 4096}}}" ) ) );
+        ASSERT_NOT_OK( CollectionOptions().parse( fromjson( "{storageEngine: {mmapv1: {}}}" ) ) );
+    }
+
     TEST( CollectionOptions, ErrorBadSize ) {
         ASSERT_NOT_OK( CollectionOptions().parse( fromjson( "{capped: true, size: -1}" ) ) );
         ASSERT_NOT_OK( CollectionOptions().parse( fromjson( "{capped: false, size: -1}" ) ) );
@@ -367,6 +367,40 @@ namespace mongo {
         return Status::OK();
     }
 
+    Status MultiIndexBlock::insertAllDocumentsInCollection() {
+        const char* curopMessage = "Index Build";
+        ProgressMeter* progress = _txn->setMessage( curopMessage,
+                                                    curopMessage,
+                                                    _collection->numRecords() );
+
+        InsertDeleteOptions options;
+        options.logIfError = false;
+        options.dupsAllowed = true; // the bulk builders check uniqueness in commit()
+
+        unsigned long long n = 0;
+        scoped_ptr<RecordIterator> it( _collection->getIterator( DiskLoc(),
+                                                                 false,
+                                                                 CollectionScanParams::FORWARD ) );
+        while ( !it->isEOF() ) {
+            DiskLoc loc = it->getNext();
+            Status status = insert( it->dataFor( loc ).toBson(), loc, options );
+            if ( !status.isOK() )
+                return status;
+
+            n++;
+            progress->hit();
+            _txn->recoveryUnit()->commitIfNeeded();
+
+            // killOp must be able to stop a long build; the unfinished indexes are dropped when
+            // this block is destroyed
+            _txn->checkForInterrupt();
+        }
+
+        progress->finished();
+        LOG(1) << "\t scanned " << n << " records for " << _states.size() << " indexes";
+        return Status::OK();
+    }
+
     Status MultiIndexBlock::commit() {
         for ( size_t i = 0; i < _states.size(); i++ ) {
             if ( _states[i].bulk == NULL )
@@ -66,6 +66,13 @@ namespace mongo {
                        const DiskLoc& loc,
                        const InsertDeleteOptions& options );
 
+        /**
+         * Calls insert() for every document already in the collection, so all the indexes
+         * are built from a single collection scan.  Uniqueness is checked by commit().
+         * Throws if the operation is interrupted.
+         */
+        Status insertAllDocumentsInCollection();
+
         Status commit();
 
     private:
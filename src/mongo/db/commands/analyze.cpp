@@ -0,0 +1,215 @@
+// analyze.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include <vector>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/d_concurrency.h"
+#include "mongo/db/exec/index_scan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/index_names.h"
+#include "mongo/db/query/get_runner.h"
+#include "mongo/db/query/index_stats.h"
+#include "mongo/db/query/internal_runner.h"
+#include "mongo/util/elapsed_tracker.h"
+#include "mongo/util/mongoutils/str.h"
+
+namespace mongo {
+
+    /**
+     * { analyze : "bar", index : <name or key pattern>, buckets : <n> }
+     *
+     * Scans the btree indexes of the collection, or just the one asked for, and keeps a
+     * histogram of each index's leading field with 'buckets' buckets (100 by default).  The
+     * planner uses them to drop plans that can't compete before trying the rest.  The
+     * statistics are only held in memory, and are forgotten when the collection's indexes
+     * change or the server restarts.  Run it again after the data changes a lot.  The scans
+     * yield the lock now and then, and can be killed.
+     */
+    class CmdAnalyze : public Command {
+    public:
+        CmdAnalyze() : Command( "analyze" ) {}
+
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual bool slaveOk() const { return true; }
+
+        virtual void help( stringstream& help ) const {
+            help << "gather statistics on a collection's indexes for the query planner\n"
+                 << "{ analyze : <collection>, index : <name or key pattern>, buckets : <n> }";
+        }
+
+        virtual Status checkAuthForCommand(ClientBasic* client,
+                                           const std::string& dbname,
+                                           const BSONObj& cmdObj) {
+            ActionSet actions;
+            actions.addAction(ActionType::planCacheWrite);
+            Privilege p(parseResourcePattern(dbname, cmdObj), actions);
+            if (client->getAuthorizationSession()->isAuthorizedForPrivilege(p))
+                return Status::OK();
+            return Status(ErrorCodes::Unauthorized, "Unauthorized");
+        }
+
+        virtual bool run(OperationContext* txn,  const string& dbname, BSONObj& cmdObj, int options,
+                          string& errmsg, BSONObjBuilder& result,
+                          bool fromRepl = false ) {
+
+            NamespaceString ns( dbname, cmdObj.firstElement().valuestrsafe() );
+            if ( !ns.isNormal() ) {
+                errmsg = "bad namespace name";
+                return false;
+            }
+
+            BSONElement indexElt = cmdObj["index"];
+            if ( !indexElt.eoo() && indexElt.type() != String && indexElt.type() != Object ) {
+                errmsg = "index has to be a name or a key pattern";
+                return false;
+            }
+
+            long long numBuckets = 100;
+            BSONElement bucketsElt = cmdObj["buckets"];
+            if ( !bucketsElt.eoo() ) {
+                if ( !bucketsElt.isNumber() || bucketsElt.numberLong() < 1 ) {
+                    errmsg = "buckets has to be a positive number";
+                    return false;
+                }
+                numBuckets = bucketsElt.numberLong();
+            }
+
+            Client::ReadContext ctx( txn, ns.ns() );
+            Collection* collection = ctx.ctx().db()->getCollection( txn, ns.ns() );
+            if ( !collection ) {
+                errmsg = "collection not found";
+                return false;
+            }
+
+            std::vector<IndexDescriptor*> indexes;
+            IndexCatalog::IndexIterator it =
+                collection->getIndexCatalog()->getIndexIterator( false );
+            while ( it.more() ) {
+                IndexDescriptor* desc = it.next();
+                if ( indexElt.type() == String && desc->indexName() != indexElt.String() )
+                    continue;
+                if ( indexElt.type() == Object && desc->keyPattern() != indexElt.Obj() )
+                    continue;
+                if ( IndexNames::findPluginName( desc->keyPattern() ) != IndexNames::BTREE )
+                    continue;
+                indexes.push_back( desc );
+            }
+
+            if ( !indexElt.eoo() && indexes.empty() ) {
+                errmsg = str::stream() << "no btree index matches " << indexElt.toString( false );
+                return false;
+            }
+
+            long long numRecords = collection->numRecords();
+
+            OwnedPointerVector<IndexStats> allStats;
+            for ( size_t i = 0; i < indexes.size(); ++i ) {
+                IndexStatsBuilder builder( indexes[i]->keyPattern(), numRecords / numBuckets );
+
+                // Every key is counted, including all of a multikey document's keys, as they're
+                // what an index scan looks at.
+                IndexScanParams params;
+                params.descriptor = indexes[i];
+                params.bounds.isSimpleRange = true;
+                params.doNotDedup = true;
+
+                WorkingSet* ws = new WorkingSet();
+                InternalRunner runner( collection, new IndexScan( params, ws, NULL ), ws );
+
+                // Registered so that it's killed if the collection or its indexes go away while
+                // we yield, after which neither 'collection' nor 'indexes' can be used.
+                ScopedRunnerRegistration safety( &runner );
+
+                ElapsedTracker yieldTracker( 128, 10 );
+                BSONObj key;
+                Runner::RunnerState state;
+                while ( Runner::RUNNER_ADVANCED == ( state = runner.getNext( &key, NULL ) ) ) {
+                    builder.addKey( key );
+
+                    if ( yieldTracker.intervalHasElapsed() ) {
+                        txn->checkForInterrupt();
+
+                        runner.saveState();
+                        {
+                            Lock::TempRelease yield( txn->lockState() );
+                        }
+                        if ( !runner.restoreState( txn ) ) {
+                            state = Runner::RUNNER_DEAD;
+                            break;
+                        }
+
+                        yieldTracker.resetLastTime();
+                    }
+                }
+
+                if ( Runner::RUNNER_DEAD == state ) {
+                    errmsg = "collection or index dropped during analyze";
+                    return false;
+                }
+                if ( Runner::RUNNER_EOF != state ) {
+                    errmsg = "failed to scan index " + params.descriptor->indexName();
+                    return false;
+                }
+
+                allStats.mutableVector().push_back( builder.done( numRecords ) );
+            }
+
+            IndexStatsCache* cache = collection->infoCache()->getIndexStats();
+            BSONArrayBuilder analyzed( result.subarrayStart( "indexes" ) );
+            for ( size_t i = 0; i < indexes.size(); ++i ) {
+                IndexStats* stats = allStats.releaseAt( i );
+
+                BSONObjBuilder indexBob( analyzed.subobjStart() );
+                indexBob.append( "name", indexes[i]->indexName() );
+                indexBob.appendElements( stats->toBSON() );
+                indexBob.doneFast();
+
+                cache->add( stats );
+            }
+            analyzed.doneFast();
+
+            // Cached plans were picked without these statistics and pruneByCost() only runs
+            // when planning, so drop them to have the next query of each shape replanned.
+            collection->infoCache()->clearQueryCache();
+
+            return true;
+        }
+
+    } cmdAnalyze;
+
+}
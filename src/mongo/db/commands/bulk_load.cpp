@@ -0,0 +1,292 @@
+// bulk_load.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/auth/authorization_session.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_catalog_entry.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog/index_create.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands.h"
+#include "mongo/db/index/index_descriptor.h"
+#include "mongo/db/ops/insert.h"
+#include "mongo/db/repl/repl_coordinator_global.h"
+#include "mongo/db/structure/record_store.h"
+
+namespace mongo {
+
+    namespace {
+
+        class BSONDocWriter : public DocWriter {
+        public:
+            BSONDocWriter( const BSONObj& doc ) : _doc( doc ) {}
+            virtual void writeDocument( char* buf ) const {
+                memcpy( buf, _doc.objdata(), _doc.objsize() );
+            }
+            virtual size_t documentSize() const { return _doc.objsize(); }
+        private:
+            BSONObj _doc;
+        };
+
+    } // namespace
+
+    /**
+     * For loading a large collection from scratch, as the restore and import tools do.
+     *
+     * { bulkLoad : "bar", documents : [ { ... }, ... ], options : { <as for create> } }
+     *   appends the documents to a collection that has no indexes, creating it (without an
+     *   _id index) with the given options if need be, so nothing but the records themselves
+     *   is written per document.
+     *
+     * { bulkLoad : "bar", indexes : [ { key : { x : 1 }, name : "x_1" }, ... ] }
+     *   then builds all the indexes from one scan of the collection with the external sort
+     *   bulk builders.  The _id index is added unless the collection was created without one.
+     *
+     * Both may be in one command, in which case the documents go in first.  Until the indexes
+     * are built nothing enforces uniqueness of _id, and if the load is interrupted the
+     * collection should be dropped and loaded again.  The writes aren't replicated, so this
+     * refuses to run on a replica set member or master/slave node.
+     */
+    class CmdBulkLoad : public Command {
+    public:
+        CmdBulkLoad() : Command( "bulkLoad" ) {}
+
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        virtual bool slaveOk() const { return false; }
+
+        virtual void help( stringstream& help ) const {
+            help << "internal. for the restore and import tools.\n"
+                 << "{ bulkLoad : <collection>, documents : [ ... ], options : { ... } } appends "
+                 << "to a collection without indexes\n"
+                 << "{ bulkLoad : <collection>, indexes : [ <spec>, ... ] } then builds the "
+                 << "indexes with one scan";
+        }
+
+        virtual Status checkAuthForCommand(ClientBasic* client,
+                                           const std::string& dbname,
+                                           const BSONObj& cmdObj) {
+            ActionSet actions;
+            actions.addAction(ActionType::insert);
+            actions.addAction(ActionType::createIndex);
+            Privilege p(parseResourcePattern(dbname, cmdObj), actions);
+            if (client->getAuthorizationSession()->isAuthorizedForPrivilege(p))
+                return Status::OK();
+            return Status(ErrorCodes::Unauthorized, "Unauthorized");
+        }
+
+        virtual bool run(OperationContext* txn,  const string& dbname, BSONObj& cmdObj, int options,
+                          string& errmsg, BSONObjBuilder& result,
+                          bool fromRepl = false ) {
+
+            NamespaceString ns( dbname, cmdObj[name].String() );
+            Status status = userAllowedWriteNS( ns );
+            if ( !status.isOK() )
+                return appendCommandStatus( result, status );
+
+            if ( repl::getGlobalReplicationCoordinator()->isReplEnabled() ) {
+                return appendCommandStatus(
+                    result,
+                    Status( ErrorCodes::IllegalOperation,
+                            "bulkLoad isn't replicated, so only runs on a standalone server" ) );
+            }
+
+            BSONElement documents = cmdObj["documents"];
+            BSONElement indexes = cmdObj["indexes"];
+            if ( documents.eoo() && indexes.eoo() ) {
+                errmsg = "need documents or indexes";
+                return false;
+            }
+            if ( !documents.eoo() && documents.type() != Array ) {
+                errmsg = "documents has to be an array";
+                return false;
+            }
+            if ( !indexes.eoo() && indexes.type() != Array ) {
+                errmsg = "indexes has to be an array";
+                return false;
+            }
+
+            CollectionOptions collectionOptions;
+            if ( cmdObj["options"].type() == Object ) {
+                status = collectionOptions.parse( cmdObj["options"].Obj() );
+                if ( !status.isOK() )
+                    return appendCommandStatus( result, status );
+            }
+
+            Client::WriteContext writeContext( txn, ns.ns() );
+            Database* db = writeContext.ctx().db();
+
+            Collection* collection = db->getCollection( txn, ns.ns() );
+            if ( !collection ) {
+                collection = db->createCollection( txn,
+                                                   ns.ns(),
+                                                   collectionOptions,
+                                                   true,
+                                                   false /* createDefaultIndexes */ );
+                invariant( collection );
+                result.appendBool( "createdCollectionAutomatically", true );
+            }
+
+            if ( !documents.eoo() ) {
+                status = _insertDocuments( txn, collection, documents.Obj(), &result );
+                if ( !status.isOK() )
+                    return appendCommandStatus( result, status );
+            }
+
+            if ( !indexes.eoo() ) {
+                status = _buildIndexes( txn, collection, ns, indexes.Obj(), &result );
+                if ( !status.isOK() )
+                    return appendCommandStatus( result, status );
+            }
+
+            writeContext.commit();
+            return true;
+        }
+
+    private:
+        static Status _insertDocuments( OperationContext* txn,
+                                        Collection* collection,
+                                        const BSONObj& documents,
+                                        BSONObjBuilder* result ) {
+            if ( collection->getIndexCatalog()->numIndexesTotal() != 0 ) {
+                return Status( ErrorCodes::IllegalOperation,
+                               "bulkLoad can only add documents to a collection without indexes" );
+            }
+
+            std::vector<BSONObj> docs;
+            BSONObjIterator i( documents );
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                if ( e.type() != Object )
+                    return Status( ErrorCodes::BadValue,
+                                   "everything in documents has to be an Object" );
+                StatusWith<BSONObj> fixed = fixDocumentForInsert( e.Obj() );
+                if ( !fixed.isOK() )
+                    return fixed.getStatus();
+                docs.push_back( fixed.getValue().isEmpty() ? e.Obj() : fixed.getValue() );
+            }
+
+            std::vector<BSONDocWriter> writers( docs.begin(), docs.end() );
+            std::vector<const DocWriter*> writerPtrs;
+            for ( size_t j = 0; j < writers.size(); j++ )
+                writerPtrs.push_back( &writers[j] );
+            std::vector<DiskLoc> locs( docs.size() );
+
+            if ( !docs.empty() ) {
+                Status status = collection->insertDocuments( txn,
+                                                             &writerPtrs[0],
+                                                             writerPtrs.size(),
+                                                             &locs[0],
+                                                             true );
+                if ( !status.isOK() )
+                    return status;
+            }
+
+            result->appendNumber( "nInserted", static_cast<long long>( docs.size() ) );
+            return Status::OK();
+        }
+
+        static Status _buildIndexes( OperationContext* txn,
+                                     Collection* collection,
+                                     const NamespaceString& ns,
+                                     const BSONObj& indexes,
+                                     BSONObjBuilder* result ) {
+            IndexCatalog* catalog = collection->getIndexCatalog();
+            result->append( "numIndexesBefore", catalog->numIndexesTotal() );
+
+            std::vector<BSONObj> specs;
+            bool haveIdIndex = catalog->findIdIndex() != NULL;
+            BSONObjIterator i( indexes );
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                if ( e.type() != Object )
+                    return Status( ErrorCodes::BadValue,
+                                   "everything in indexes has to be an Object" );
+
+                BSONObjBuilder b;
+                b.append( "ns", ns );
+                BSONObjIterator j( e.Obj() );
+                while ( j.more() ) {
+                    BSONElement f = j.next();
+                    if ( f.fieldNameStringData() == "ns" ) {
+                        if ( f.type() != String || ns != f.String() )
+                            return Status( ErrorCodes::BadValue, "namespace mismatch" );
+                        continue;
+                    }
+                    b.append( f );
+                }
+                BSONObj spec = b.obj();
+
+                // there is nowhere for commit() to put the duplicates it would drop
+                if ( spec["dropDups"].trueValue() )
+                    return Status( ErrorCodes::BadValue, "bulkLoad doesn't support dropDups" );
+
+                StatusWith<BSONObj> prepared = catalog->prepareSpecForCreate( txn, spec );
+                if ( prepared.getStatus().code() == ErrorCodes::IndexAlreadyExists )
+                    continue;
+                if ( !prepared.isOK() )
+                    return prepared.getStatus();
+
+                if ( IndexDescriptor::isIdIndexPattern( spec["key"].Obj() ) )
+                    haveIdIndex = true;
+                specs.push_back( spec );
+            }
+
+            if ( !haveIdIndex &&
+                 collection->requiresIdIndex() &&
+                 collection->getCatalogEntry()->getCollectionOptions().autoIndexId !=
+                     CollectionOptions::NO ) {
+                specs.push_back( BSON( "ns" << ns.ns()
+                                       << "key" << BSON( "_id" << 1 )
+                                       << "name" << "_id_" ) );
+            }
+
+            if ( !specs.empty() ) {
+                MultiIndexBlock indexer( txn, collection );
+                Status status = indexer.init( specs );
+                if ( !status.isOK() )
+                    return status;
+
+                status = indexer.insertAllDocumentsInCollection();
+                if ( !status.isOK() )
+                    return status;
+
+                status = indexer.commit();
+                if ( !status.isOK() )
+                    return status;
+            }
+
+            result->append( "numIndexesAfter", catalog->numIndexesTotal() );
+            return Status::OK();
+        }
+
+    } cmdBulkLoad;
+
+}
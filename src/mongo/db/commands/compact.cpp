@@ -28,6 +28,7 @@
 *    it in the license file.
 */
 
+#include <boost/scoped_ptr.hpp>
 #include <string>
 #include <vector>
 
@@ -64,8 +65,10 @@ namespace mongo {
             help << "compact collection\n"
                 "warning: this operation locks the database and is slow. you can cancel with killOp()\n"
                 "{ compact : <collection_name>, [force:<bool>], [validate:<bool>],\n"
-                "  [paddingFactor:<num>], [paddingBytes:<num>] }\n"
+                "  [paddingFactor:<num>], [paddingBytes:<num>], [online:<bool>] }\n"
                 "  force - allows to run on a replica set primary\n"
+                "  online - move records out of the last extents in small batches, yielding the lock between them, and free the emptied extents. can run on a primary\n"
+                "  recordsPerBatch - records moved per batch when online (default 128)\n"
                 "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (defaults to true in this version)\n";
         }
         CompactCmd() : Command("compact") { }
@@ -88,9 +91,12 @@ namespace mongo {
                 return false;
             }
 
+            const bool online = cmdObj["online"].trueValue();
+
             repl::ReplicationCoordinator* replCoord = repl::getGlobalReplicationCoordinator();
             if (replCoord->getReplicationMode() == repl::ReplicationCoordinator::modeReplSet
                     && replCoord->getCurrentMemberState().primary()
+                    && !online
                     && !cmdObj["force"].trueValue()) {
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
@@ -142,6 +148,17 @@ namespace mongo {
             if ( cmdObj.hasElement("validate") )
                 compactOptions.validateDocuments = cmdObj["validate"].trueValue();
 
+            if ( online ) {
+                int recordsPerBatch = 128;
+                if ( cmdObj.hasElement("recordsPerBatch") ) {
+                    recordsPerBatch = cmdObj["recordsPerBatch"].numberInt();
+                    if ( recordsPerBatch < 1 || recordsPerBatch > 100000 ) {
+                        errmsg = "invalid recordsPerBatch";
+                        return false;
+                    }
+                }
+                return runOnline( txn, ns, compactOptions, recordsPerBatch, errmsg, result );
+            }
 
             Lock::DBWrite lk(txn->lockState(), ns.ns());
             //  SERVER-14085: The following will have to go as we push down WOUW
@@ -178,6 +195,98 @@ namespace mongo {
 
             return true;
         }
+
+    private:
+        /**
+         * Moves records a batch at a time, taking the lock for each batch, so reads and writes
+         * to the collection carry on in between.  Index builds are left alone and make it fail.
+         */
+        bool runOnline(OperationContext* txn,
+                       const NamespaceString& ns,
+                       const CompactOptions& compactOptions,
+                       int recordsPerBatch,
+                       string& errmsg,
+                       BSONObjBuilder& result) {
+            bool ok;
+            try {
+                ok = runOnlineSteps(txn, ns, compactOptions, recordsPerBatch, errmsg, result);
+            }
+            catch (...) {
+                abortOnline(txn, ns);
+                throw;
+            }
+            if (!ok)
+                abortOnline(txn, ns);
+            return ok;
+        }
+
+        bool runOnlineSteps(OperationContext* txn,
+                            const NamespaceString& ns,
+                            const CompactOptions& compactOptions,
+                            int recordsPerBatch,
+                            string& errmsg,
+                            BSONObjBuilder& result) {
+            boost::scoped_ptr<BackgroundOperation> backgroundOp;
+            CompactStats stats;
+
+            log() << "compact " << ns << " online begin, options: " << compactOptions.toString();
+
+            for ( bool done = false; !done; ) {
+                txn->checkForInterrupt();
+
+                Lock::DBWrite lk(txn->lockState(), ns.ns());
+                WriteUnitOfWork wunit(txn->recoveryUnit());
+                Client::Context ctx(txn, ns);
+
+                if ( !backgroundOp ) {
+                    BackgroundOperation::assertNoBgOpInProgForNs(ns.ns());
+                    backgroundOp.reset(new BackgroundOperation(ns.ns()));
+                }
+
+                Collection* collection = ctx.db()->getCollection(txn, ns.ns());
+                if ( !collection ) {
+                    errmsg = "namespace does not exist";
+                    return false;
+                }
+
+                if ( collection->isCapped() ) {
+                    errmsg = "cannot compact a capped collection";
+                    return false;
+                }
+
+                StatusWith<bool> status =
+                    collection->compactIncremental( txn, &compactOptions, recordsPerBatch, &stats );
+                if ( !status.isOK() )
+                    return appendCommandStatus( result, status.getStatus() );
+                done = status.getValue();
+
+                wunit.commit();
+            }
+
+            log() << "compact " << ns << " online end, moved " << stats.recordsMoved
+                  << " records, freed " << stats.extentsFreed << " extents";
+
+            result.appendNumber("recordsMoved", stats.recordsMoved);
+            result.appendNumber("extentsFreed", stats.extentsFreed);
+            return true;
+        }
+
+        /**
+         * Gives back the space set aside by a step that didn't finish emptying its extent, once
+         * the steps stop early because of an error or interrupt.
+         */
+        void abortOnline(OperationContext* txn, const NamespaceString& ns) {
+            Lock::DBWrite lk(txn->lockState(), ns.ns());
+            WriteUnitOfWork wunit(txn->recoveryUnit());
+            Client::Context ctx(txn, ns);
+
+            Collection* collection = ctx.db()->getCollection(txn, ns.ns());
+            if ( !collection )
+                return;
+
+            collection->abortCompactIncremental(txn);
+            wunit.commit();
+        }
     };
     static CompactCmd compactCmd;
 
@@ -37,6 +37,8 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/repl/oplog.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/storage/storage_benchmark.h"
+#include "mongo/db/storage_options.h"
 
 namespace mongo {
 
@@ -211,6 +213,42 @@ namespace mongo {
         }
     };
 
+    // Testing only, enabled via command line.
+    class StorageBenchmarkCmd : public Command {
+    public:
+        StorageBenchmarkCmd() : Command( "storageBenchmark" ) {}
+        virtual bool adminOnly() const { return true; }
+        virtual bool slaveOk() const { return true; }
+        virtual bool isWriteCommandForConfigServer() const { return false; }
+        // No auth needed because it only works when enabled via command line.
+        virtual void addRequiredPrivileges(const std::string& dbname,
+                                           const BSONObj& cmdObj,
+                                           std::vector<Privilege>* out) {}
+        virtual void help( stringstream& help ) const {
+            help << "internal testing command.  Times storage engine operations on a scratch "
+                 << "collection in the storagebench database.\n"
+                 << "{ storageBenchmark: <engine name, defaults to the one in use>, "
+                 << "numRecords: 10000, recordSize: 128, numOps: 10000, numThreads: 1, "
+                 << "scanLength: 100, workloads: [ ... ] }";
+        }
+        virtual bool run(OperationContext* txn, const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            string engine = storageGlobalParams.engine;
+            if ( cmdObj.firstElement().type() == String )
+                engine = cmdObj.firstElement().String();
+
+            StatusWith<StorageBenchmarkOptions> options =
+                StorageBenchmarkOptions::parse( cmdObj );
+            if ( !options.isOK() )
+                return appendCommandStatus( result, options.getStatus() );
+
+            log() << "test only command storageBenchmark invoked engine:" << engine << endl;
+            return appendCommandStatus( result,
+                                        runStorageBenchmark( engine,
+                                                             options.getValue(),
+                                                             &result ) );
+        }
+    };
+
     // ----------------------------
 
     MONGO_INITIALIZER(RegisterEmptyCappedCmd)(InitializerContext* context) {
@@ -220,6 +258,7 @@ namespace mongo {
             new CmdSleep();
             new EmptyCapped();
             new GodInsert();
+            new StorageBenchmarkCmd();
         }
         return Status::OK();
     }
@@ -67,6 +67,7 @@
 #include "mongo/db/pdfile_version.h"
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/range_deleter_service.h"
+#include "mongo/db/record_scrubber.h"
 #include "mongo/db/repair_database.h"
 #include "mongo/db/repl/network_interface_impl.h"
 #include "mongo/db/repl/repl_coordinator_global.h"
@@ -595,6 +596,9 @@ namespace mongo {
 #endif // __linux__
     }
 
+    // how many data files can be preallocated at once
+    MONGO_EXPORT_STARTUP_SERVER_PARAMETER(fileAllocatorThreads, int, 4);
+
     static void _initAndListen(int listenPort ) {
         Client::initThread("initandlisten");
 
@@ -639,7 +643,7 @@ namespace mongo {
         acquirePathLock(mongodGlobalParams.repair);
         boost::filesystem::remove_all(storageGlobalParams.dbpath + "/_tmp/");
 
-        FileAllocator::get()->start();
+        FileAllocator::get()->start( fileAllocatorThreads );
 
         // TODO:  This should go into a MONGO_INITIALIZER once we have figured out the correct
         // dependencies.
@@ -707,6 +711,8 @@ namespace mongo {
             startTTLBackgroundJob();
         }
 
+        startRecordScrubber();
+
 #ifndef _WIN32
         mongo::signalForkSuccess();
 #endif
@@ -42,12 +42,19 @@ namespace mongo {
     // static
     const char* CollectionScan::kStageType = "COLLSCAN";
 
+    const size_t CollectionScan::kBatchSize;
+    const size_t CollectionScan::kPrefetchDistance;
+
     CollectionScan::CollectionScan(const CollectionScanParams& params,
                                    WorkingSet* workingSet,
                                    const MatchExpression* filter)
         : _workingSet(workingSet),
           _filter(filter),
           _params(params),
+          _batch(kBatchSize),
+          _batchPos(0),
+          _batchSize(0),
+          _batchDataStale(false),
           _nsDropped(false),
           _commonStats(kStageType) { }
 
@@ -74,31 +81,27 @@ namespace mongo {
             return PlanStage::NEED_TIME;
         }
 
-        // What we'll return to the user.
-        DiskLoc nextLoc;
-
         // Should we try getNext() on the underlying _iter if we're EOF?  Yes, if we're tailable.
-        if (isEOF()) {
-            if (!_params.tailable) {
-                return PlanStage::IS_EOF;
-            }
-            else {
-                // See if _iter gives us anything new.
-                nextLoc = _iter->getNext();
-                if (nextLoc.isNull()) {
-                    // Nope, still EOF.
-                    return PlanStage::IS_EOF;
-                }
-            }
+        if (isEOF() && !_params.tailable) {
+            return PlanStage::IS_EOF;
         }
-        else {
-            nextLoc = _iter->getNext();
+
+        // What we'll return to the user.  If we're tailable this also sees if _iter gives us
+        // anything new.
+        RecordLocAndData next;
+        if (!nextFromBatch(&next)) {
+            return PlanStage::IS_EOF;
         }
 
         WorkingSetID id = _workingSet->allocate();
         WorkingSetMember* member = _workingSet->get(id);
-        member->loc = nextLoc;
-        member->obj = _params.collection->docFor(member->loc);
+        member->loc = next.loc;
+        if (_batchDataStale) {
+            member->obj = _params.collection->docFor(member->loc);
+        }
+        else {
+            member->obj = next.data.toBson();
+        }
         member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
 
         ++_specificStats.docsTested;
@@ -115,13 +118,42 @@ namespace mongo {
         }
     }
 
+    bool CollectionScan::nextFromBatch(RecordLocAndData* out) {
+        while (true) {
+            if (_batchPos == _batchSize) {
+                _batchSize = _iter->getNextBatch(&_batch[0], kBatchSize);
+                _batchPos = 0;
+                _batchDataStale = false;
+                if (0 == _batchSize) {
+                    return false;
+                }
+            }
+
+            RecordLocAndData& entry = _batch[_batchPos++];
+            if (entry.loc.isNull()) {
+                // Deleted while we had it buffered.
+                continue;
+            }
+
+            *out = entry;
+            entry.data = RecordData();
+
+            // Start pulling in a record we'll want shortly while the caller works on this one.
+            const size_t ahead = _batchPos + kPrefetchDistance - 1;
+            if (!_batchDataStale && ahead < _batchSize && !_batch[ahead].loc.isNull()) {
+                prefetch(const_cast<char*>(_batch[ahead].data.data()));
+            }
+            return true;
+        }
+    }
+
     bool CollectionScan::isEOF() {
         if ((0 != _params.maxScan) && (_specificStats.docsTested >= _params.maxScan)) {
             return true;
         }
         if (_nsDropped) { return true; }
         if (NULL == _iter) { return false; }
-        return _iter->isEOF();
+        return _batchPos == _batchSize && _iter->isEOF();
     }
 
     void CollectionScan::invalidate(const DiskLoc& dl, InvalidationType type) {
@@ -135,6 +167,14 @@ namespace mongo {
 
         // If we're here, 'dl' is being deleted.
 
+        // We may have already read past 'dl'.  Drop it rather than return a deleted record.
+        for (size_t i = _batchPos; i < _batchSize; ++i) {
+            if (_batch[i].loc == dl) {
+                _batch[i].loc = DiskLoc();
+                _batch[i].data = RecordData();
+            }
+        }
+
         // Deletions can harm the underlying RecordIterator so we must pass them down.
         if (NULL != _iter) {
             _iter->invalidate(dl);
@@ -143,6 +183,9 @@ namespace mongo {
 
     void CollectionScan::prepareToYield() {
         ++_commonStats.yields;
+        if (_batchPos < _batchSize) {
+            _batchDataStale = true;
+        }
         if (NULL != _iter) {
             _iter->prepareToYield();
         }
@@ -32,10 +32,10 @@
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/structure/record_store.h"
 
 namespace mongo {
 
-    class RecordIterator;
     class WorkingSet;
 
     /**
@@ -71,6 +71,17 @@ namespace mongo {
          */
         bool diskLocInMemory(DiskLoc loc);
 
+        /**
+         * Pops the next live record off _batch, refilling it from _iter when it runs dry.
+         * Returns false if _iter has nothing more to give.
+         */
+        bool nextFromBatch(RecordLocAndData* out);
+
+        // How many records we pull from _iter at once, and how far ahead of the record being
+        // returned we prefetch.
+        static const size_t kBatchSize = 32;
+        static const size_t kPrefetchDistance = 4;
+
         // WorkingSet is not owned by us.
         WorkingSet* _workingSet;
 
@@ -81,6 +92,16 @@ namespace mongo {
 
         CollectionScanParams _params;
 
+        // Records read from _iter but not yet returned are _batch[_batchPos, _batchSize).  Entries
+        // deleted while buffered have their loc nulled out by invalidate().
+        std::vector<RecordLocAndData> _batch;
+        size_t _batchPos;
+        size_t _batchSize;
+
+        // Set when we yield with records buffered.  Their data pointers may no longer be valid so
+        // we go back to the collection for those records.
+        bool _batchDataStale;
+
         // True if Database::getCollection(_ns) == NULL on our first call to work.
         bool _nsDropped;
 
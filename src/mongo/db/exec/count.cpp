@@ -28,6 +28,7 @@
 
 #include "mongo/db/exec/count.h"
 
+#include "mongo/db/exec/filter.h"
 #include "mongo/db/index/index_cursor.h"
 #include "mongo/db/index/index_descriptor.h"
 
@@ -47,6 +48,9 @@ namespace mongo {
           _commonStats(kStageType) {
         _specificStats.keyPattern = _params.descriptor->keyPattern();
         _specificStats.isMultiKey = _params.descriptor->isMultikey();
+        if (_params.useBounds) {
+            _specificStats.indexBounds = _params.bounds.toBSON();
+        }
     }
 
     void Count::initIndexCursor() {
@@ -61,6 +65,26 @@ namespace mongo {
         // Is this assumption always valid?  See SERVER-12397
         _btreeCursor.reset(static_cast<BtreeIndexCursor*>(cursor));
 
+        if (_params.useBounds) {
+            // Navigate the bounds the way IndexScan does, skipping over the gaps between
+            // intervals instead of reading every key in between.
+            const BSONObj& keyPattern = _descriptor->keyPattern();
+            _checker.reset(new IndexBoundsChecker(&_params.bounds, keyPattern, 1));
+
+            int nFields = keyPattern.nFields();
+            vector<const BSONElement*> key(nFields);
+            vector<bool> inc(nFields);
+            if (_checker->getStartKey(&key, &inc)) {
+                _btreeCursor->seek(key, inc);
+                _keyElts.resize(nFields);
+                _keyEltsInc.resize(nFields);
+            }
+            else {
+                _hitEnd = true;
+            }
+            return;
+        }
+
         // _btreeCursor points at our start position.  We move it forward until it hits a cursor
         // that points at the end.
         _btreeCursor->seek(_params.startKey, !_params.startKeyInclusive);
@@ -87,6 +111,11 @@ namespace mongo {
     void Count::checkEnd() {
         if (isEOF()) { return; }
 
+        if (_params.useBounds) {
+            checkEndBounds();
+            return;
+        }
+
         if (_endCursor->isEOF()) {
             // If the endCursor is EOF we're only done when our 'current count position' hits EOF.
             _hitEnd = _btreeCursor->isEOF();
@@ -97,6 +126,34 @@ namespace mongo {
         }
     }
 
+    void Count::checkEndBounds() {
+        for (;;) {
+            if (_btreeCursor->isEOF()) {
+                _hitEnd = true;
+                return;
+            }
+
+            IndexBoundsChecker::KeyState keyState = _checker->checkKey(_btreeCursor->getKey(),
+                                                                       &_keyEltsToUse,
+                                                                       &_movePastKeyElts,
+                                                                       &_keyElts,
+                                                                       &_keyEltsInc);
+            if (IndexBoundsChecker::DONE == keyState) {
+                _hitEnd = true;
+                return;
+            }
+
+            if (IndexBoundsChecker::VALID == keyState) {
+                return;
+            }
+
+            verify(IndexBoundsChecker::MUST_ADVANCE == keyState);
+            ++_specificStats.keysExamined;
+            _btreeCursor->skip(_btreeCursor->getKey(), _keyEltsToUse, _movePastKeyElts,
+                               _keyElts, _keyEltsInc);
+        }
+    }
+
     PlanStage::StageState Count::work(WorkingSetID* out) {
         ++_commonStats.works;
 
@@ -114,11 +171,21 @@ namespace mongo {
         if (isEOF()) { return PlanStage::IS_EOF; }
 
         DiskLoc loc = _btreeCursor->getValue();
+
+        // The filter has to see the key before we move off it.
+        bool passes = Filter::passes(_btreeCursor->getKey(), _descriptor->keyPattern(),
+                                     _params.filter);
+
         _btreeCursor->next();
         checkEnd();
 
         ++_specificStats.keysExamined;
 
+        if (!passes) {
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
         if (_shouldDedup) {
             if (_returned.end() != _returned.find(loc)) {
                 ++_commonStats.needTime;
@@ -148,7 +215,9 @@ namespace mongo {
         if (_hitEnd || (NULL == _btreeCursor.get())) { return; }
 
         _btreeCursor->savePosition();
-        _endCursor->savePosition();
+        if (NULL != _endCursor.get()) {
+            _endCursor->savePosition();
+        }
     }
 
     void Count::recoverFromYield() {
@@ -165,6 +234,16 @@ namespace mongo {
             return;
         }
 
+        // This can change during yielding.
+        _shouldDedup = _descriptor->isMultikey();
+
+        if (_params.useBounds) {
+            // The restored position is at or after the one we saved, so the checker can carry on
+            // from where it was.
+            checkEndBounds();
+            return;
+        }
+
         // See if we're somehow already past our end key (maybe the thing we were pointing at got
         // deleted...)
         int cmp = _btreeCursor->getKey().woCompare(_params.endKey, _descriptor->keyPattern(), false);
@@ -190,9 +269,6 @@ namespace mongo {
         // If we weren't EOF our end position might have moved around.  Relocate it.
         _endCursor->seek(_params.endKey, _params.endKeyInclusive);
 
-        // This can change during yielding.
-        _shouldDedup = _descriptor->isMultikey();
-
         checkEnd();
     }
 
@@ -220,10 +296,19 @@ namespace mongo {
 
     PlanStageStats* Count::getStats() {
         _commonStats.isEOF = isEOF();
+
+        // Add a BSON representation of the filter to the stats tree, if there is one.
+        if (NULL != _params.filter) {
+            BSONObjBuilder bob;
+            _params.filter->toBSON(&bob);
+            _commonStats.filter = bob.obj();
+        }
+
         auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_COUNT));
 
         CountStats* countStats = new CountStats(_specificStats);
         countStats->keyPattern = _specificStats.keyPattern.getOwned();
+        countStats->indexBounds = _specificStats.indexBounds.getOwned();
         ret->specific.reset(countStats);
 
         return ret.release();
@@ -36,6 +36,7 @@
 #include "mongo/db/index/index_access_method.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
+#include "mongo/db/query/index_bounds.h"
 #include "mongo/platform/unordered_set.h"
 
 namespace mongo {
@@ -45,7 +46,7 @@ namespace mongo {
     class WorkingSet;
 
     struct CountParams {
-        CountParams() : descriptor(NULL) { }
+        CountParams() : descriptor(NULL), useBounds(false), filter(NULL) { }
 
         // What index are we traversing?
         const IndexDescriptor* descriptor;
@@ -55,12 +56,21 @@ namespace mongo {
 
         BSONObj endKey;
         bool endKeyInclusive;
+
+        // If true we count the keys within 'bounds' instead of the keys between startKey and
+        // endKey.  The bounds may have any number of intervals per field.
+        bool useBounds;
+        IndexBounds bounds;
+
+        // Only keys matching this are counted.  It is evaluated against the index key, so it may
+        // only refer to indexed fields.  Not owned by us, may be NULL.
+        const MatchExpression* filter;
     };
 
     /**
-     * Used by the count command.  Scans an index from a start key to an end key.  Does not create
-     * any WorkingSetMember(s) for any of the data, instead returning ADVANCED to indicate to the
-     * caller that another result should be counted.
+     * Used by the count command.  Scans an index from a start key to an end key, or over
+     * arbitrary index bounds.  Does not create any WorkingSetMember(s) for any of the data,
+     * instead returning ADVANCED to indicate to the caller that another result should be counted.
      *
      * Only created through the getRunnerCount path, as count is the only operation that doesn't
      * care about its data.
@@ -95,6 +105,12 @@ namespace mongo {
          */
         void checkEnd();
 
+        /**
+         * checkEnd() for when we're counting over _params.bounds.  Skips the cursor forward
+         * until it points at a key within the bounds or we run out of bounds.
+         */
+        void checkEndBounds();
+
         // The WorkingSet we annotate with results.  Not owned by us.
         WorkingSet* _workingSet;
 
@@ -105,9 +121,16 @@ namespace mongo {
         // Our start cursor is _btreeCursor.
         boost::scoped_ptr<BtreeIndexCursor> _btreeCursor;
 
-        // Our end marker.
+        // Our end marker.  Only used when we're not counting over _params.bounds.
         boost::scoped_ptr<BtreeIndexCursor> _endCursor;
 
+        // Used instead of _endCursor to navigate _params.bounds.
+        boost::scoped_ptr<IndexBoundsChecker> _checker;
+        int _keyEltsToUse;
+        bool _movePastKeyElts;
+        std::vector<const BSONElement*> _keyElts;
+        std::vector<bool> _keyEltsInc;
+
         // Could our index have duplicates?  If so, we use _returned to dedup.
         unordered_set<DiskLoc, DiskLoc::Hasher> _returned;
 
@@ -0,0 +1,351 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+    // static
+    const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+    const size_t ParallelCollectionScan::kBatchSize;
+
+    namespace {
+
+        SimpleMutex scanPoolMutex("parallelCollScanPool");
+        ThreadPool* scanPool = NULL;
+
+        /**
+         * The threads every parallel scan shares.  Created on first use and never torn down.
+         */
+        ThreadPool& getScanPool() {
+            SimpleMutex::scoped_lock lk(scanPoolMutex);
+            if (NULL == scanPool) {
+                const unsigned nThreads =
+                    std::max(1u, std::min(16u, ProcessInfo().getNumCores()));
+                scanPool = new ThreadPool(nThreads);
+            }
+            return *scanPool;
+        }
+
+    } // namespace
+
+    /**
+     * Lets the query's thread wait for the rest of a round to finish.
+     */
+    class ParallelCollectionScan::RoundLatch {
+    public:
+        explicit RoundLatch(size_t count) : _count(count) { }
+
+        void countDown() {
+            boost::mutex::scoped_lock lk(_mutex);
+            if (0 == --_count) {
+                _done.notify_all();
+            }
+        }
+
+        void wait() {
+            boost::mutex::scoped_lock lk(_mutex);
+            while (_count > 0) {
+                _done.wait(lk);
+            }
+        }
+
+    private:
+        boost::mutex _mutex;
+        boost::condition_variable _done;
+        size_t _count;
+    };
+
+    ParallelCollectionScan::ParallelCollectionScan(const CollectionScanParams& params,
+                                                   WorkingSet* workingSet,
+                                                   const MatchExpression* filter,
+                                                   int numThreads)
+        : _workingSet(workingSet),
+          _filter(filter),
+          _params(params),
+          _numThreads(std::max(1, numThreads)),
+          _initialized(false),
+          _resultsPos(0),
+          _resultsStale(false),
+          _scanDone(false),
+          _nsDropped(false),
+          _commonStats(kStageType) {
+        invariant(params.start.isNull());
+        invariant(CollectionScanParams::FORWARD == params.direction);
+        invariant(!params.tailable);
+        invariant(0 == params.maxScan);
+    }
+
+    ParallelCollectionScan::~ParallelCollectionScan() { }
+
+    // static
+    bool ParallelCollectionScan::canFilterInParallel(const MatchExpression* filter) {
+        if (NULL == filter) {
+            return true;
+        }
+        // $where runs in the query's JavaScript scope.
+        if (MatchExpression::WHERE == filter->matchType()) {
+            return false;
+        }
+        for (size_t i = 0; i < filter->numChildren(); ++i) {
+            if (!canFilterInParallel(filter->getChild(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    PlanStage::StageState ParallelCollectionScan::work(WorkingSetID* out) {
+        ++_commonStats.works;
+
+        // Adds the amount of time taken by work() to executionTimeMillis.
+        ScopedTimer timer(&_commonStats.executionTimeMillis);
+
+        if (_nsDropped) { return PlanStage::DEAD; }
+
+        if (!_initialized) {
+            if (NULL == _params.collection) {
+                _nsDropped = true;
+                return PlanStage::DEAD;
+            }
+
+            _iters.mutableVector() = _params.collection->getManyIterators();
+
+            // Deal the iterators out so neighbouring pieces go to different threads.
+            const size_t numPartitions =
+                std::min(_iters.size(), static_cast<size_t>(_numThreads));
+            _partitions.resize(numPartitions);
+            for (size_t i = 0; i < _iters.size(); ++i) {
+                _partitions[i % numPartitions].iters.push_back(_iters[i]);
+            }
+
+            _initialized = true;
+            ++_commonStats.needTime;
+            return PlanStage::NEED_TIME;
+        }
+
+        while (_resultsPos < _results.size()) {
+            RecordLocAndData& entry = _results[_resultsPos++];
+            if (entry.loc.isNull()) {
+                // Deleted while we had it buffered.
+                continue;
+            }
+
+            WorkingSetID id = _workingSet->allocate();
+            WorkingSetMember* member = _workingSet->get(id);
+            member->loc = entry.loc;
+            member->state = WorkingSetMember::LOC_AND_UNOWNED_OBJ;
+
+            if (_resultsStale) {
+                // It passed the filter before the yield, but may have changed since.
+                member->obj = _params.collection->docFor(member->loc);
+                entry.data = RecordData();
+                if (!Filter::passes(member, _filter)) {
+                    _workingSet->free(id);
+                    ++_commonStats.needTime;
+                    return PlanStage::NEED_TIME;
+                }
+            }
+            else {
+                member->obj = entry.data.toBson();
+                entry.data = RecordData();
+            }
+
+            *out = id;
+            ++_commonStats.advanced;
+            return PlanStage::ADVANCED;
+        }
+
+        if (_scanDone || !runRound()) {
+            _scanDone = true;
+            return PlanStage::IS_EOF;
+        }
+
+        ++_commonStats.needTime;
+        return PlanStage::NEED_TIME;
+    }
+
+    bool ParallelCollectionScan::runRound() {
+        std::vector<Partition*> active;
+        for (size_t i = 0; i < _partitions.size(); ++i) {
+            if (_partitions[i].current < _partitions[i].iters.size()) {
+                active.push_back(&_partitions[i]);
+            }
+        }
+        if (active.empty()) {
+            return false;
+        }
+
+        // Our own thread takes the first share rather than waiting idle, so a round finishes
+        // even when other scans keep the pool busy.
+        RoundLatch latch(active.size() - 1);
+        for (size_t i = 1; i < active.size(); ++i) {
+            getScanPool().schedule(&ParallelCollectionScan::scanPartition,
+                                   active[i], _filter, &latch);
+        }
+        scanPartition(active[0], _filter, NULL);
+        latch.wait();
+
+        _results.clear();
+        _resultsPos = 0;
+        _resultsStale = false;
+        for (size_t i = 0; i < active.size(); ++i) {
+            Partition* partition = active[i];
+            _specificStats.docsTested += partition->docsTested;
+            partition->docsTested = 0;
+            _results.insert(_results.end(), partition->matched.begin(), partition->matched.end());
+            partition->matched.clear();
+        }
+        for (size_t i = 0; i < active.size(); ++i) {
+            uassertStatusOK(active[i]->status);
+        }
+        return true;
+    }
+
+    // static
+    void ParallelCollectionScan::scanPartition(Partition* partition,
+                                               const MatchExpression* filter,
+                                               RoundLatch* latch) {
+        partition->status = Status::OK();
+        try {
+            std::vector<RecordLocAndData> batch(kBatchSize);
+            size_t wanted = kBatchSize;
+            while (wanted > 0 && partition->current < partition->iters.size()) {
+                RecordIterator* iter = partition->iters[partition->current];
+                const size_t got = iter->getNextBatch(&batch[0], wanted);
+                for (size_t i = 0; i < got; ++i) {
+                    ++partition->docsTested;
+                    if (NULL == filter || filter->matchesBSON(batch[i].data.toBson())) {
+                        partition->matched.push_back(batch[i]);
+                    }
+                    batch[i].data = RecordData();
+                }
+                if (got < wanted) {
+                    // This iterator is done.
+                    ++partition->current;
+                }
+                wanted -= got;
+            }
+        }
+        catch (const DBException& e) {
+            partition->status = e.toStatus();
+        }
+        catch (const std::exception& e) {
+            partition->status = Status(ErrorCodes::InternalError, e.what());
+        }
+        catch (...) {
+            // Nothing may escape: the latch has to be counted down or the query waits forever.
+            partition->status = Status(ErrorCodes::UnknownError,
+                                       "unknown exception in parallel collection scan");
+        }
+
+        if (NULL != latch) {
+            latch->countDown();
+        }
+    }
+
+    bool ParallelCollectionScan::isEOF() {
+        if (_nsDropped) { return true; }
+        return _scanDone && _resultsPos == _results.size();
+    }
+
+    void ParallelCollectionScan::invalidate(const DiskLoc& dl, InvalidationType type) {
+        ++_commonStats.invalidates;
+
+        // We don't care about mutations since we filter buffered results again after a yield.
+        if (INVALIDATION_DELETION != type) {
+            return;
+        }
+
+        for (size_t i = _resultsPos; i < _results.size(); ++i) {
+            if (_results[i].loc == dl) {
+                _results[i].loc = DiskLoc();
+                _results[i].data = RecordData();
+            }
+        }
+
+        // Deletions can harm the underlying RecordIterators so we must pass them down.
+        for (size_t i = 0; i < _iters.size(); ++i) {
+            _iters[i]->invalidate(dl);
+        }
+    }
+
+    void ParallelCollectionScan::prepareToYield() {
+        ++_commonStats.yields;
+        if (_resultsPos < _results.size()) {
+            _resultsStale = true;
+        }
+        for (size_t i = 0; i < _iters.size(); ++i) {
+            _iters[i]->prepareToYield();
+        }
+    }
+
+    void ParallelCollectionScan::recoverFromYield() {
+        ++_commonStats.unyields;
+        for (size_t i = 0; i < _iters.size(); ++i) {
+            if (!_iters[i]->recoverFromYield()) {
+                warning() << "Collection dropped or state deleted during yield of "
+                          << "ParallelCollectionScan";
+                _nsDropped = true;
+            }
+        }
+    }
+
+    vector<PlanStage*> ParallelCollectionScan::getChildren() const {
+        vector<PlanStage*> empty;
+        return empty;
+    }
+
+    PlanStageStats* ParallelCollectionScan::getStats() {
+        _commonStats.isEOF = isEOF();
+
+        // Add a BSON representation of the filter to the stats tree, if there is one.
+        if (NULL != _filter) {
+            BSONObjBuilder bob;
+            _filter->toBSON(&bob);
+            _commonStats.filter = bob.obj();
+        }
+
+        auto_ptr<PlanStageStats> ret(new PlanStageStats(_commonStats, STAGE_COLLSCAN));
+        ret->specific.reset(new CollectionScanStats(_specificStats));
+        return ret.release();
+    }
+
+}  // namespace mongo
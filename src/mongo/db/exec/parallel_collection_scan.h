@@ -0,0 +1,158 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/base/owned_pointer_vector.h"
+#include "mongo/db/diskloc.h"
+#include "mongo/db/exec/collection_scan_common.h"
+#include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/structure/record_store.h"
+
+namespace mongo {
+
+    class WorkingSet;
+
+    /**
+     * Scans over a whole collection like CollectionScan, but splits the collection up with
+     * Collection::getManyIterators() and reads and filters the pieces on a shared pool of
+     * threads.  Results come back in no particular order.
+     *
+     * The threads only run inside work(), one round at a time: each takes up to kBatchSize
+     * records from its iterators and keeps the ones that pass the filter.  work() then hands
+     * the survivors out one per call until it needs another round, so yields, invalidations and
+     * the caller's locks all see the stage as single threaded.
+     *
+     * Preconditions: a forward, non-tailable scan from the start of the collection without
+     * maxScan, and a filter canFilterInParallel() accepts.
+     */
+    class ParallelCollectionScan : public PlanStage {
+    public:
+        ParallelCollectionScan(const CollectionScanParams& params,
+                               WorkingSet* workingSet,
+                               const MatchExpression* filter,
+                               int numThreads);
+
+        virtual ~ParallelCollectionScan();
+
+        /**
+         * Returns false if evaluating 'filter' needs the query's own thread, as $where does.
+         */
+        static bool canFilterInParallel(const MatchExpression* filter);
+
+        virtual StageState work(WorkingSetID* out);
+        virtual bool isEOF();
+
+        virtual void invalidate(const DiskLoc& dl, InvalidationType type);
+        virtual void prepareToYield();
+        virtual void recoverFromYield();
+
+        virtual std::vector<PlanStage*> getChildren() const;
+
+        virtual StageType stageType() const { return STAGE_COLLSCAN; }
+
+        virtual PlanStageStats* getStats();
+
+        /**
+         * How many pieces getManyIterators() split the collection into.  Zero until the first
+         * call to work().
+         */
+        size_t numIterators() const { return _iters.size(); }
+
+        static const char* kStageType;
+
+    private:
+        /**
+         * The iterators one thread reads from, in turn, and what it found in the last round.
+         */
+        struct Partition {
+            Partition() : current(0), docsTested(0), status(Status::OK()) { }
+
+            std::vector<RecordIterator*> iters; // owned by _iters
+            size_t current;
+            std::vector<RecordLocAndData> matched;
+            size_t docsTested;
+            Status status; // of the last round
+        };
+
+        class RoundLatch;
+
+        /**
+         * Runs one round over all the partitions that have records left and moves what passed
+         * the filter into _results.  Returns false once there is nothing left to read.
+         */
+        bool runRound();
+
+        /**
+         * One thread's share of a round.
+         */
+        static void scanPartition(Partition* partition,
+                                  const MatchExpression* filter,
+                                  RoundLatch* latch);
+
+        // How many records each thread reads per round.
+        static const size_t kBatchSize = 256;
+
+        // WorkingSet is not owned by us.
+        WorkingSet* _workingSet;
+
+        // The filter is not owned by us.
+        const MatchExpression* _filter;
+
+        CollectionScanParams _params;
+
+        const int _numThreads;
+
+        OwnedPointerVector<RecordIterator> _iters;
+        std::vector<Partition> _partitions;
+        bool _initialized;
+
+        // Passed the filter in the last round but not yet returned are _results[_resultsPos..].
+        // Entries deleted while buffered have their loc nulled out by invalidate().
+        std::vector<RecordLocAndData> _results;
+        size_t _resultsPos;
+
+        // Set when we yield with results buffered.  Their data pointers may no longer be valid,
+        // and the documents may have changed, so we fetch and filter those again.
+        bool _resultsStale;
+
+        // Set once every iterator is done.
+        bool _scanDone;
+
+        // True if the collection was gone on our first call to work, or went away in a yield.
+        bool _nsDropped;
+
+        // Stats
+        CommonStats _commonStats;
+        CollectionScanStats _specificStats;
+    };
+
+}  // namespace mongo
@@ -253,11 +253,15 @@ namespace mongo {
             CountStats* specific = new CountStats(*this);
             // BSON objects have to be explicitly copied.
             specific->keyPattern = keyPattern.getOwned();
+            specific->indexBounds = indexBounds.getOwned();
             return specific;
         }
 
         BSONObj keyPattern;
 
+        // Empty unless we're counting over multi-interval bounds.
+        BSONObj indexBounds;
+
         bool isMultiKey;
 
         size_t keysExamined;
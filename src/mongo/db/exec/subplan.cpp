@@ -35,6 +35,7 @@
 #include "mongo/db/query/canonical_query.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/planner_analysis.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/qlog.h"
@@ -220,6 +221,11 @@ namespace mongo {
             // We already checked for zero solutions in planSubqueries(...).
             invariant(!solutions.empty());
 
+            // Don't bother running the candidates that the index statistics rule out.
+            PlanRanker::pruneByCost(*_collection->infoCache()->getIndexStats(),
+                                    _collection->numRecords(),
+                                    &solutions);
+
             if (1 == solutions.size()) {
                 // There is only one solution. Transfer ownership to an auto_ptr.
                 auto_ptr<QuerySolution> autoSoln(solutions[0]);
@@ -56,7 +56,8 @@ namespace mongo {
         if (0 == _descriptor->version()) {
             _keyGenerator.reset(new BtreeKeyGeneratorV0(fieldNames, fixed,
                 _descriptor->isSparse()));
-        } else if (1 == _descriptor->version()) {
+        } else if (1 == _descriptor->version() || 2 == _descriptor->version()) {
+            // v2 indexes store the same keys as v1, prefix compressed within each bucket.
             _keyGenerator.reset(new BtreeKeyGeneratorV1(fieldNames, fixed,
                 _descriptor->isSparse()));
         } else {
@@ -61,7 +61,9 @@ namespace mongo {
         : _btreeState(btreeState),
           _descriptor(btreeState->descriptor()),
           _newInterface(btree) {
-        verify(0 == _descriptor->version() || 1 == _descriptor->version());
+        verify(0 == _descriptor->version()
+               || 1 == _descriptor->version()
+               || 2 == _descriptor->version());
     }
 
     // Find the keys for obj, put them in the tree pointing to loc
@@ -630,14 +630,25 @@ namespace mongo {
                 // If a set of modifiers were all no-ops, we are still 'in place', but there is
                 // no work to do, in which case we want to consider the object unchanged.
                 if (!damages.empty() ) {
-                    collection->updateDocumentWithDamages( txn, loc, source, damages );
-                    docWasModified = true;
-                    opDebug->fastmod = true;
+                    // The record store may be unable to apply the damages where the document
+                    // is, e.g. for compressed records, in which case we rewrite it below.
+                    Status status =
+                        collection->updateDocumentWithDamages( txn, loc, source, damages );
+                    if (status.code() != ErrorCodes::CannotUpdateInPlace) {
+                        uassertStatusOK(status);
+                    }
+                    inPlace = status.isOK();
+                    if (inPlace) {
+                        docWasModified = true;
+                        opDebug->fastmod = true;
+                    }
                 }
 
-                newObj = oldObj;
+                if (inPlace)
+                    newObj = oldObj;
             }
-            else {
+
+            if (!inPlace || driver->modsAffectIndices()) {
                 // The updates were not in place. Apply them through the file manager.
 
                 // XXX: With experimental document-level locking, we do not hold the sufficient
@@ -133,6 +133,9 @@ namespace mongo {
 
             bob->append("keyPattern", spec->keyPattern);
             bob->appendBool("isMultiKey", spec->isMultiKey);
+            if (!spec->indexBounds.isEmpty()) {
+                bob->append("indexBounds", spec->indexBounds);
+            }
         }
         else if (STAGE_FETCH == stats.stageType) {
             FetchStats* spec = static_cast<FetchStats*>(stats.specific.get());
@@ -48,6 +48,7 @@
 #include "mongo/db/query/internal_plans.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/planner_analysis.h"
 #include "mongo/db/query/planner_access.h"
 #include "mongo/db/query/qlog.h"
@@ -158,6 +159,10 @@ namespace mongo {
             plannerParams->options |= QueryPlannerParams::INDEX_INTERSECTION;
         }
 
+        if (internalQueryPlannerEnableSkipScan) {
+            plannerParams->options |= QueryPlannerParams::SKIP_SCAN;
+        }
+
         plannerParams->options |= QueryPlannerParams::KEEP_MUTATIONS;
         plannerParams->options |= QueryPlannerParams::SPLIT_LIMITED_SORT;
     }
@@ -363,6 +368,11 @@ namespace mongo {
             }
         }
 
+        // Don't bother running the candidates that the index statistics rule out.
+        PlanRanker::pruneByCost(*collection->infoCache()->getIndexStats(),
+                                collection->numRecords(),
+                                &solutions);
+
         if (1 == solutions.size()) {
             LOG(2) << "Only one plan is available; it will be run but will not be cached. "
                    << canonicalQuery->toStringShort()
@@ -436,37 +446,41 @@ namespace mongo {
 
             IndexScanNode* isn = static_cast<IndexScanNode*>(root->children[0]);
 
-            // No filters allowed and side-stepping isSimpleRange for now.  TODO: do we ever see
-            // isSimpleRange here?  because we could well use it.  I just don't think we ever do see
-            // it.
-
-            if (NULL != isn->filter.get() || isn->bounds.isSimpleRange) {
+            // Side-stepping isSimpleRange for now.  TODO: do we ever see isSimpleRange here?
+            // because we could well use it.  I just don't think we ever do see it.
+            if (isn->bounds.isSimpleRange) {
                 return false;
             }
 
-            // Make sure the bounds are OK.
-            BSONObj startKey;
-            bool startKeyInclusive;
-            BSONObj endKey;
-            bool endKeyInclusive;
-
-            if (!IndexBoundsBuilder::isSingleInterval( isn->bounds,
-                                                       &startKey,
-                                                       &startKeyInclusive,
-                                                       &endKey,
-                                                       &endKeyInclusive )) {
+            // Make the count node that we replace the fetch + ixscan with.
+            auto_ptr<CountNode> cn(new CountNode());
+            cn->indexKeyPattern = isn->indexKeyPattern;
+
+            // A single interval with nothing left to check is counted by comparing cursor
+            // positions.
+            if (NULL == isn->filter.get()
+                && IndexBoundsBuilder::isSingleInterval(isn->bounds,
+                                                        &cn->startKey,
+                                                        &cn->startKeyInclusive,
+                                                        &cn->endKey,
+                                                        &cn->endKeyInclusive)) {
+                // Takes ownership of 'cn' and deletes the old root.
+                soln->root.reset(cn.release());
+                return true;
+            }
+
+            // Otherwise the count stage walks the bounds itself.  Any filter on the ixscan only
+            // needs the index key, so it comes along and we still never fetch.  The count stage
+            // only moves forwards.
+            if (1 != isn->direction) {
                 return false;
             }
 
-            // Make the count node that we replace the fetch + ixscan with.
-            CountNode* cn = new CountNode();
-            cn->indexKeyPattern = isn->indexKeyPattern;
-            cn->startKey = startKey;
-            cn->startKeyInclusive = startKeyInclusive;
-            cn->endKey = endKey;
-            cn->endKeyInclusive = endKeyInclusive;
+            cn->useBounds = true;
+            cn->bounds = isn->bounds;
+            cn->filter.swap(isn->filter);
             // Takes ownership of 'cn' and deletes the old root.
-            soln->root.reset(cn);
+            soln->root.reset(cn.release());
             return true;
         }
 
@@ -0,0 +1,198 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/query/index_stats.h"
+
+#include <algorithm>
+
+namespace mongo {
+
+    namespace {
+
+        int compareValues(const BSONElement& lhs, const BSONElement& rhs) {
+            return lhs.woCompare(rhs, false);
+        }
+
+    } // namespace
+
+    //
+    // IndexStats
+    //
+
+    double IndexStats::estimateKeys(const OrderedIntervalList& oil) const {
+        double estimate = 0;
+
+        // Values inserted since the statistics were gathered, say above the last bucket, aren't
+        // in the histogram.  So no interval counts for less than one average leading value.
+        const double keysPerValue = numDistinct > 0 ? double(numKeys) / numDistinct : 0;
+
+        for (size_t i = 0; i < oil.intervals.size(); ++i) {
+            const Interval& interval = oil.intervals[i];
+            double intervalEstimate = 0;
+
+            // The intervals of a descending scan run from high to low.
+            BSONElement low = interval.start;
+            bool lowInclusive = interval.startInclusive;
+            BSONElement high = interval.end;
+            bool highInclusive = interval.endInclusive;
+            if (compareValues(low, high) > 0) {
+                std::swap(low, high);
+                std::swap(lowInclusive, highInclusive);
+            }
+
+            for (size_t j = 0; j < buckets.size(); ++j) {
+                const Bucket& bucket = buckets[j];
+                BSONElement min = bucket.min.firstElement();
+                BSONElement max = bucket.max.firstElement();
+
+                int maxVsLow = compareValues(max, low);
+                int minVsHigh = compareValues(min, high);
+                if (maxVsLow < 0 || (0 == maxVsLow && !lowInclusive)
+                    || minVsHigh > 0 || (0 == minVsHigh && !highInclusive)) {
+                    // No overlap.
+                    continue;
+                }
+
+                int minVsLow = compareValues(min, low);
+                int maxVsHigh = compareValues(max, high);
+                bool covered = (minVsLow > 0 || (0 == minVsLow && lowInclusive))
+                               && (maxVsHigh < 0 || (0 == maxVsHigh && highInclusive));
+
+                if (interval.isPoint()) {
+                    // Assume the keys are spread evenly over the values in the bucket.
+                    intervalEstimate += double(bucket.numKeys) / bucket.numDistinct;
+                }
+                else if (covered || 1 == bucket.numDistinct) {
+                    intervalEstimate += bucket.numKeys;
+                }
+                else {
+                    // We don't know where the interval falls inside the bucket.
+                    intervalEstimate += bucket.numKeys / 2.0;
+                }
+            }
+
+            estimate += std::max(intervalEstimate, keysPerValue);
+        }
+
+        return std::min(estimate, double(numKeys));
+    }
+
+    BSONObj IndexStats::toBSON() const {
+        BSONObjBuilder bob;
+        bob.append("key", keyPattern);
+        bob.appendNumber("numRecords", numRecords);
+        bob.appendNumber("numKeys", numKeys);
+        bob.appendNumber("numDistinct", numDistinct);
+
+        BSONArrayBuilder bucketsBob(bob.subarrayStart("buckets"));
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            BSONObjBuilder bucketBob(bucketsBob.subobjStart());
+            bucketBob.appendAs(buckets[i].min.firstElement(), "min");
+            bucketBob.appendAs(buckets[i].max.firstElement(), "max");
+            bucketBob.appendNumber("numKeys", buckets[i].numKeys);
+            bucketBob.appendNumber("numDistinct", buckets[i].numDistinct);
+            bucketBob.doneFast();
+        }
+        bucketsBob.doneFast();
+
+        return bob.obj();
+    }
+
+    //
+    // IndexStatsBuilder
+    //
+
+    IndexStatsBuilder::IndexStatsBuilder(const BSONObj& keyPattern, long long keysPerBucket)
+        : _keysPerBucket(std::max(1LL, keysPerBucket)),
+          _stats(new IndexStats()) {
+        _stats->keyPattern = keyPattern.getOwned();
+    }
+
+    void IndexStatsBuilder::addKey(const BSONObj& key) {
+        BSONElement value = key.firstElement();
+        std::vector<IndexStats::Bucket>& buckets = _stats->buckets;
+
+        if (buckets.empty() || 0 != compareValues(value, _last.firstElement())) {
+            BSONObjBuilder bob;
+            bob.appendAs(value, "");
+            _last = bob.obj();
+
+            if (buckets.empty() || buckets.back().numKeys >= _keysPerBucket) {
+                buckets.push_back(IndexStats::Bucket());
+                buckets.back().min = _last;
+                buckets.back().max = _last;
+            }
+
+            // A descending index gives its values from high to low.
+            IndexStats::Bucket& bucket = buckets.back();
+            if (compareValues(value, bucket.min.firstElement()) < 0) {
+                bucket.min = _last;
+            }
+            if (compareValues(value, bucket.max.firstElement()) > 0) {
+                bucket.max = _last;
+            }
+
+            ++bucket.numDistinct;
+            ++_stats->numDistinct;
+        }
+
+        ++buckets.back().numKeys;
+        ++_stats->numKeys;
+    }
+
+    IndexStats* IndexStatsBuilder::done(long long numRecords) {
+        invariant(_stats.get());
+        _stats->numRecords = numRecords;
+        return _stats.release();
+    }
+
+    //
+    // IndexStatsCache
+    //
+
+    void IndexStatsCache::add(IndexStats* stats) {
+        boost::shared_ptr<const IndexStats> entry(stats);
+        boost::lock_guard<boost::mutex> cacheLock(_mutex);
+        _stats[entry->keyPattern] = entry;
+    }
+
+    boost::shared_ptr<const IndexStats> IndexStatsCache::get(const BSONObj& keyPattern) const {
+        boost::lock_guard<boost::mutex> cacheLock(_mutex);
+        StatsMap::const_iterator it = _stats.find(keyPattern);
+        if (it == _stats.end()) {
+            return boost::shared_ptr<const IndexStats>();
+        }
+        return it->second;
+    }
+
+    void IndexStatsCache::clear() {
+        boost::lock_guard<boost::mutex> cacheLock(_mutex);
+        _stats.clear();
+    }
+
+}  // namespace mongo
@@ -0,0 +1,150 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
+#include "mongo/db/query/index_bounds.h"
+
+namespace mongo {
+
+    /**
+     * A summary of the keys in one index, used to estimate how many keys a scan over some
+     * bounds will look at.  Gathered by the analyze command through IndexStatsBuilder.
+     *
+     * The leading field of the key is described by an equi-depth histogram.  Each bucket covers
+     * a run of adjacent leading values, and no value is split across two buckets.
+     */
+    struct IndexStats {
+        struct Bucket {
+            Bucket() : numKeys(0), numDistinct(0) { }
+
+            // The smallest and largest leading value in the bucket, as the only field of the
+            // object.
+            BSONObj min;
+            BSONObj max;
+
+            long long numKeys;
+            long long numDistinct;
+        };
+
+        IndexStats() : numRecords(0), numKeys(0), numDistinct(0) { }
+
+        /**
+         * Returns the estimated number of keys whose leading field falls in 'oil'.  Each
+         * interval counts for at least the keys of one average leading value, even where the
+         * histogram has none.
+         */
+        double estimateKeys(const OrderedIntervalList& oil) const;
+
+        BSONObj toBSON() const;
+
+        BSONObj keyPattern;
+
+        // How many documents the collection held when the statistics were gathered.
+        long long numRecords;
+
+        long long numKeys;
+
+        // How many different values the leading field has.
+        long long numDistinct;
+
+        std::vector<Bucket> buckets;
+    };
+
+    /**
+     * Builds the IndexStats for an index from its keys, which must be added in index order.
+     */
+    class IndexStatsBuilder {
+        MONGO_DISALLOW_COPYING(IndexStatsBuilder);
+    public:
+        /**
+         * A bucket is closed at the first change of leading value after it holds
+         * 'keysPerBucket' keys.
+         */
+        IndexStatsBuilder(const BSONObj& keyPattern, long long keysPerBucket);
+
+        void addKey(const BSONObj& key);
+
+        /**
+         * Returns the statistics for the keys added so far.  Caller owns the result.  Can only
+         * be called once.
+         */
+        IndexStats* done(long long numRecords);
+
+    private:
+        long long _keysPerBucket;
+
+        std::auto_ptr<IndexStats> _stats;
+
+        // The leading value of the last key added.
+        BSONObj _last;
+    };
+
+    /**
+     * Holds the statistics of the analyzed indexes of a collection, by key pattern.
+     */
+    class IndexStatsCache {
+        MONGO_DISALLOW_COPYING(IndexStatsCache);
+    public:
+        IndexStatsCache() { }
+
+        /**
+         * Adds or replaces the statistics for 'stats->keyPattern'.  Takes ownership of 'stats'.
+         */
+        void add(IndexStats* stats);
+
+        /**
+         * Returns the statistics for the index 'keyPattern', or an empty pointer if it hasn't
+         * been analyzed.
+         */
+        boost::shared_ptr<const IndexStats> get(const BSONObj& keyPattern) const;
+
+        /**
+         * Forgets all the statistics, as when the indexes change.
+         */
+        void clear();
+
+    private:
+        typedef std::map<BSONObj, boost::shared_ptr<const IndexStats>, BSONObjCmp> StatsMap;
+        StatsMap _stats;
+
+        /**
+         * Protects '_stats'.
+         */
+        mutable boost::mutex _mutex;
+    };
+
+}  // namespace mongo
@@ -0,0 +1,188 @@
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+/**
+ * This file contains tests for mongo/db/query/index_stats.h
+ */
+
+#include "mongo/db/query/index_stats.h"
+
+#include "mongo/db/jsobj.h"
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    /**
+     * Statistics for an index on {a: 1} over the values 0 to 99, each twice, in buckets of
+     * ten values.
+     */
+    IndexStats* makeStats() {
+        IndexStatsBuilder builder(BSON("a" << 1), 20);
+        for (int i = 0; i < 100; ++i) {
+            builder.addKey(BSON("" << i));
+            builder.addKey(BSON("" << i));
+        }
+        return builder.done(200);
+    }
+
+    OrderedIntervalList makeOil(const Interval& interval) {
+        OrderedIntervalList oil("a");
+        oil.intervals.push_back(interval);
+        return oil;
+    }
+
+    //
+    // IndexStatsBuilder
+    //
+
+    TEST(IndexStatsBuilderTest, FillsBuckets) {
+        auto_ptr<IndexStats> stats(makeStats());
+        ASSERT_EQUALS(stats->keyPattern, BSON("a" << 1));
+        ASSERT_EQUALS(stats->numRecords, 200);
+        ASSERT_EQUALS(stats->numKeys, 200);
+        ASSERT_EQUALS(stats->numDistinct, 100);
+        ASSERT_EQUALS(stats->buckets.size(), 10U);
+
+        const IndexStats::Bucket& bucket = stats->buckets[3];
+        ASSERT_EQUALS(bucket.min, BSON("" << 30));
+        ASSERT_EQUALS(bucket.max, BSON("" << 39));
+        ASSERT_EQUALS(bucket.numKeys, 20);
+        ASSERT_EQUALS(bucket.numDistinct, 10);
+    }
+
+    TEST(IndexStatsBuilderTest, DoesNotSplitValues) {
+        IndexStatsBuilder builder(BSON("a" << 1), 2);
+        for (int i = 0; i < 5; ++i) {
+            builder.addKey(BSON("" << 1));
+        }
+        builder.addKey(BSON("" << 2));
+        auto_ptr<IndexStats> stats(builder.done(6));
+
+        ASSERT_EQUALS(stats->buckets.size(), 2U);
+        ASSERT_EQUALS(stats->buckets[0].numKeys, 5);
+        ASSERT_EQUALS(stats->buckets[0].numDistinct, 1);
+        ASSERT_EQUALS(stats->buckets[1].numKeys, 1);
+    }
+
+    TEST(IndexStatsBuilderTest, DescendingIndex) {
+        IndexStatsBuilder builder(BSON("a" << -1), 100);
+        for (int i = 9; i >= 0; --i) {
+            builder.addKey(BSON("" << i));
+        }
+        auto_ptr<IndexStats> stats(builder.done(10));
+
+        ASSERT_EQUALS(stats->buckets.size(), 1U);
+        ASSERT_EQUALS(stats->buckets[0].min, BSON("" << 0));
+        ASSERT_EQUALS(stats->buckets[0].max, BSON("" << 9));
+    }
+
+    //
+    // IndexStats::estimateKeys
+    //
+
+    TEST(IndexStatsTest, EstimatePoint) {
+        auto_ptr<IndexStats> stats(makeStats());
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << 5 << "" << 5),
+                                                           true, true))), 2.0);
+    }
+
+    TEST(IndexStatsTest, EstimateOutsideHistogram) {
+        // Values the histogram doesn't have may have been inserted since, so they count for
+        // the average number of keys per value rather than nothing.
+        auto_ptr<IndexStats> stats(makeStats());
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << 500 << "" << 500),
+                                                           true, true))), 2.0);
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << "x" << "" << "x"),
+                                                           true, true))), 2.0);
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << 500 << "" << 600),
+                                                           true, true))), 2.0);
+    }
+
+    TEST(IndexStatsTest, EstimateCoveredBuckets) {
+        auto_ptr<IndexStats> stats(makeStats());
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << 10 << "" << 29),
+                                                           true, true))), 40.0);
+    }
+
+    TEST(IndexStatsTest, EstimatePartialBuckets) {
+        auto_ptr<IndexStats> stats(makeStats());
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << 5 << "" << 14),
+                                                           true, true))), 20.0);
+    }
+
+    TEST(IndexStatsTest, EstimateExclusiveBounds) {
+        auto_ptr<IndexStats> stats(makeStats());
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << 9 << "" << 19),
+                                                           false, true))), 20.0);
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << 10 << "" << 20),
+                                                           true, false))), 20.0);
+    }
+
+    TEST(IndexStatsTest, EstimateDescendingInterval) {
+        auto_ptr<IndexStats> stats(makeStats());
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(BSON("" << 19 << "" << 10),
+                                                           true, true))), 20.0);
+    }
+
+    TEST(IndexStatsTest, EstimateAllValues) {
+        auto_ptr<IndexStats> stats(makeStats());
+        BSONObjBuilder bob;
+        bob.appendMinKey("");
+        bob.appendMaxKey("");
+        ASSERT_EQUALS(stats->estimateKeys(makeOil(Interval(bob.obj(), true, true))), 200.0);
+    }
+
+    TEST(IndexStatsTest, EstimateSeveralIntervals) {
+        auto_ptr<IndexStats> stats(makeStats());
+        OrderedIntervalList oil("a");
+        oil.intervals.push_back(Interval(BSON("" << 5 << "" << 5), true, true));
+        oil.intervals.push_back(Interval(BSON("" << 50 << "" << 59), true, true));
+        ASSERT_EQUALS(stats->estimateKeys(oil), 22.0);
+    }
+
+    //
+    // IndexStatsCache
+    //
+
+    TEST(IndexStatsCacheTest, AddGetClear) {
+        IndexStatsCache cache;
+        ASSERT(NULL == cache.get(BSON("a" << 1)).get());
+
+        cache.add(makeStats());
+        boost::shared_ptr<const IndexStats> stats = cache.get(BSON("a" << 1));
+        ASSERT(NULL != stats.get());
+        ASSERT_EQUALS(stats->numKeys, 200);
+        ASSERT(NULL == cache.get(BSON("a" << -1)).get());
+
+        cache.clear();
+        ASSERT(NULL == cache.get(BSON("a" << 1)).get());
+    }
+
+}  // namespace
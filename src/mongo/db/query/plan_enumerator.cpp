@@ -65,6 +65,7 @@ namespace mongo {
         : _root(params.root),
           _indices(params.indices),
           _ixisect(params.intersect),
+          _skipScan(params.skipScan),
           _orLimit(params.maxSolutionsPerOr),
           _intersectLimit(params.maxIntersectPerAnd) { }
 
@@ -215,8 +216,18 @@ namespace mongo {
             // In order to definitely use an index it must be prefixed with our field.
             // We don't consider notFirst indices here because we must be AND-related to a node
             // that uses the first spot in that index, and we currently do not know that
-            // unless we're in an AND node.
-            if (0 == rt->first.size()) { return false; }
+            // unless we're in an AND node.  The exception is a skip scan, which we only
+            // consider when there's no index prefixed with our field.
+            vector<IndexID> skipScanIndices;
+            if (0 == rt->first.size() && _skipScan) {
+                for (size_t i = 0; i < rt->notFirst.size(); ++i) {
+                    if (canSkipScan(rt->notFirst[i])) {
+                        skipScanIndices.push_back(rt->notFirst[i]);
+                    }
+                }
+            }
+
+            if (0 == rt->first.size() && skipScanIndices.empty()) { return false; }
 
             // We know we can use an index, so grab a memo spot.
             size_t myMemoID;
@@ -225,7 +236,20 @@ namespace mongo {
 
             assign->pred.reset(new PredicateAssignment());
             assign->pred->expr = node;
-            assign->pred->first.swap(rt->first);
+            if (0 != rt->first.size()) {
+                assign->pred->first.swap(rt->first);
+                assign->pred->positions.resize(assign->pred->first.size(), 0);
+                return true;
+            }
+
+            vector<MatchExpression*> self(1, node);
+            for (size_t i = 0; i < skipScanIndices.size(); ++i) {
+                OneIndexAssignment indexAssign;
+                compound(self, (*_indices)[skipScanIndices[i]], &indexAssign);
+                invariant(1 == indexAssign.positions.size());
+                assign->pred->first.push_back(skipScanIndices[i]);
+                assign->pred->positions.push_back(indexAssign.positions[0]);
+            }
             return true;
         }
         else if (Indexability::isBoundsGeneratingNot(node)) {
@@ -380,10 +404,23 @@ namespace mongo {
                 }
             }
 
+            // Only skip scan when nothing can use the leading field of an index.
+            bool skipScan = false;
+            if (_skipScan && idxToFirst.empty() && NULL == mandatoryPred) {
+                for (IndexToPredMap::const_iterator it = idxToNotFirst.begin();
+                     it != idxToNotFirst.end(); ++it) {
+                    if (canSkipScan(it->first)) {
+                        skipScan = true;
+                        break;
+                    }
+                }
+            }
+
             // If none of our children can use indices, bail out.
             if (idxToFirst.empty()
                 && (subnodes.size() == 0)
-                && (mandatorySubnodes.size() == 0)) {
+                && (mandatorySubnodes.size() == 0)
+                && !skipScan) {
                 return false;
             }
 
@@ -415,6 +452,10 @@ namespace mongo {
 
             enumerateOneIndex(idxToFirst, idxToNotFirst, subnodes, andAssignment);
 
+            if (skipScan) {
+                enumerateSkipScan(idxToNotFirst, andAssignment);
+            }
+
             if (_ixisect) {
                 enumerateAndIntersect(idxToFirst, idxToNotFirst, subnodes, andAssignment);
             }
@@ -639,6 +680,45 @@ namespace mongo {
         }
     }
 
+    bool PlanEnumerator::canSkipScan(IndexID index) const {
+        const IndexEntry& entry = (*_indices)[index];
+        // Sparse indices may not have every document the predicates could match, and the other
+        // index types don't keep the fields in key order.
+        return INDEX_BTREE == entry.type && !entry.sparse;
+    }
+
+    void PlanEnumerator::enumerateSkipScan(const IndexToPredMap& idxToNotFirst,
+                                           AndAssignment* andAssignment) {
+        for (IndexToPredMap::const_iterator it = idxToNotFirst.begin();
+             it != idxToNotFirst.end(); ++it) {
+            if (!canSkipScan(it->first)) {
+                continue;
+            }
+
+            const IndexEntry& thisIndex = (*_indices)[it->first];
+
+            OneIndexAssignment indexAssign;
+            indexAssign.index = it->first;
+
+            if (thisIndex.multikey) {
+                // As for a multikey index prefixed by one of our predicates, we take one pred.
+                // Compounding preds on other fields would need the $elemMatch analysis that
+                // getMultikeyCompoundablePreds(...) does relative to an assigned leading pred.
+                vector<MatchExpression*> one(1, it->second[0]);
+                compound(one, thisIndex, &indexAssign);
+            }
+            else {
+                compound(it->second, thisIndex, &indexAssign);
+            }
+
+            invariant(!indexAssign.preds.empty());
+
+            AndEnumerableState state;
+            state.assignments.push_back(indexAssign);
+            andAssignment->choices.push_back(state);
+        }
+    }
+
     void PlanEnumerator::enumerateAndIntersect(const IndexToPredMap& idxToFirst,
                                                const IndexToPredMap& idxToNotFirst,
                                                const vector<MemoID>& subnodes,
@@ -1141,7 +1221,8 @@ namespace mongo {
             PredicateAssignment* pa = assign->pred.get();
             verify(NULL == pa->expr->getTag());
             verify(pa->indexToAssign < pa->first.size());
-            pa->expr->setTag(new IndexTag(pa->first[pa->indexToAssign]));
+            pa->expr->setTag(new IndexTag(pa->first[pa->indexToAssign],
+                                          pa->positions[pa->indexToAssign]));
         }
         else if (NULL != assign->orAssignment) {
             OrAssignment* oa = assign->orAssignment.get();
@@ -42,6 +42,7 @@ namespace mongo {
     struct PlanEnumeratorParams {
 
         PlanEnumeratorParams() : intersect(false),
+                                 skipScan(false),
                                  maxSolutionsPerOr(internalQueryEnumerationMaxOrSolutions),
                                  maxIntersectPerAnd(internalQueryEnumerationMaxIntersectPerAnd) { }
 
@@ -49,6 +50,10 @@ namespace mongo {
         // an indexed solution?
         bool intersect;
 
+        // May we use a compound index when nothing constrains its leading field, by skipping
+        // from one distinct leading value to the next?
+        bool skipScan;
+
         // Not owned here.
         MatchExpression* root;
 
@@ -177,6 +182,11 @@ namespace mongo {
             PredicateAssignment() : indexToAssign(0) { }
 
             std::vector<IndexID> first;
+
+            // Parallel to 'first': the position of the predicate's field in each index.  Only
+            // skip scans have anything other than 0 here.
+            std::vector<IndexPosition> positions;
+
             // Not owned here.
             MatchExpression* expr;
 
@@ -384,6 +394,21 @@ namespace mongo {
                                const std::vector<MemoID>& subnodes,
                                AndAssignment* andAssignment);
 
+        /**
+         * Returns true if 'index' may be used for a skip scan: a scan with no predicate on the
+         * leading field, which the index scan answers by seeking from one leading value to the
+         * next.
+         */
+        bool canSkipScan(IndexID index) const;
+
+        /**
+         * Generate one-index-at-once assignments that skip scan the indices in 'idxToNotFirst'
+         * that canSkipScan(...) accepts.  Only used when no index has a predicate over its
+         * leading field.  Outputs the assignments into 'andAssignment'.
+         */
+        void enumerateSkipScan(const IndexToPredMap& idxToNotFirst,
+                               AndAssignment* andAssignment);
+
         /**
          * Generate single-index assignments for queries which contain mandatory
          * predicates (TEXT and GEO_NEAR, which are required to use a compatible index).
@@ -434,6 +459,9 @@ namespace mongo {
         // Do we output >1 index per AND (index intersection)?
         bool _ixisect;
 
+        // Do we output skip scans of indices whose leading field isn't constrained?
+        bool _skipScan;
+
         // How many enumerations are we willing to produce from each OR?
         size_t _orLimit;
 
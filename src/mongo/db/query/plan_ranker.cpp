@@ -29,6 +29,7 @@
 #include "mongo/platform/basic.h"
 
 #include <algorithm>
+#include <limits>
 #include <math.h>
 #include <vector>
 #include <utility>
@@ -38,6 +39,7 @@
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/explain_plan.h"
+#include "mongo/db/query/index_stats.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/query/qlog.h"
@@ -272,4 +274,171 @@ namespace mongo {
         return score;
     }
 
+    namespace {
+
+        /**
+         * What the index statistics say about running a plan: how many keys and documents it
+         * looks at, and how many results it gives back.  Filters are left out, so both are
+         * upper bounds.
+         */
+        struct CostEstimate {
+            CostEstimate() : works(0), results(0), prunable(true) { }
+            double works;
+            double results;
+
+            // False if 'works' may be far above what the plan really does, as when an index
+            // scan has bounds on fields after the first that the statistics don't cover.  Such
+            // a plan can still be the one the others are held up against, but isn't pruned.
+            bool prunable;
+        };
+
+        /**
+         * Returns true if 'oil' lets every value through, in either direction.
+         */
+        bool isAllValues(const OrderedIntervalList& oil) {
+            if (1 != oil.intervals.size()) {
+                return false;
+            }
+            const Interval& interval = oil.intervals[0];
+            if (!interval.startInclusive || !interval.endInclusive) {
+                return false;
+            }
+            BSONType start = interval.start.type();
+            BSONType end = interval.end.type();
+            return (MinKey == start && MaxKey == end) || (MaxKey == start && MinKey == end);
+        }
+
+        /**
+         * Fills out 'out' for the solution tree rooted at 'node'.  Returns false if some part of
+         * the tree can't be estimated.
+         */
+        bool estimateCost(const QuerySolutionNode* node,
+                          const IndexStatsCache& stats,
+                          long long numRecords,
+                          CostEstimate* out) {
+            if (STAGE_COLLSCAN == node->getType()) {
+                out->works = numRecords;
+                out->results = numRecords;
+                return true;
+            }
+
+            if (STAGE_IXSCAN == node->getType()) {
+                const IndexScanNode* isn = static_cast<const IndexScanNode*>(node);
+                if (isn->bounds.isSimpleRange || isn->bounds.fields.empty()) {
+                    return false;
+                }
+
+                boost::shared_ptr<const IndexStats> indexStats = stats.get(isn->indexKeyPattern);
+                if (NULL == indexStats.get()) {
+                    return false;
+                }
+
+                // Only the leading field is estimated.  Scale for the documents added or removed
+                // since the statistics were gathered.  Never estimate nothing: a scan still has
+                // to look, and a zero would make every other plan look infinitely worse.
+                double keys = indexStats->estimateKeys(isn->bounds.fields[0]);
+                if (indexStats->numRecords > 0) {
+                    keys *= static_cast<double>(numRecords) / indexStats->numRecords;
+                }
+                keys = std::max(keys, 1.0);
+
+                out->works = keys;
+                out->results = keys;
+                out->prunable = true;
+                for (size_t i = 1; i < isn->bounds.fields.size(); ++i) {
+                    if (!isAllValues(isn->bounds.fields[i])) {
+                        out->prunable = false;
+                        break;
+                    }
+                }
+                return true;
+            }
+
+            if (node->children.empty()) {
+                // Text, geo and the like.
+                return false;
+            }
+
+            vector<CostEstimate> children(node->children.size());
+            for (size_t i = 0; i < node->children.size(); ++i) {
+                if (!estimateCost(node->children[i], stats, numRecords, &children[i])) {
+                    return false;
+                }
+            }
+
+            out->works = 0;
+            out->results = 0;
+            out->prunable = true;
+            for (size_t i = 0; i < children.size(); ++i) {
+                out->works += children[i].works;
+                out->results += children[i].results;
+                out->prunable = out->prunable && children[i].prunable;
+            }
+
+            if (STAGE_AND_HASH == node->getType() || STAGE_AND_SORTED == node->getType()) {
+                out->results = children[0].results;
+                for (size_t i = 1; i < children.size(); ++i) {
+                    out->results = std::min(out->results, children[i].results);
+                }
+            }
+            else if (STAGE_FETCH == node->getType()) {
+                // One document per key.
+                out->works += children[0].results;
+            }
+
+            return true;
+        }
+
+    } // namespace
+
+    // static
+    void PlanRanker::pruneByCost(const IndexStatsCache& stats,
+                                 long long numRecords,
+                                 vector<QuerySolution*>* solutions) {
+        double ratio = internalQueryPlanPruneCostRatio;
+        if (ratio <= 0 || internalQueryForceIntersectionPlans || solutions->size() < 2) {
+            return;
+        }
+
+        vector<CostEstimate> costs(solutions->size());
+        vector<bool> estimated(solutions->size(), false);
+
+        // A solution without a blocking stage is only held up against others without one, since
+        // a limit can stop it long before it does all the work estimated.
+        double cheapest = std::numeric_limits<double>::max();
+        double cheapestNonBlocking = std::numeric_limits<double>::max();
+
+        for (size_t i = 0; i < solutions->size(); ++i) {
+            const QuerySolution* soln = (*solutions)[i];
+            estimated[i] = estimateCost(soln->root.get(), stats, numRecords, &costs[i]);
+            if (!estimated[i]) {
+                continue;
+            }
+
+            cheapest = std::min(cheapest, costs[i].works);
+            if (!soln->hasBlockingStage) {
+                cheapestNonBlocking = std::min(cheapestNonBlocking, costs[i].works);
+            }
+        }
+
+        vector<QuerySolution*> kept;
+        for (size_t i = 0; i < solutions->size(); ++i) {
+            QuerySolution* soln = (*solutions)[i];
+            double bar = soln->hasBlockingStage ? cheapest : cheapestNonBlocking;
+
+            if (estimated[i] && costs[i].prunable && costs[i].works > ratio * bar) {
+                QLOG() << "Pruning plan with estimated cost " << costs[i].works
+                       << " (cheapest " << bar << "):" << endl << soln->toString();
+                LOG(2) << "Pruning query plan: " << getPlanSummary(*soln)
+                       << " estimatedCost=" << costs[i].works;
+                delete soln;
+            }
+            else {
+                kept.push_back(soln);
+            }
+        }
+
+        solutions->swap(kept);
+    }
+
 }  // namespace mongo
@@ -40,6 +40,7 @@
 namespace mongo {
 
     struct CandidatePlan;
+    class IndexStatsCache;
     struct PlanRankingDecision;
 
     /**
@@ -61,6 +62,20 @@ namespace mongo {
          * the plan. The exact value isn't meaningful except for imposing a ranking.
          */
         static double scoreTree(const PlanStageStats* stats);
+
+        /**
+         * Estimates the cost of each of 'solutions' from the index statistics in 'stats', and
+         * removes and deletes the ones estimated to cost more than
+         * internalQueryPlanPruneCostRatio times the cheapest, so that they're never run.
+         * 'numRecords' is the current size of the collection.
+         *
+         * Solutions that use an index without statistics, or a stage with no cost model, are
+         * kept.  So is the cheapest solution without a blocking stage, as it may be all that
+         * can provide a sort.
+         */
+        static void pruneByCost(const IndexStatsCache& stats,
+                                long long numRecords,
+                                std::vector<QuerySolution*>* solutions);
     };
 
     /**
@@ -31,8 +31,10 @@
 #include <algorithm>
 #include <vector>
 
+#include "mongo/db/index_names.h"
 #include "mongo/db/matcher/expression_array.h"
 #include "mongo/db/matcher/expression_geo.h"
+#include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/matcher/expression_text.h"
 #include "mongo/db/query/indexability.h"
 #include "mongo/db/query/index_bounds_builder.h"
@@ -74,6 +76,7 @@ namespace mongo {
             BSONElement natural = query.getParsed().getHint().getFieldDotted("$natural");
             if (!natural.eoo()) {
                 csn->direction = natural.numberInt() >= 0 ? 1 : -1;
+                csn->naturalOrder = true;
             }
         }
 
@@ -84,6 +87,7 @@ namespace mongo {
             BSONElement natural = sortObj.getFieldDotted("$natural");
             if (!natural.eoo()) {
                 csn->direction = natural.numberInt() >= 0 ? 1 : -1;
+                csn->naturalOrder = true;
             }
         }
 
@@ -222,8 +226,10 @@ namespace mongo {
 
         if (boundsToFillOut->fields[pos].name.empty()) {
             // The bounds will be compounded. This is OK because the
-            // plan enumerator told us that it is OK.
-            return true;
+            // plan enumerator told us that it is OK.  Only ANDed predicates can be
+            // compounded, though: OR branches on different fields of the index, which skip
+            // scans produce, each need a scan of their own.
+            return MatchExpression::AND == mergeType;
         }
         else {
             if (MatchExpression::AND == mergeType) {
@@ -849,6 +855,11 @@ namespace mongo {
             return andResult;
         }
 
+        // Some of what's left may not generate bounds but still only look at indexed fields.
+        if (STAGE_IXSCAN == andResult->getType()) {
+            moveKeyPredicatesToIndexScan(root, static_cast<IndexScanNode*>(andResult));
+        }
+
         // If there are any nodes still attached to the AND, we can't answer them using the
         // index, so we put a fetch with filter.
         if (root->numChildren() > 0) {
@@ -1170,6 +1181,96 @@ namespace mongo {
         }
     }
 
+    // static
+    bool QueryPlannerAccess::canEvaluateOnIndexKey(const MatchExpression* expr,
+                                                   const BSONObj& keyPattern) {
+        switch (expr->matchType()) {
+        case MatchExpression::AND:
+        case MatchExpression::OR:
+        case MatchExpression::NOR:
+        case MatchExpression::NOT:
+            for (size_t i = 0; i < expr->numChildren(); ++i) {
+                if (!canEvaluateOnIndexKey(expr->getChild(i), keyPattern)) {
+                    return false;
+                }
+            }
+            return true;
+        case MatchExpression::REGEX:
+        case MatchExpression::MOD:
+            break;
+        case MatchExpression::EQ:
+        case MatchExpression::LTE:
+        case MatchExpression::LT:
+        case MatchExpression::GT:
+        case MatchExpression::GTE: {
+            // A missing field is indexed as null, and arrays and the special key types compare
+            // in ways that depend on what the document actually holds.
+            const BSONElement& rhs =
+                static_cast<const ComparisonMatchExpression*>(expr)->getData();
+            if (Array == rhs.type() || jstNULL == rhs.type() || Undefined == rhs.type()
+                || MinKey == rhs.type() || MaxKey == rhs.type()) {
+                return false;
+            }
+            break;
+        }
+        case MatchExpression::MATCH_IN: {
+            const ArrayFilterEntries& entries =
+                static_cast<const InMatchExpression*>(expr)->getData();
+            if (entries.hasNull() || entries.hasEmptyArray()) {
+                return false;
+            }
+            for (BSONElementSet::const_iterator it = entries.equalities().begin();
+                 it != entries.equalities().end(); ++it) {
+                if (Array == it->type() || Undefined == it->type()
+                    || MinKey == it->type() || MaxKey == it->type()) {
+                    return false;
+                }
+            }
+            break;
+        }
+        default:
+            // $exists and $type tell null apart from missing, and the array operators need the
+            // whole array.
+            return false;
+        }
+
+        // The key only has the fields in the key pattern.
+        BSONObjIterator it(keyPattern);
+        while (it.more()) {
+            if (expr->path() == it.next().fieldName()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // static
+    void QueryPlannerAccess::moveKeyPredicatesToIndexScan(MatchExpression* root,
+                                                          IndexScanNode* isn) {
+        invariant(MatchExpression::AND == root->matchType());
+
+        // See the comment in handleFilterAnd(...) about multikey indices.  Other index types
+        // don't store the field's value in the key.
+        if (isn->indexIsMultiKey
+            || INDEX_BTREE != IndexNames::nameToType(
+                                  IndexNames::findPluginName(isn->indexKeyPattern))) {
+            return;
+        }
+
+        std::vector<MatchExpression*>* children = root->getChildVector();
+        for (size_t i = 0; i < children->size(); ) {
+            MatchExpression* child = (*children)[i];
+            if (canEvaluateOnIndexKey(child, isn->indexKeyPattern)) {
+                children->erase(children->begin() + i);
+                // Takes ownership.
+                addFilterToSolutionNode(isn, child, MatchExpression::AND);
+            }
+            else {
+                ++i;
+            }
+        }
+    }
+
     // static
     void QueryPlannerAccess::handleFilter(ScanBuildingState* scanState) {
         if (MatchExpression::OR == scanState->root->matchType()) {
@@ -373,6 +373,20 @@ namespace mongo {
         static void addFilterToSolutionNode(QuerySolutionNode* node, MatchExpression* match,
                                             MatchExpression::MatchType type);
 
+        /**
+         * Returns true if 'expr' gives the same answer when evaluated against the keys of the
+         * non-multikey btree index 'keyPattern' as it does against the document.
+         */
+        static bool canEvaluateOnIndexKey(const MatchExpression* expr,
+                                          const BSONObj& keyPattern);
+
+        /**
+         * Detaches the children of the AND 'root' that canEvaluateOnIndexKey(...) accepts and
+         * adds them to the filter of 'isn', so the index scan drops entries that can't match
+         * before anything is fetched.
+         */
+        static void moveKeyPredicatesToIndexScan(MatchExpression* root, IndexScanNode* isn);
+
         /**
          * Once a predicate is merged into the current scan, there are a few things we might
          * want to do with the filter:
@@ -120,6 +120,32 @@ namespace mongo {
         }
     }
 
+    // static
+    void QueryPlannerIXSelect::findSkipScanIndices(const unordered_set<string>& fields,
+                                                   const vector<IndexEntry>& allIndices,
+                                                   vector<IndexEntry>* out) {
+        for (size_t i = 0; i < allIndices.size(); ++i) {
+            const IndexEntry& index = allIndices[i];
+            if (INDEX_BTREE != index.type || index.sparse) {
+                continue;
+            }
+
+            BSONObjIterator it(index.keyPattern);
+            verify(it.more());
+            if (fields.end() != fields.find(it.next().fieldName())) {
+                // Prefixed by one of our fields, so findRelevantIndices(...) has it.
+                continue;
+            }
+
+            while (it.more()) {
+                if (fields.end() != fields.find(it.next().fieldName())) {
+                    out->push_back(index);
+                    break;
+                }
+            }
+        }
+    }
+
     // static
     bool QueryPlannerIXSelect::compatible(const BSONElement& elt,
                                           const IndexEntry& index,
@@ -56,6 +56,14 @@ namespace mongo {
                                         const std::vector<IndexEntry>& indices,
                                         std::vector<IndexEntry>* out);
 
+        /**
+         * Find the indices that aren't prefixed by any of 'fields' but that a skip scan could
+         * use for them: non-sparse btree indices with one of 'fields' after the leading field.
+         */
+        static void findSkipScanIndices(const unordered_set<std::string>& fields,
+                                        const std::vector<IndexEntry>& indices,
+                                        std::vector<IndexEntry>* out);
+
         /**
          * Return true if the index key pattern field 'elt' (which belongs to 'index') can be used
          * to answer the predicate 'node'.
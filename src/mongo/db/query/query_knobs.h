@@ -45,12 +45,19 @@ namespace mongo {
     // Stop working plans once a plan returns this many results.
     extern int internalQueryPlanEvaluationMaxResults;
 
+    // Candidates that the index statistics estimate to cost more than this many times the
+    // cheapest candidate aren't run at all.  Zero turns pruning off.
+    extern double internalQueryPlanPruneCostRatio;
+
     // Do we give a big ranking bonus to intersection plans?
     extern bool internalQueryForceIntersectionPlans;
 
     // Do we have ixisect on at all?
     extern bool internalQueryPlannerEnableIndexIntersection;
 
+    // Do we use compound indices whose leading field the query doesn't constrain?
+    extern bool internalQueryPlannerEnableSkipScan;
+
     //
     // plan cache
     //
@@ -89,4 +96,15 @@ namespace mongo {
     // during explodeForSort?
     extern int internalQueryMaxScansToExplode;
 
+    //
+    // Query execution.
+    //
+
+    // How many threads may read and filter the records of one collection scan?  1 or less
+    // keeps collection scans on the query's own thread.
+    extern int internalQueryExecParallelCollScanThreads;
+
+    // Collections with fewer records than this are always scanned on one thread.
+    extern int internalQueryExecParallelCollScanMinRecords;
+
 }  // namespace mongo
@@ -30,6 +30,7 @@
 
 #include "mongo/db/query/query_planner.h"
 
+#include <map>
 #include <vector>
 
 #include "mongo/client/dbclientinterface.h"   // For QueryOption_foobar
@@ -157,6 +158,66 @@ namespace mongo {
         return QueryPlannerAnalysis::analyzeDataAccess(query, params, solnRoot);
     }
 
+    /**
+     * Records in 'minPositions' the first position each index is used at by the predicates in
+     * the tagged tree 'node' that share index scans with it.  Those are the ones reached through
+     * ANDs and $elemMatch, whereas each $or branch gets scans of its own, so the $or nodes are
+     * put in 'ors' rather than descended into.
+     */
+    static void getMinIndexPositions(const MatchExpression* node,
+                                     std::map<size_t, size_t>* minPositions,
+                                     std::vector<const MatchExpression*>* ors) {
+        if (MatchExpression::OR == node->matchType()) {
+            ors->push_back(node);
+            return;
+        }
+
+        const IndexTag* tag = static_cast<const IndexTag*>(node->getTag());
+        if (NULL != tag && IndexTag::kNoIndex != tag->index) {
+            std::map<size_t, size_t>::iterator it = minPositions->find(tag->index);
+            if (minPositions->end() == it) {
+                (*minPositions)[tag->index] = tag->pos;
+            }
+            else if (tag->pos < it->second) {
+                it->second = tag->pos;
+            }
+        }
+
+        for (size_t i = 0; i < node->numChildren(); ++i) {
+            getMinIndexPositions(node->getChild(i), minPositions, ors);
+        }
+    }
+
+    /**
+     * Returns true if the tagged tree 'node' scans an index without constraining its leading
+     * field, which the index scan answers by skipping between leading values.
+     */
+    static bool usesSkipScan(const MatchExpression* node) {
+        std::vector<const MatchExpression*> ors;
+        if (MatchExpression::OR == node->matchType()) {
+            ors.push_back(node);
+        }
+        else {
+            std::map<size_t, size_t> minPositions;
+            getMinIndexPositions(node, &minPositions, &ors);
+            for (std::map<size_t, size_t>::const_iterator it = minPositions.begin();
+                 it != minPositions.end(); ++it) {
+                if (0 != it->second) {
+                    return true;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < ors.size(); ++i) {
+            for (size_t j = 0; j < ors[i]->numChildren(); ++j) {
+                if (usesSkipScan(ors[i]->getChild(j))) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
     bool providesSort(const CanonicalQuery& query, const BSONObj& kp) {
         BSONObjIterator sortIt(query.getParsed().getSort());
         BSONObjIterator kpIt(kp);
@@ -484,6 +545,10 @@ namespace mongo {
 
         if (hintIndex.isEmpty()) {
             QueryPlannerIXSelect::findRelevantIndices(fields, params.indices, &relevantIndices);
+            if (params.options & QueryPlannerParams::SKIP_SCAN) {
+                QueryPlannerIXSelect::findSkipScanIndices(fields, params.indices,
+                                                          &relevantIndices);
+            }
         }
         else {
             // Sigh.  If the hint is specified it might be using the index name.
@@ -733,11 +798,15 @@ namespace mongo {
             QLOG() << "Rated tree after text processing:" << query.root()->toString();
         }
 
+        // Did any of the indexed plans skip scan?
+        bool anySkipScan = false;
+
         // If we have any relevant indices, we try to create indexed plans.
         if (0 < relevantIndices.size()) {
             // The enumerator spits out trees tagged with IndexTag(s).
             PlanEnumeratorParams enumParams;
             enumParams.intersect = params.options & QueryPlannerParams::INDEX_INTERSECTION;
+            enumParams.skipScan = params.options & QueryPlannerParams::SKIP_SCAN;
             enumParams.root = query.root();
             enumParams.indices = &relevantIndices;
 
@@ -762,6 +831,12 @@ namespace mongo {
                 }
                 auto_ptr<PlanCacheIndexTree> autoData(cacheData);
 
+                // How well a skip scan does depends on how many distinct leading values the
+                // index has, so we always let it compete with a collscan.
+                if (usesSkipScan(rawTree)) {
+                    anySkipScan = true;
+                }
+
                 // This can fail if enumeration makes a mistake.
                 QuerySolutionNode* solnRoot =
                     QueryPlannerAccess::buildIndexedDataAccess(query, rawTree, false, relevantIndices);
@@ -909,7 +984,8 @@ namespace mongo {
         bool collscanRequested = (params.options & QueryPlannerParams::INCLUDE_COLLSCAN);
 
         // No indexed plans?  We must provide a collscan if possible or else we can't run the query.
-        bool collscanNeeded = (0 == out->size() && canTableScan);
+        // We also want one to rank against any skip scans.
+        bool collscanNeeded = ((0 == out->size() || anySkipScan) && canTableScan);
 
         if (possibleToCollscan && (collscanRequested || collscanNeeded)) {
             QuerySolution* collscan = buildCollscanSoln(query, false, params);
@@ -81,7 +81,13 @@ namespace mongo {
             // Set this if you want to handle batchSize properly with sort(). If limits on SORT
             // stages are always actually limits, then this should be left off. If they are
             // sometimes to be interpreted as batchSize, then this should be turned on.
-            SPLIT_LIMITED_SORT = 1 << 7
+            SPLIT_LIMITED_SORT = 1 << 7,
+
+            // Set this if you want to use compound indices for queries that don't constrain
+            // their leading field, seeking from one leading value to the next.  Skip scans are
+            // only considered when no index is prefixed by a predicate, and they always compete
+            // against a collscan.
+            SKIP_SCAN = 1 << 8
         };
 
         // See Options enum above.
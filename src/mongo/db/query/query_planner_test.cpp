@@ -3211,6 +3211,44 @@ namespace {
         assertSolutionExists("{cscan: {dir: 1}}");
     }
 
+    //
+    // Predicates on indexed fields that don't generate bounds
+    //
+
+    TEST_F(QueryPlannerTest, NonBoundsPredicatesFilterIndexKeys) {
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{a: 1, b: {$not: /foo/}, $nor: [{b: 3}, {b: {$mod: [2, 0]}}], c: 1}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: {c: 1}, node: {ixscan: {pattern: {a:1,b:1}, "
+                                "filter: {$and: [{b: {$not: /foo/}}, "
+                                                "{$nor: [{b: 3}, {b: {$mod: [2, 0]}}]}]}, "
+                                "bounds: {a: [[1,1,true,true]], "
+                                         "b: [['MinKey','MaxKey',true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, NonBoundsPredicatesMultikeyNeedFetch) {
+        // true means multikey
+        addIndex(BSON("a" << 1 << "b" << 1), true);
+        runQuery(fromjson("{a: 1, b: {$not: /foo/}}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: {b: {$not: /foo/}}, node: {ixscan: "
+                                "{pattern: {a:1,b:1}, filter: null}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, NonBoundsPredicatesNullAndExistsNeedFetch) {
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{a: 1, $nor: [{b: null}, {b: {$exists: false}}]}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: {$nor: [{b: null}, {b: {$exists: false}}]}, "
+                                "node: {ixscan: {pattern: {a:1,b:1}, filter: null}}}}");
+    }
+
     //
     // 2D geo negation
     // The filter b != 1 is embedded in the geoNear2d node.
@@ -4413,6 +4451,102 @@ namespace {
                                     "{fetch: {node: {ixscan: {pattern: {a: 1}}}}}}}]}}");
     }
 
+    //
+    // Skip scans
+    //
+
+    TEST_F(QueryPlannerTest, SkipScanNoLeadingPredicate) {
+        params.options |= QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, "
+                                "bounds: {a: [['MinKey','MaxKey',true,true]], "
+                                         "b: [[5,5,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanCompoundsTrailingFields) {
+        params.options |= QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1 << "c" << 1));
+        runQuery(fromjson("{b: {$gt: 1}, c: 3, d: 1}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: {d: 1}, node: "
+                                "{ixscan: {pattern: {a: 1, b: 1, c: 1}, "
+                                "bounds: {a: [['MinKey','MaxKey',true,true]], "
+                                         "b: [[1,Infinity,false,true]], "
+                                         "c: [[3,3,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanNotUsedWhenPrefixIndexExists) {
+        params.options |= QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        addIndex(BSON("c" << 1));
+        runQuery(fromjson("{b: 5, c: 1}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: {b: 5}, node: {ixscan: {pattern: {c: 1}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanNotUsedForSparseIndex) {
+        params.options |= QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1), false, true);
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanAddsCollscan) {
+        params.options = QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, "
+                                "bounds: {a: [['MinKey','MaxKey',true,true]], "
+                                         "b: [[5,5,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanInOrBranchAddsCollscan) {
+        params.options = QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{$or: [{a: 1}, {b: 5}]}"));
+
+        assertNumSolutions(2U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+        assertSolutionExists("{fetch: {filter: null, node: {or: {nodes: ["
+                                "{ixscan: {pattern: {a: 1, b: 1}, "
+                                    "bounds: {a: [[1,1,true,true]], "
+                                             "b: [['MinKey','MaxKey',true,true]]}}}, "
+                                "{ixscan: {pattern: {a: 1, b: 1}, "
+                                    "bounds: {a: [['MinKey','MaxKey',true,true]], "
+                                             "b: [[5,5,true,true]]}}}]}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanNoCollscanWhenLeadingFieldUsed) {
+        params.options = QueryPlannerParams::SKIP_SCAN;
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{a: 1, b: 5}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{fetch: {filter: null, node: {ixscan: {pattern: {a: 1, b: 1}, "
+                                "bounds: {a: [[1,1,true,true]], b: [[5,5,true,true]]}}}}}");
+    }
+
+    TEST_F(QueryPlannerTest, SkipScanOffWithoutOption) {
+        addIndex(BSON("a" << 1 << "b" << 1));
+        runQuery(fromjson("{b: 5}"));
+
+        assertNumSolutions(1U);
+        assertSolutionExists("{cscan: {dir: 1}}");
+    }
+
     //
     // Test bad input to query planner helpers.
     //
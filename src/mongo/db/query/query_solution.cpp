@@ -96,7 +96,10 @@ namespace mongo {
     // CollectionScanNode
     //
 
-    CollectionScanNode::CollectionScanNode() : tailable(false), direction(1), maxScan(0) { }
+    CollectionScanNode::CollectionScanNode() : tailable(false),
+                                               direction(1),
+                                               naturalOrder(false),
+                                               maxScan(0) { }
 
     void CollectionScanNode::appendToString(mongoutils::str::stream* ss, int indent) const {
         addIndent(ss, indent);
@@ -118,6 +121,7 @@ namespace mongo {
         copy->name = this->name;
         copy->tailable = this->tailable;
         copy->direction = this->direction;
+        copy->naturalOrder = this->naturalOrder;
         copy->maxScan = this->maxScan;
 
         return copy;
@@ -841,10 +845,19 @@ namespace mongo {
         *ss << "COUNT\n";
         addIndent(ss, indent + 1);
         *ss << "keyPattern = " << indexKeyPattern << '\n';
+        if (NULL != filter) {
+            addIndent(ss, indent + 1);
+            *ss << "filter = " << filter->toString();
+        }
         addIndent(ss, indent + 1);
-        *ss << "startKey = " << startKey << '\n';
-        addIndent(ss, indent + 1);
-        *ss << "endKey = " << endKey << '\n';
+        if (useBounds) {
+            *ss << "bounds = " << bounds.toString() << '\n';
+        }
+        else {
+            *ss << "startKey = " << startKey << '\n';
+            addIndent(ss, indent + 1);
+            *ss << "endKey = " << endKey << '\n';
+        }
     }
 
     QuerySolutionNode* CountNode::clone() const {
@@ -857,6 +870,8 @@ namespace mongo {
         copy->startKeyInclusive = this->startKeyInclusive;
         copy->endKey = this->endKey;
         copy->endKeyInclusive = this->endKeyInclusive;
+        copy->useBounds = this->useBounds;
+        copy->bounds = this->bounds;
 
         return copy;
     }
@@ -267,6 +267,10 @@ namespace mongo {
 
         int direction;
 
+        // True if the query asked for $natural order by hint or sort, so the documents have to
+        // come back in the order the collection stores them.
+        bool naturalOrder;
+
         // maxScan option to .find() limits how many docs we look at.
         int maxScan;
     };
@@ -694,10 +698,10 @@ namespace mongo {
 
     /**
      * Some count queries reduce to counting how many keys are between two entries in a
-     * Btree.
+     * Btree, or within some index bounds.  Any filter is applied to the index keys.
      */
     struct CountNode : public QuerySolutionNode {
-        CountNode() { }
+        CountNode() : useBounds(false) { }
         virtual ~CountNode() { }
 
         virtual StageType getType() const { return STAGE_COUNT; }
@@ -719,6 +723,10 @@ namespace mongo {
 
         BSONObj endKey;
         bool endKeyInclusive;
+
+        // If true, count over 'bounds' rather than from startKey to endKey.
+        bool useBounds;
+        IndexBounds bounds;
     };
 
 }  // namespace mongo
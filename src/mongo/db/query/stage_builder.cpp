@@ -41,6 +41,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/s2near.h"
 #include "mongo/db/exec/shard_filter.h"
@@ -48,6 +49,7 @@
 #include "mongo/db/exec/skip.h"
 #include "mongo/db/exec/text.h"
 #include "mongo/db/index/fts_access_method.h"
+#include "mongo/db/query/query_knobs.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 
@@ -65,6 +67,22 @@ namespace mongo {
             params.direction = (csn->direction == 1) ? CollectionScanParams::FORWARD
                                                      : CollectionScanParams::BACKWARD;
             params.maxScan = csn->maxScan;
+
+            // Without an order to keep, a big enough collection can be read and filtered on
+            // several threads.
+            if (internalQueryExecParallelCollScanThreads > 1
+                && NULL != collection
+                && !collection->isCapped()
+                && !csn->naturalOrder
+                && !csn->tailable
+                && 0 == csn->maxScan
+                && static_cast<long long>(collection->numRecords())
+                   >= internalQueryExecParallelCollScanMinRecords
+                && ParallelCollectionScan::canFilterInParallel(csn->filter.get())) {
+                return new ParallelCollectionScan(params, ws, csn->filter.get(),
+                                                  internalQueryExecParallelCollScanThreads);
+            }
+
             return new CollectionScan(params, ws, csn->filter.get());
         }
         else if (STAGE_IXSCAN == root->getType()) {
@@ -293,6 +311,9 @@ namespace mongo {
             params.startKeyInclusive = cn->startKeyInclusive;
             params.endKey = cn->endKey;
             params.endKeyInclusive = cn->endKeyInclusive;
+            params.useBounds = cn->useBounds;
+            params.bounds = cn->bounds;
+            params.filter = cn->filter.get();
 
             return new Count(params, ws);
         }
@@ -0,0 +1,222 @@
+// record_scrubber.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/record_scrubber.h"
+
+#include <deque>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_catalog_entry.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/client.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/d_concurrency.h"
+#include "mongo/db/operation_context_impl.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/structure/record_store.h"
+#include "mongo/util/background.h"
+#include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/crc32c.h"
+#include "mongo/util/log.h"
+#include "mongo/util/time_support.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    MONGO_LOG_DEFAULT_COMPONENT_FILE(::mongo::logger::LogComponent::kStorage);
+
+    MONGO_EXPORT_SERVER_PARAMETER( recordScrubberEnabled, bool, true );
+
+    // how fast to check records, so the scrubber doesn't compete with the workload for i/o
+    MONGO_EXPORT_SERVER_PARAMETER( recordScrubberRecordsPerSecond, int, 10000 );
+
+namespace {
+
+    Counter64 scrubberPasses;
+    Counter64 scrubberRecordsChecked;
+    Counter64 scrubberRecordsWithoutChecksum;
+    Counter64 scrubberMismatches;
+
+    // the most recent mismatches, for serverStatus
+    const size_t MaxRecentMismatches = 10;
+    SimpleMutex recentMismatchesMutex( "recordScrubber" );
+    std::deque<BSONObj> recentMismatches;
+
+    void noteMismatch( const std::string& ns, const DiskLoc& loc ) {
+        error() << "record checksum mismatch in " << ns << " at " << loc
+                << ", the record may be corrupt. Run validate with full:true for details";
+
+        BSONObj info = BSON( "ns" << ns
+                             << "loc" << loc.toString()
+                             << "time" << jsTime() );
+
+        SimpleMutex::scoped_lock lk( recentMismatchesMutex );
+        recentMismatches.push_back( info );
+        if ( recentMismatches.size() > MaxRecentMismatches )
+            recentMismatches.pop_front();
+    }
+
+    class RecordScrubber : public BackgroundJob {
+    public:
+        virtual std::string name() const { return "RecordScrubber"; }
+
+        virtual void run() {
+            Client::initThread( name().c_str() );
+
+            while ( !inShutdown() ) {
+                sleepsecs( 60 );
+
+                if ( !recordScrubberEnabled )
+                    continue;
+
+                std::set<std::string> dbs;
+                dbHolder().getAllShortNames( dbs );
+
+                for ( std::set<std::string>::const_iterator i = dbs.begin(); i != dbs.end(); ++i ) {
+                    try {
+                        scrubDatabase( *i );
+                    }
+                    catch ( const DBException& e ) {
+                        error() << "error scrubbing records of db: " << *i << " " << e;
+                    }
+                }
+
+                scrubberPasses.increment();
+            }
+        }
+
+    private:
+        void scrubDatabase( const std::string& dbName ) {
+            std::list<std::string> namespaces;
+            {
+                OperationContextImpl txn;
+                Lock::DBRead lk( txn.lockState(), dbName );
+                Database* db = dbHolder().get( &txn, dbName );
+                if ( !db )
+                    return;
+                db->getDatabaseCatalogEntry()->getCollectionNamespaces( &namespaces );
+            }
+
+            for ( std::list<std::string>::const_iterator i = namespaces.begin();
+                  i != namespaces.end() && recordScrubberEnabled && !inShutdown();
+                  ++i ) {
+                scrubCollection( dbName, *i );
+            }
+        }
+
+        /**
+         * Takes the lock for a batch of records at a time and sleeps in between, long enough
+         * to keep to recordScrubberRecordsPerSecond.
+         */
+        void scrubCollection( const std::string& dbName, const std::string& ns ) {
+            ScrubState state;
+            for ( bool done = false; !done; ) {
+                if ( !recordScrubberEnabled || inShutdown() )
+                    return;
+
+                const int rate = std::max( 1, static_cast<int>( recordScrubberRecordsPerSecond ) );
+                const int batchSize = std::min( std::max( 1, rate / 10 ), 1000 );
+
+                const ScrubState before = state;
+                std::vector<DiskLoc> corrupt;
+                Timer t;
+                {
+                    OperationContextImpl txn;
+                    Lock::DBRead lk( txn.lockState(), ns );
+                    Database* db = dbHolder().get( &txn, dbName );
+                    if ( !db )
+                        return;
+                    Collection* collection = db->getCollection( &txn, ns );
+                    if ( !collection )
+                        return; // dropped
+
+                    StatusWith<bool> status =
+                        collection->getRecordStore()->scrubRecords( &txn,
+                                                                    batchSize,
+                                                                    &state,
+                                                                    &corrupt );
+                    if ( !status.isOK() )
+                        return; // no checksums in this kind of store
+                    done = status.getValue();
+                }
+
+                scrubberRecordsChecked.increment( state.recordsChecked - before.recordsChecked );
+                scrubberRecordsWithoutChecksum.increment( state.recordsWithoutChecksum -
+                                                          before.recordsWithoutChecksum );
+                scrubberMismatches.increment( state.mismatches - before.mismatches );
+                for ( size_t i = 0; i < corrupt.size(); i++ )
+                    noteMismatch( ns, corrupt[i] );
+
+                const long long scrubbed = ( state.recordsChecked - before.recordsChecked ) +
+                    ( state.recordsWithoutChecksum - before.recordsWithoutChecksum );
+                const long long sleepMillis = scrubbed * 1000 / rate - t.millis();
+                if ( sleepMillis > 0 )
+                    sleepmillis( sleepMillis );
+            }
+        }
+    };
+
+    class RecordScrubberSSS : public ServerStatusSection {
+    public:
+        RecordScrubberSSS() : ServerStatusSection( "recordScrubber" ){}
+        virtual bool includeByDefault() const { return true; }
+
+        BSONObj generateSection(const BSONElement& configElement) const {
+            BSONObjBuilder b;
+            b.appendBool( "enabled", recordScrubberEnabled );
+            b.appendBool( "hardwareCrc32c", crc32cIsHardwareAccelerated() );
+            b.appendNumber( "passes", scrubberPasses.get() );
+            b.appendNumber( "recordsChecked", scrubberRecordsChecked.get() );
+            b.appendNumber( "recordsWithoutChecksum", scrubberRecordsWithoutChecksum.get() );
+            b.appendNumber( "mismatches", scrubberMismatches.get() );
+
+            BSONArrayBuilder recent( b.subarrayStart( "recentMismatches" ) );
+            {
+                SimpleMutex::scoped_lock lk( recentMismatchesMutex );
+                for ( size_t i = 0; i < recentMismatches.size(); i++ )
+                    recent.append( recentMismatches[i] );
+            }
+            recent.done();
+
+            return b.obj();
+        }
+    } recordScrubberSSS;
+
+} // namespace
+
+    void startRecordScrubber() {
+        RecordScrubber* scrubber = new RecordScrubber();
+        scrubber->go();
+    }
+}
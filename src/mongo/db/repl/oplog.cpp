@@ -98,10 +98,14 @@ namespace repl {
     }
 
     // so we can fail the same way
-    void checkOplogInsert( StatusWith<DiskLoc> result ) {
+    void checkOplogInsert( const Status& status ) {
         massert( 17322,
-                 str::stream() << "write to oplog failed: " << result.getStatus().toString(),
-                 result.isOK() );
+                 str::stream() << "write to oplog failed: " << status.toString(),
+                 status.isOK() );
+    }
+
+    void checkOplogInsert( StatusWith<DiskLoc> result ) {
+        checkOplogInsert( result.getStatus() );
     }
 
     static void _logOpUninitialized(OperationContext* txn,
@@ -115,6 +119,49 @@ namespace repl {
         uassert(13288, "replSet error write op to db before replSet initialized", str::startsWith(ns, "local.") || *opstr == 'n');
     }
 
+    /** opens local.oplog.rs the first time through */
+    static void _openOplogRS(OperationContext* txn) {
+        if ( localOplogRSCollection == 0 ) {
+            Client::Context ctx(txn, rsoplog);
+
+            localDB = ctx.db();
+            verify( localDB );
+            localOplogRSCollection = localDB->getCollection( txn, rsoplog );
+            massert(13389,
+                    "local.oplog.rs missing. did you drop it? if so restart server",
+                    localOplogRSCollection);
+        }
+    }
+
+    /** bookkeeping for an op a secondary has just written to its oplog */
+    static void _opWrittenRS(Client* client, const BSONObj& op) {
+        const OpTime ts = op["ts"]._opTime();
+        long long h = op["h"].numberLong();
+
+        /* todo: now() has code to handle clock skew.  but if the skew server to server is large it will get unhappy.
+                 this code (or code in now() maybe) should be improved.
+                 */
+        if( theReplSet ) {
+            if( !(theReplSet->lastOpTimeWritten<ts) ) {
+                log() << "replication oplog stream went back in time. previous timestamp: "
+                      << theReplSet->lastOpTimeWritten << " newest timestamp: " << ts
+                      << ". attempting to sync directly from primary." << endl;
+                BSONObjBuilder result;
+                Status status =
+                        theReplSet->forceSyncFrom(theReplSet->box.getPrimary()->fullName(),
+                                                  &result);
+                if (!status.isOK()) {
+                    log() << "Can't sync from primary: " << status;
+                }
+            }
+            theReplSet->lastOpTimeWritten = ts;
+            theReplSet->lastH = h;
+            client->setLastOp( ts );
+
+            BackgroundSync::notify();
+        }
+    }
+
     /** write an op to the oplog that is already built.
         todo : make _logOpRS() call this so we don't repeat ourself?
         */
@@ -125,48 +172,79 @@ namespace repl {
         // We can't do this yet due to locking limitations.
         WriteUnitOfWork wunit(txn.recoveryUnit());
 
-        const OpTime ts = op["ts"]._opTime();
-        long long h = op["h"].numberLong();
-
         {
-            if ( localOplogRSCollection == 0 ) {
-                Client::Context ctx(&txn, rsoplog);
-
-                localDB = ctx.db();
-                verify( localDB );
-                localOplogRSCollection = localDB->getCollection( &txn, rsoplog );
-                massert(13389,
-                        "local.oplog.rs missing. did you drop it? if so restart server",
-                        localOplogRSCollection);
-            }
+            _openOplogRS(&txn);
             Client::Context ctx(&txn, rsoplog, localDB);
             checkOplogInsert( localOplogRSCollection->insertDocument( &txn, op, false ) );
+            _opWrittenRS(ctx.getClient(), op);
+        }
 
-            /* todo: now() has code to handle clock skew.  but if the skew server to server is large it will get unhappy.
-                     this code (or code in now() maybe) should be improved.
-                     */
-            if( theReplSet ) {
-                if( !(theReplSet->lastOpTimeWritten<ts) ) {
-                    log() << "replication oplog stream went back in time. previous timestamp: "
-                          << theReplSet->lastOpTimeWritten << " newest timestamp: " << ts
-                          << ". attempting to sync directly from primary." << endl;
-                    BSONObjBuilder result;
-                    Status status =
-                            theReplSet->forceSyncFrom(theReplSet->box.getPrimary()->fullName(),
-                                                      &result);
-                    if (!status.isOK()) {
-                        log() << "Can't sync from primary: " << status;
-                    }
+        setNewOptime(op["ts"]._opTime());
+        wunit.commit();
+    }
+
+    /** writes an oplog entry that is already built, as is */
+    class BuiltOplogDocWriter : public DocWriter {
+    public:
+        explicit BuiltOplogDocWriter( const BSONObj& op ) : _op( op ) {}
+
+        void writeDocument( char* start ) const {
+            memcpy( start, _op.objdata(), _op.objsize() );
+        }
+
+        size_t documentSize() const {
+            return _op.objsize();
+        }
+
+    private:
+        BSONObj _op;
+    };
+
+    void _logOpObjsRS(const std::deque<BSONObj>& ops) {
+        if ( ops.empty() )
+            return;
+
+        OperationContextImpl txn;
+        Lock::DBWrite lk(txn.lockState(), "local");
+        WriteUnitOfWork wunit(txn.recoveryUnit());
+
+        {
+            _openOplogRS(&txn);
+            Client::Context ctx(&txn, rsoplog, localDB);
+
+            if ( localOplogRSCollection->getIndexCatalog()->numIndexesTotal() != 0 ) {
+                // someone indexed the oplog, only insertDocument keeps indexes up to date
+                for ( std::deque<BSONObj>::const_iterator it = ops.begin();
+                      it != ops.end();
+                      ++it ) {
+                    _logOpObjRS(*it);
                 }
-                theReplSet->lastOpTimeWritten = ts;
-                theReplSet->lastH = h;
-                ctx.getClient()->setLastOp( ts );
+                wunit.commit();
+                return;
+            }
 
-                BackgroundSync::notify();
+            std::vector<BuiltOplogDocWriter> writers;
+            writers.reserve( ops.size() );
+            std::vector<const DocWriter*> docs;
+            for ( std::deque<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it ) {
+                writers.push_back( BuiltOplogDocWriter( *it ) );
+                docs.push_back( &writers.back() );
             }
+            std::vector<DiskLoc> locs( ops.size() );
+
+            // the oplog's record store appends them together while they fit before the
+            // wraparound point
+            checkOplogInsert( localOplogRSCollection->insertDocuments( &txn,
+                                                                       &docs[0],
+                                                                       docs.size(),
+                                                                       &locs[0],
+                                                                       false ) );
+
+            for ( std::deque<BSONObj>::const_iterator it = ops.begin(); it != ops.end(); ++it )
+                _opWrittenRS(ctx.getClient(), *it);
         }
 
-        setNewOptime(ts);
+        setNewOptime(ops.back()["ts"]._opTime());
         wunit.commit();
     }
 
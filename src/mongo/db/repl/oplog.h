@@ -29,6 +29,7 @@
 #pragma once
 
 #include <cstddef>
+#include <deque>
 #include <string>
 
 namespace mongo {
@@ -54,6 +55,9 @@ namespace repl {
     // used internally by replication secondaries after they have applied an op
     void _logOpObjRS(const BSONObj& op);
 
+    // The same for several ops at once, which go into the oplog together
+    void _logOpObjsRS(const std::deque<BSONObj>& ops);
+
     const char rsoplog[] = "local.oplog.rs";
 
     /** Log an operation to the local oplog 
@@ -489,12 +489,9 @@ namespace repl {
             Lock::DBWrite lk(txn.lockState(), "local");
             WriteUnitOfWork wunit(txn.recoveryUnit());
 
-            while (!ops->empty()) {
-                const BSONObj& op = ops->front();
-                // this updates theReplSet->lastOpTimeWritten
-                _logOpObjRS(op);
-                ops->pop_front();
-             }
+            // this updates theReplSet->lastOpTimeWritten
+            _logOpObjsRS(*ops);
+            ops->clear();
             wunit.commit();
         }
 
@@ -33,6 +33,7 @@
 #include <set>
 
 #include "mongo/db/catalog/index_catalog_entry.h"
+#include "mongo/db/structure/heap_slab_allocator.h"
 
 
 namespace mongo {
@@ -182,6 +183,39 @@ namespace {
 
     typedef std::set<IndexEntry, IndexEntryComparison> IndexSet;
 
+    /**
+     * The entries of one index. Stored keys point into blocks from 'keyAllocator' rather than
+     * each owning a separately allocated buffer.
+     */
+    struct IndexData {
+        IndexData(Ordering order) : entries(IndexEntryComparison(order)) {}
+
+        ~IndexData() {
+            clear();
+        }
+
+        BSONObj copyKey(const BSONObj& key) {
+            char* buf = keyAllocator.allocate(key.objsize());
+            memcpy(buf, key.objdata(), key.objsize());
+            return BSONObj(buf);
+        }
+
+        void freeKey(const BSONObj& key) {
+            keyAllocator.free(const_cast<char*>(key.objdata()), key.objsize());
+        }
+
+        void clear() {
+            for (IndexSet::const_iterator it = entries.begin(); it != entries.end(); ++it) {
+                freeKey(it->key);
+            }
+            entries.clear();
+        }
+
+        // declared first so it outlives the keys in 'entries'
+        HeapSlabAllocator keyAllocator;
+        IndexSet entries;
+    };
+
     // taken from btree_logic.cpp
     Status dupKeyError(const BSONObj& key) {
         StringBuilder sb;
@@ -202,11 +236,11 @@ namespace {
 
     class Heap1BtreeBuilderImpl : public BtreeBuilderInterface {
     public:
-        Heap1BtreeBuilderImpl(IndexSet* data, bool dupsAllowed)
+        Heap1BtreeBuilderImpl(IndexData* data, bool dupsAllowed)
                 : _data(data),
                   _dupsAllowed(dupsAllowed),
                   _committed(false) {
-            invariant(_data->empty());
+            invariant(_data->entries.empty());
         }
 
         ~Heap1BtreeBuilderImpl() {
@@ -223,27 +257,27 @@ namespace {
 
             // TODO optimization: dup check can assume dup is only possible with last inserted key
             // and avoid the log(n) lookup.
-            if (!_dupsAllowed && isDup(*_data, key, loc))
+            if (!_dupsAllowed && isDup(_data->entries, key, loc))
                 return dupKeyError(key);
 
-            _data->insert(_data->end(), IndexEntry(key.getOwned(), loc));
+            _data->entries.insert(_data->entries.end(), IndexEntry(_data->copyKey(key), loc));
             return Status::OK();
         }
 
         unsigned long long commit(bool mayInterrupt) {
             _committed = true;
-            return _data->size();
+            return _data->entries.size();
         }
 
     private:
-        IndexSet* const _data;
+        IndexData* const _data;
         const bool _dupsAllowed;
         bool _committed;
     };
 
     class Heap1BtreeImpl : public BtreeInterface {
     public:
-        Heap1BtreeImpl(const IndexCatalogEntry& info, IndexSet* data) 
+        Heap1BtreeImpl(const IndexCatalogEntry& info, IndexData* data) 
             : _info(info),
               _data(data)
         {}
@@ -261,10 +295,12 @@ namespace {
             invariant(!hasFieldNames(key));
 
             // TODO optimization: save the iterator from the dup-check to speed up insert
-            if (!dupsAllowed && isDup(*_data, key, loc))
+            if (!dupsAllowed && isDup(_data->entries, key, loc))
                 return dupKeyError(key);
 
-            _data->insert(IndexEntry(key.getOwned(), loc));
+            const BSONObj storedKey = _data->copyKey(key);
+            if (!_data->entries.insert(IndexEntry(storedKey, loc)).second)
+                _data->freeKey(storedKey); // already indexed
             return Status::OK();
         }
 
@@ -273,26 +309,30 @@ namespace {
             invariant(loc.isValid());
             invariant(!hasFieldNames(key));
 
-            const size_t numDeleted = _data->erase(IndexEntry(key, loc));
-            invariant(numDeleted <= 1);
-            return numDeleted == 1;
-            
+            const IndexSet::iterator it = _data->entries.find(IndexEntry(key, loc));
+            if (it == _data->entries.end())
+                return false;
+
+            const BSONObj storedKey = it->key;
+            _data->entries.erase(it);
+            _data->freeKey(storedKey);
+            return true;
         }
 
         virtual void fullValidate(long long *numKeysOut) {
             // TODO check invariants?
-            *numKeysOut = _data->size();
+            *numKeysOut = _data->entries.size();
         }
 
         virtual Status dupKeyCheck(const BSONObj& key, const DiskLoc& loc) {
             invariant(!hasFieldNames(key));
-            if (isDup(*_data, key, loc))
+            if (isDup(_data->entries, key, loc))
                 return dupKeyError(key);
             return Status::OK();
         }
 
         virtual bool isEmpty() {
-            return _data->empty();
+            return _data->entries.empty();
         }
 
         virtual Status touch(OperationContext* txn) const{
@@ -373,7 +413,8 @@ namespace {
                     return;
                 }
 
-                _savedKey = _it->key;
+                // the stored key may be freed by an unindex during the yield
+                _savedKey = _it->key.getOwned();
                 _savedLoc = _it->loc;
             }
 
@@ -470,7 +511,8 @@ namespace {
                     return;
                 }
 
-                _savedKey = _it->key;
+                // the stored key may be freed by an unindex during the yield
+                _savedKey = _it->key.getOwned();
                 _savedLoc = _it->loc;
             }
 
@@ -510,10 +552,10 @@ namespace {
 
         virtual BtreeInterface::Cursor* newCursor(int direction) const {
             if (direction == 1)
-                return new ForwardCursor(*_data);
+                return new ForwardCursor(_data->entries);
 
             invariant(direction == -1);
-            return new ReverseCursor(*_data);
+            return new ReverseCursor(_data->entries);
         }
 
         virtual Status initAsEmpty(OperationContext* txn) {
@@ -523,7 +565,7 @@ namespace {
 
     private:
         const IndexCatalogEntry& _info;
-        IndexSet* _data;
+        IndexData* _data;
     };
 } // namespace
 
@@ -533,9 +575,9 @@ namespace {
         invariant(info);
         invariant(dataInOut);
         if (!*dataInOut) {
-            *dataInOut = boost::make_shared<IndexSet>(IndexEntryComparison(info->ordering()));
+            *dataInOut = boost::make_shared<IndexData>(info->ordering());
         }
-        return new Heap1BtreeImpl(*info, static_cast<IndexSet*>(dataInOut->get()));
+        return new Heap1BtreeImpl(*info, static_cast<IndexData*>(dataInOut->get()));
     }
 
 }  // namespace mongo
@@ -54,17 +54,25 @@
 
      READLOCK dbMutex (big 'R')
      LOCK groupCommitMutex
-       PREPLOGBUFFER()
-     READLOCK mmmutex
+       PREPLOGBUFFER()                   // into a free JournalGroup buffer
        commitJob.reset()
      UNLOCK dbMutex                      // now other threads can write
+       queue the group for the journal writer thread
+     UNLOCK groupCommitMutex
+
+   journal writer thread, for each queued group in order:
+     READLOCK mmmutex
        WRITETOJOURNAL()
+       notify j:true waiters of the group
        WRITETODATAFILES()
      UNLOCK mmmutex
-     UNLOCK groupCommitMutex
+
+   so the next group's PREPLOGBUFFER overlaps this one's WRITETOJOURNAL.  there are two group
+   buffers, so at most one group waits while another is written.
 
    every Nth groupCommit, at the end, we REMAPPRIVATEVIEW() at the end of the work. because of
-   that we are in W lock for that groupCommit, which is nonideal of course.
+   that we are in W lock for that groupCommit, which is nonideal of course.  that path first
+   waits for the journal writer to finish its queue, as remapping needs everything applied.
 
    @see https://docs.google.com/drawings/edit?id=1TklsmZzm7ohIZkwgeK6rMvsdaR13KjtJYMsfLr175Zc
 */
@@ -100,8 +108,8 @@ namespace mongo {
     namespace dur {
 
         void PREPLOGBUFFER(JSectHeader& outParm, AlignedBuilder&);
-        void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed);
-        void WRITETODATAFILES(const JSectHeader& h, AlignedBuilder& uncompressed);
+        void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed, Stats::S* s);
+        void WRITETODATAFILES(const JSectHeader& h, AlignedBuilder& uncompressed, Stats::S* s);
 
         /** declared later in this file
             only used in this file -- use DurableInterface::commitNow() outside
@@ -116,7 +124,20 @@ namespace mongo {
             memset(this, 0, sizeof(*this));
         }
 
-        Stats::Stats() {
+        void Stats::S::add(const S& other) {
+            _commits += other._commits;
+            _earlyCommits += other._earlyCommits;
+            _journaledBytes += other._journaledBytes;
+            _uncompressedBytes += other._uncompressedBytes;
+            _writeToDataFilesBytes += other._writeToDataFilesBytes;
+            _prepLogBufferMicros += other._prepLogBufferMicros;
+            _writeToJournalMicros += other._writeToJournalMicros;
+            _writeToDataFilesMicros += other._writeToDataFilesMicros;
+            _remapPrivateViewMicros += other._remapPrivateViewMicros;
+            _commitsInWriteLock += other._commitsInWriteLock;
+        }
+
+        Stats::Stats() : _mutex("durStats") {
             _a.reset();
             _b.reset();
             curr = &_a;
@@ -179,13 +200,19 @@ namespace mongo {
             unsigned long long dt = now - _lastRotate;
             if( dt >= _intervalMicros && _intervalMicros ) {
                 // rotate
+                SimpleMutex::scoped_lock lk(_mutex);
                 curr->_dtMillis = (unsigned) (dt/1000);
                 _lastRotate = now;
+                other()->reset();
                 curr = other();
-                curr->reset();
             }
         }
 
+        void Stats::publish(const S& delta) {
+            SimpleMutex::scoped_lock lk(_mutex);
+            curr->add(delta);
+        }
+
         void* NonDurableImpl::writingPtr(void *x, unsigned len) { 
             return x; 
         }
@@ -227,8 +254,20 @@ namespace mongo {
             return true;
         }
 
+        // getlasterror j:true callers ask durThread to commit now rather than at its next interval
+        static mongo::mutex commitRequestMutex("commitRequest");
+        static boost::condition commitRequestCond;
+        static bool commitRequested = false;
+
         bool DurableImpl::awaitCommit() {
-            commitJob._notify.awaitBeyondNow();
+            // same as _notify.awaitBeyondNow(), but wake durThread once we hold our place
+            NotifyAll::When e = commitJob._notify.now();
+            {
+                scoped_lock lk(commitRequestMutex);
+                commitRequested = true;
+                commitRequestCond.notify_one();
+            }
+            commitJob._notify.waitFor(e + 1);
             return true;
         }
 
@@ -556,16 +595,133 @@ namespace mongo {
             stats.curr->_remapPrivateViewMicros += t.micros();
         }
 
-        // this is a pseudo-local variable in the groupcommit functions 
-        // below.  however we don't truly do that so that we don't have to 
-        // reallocate, and more importantly regrow it, on every single commit.
-        static AlignedBuilder __theBuilder(4 * 1024 * 1024);
+        /** a group commit's journal section, ready for WRITETOJOURNAL */
+        struct JournalGroup : boost::noncopyable {
+            // the buffer is kept between commits so we don't have to reallocate, and more
+            // importantly regrow it, on every single commit.
+            JournalGroup() : ab(4 * 1024 * 1024), commitNumber(0), queued(false) { }
 
-        static bool _groupCommitWithLimitedLocks(OperationContext* txn) {
-            AlignedBuilder &ab = __theBuilder;
+            JSectHeader h;
+            AlignedBuilder ab;
+            NotifyAll::When commitNumber;   // acknowledged once h/ab reach the journal
+            bool queued;                    // handed to the journal writer and not done yet
+        };
+
+        /** Journals and applies groups prepared by groupCommitWithLimitedLocks() on its own
+            thread, in the order they were queued.  See top of file.
+        */
+        class JournalWriter : boost::noncopyable {
+        public:
+            JournalWriter() : _mutex("journalWriter"), _fill(0), _write(0) { }
+
+            /** wait until the group the next commit will prepare is free */
+            void awaitFreeGroup() {
+                scoped_lock lk(_mutex);
+                while( _groups[_fill].queued )
+                    _changed.wait(lk.boost());
+            }
+
+            /** the group for the next commit to prepare.  call in groupCommitMutex.  only
+                groupCommitWithLimitedLocks() queues groups, and it calls awaitFreeGroup()
+                first, so this never waits.
+            */
+            JournalGroup& nextGroup() {
+                scoped_lock lk(_mutex);
+                invariant(!_groups[_fill].queued);
+                return _groups[_fill];
+            }
+
+            /** hand a group from nextGroup() to the journal writer thread */
+            void enqueue(JournalGroup& g) {
+                scoped_lock lk(_mutex);
+                invariant(&g == &_groups[_fill]);
+                g.queued = true;
+                _fill ^= 1;
+                _changed.notify_all();
+            }
+
+            /** wait until all queued groups are journaled and written to the data files */
+            void drain() {
+                scoped_lock lk(_mutex);
+                while( _groups[0].queued || _groups[1].queued )
+                    _changed.wait(lk.boost());
+            }
+
+            void run() {
+                while( 1 ) {
+                    JournalGroup* g;
+                    {
+                        scoped_lock lk(_mutex);
+                        while( !_groups[_write].queued )
+                            _changed.wait(lk.boost());
+                        g = &_groups[_write];
+                    }
+
+                    {
+                        // files may not be closed while we write to them; closingFileNotification()
+                        // waits for us to finish with them first.
+                        LockMongoFilesShared lk;
+                        unsigned abLen = g->ab.len();
+
+                        // the commit thread may rotate stats.curr at any time, so this group's
+                        // numbers are kept apart and published once it is done
+                        Stats::S groupStats;
+                        groupStats.reset();
+
+                        WRITETOJOURNAL(g->h, g->ab, &groupStats);
+
+                        // data is now in the journal, which is sufficient for acknowledging
+                        // getLastError.  (ok to crash after that)
+                        commitJob.notifyCommitted(g->commitNumber);
+
+                        WRITETODATAFILES(g->h, g->ab, &groupStats);
+                        verify( abLen == g->ab.len() ); // no one touched the builder meanwhile
+                        g->ab.reset();
 
+                        stats.publish(groupStats);
+                    }
+
+                    {
+                        scoped_lock lk(_mutex);
+                        g->queued = false;
+                        _write ^= 1;
+                        _changed.notify_all();
+                    }
+                }
+            }
+
+        private:
+            mongo::mutex _mutex;
+            boost::condition _changed;      // a group was queued or finished
+            JournalGroup _groups[2];
+            int _fill;                      // index of the group the next commit prepares
+            int _write;                     // index of the group the writer does next
+        };
+
+        static JournalWriter& journalWriter = *(new JournalWriter()); // don't destroy
+
+        static void journalWriterThread() {
+            Client::initThread("journalWriter");
+            try {
+                journalWriter.run();
+            }
+            catch(DBException& e ) {
+                log() << "dbexception in journalWriter causing immediate shutdown: " << e.toString() << endl;
+                mongoAbort("jw1");
+            }
+            catch(std::exception& e) {
+                log() << "exception in journalWriter causing immediate shutdown: " << e.what() << endl;
+                mongoAbort("jw2");
+            }
+        }
+
+        static bool _groupCommitWithLimitedLocks(OperationContext* txn) {
             invariant(!txn->lockState()->isLocked());
 
+            // wait here rather than in the locks below if the group before last is still being
+            // written
+            journalWriter.awaitFreeGroup();
+
             // do we need this to be greedy, so that it can start working fairly soon?
             // probably: as this is a read lock, it wouldn't change anything if only reads anyway.
             // also needs to stop greed. our time to work before clearing lk1 is not too bad, so 
@@ -577,21 +733,22 @@ namespace mongo {
             commitJob.commitingBegin(); // increments the commit epoch for getlasterror j:true
 
             if( !commitJob.hasWritten() ) {
-                // getlasterror request could have came after the data was already committed
+                // getlasterror request could have came after the data was already committed.
+                // it may be in a group still on its way to the journal though.
+                lk1.reset();
+                journalWriter.drain();
                 commitJob.committingNotifyCommitted();
                 return true;
             }
 
-            JSectHeader h;
+            JournalGroup& g = journalWriter.nextGroup();
             // need to be in readlock (writes excluded) for this as write intent stuctures point into 
             // the private mmap for their actual data.  i suppose we could lock individual databases 
             // and do them one at a time or in parallel (surely the latter would make sense if one went 
             // that route...)
-            PREPLOGBUFFER(h,ab); 
-
-            LockMongoFilesShared lk3;
+            PREPLOGBUFFER(g.h, g.ab);
+            g.commitNumber = commitJob.commitNumber();
 
-            unsigned abLen = ab.len();
             commitJob.committingReset(); // must be reset before allowing anyone to write
             DEV verify( !commitJob.hasWritten() );
 
@@ -600,20 +757,12 @@ namespace mongo {
 
             // ****** now other threads can do writes ******
 
-            WRITETOJOURNAL(h, ab);
-            verify( abLen == ab.len() ); // a check that no one touched the builder while we were doing work. if so, our locking is wrong.
-
-            // data is now in the journal, which is sufficient for acknowledging getLastError.
-            // (ok to crash after that)
-            commitJob.committingNotifyCommitted();
-
-            // note the higher-up-the-chain locking of filesLockedFsync is important here, 
-            // as we are not in Lock::GlobalRead anymore. private view readers won't see 
-            // anything as we do this, but external viewers of the datafiles will see them 
-            // mutating.
-            WRITETODATAFILES(h, ab);
-            verify( abLen == ab.len() ); // check again wasn't modded
-            ab.reset();
+            // the journal writer applies the group outside of Lock::GlobalRead and after
+            // durThreadGroupCommit() has let go of filesLockedFsync. private view readers won't
+            // see anything as it does this, but external viewers of the datafiles will see them
+            // mutating.  fsync lock still gets quiescent files: it holds filesLockedFsync, so
+            // nothing new is queued, and its syncDataAndTruncateJournal() drains the writer first.
+            journalWriter.enqueue(g);
 
             // can't : d.dbMutex._remapPrivateViewRequested = true;
             // (writes have happened we released)
@@ -652,13 +801,15 @@ namespace mongo {
             invariant(txn->lockState()->isLockedForCommitting());
 
             {
-                AlignedBuilder &ab = __theBuilder;
-
                 // we need to make sure two group commits aren't running at the same time
                 // (and we are only read locked in the dbMutex, so it could happen -- while 
                 // there is only one dur thread, "early commits" can be done by other threads)
                 SimpleMutex::scoped_lock lk(commitJob.groupCommitMutex);
 
+                // groups from groupCommitWithLimitedLocks() go first, and must be in the data
+                // files before we remap below.
+                journalWriter.drain();
+
                 commitJob.commitingBegin();
 
                 if( !commitJob.hasWritten() ) {
@@ -666,23 +817,24 @@ namespace mongo {
                     commitJob.committingNotifyCommitted();
                 }
                 else {
-                    JSectHeader h;
-                    PREPLOGBUFFER(h,ab);
+                    // the journal writer is idle, so we can use its buffer
+                    JournalGroup& g = journalWriter.nextGroup();
+                    PREPLOGBUFFER(g.h, g.ab);
 
                     // todo : write to the journal outside locks, as this write can be slow.
                     //        however, be careful then about remapprivateview as that cannot be done 
                     //        if new writes are then pending in the private maps.
-                    WRITETOJOURNAL(h, ab);
+                    WRITETOJOURNAL(g.h, g.ab, stats.curr);
 
                     // data is now in the journal, which is sufficient for acknowledging getLastError.
                     // (ok to crash after that)
                     commitJob.committingNotifyCommitted();
 
-                    WRITETODATAFILES(h, ab);
+                    WRITETODATAFILES(g.h, g.ab, stats.curr);
                     debugValidateAllMapsMatch();
 
                     commitJob.committingReset();
-                    ab.reset();
+                    g.ab.reset();
                 }
             }
 
@@ -783,6 +935,9 @@ namespace mongo {
             if (!storageGlobalParams.dur)
                 return;
 
+            // the journal writer may still have writes to apply to this file
+            journalWriter.drain();
+
             if (commitJob.hasWritten()) {
                 if (inShutdown()) {
                     log() << "journal warning files are closing outside locks with writes pending"
@@ -797,6 +952,21 @@ namespace mongo {
         extern int groupCommitIntervalMs;
         boost::filesystem::path getJournalDir();
 
+        /** wait for up to 'ms' for a reason to commit: awaitCommit() callers or a lot of data
+            written.  the latter is checked every third of 'ms'.
+        */
+        static void awaitCommitRequest(unsigned ms) {
+            unsigned oneThird = (ms / 3) + 1; // +1 so never zero
+
+            scoped_lock lk(commitRequestMutex);
+            for( unsigned i = 0; i < 3 && !commitRequested; i++ ) {
+                if( i && commitJob.bytes() > UncommittedBytesLimit / 2 )
+                    break;
+                commitRequestCond.timed_wait(lk.boost(), boost::posix_time::milliseconds(oneThird));
+            }
+            commitRequested = false;
+        }
+
         void durThread() {
             Client::initThread("journal");
 
@@ -818,21 +988,12 @@ namespace mongo {
                     ms = samePartition ? 100 : 30;
                 }
 
-                unsigned oneThird = (ms / 3) + 1; // +1 so never zero
-
                 try {
                     stats.rotate();
 
-                    // commit sooner if one or more getLastError j:true is pending
-                    sleepmillis(oneThird);
-                    for( unsigned i = 1; i <= 2; i++ ) {
-                        if( commitJob._notify.nWaiting() )
-                            break;
-                        if( commitJob.bytes() > UncommittedBytesLimit / 2  )
-                            break;
-                        sleepmillis(oneThird);
-                    }
-                                        
+                    // commit as soon as a getLastError j:true is pending
+                    awaitCommitRequest(ms);
+
                     //DEV log() << "privateMapBytes=" << privateMapBytes << endl;
 
                     durThreadGroupCommit();
@@ -889,6 +1050,7 @@ namespace mongo {
 
             preallocateFiles();
 
+            boost::thread jw(journalWriterThread);
             boost::thread t(durThread);
         }
 
@@ -159,6 +159,16 @@ namespace mongo {
                 groupCommitMutex.dassertLocked();
                 _notify.notifyAll(_commitNumber); 
             }
+            /** the commit number of the group being committed, for notifyCommitted() */
+            NotifyAll::When commitNumber() const {
+                groupCommitMutex.dassertLocked();
+                return _commitNumber;
+            }
+            /** like committingNotifyCommitted() for a group the journal writer finished after
+                groupCommitMutex was released */
+            void notifyCommitted(NotifyAll::When commitNumber) {
+                _notify.notifyAll(commitNumber);
+            }
             /** we use the commitjob object over and over, calling reset() rather than reconstructing */
             void committingReset() {
                 groupCommitMutex.dassertLocked();
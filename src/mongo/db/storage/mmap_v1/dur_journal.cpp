@@ -723,14 +723,17 @@ namespace mongo {
         /** write (append) the buffer we have built to the journal and fsync it.
             outside of dbMutex lock as this could be slow.
             @param uncompressed - a buffer that will be written to the journal after compression
+            @param s - stats to add to
             will not return until on disk
         */
-        void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed) {
+        void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed, Stats::S* s) {
             Timer t;
-            j.journal(h, uncompressed);
-            stats.curr->_writeToJournalMicros += t.micros();
+            unsigned journaled = j.journal(h, uncompressed);
+            s->_uncompressedBytes += uncompressed.len();
+            s->_journaledBytes += journaled;
+            s->_writeToJournalMicros += t.micros();
         }
-        void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
+        unsigned Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
             RACECHECK
             static AlignedBuilder b(32*1024*1024);
             /* buffer to journal will be
@@ -745,6 +748,11 @@ namespace mongo {
             {
                 dassert( h.sectionLen() == (unsigned) 0xffffffff ); // we will backfill later
                 b.appendStruct(h);
+
+                // the section was prepared while an earlier one may still have been on its way
+                // here, and that write can rotate to a new file.  stamp the file we append to.
+                SimpleMutex::scoped_lock lk(_curLogFileMutex);
+                ((JSectHeader*)b.atOfs(0))->fileId = _curFileId;
             }
 
             size_t compressedLength = 0;
@@ -778,11 +786,9 @@ namespace mongo {
                 // must already be open -- so that _curFileId is correct for previous buffer building
                 verify( _curLogFile );
 
-                stats.curr->_uncompressedBytes += uncompressed.len();
                 unsigned w = b.len();
                 _written += w;
                 verify( w <= L );
-                stats.curr->_journaledBytes += L;
                 _curLogFile->synchronousAppend((const void *) b.buf(), L);
                 _rotate();
             }
@@ -790,6 +796,7 @@ namespace mongo {
                 log() << "error exception in dur::journal " << e.what() << endl;
                 throw;
             }
+            return L;
         }
 
     }
@@ -54,8 +54,9 @@ namespace mongo {
             void rotate();
 
             /** append to the journal file
+                @return bytes appended, including the padding
             */
-            void journal(const JSectHeader& h, const AlignedBuilder& b);
+            unsigned journal(const JSectHeader& h, const AlignedBuilder& b);
 
             boost::filesystem::path getFilePathFor(int filenumber) const;
 
@@ -53,6 +53,7 @@
 #include "mongo/util/compress.h"
 #include "mongo/util/concurrency/race.h"
 #include "mongo/util/mongoutils/str.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/startup_test.h"
 
 using namespace mongoutils;
@@ -280,7 +281,7 @@ namespace mongo {
 
                 void* dest = (char*)mmf->view_write() + entry.e->ofs;
                 memcpy(dest, entry.e->srcData(), entry.e->len);
-                stats.curr->_writeToDataFilesBytes += entry.e->len;
+                _bytesWritten += entry.e->len;
             }
             else {
                 massert(13622, "Trying to write past end of file in WRITETODATAFILES", _recovering);
@@ -365,11 +366,8 @@ namespace mongo {
                 log() << "END section" << endl;
         }
 
-        void RecoveryJob::processSection(const JSectHeader *h, const void *p, unsigned len, const JSectFooter *f) {
-            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
-            scoped_lock lk(_mx);
-            RACECHECK
-
+        /** @return true if the section was already in the data files before the crash */
+        bool RecoveryJob::skipSection(const JSectHeader *h) {
             /** todo: we should really verify the checksum to see that seqNumber is ok?
                       that is expensive maybe there is some sort of checksum of just the header 
                       within the header itself
@@ -385,8 +383,20 @@ namespace mongo {
                     }
                     _lastSeqMentionedInConsoleLog = h->seqNumber;
                 }
-                return;
+                return true;
             }
+            return false;
+        }
+
+        unsigned long long RecoveryJob::processSection(const JSectHeader *h, const void *p,
+                                                       unsigned len, const JSectFooter *f) {
+            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
+            scoped_lock lk(_mx);
+            RACECHECK
+
+            _bytesWritten = 0;
+            if( skipSection(h) )
+                return 0;
 
             auto_ptr<JournalSectionIterator> i;
             if( _recovering ) {
@@ -426,6 +436,196 @@ namespace mongo {
 
             // got all the entries for one group commit.  apply them:
             applyEntries(entries);
+            return _bytesWritten;
+        }
+
+        /** a journal section being recovered.  sections are decompressed, parsed and checksummed
+            on the recovery workers; the entries point into 'i', which owns the uncompressed data.
+        */
+        struct RecoveryJob::ParsedSection : boost::noncopyable {
+            ParsedSection(const char *hdr, unsigned dataLen) :
+                h((const JSectHeader*) hdr),
+                data(hdr + sizeof(JSectHeader)),
+                len(dataLen),
+                f((const JSectFooter*) (data + dataLen)),
+                truncated(false),
+                errCode(0) { }
+
+            const JSectHeader *h;
+            const char *data;
+            unsigned len;
+            const JSectFooter *f;
+
+            scoped_ptr<JournalSectionIterator> i;
+            vector<ParsedJournalEntry> entries;
+
+            // set instead of throwing on the worker, and rethrown when this section's turn to be
+            // applied comes
+            bool truncated;         // BufReader::eof
+            int errCode;
+            string errMsg;
+        };
+
+        void RecoveryJob::parseSection(ParsedSection* s) {
+            try {
+                s->i.reset(new JournalSectionIterator(*s->h, s->data, s->len, true));
+
+                // first read all entries to make sure this section is valid
+                ParsedJournalEntry e;
+                while( !s->i->atEof() ) {
+                    s->i->next(e);
+                    s->entries.push_back(e);
+                }
+
+                // after the entries check the footer checksum
+                if( !s->f->checkHash(s->h, s->len + sizeof(JSectHeader)) ) { 
+                    msgasserted(13594, "journal checksum doesn't match");
+                }
+            }
+            catch( BufReader::eof& ) {
+                s->truncated = true;
+            }
+            catch( DBException& e ) {
+                s->errCode = e.getCode();
+                s->errMsg = e.what();
+            }
+            catch( std::exception& e ) {
+                s->errCode = 18530;
+                s->errMsg = str::stream() << "error reading journal section: " << e.what();
+            }
+        }
+
+        /** the basic writes of a run of sections that go to one data file, in journal order */
+        struct FileWrites {
+            FileWrites() : mmf(NULL), bytes(0), errCode(0) { }
+            DurableMappedFile *mmf;
+            vector<const JEntry*> writes;
+            unsigned long long bytes;
+
+            // the pool's workers swallow exceptions, so failures are kept here and rethrown on
+            // the recovery thread, as they would have been by write()
+            int errCode;
+            string errMsg;
+        };
+
+        static void _applyFileWrites(FileWrites* fw) {
+            const unsigned long long length = fw->mmf->length();
+            char *view = (char*) fw->mmf->view_write();
+            verify(view);
+            for( vector<const JEntry*>::const_iterator i = fw->writes.begin(); i != fw->writes.end(); ++i ) {
+                const JEntry *e = *i;
+                // as in write(), writes past the end of the file are ignored when recovering
+                if( e->ofs + e->len <= length ) {
+                    memcpy(view + e->ofs, e->srcData(), e->len);
+                    fw->bytes += e->len;
+                }
+            }
+        }
+
+        static void applyFileWrites(FileWrites* fw) {
+            try {
+                _applyFileWrites(fw);
+            }
+            catch( DBException& e ) {
+                fw->errCode = e.getCode();
+                fw->errMsg = e.what();
+            }
+            catch( std::exception& e ) {
+                fw->errCode = 18532;
+                fw->errMsg = str::stream() << "error applying journal writes to "
+                                           << fw->mmf->filename() << ": " << e.what();
+            }
+        }
+
+        void RecoveryJob::applyWrites(const vector<ParsedJournalEntry>& entries) {
+            if( entries.empty() )
+                return;
+
+            // files are found or opened here, on one thread.  only the copying is parallel, with
+            // a single worker per file so writes to a file keep their order.
+            Last last;
+            map<DurableMappedFile*, size_t> fileIndex;
+            vector<FileWrites> files;
+            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                verify(i->e);
+                verify(i->dbName);
+                verify((size_t)strnlen(i->dbName, MaxDatabaseNameLen) < MaxDatabaseNameLen);
+
+                DurableMappedFile *mmf = last.newEntry(*i, *this);
+                map<DurableMappedFile*, size_t>::iterator it = fileIndex.find(mmf);
+                if( it == fileIndex.end() ) {
+                    it = fileIndex.insert(make_pair(mmf, files.size())).first;
+                    files.push_back(FileWrites());
+                    files.back().mmf = mmf;
+                }
+                files[it->second].writes.push_back(i->e);
+            }
+
+            for( size_t i = 0; i < files.size(); i++ ) {
+                _pool->schedule(&applyFileWrites, &files[i]);
+            }
+            _pool->join();
+
+            for( size_t i = 0; i < files.size(); i++ ) {
+                _bytesWritten += files[i].bytes;
+            }
+            for( size_t i = 0; i < files.size(); i++ ) {
+                if( files[i].errCode ) {
+                    // recovery stops here, and the journal is kept for the next attempt
+                    msgasserted(files[i].errCode, files[i].errMsg);
+                }
+            }
+        }
+
+        bool RecoveryJob::processSections(OwnedPointerVector<ParsedSection>* batch) {
+            OwnedPointerVector<ParsedSection> sections(batch->release());
+
+            for( size_t i = 0; i < sections.size(); i++ ) {
+                _pool->schedule(&parseSection, sections[i]);
+            }
+            _pool->join();
+
+            LockMongoFilesShared lkFiles; // for RecoveryJob::Last
+            scoped_lock lk(_mx);
+            RACECHECK
+
+            bool apply = (storageGlobalParams.durOptions &
+                          StorageGlobalParams::DurScanOnly) == 0;
+            bool dump = storageGlobalParams.durOptions &
+                        StorageGlobalParams::DurDumpJournal;
+
+            // basic writes are gathered across sections up to the next DurOp, which may close or
+            // create files and so has to see everything before it applied
+            vector<ParsedJournalEntry> writes;
+            for( size_t i = 0; i < sections.size(); i++ ) {
+                ParsedSection *s = sections[i];
+                if( s->truncated || s->errCode ) {
+                    // everything before the bad section is applied, as it would have been if
+                    // we had gone a section at a time
+                    applyWrites(writes);
+                    if( s->truncated )
+                        return true;
+                    msgasserted(s->errCode, s->errMsg);
+                }
+
+                if( dump || !apply ) {
+                    applyEntries(s->entries);
+                    continue;
+                }
+
+                for( vector<ParsedJournalEntry>::const_iterator e = s->entries.begin(); e != s->entries.end(); ++e ) {
+                    if( e->e ) {
+                        writes.push_back(*e);
+                        continue;
+                    }
+                    applyWrites(writes);
+                    writes.clear();
+                    Last last;
+                    applyEntry(last, *e, apply, dump);
+                }
+            }
+            applyWrites(writes);
+            return false;
         }
 
         /** apply a specific journal file, that is already mmap'd
@@ -433,6 +633,12 @@ namespace mongo {
             @return true if this is detected to be the last file (ends abruptly)
         */
         bool RecoveryJob::processFileBuffer(const void *p, unsigned len) {
+            // sections are handed to the recovery workers in batches of about this size
+            const size_t BatchSections = 64;
+            const unsigned long long BatchBytes = 128 * 1024 * 1024;
+
+            OwnedPointerVector<ParsedSection> batch;
+            unsigned long long batchBytes = 0;
             try {
                 unsigned long long fileId;
                 BufReader br(p,len);
@@ -475,20 +681,32 @@ namespace mongo {
                             log() << "Ending processFileBuffer at differing fileId want:" << fileId << " got:" << h.fileId << endl;
                             log() << "  sect len:" << h.sectionLen() << " seqnum:" << h.seqNumber << endl;
                         }
+                        processSections(&batch);
                         return true;
                     }
                     unsigned slen = h.sectionLen();
                     unsigned dataLen = slen - sizeof(JSectHeader) - sizeof(JSectFooter);
                     const char *hdr = (const char *) br.skip(h.sectionLenWithPadding());
-                    const char *data = hdr + sizeof(JSectHeader);
-                    const char *footer = data + dataLen;
-                    processSection((const JSectHeader*) hdr, data, dataLen, (const JSectFooter*) footer);
+                    if( !skipSection((const JSectHeader*) hdr) ) {
+                        batch.push_back(new ParsedSection(hdr, dataLen));
+                        batchBytes += slen;
+                    }
+
+                    if( batch.size() >= BatchSections || batchBytes >= BatchBytes ) {
+                        if( processSections(&batch) )
+                            throw BufReader::eof();
+                        batchBytes = 0;
 
-                    // ctrl c check
-                    uassert(ErrorCodes::Interrupted, "interrupted during journal recovery", !inShutdown());
+                        // ctrl c check
+                        uassert(ErrorCodes::Interrupted, "interrupted during journal recovery", !inShutdown());
+                    }
                 }
+                if( processSections(&batch) )
+                    throw BufReader::eof();
             }
             catch( BufReader::eof& ) {
+                // the sections read before a torn one still apply
+                processSections(&batch);
                 if (storageGlobalParams.durOptions & StorageGlobalParams::DurDumpJournal)
                     log() << "ABRUPT END" << endl;
                 return true; // abrupt end
@@ -526,6 +744,14 @@ namespace mongo {
             // load the last sequence number synced to the datafiles on disk before the last crash
             _lastDataSyncedFromLastRun = journalReadLSN();
             log() << "recover lsn: " << _lastDataSyncedFromLastRun << endl;
+            _bytesWritten = 0;
+
+            // sections are decompressed in parallel, and their writes applied in parallel across
+            // data files
+            const unsigned nThreads = std::max(1u, std::min(16u, ProcessInfo().getNumCores()));
+            ThreadPool pool(nThreads);
+            _pool = &pool;
+            log() << "recover using " << nThreads << " threads" << endl;
 
             for( unsigned i = 0; i != files.size(); ++i ) {
                 bool abruptEnd = processFile(files[i]);
@@ -538,6 +764,9 @@ namespace mongo {
 
             close();
 
+            // no journal threads yet, so nothing else is using the stats
+            stats.curr->_writeToDataFilesBytes += _bytesWritten;
+
             if (storageGlobalParams.durOptions & StorageGlobalParams::DurScanOnly) {
                 uasserted(13545, str::stream() << "--durOptions "
                                                << (int) StorageGlobalParams::DurScanOnly
@@ -549,6 +778,7 @@ namespace mongo {
             log() << "recover done" << endl;
             okToCleanUp = true;
             _recovering = false;
+            _pool = NULL;
         }
 
         void _recover() {
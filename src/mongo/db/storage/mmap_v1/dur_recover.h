@@ -33,8 +33,10 @@
 #include <boost/filesystem/operations.hpp>
 #include <list>
 
+#include "mongo/base/owned_pointer_vector.h"
 #include "mongo/db/storage/mmap_v1/dur_journalformat.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/file.h"
 
 namespace mongo {
@@ -56,21 +58,36 @@ namespace mongo {
                 int fileNo;
             } last;        
         public:
-            RecoveryJob() : _lastDataSyncedFromLastRun(0), 
-                _mx("recovery"), _recovering(false) { _lastSeqMentionedInConsoleLog = 1; }
+            RecoveryJob() : _lastDataSyncedFromLastRun(0), _bytesWritten(0),
+                _mx("recovery"), _recovering(false), _pool(NULL) { _lastSeqMentionedInConsoleLog = 1; }
             void go(std::vector<boost::filesystem::path>& files);
             ~RecoveryJob();
 
-            /** @param data data between header and footer. compressed if recovering. */
-            void processSection(const JSectHeader *h, const void *data, unsigned len, const JSectFooter *f);
+            /** @param data data between header and footer. compressed if recovering.
+                @return bytes written to the data files
+            */
+            unsigned long long processSection(const JSectHeader *h, const void *data, unsigned len,
+                                              const JSectFooter *f);
 
             void close(); // locks and calls _close()
 
             static RecoveryJob & get() { return _instance; }
         private:
+            struct ParsedSection;
+
             void write(Last& last, const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(Last& last, const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const std::vector<ParsedJournalEntry> &entries);
+            bool skipSection(const JSectHeader *h);
+
+            /** recovery only: parse 'batch' in parallel, then apply it in order.  empties 'batch'.
+                @return true if a section ended prematurely.  nothing from it on is applied.
+            */
+            bool processSections(OwnedPointerVector<ParsedSection>* batch);
+            static void parseSection(ParsedSection* s); // on a recovery worker
+
+            /** recovery only: apply basic writes, in parallel across data files */
+            void applyWrites(const std::vector<ParsedJournalEntry>& entries);
             bool processFileBuffer(const void *, unsigned len);
             bool processFile(boost::filesystem::path journalfile);
             void _close(); // doesn't lock
@@ -79,11 +96,13 @@ namespace mongo {
             std::list<boost::shared_ptr<DurableMappedFile> > _mmfs;
 
             unsigned long long _lastDataSyncedFromLastRun;
+            unsigned long long _bytesWritten; // to the data files, by write() and applyWrites()
             unsigned long long _lastSeqMentionedInConsoleLog;
         public:
             mongo::mutex _mx; // protects _mmfs
         private:
             bool _recovering; // are we in recovery or WRITETODATAFILES
+            ThreadPool* _pool; // recovery workers, while in go()
 
             static RecoveryJob &_instance;
         };
@@ -28,11 +28,14 @@
 *    it in the license file.
 */
 
+#include "mongo/util/concurrency/mutex.h"
+
 namespace mongo {
     namespace dur {
 
         /** journaling stats.  the model here is that the commit thread is the only writer, and that reads are
             uncommon (from a serverStatus command and such).  Thus, there should not be multicore chatter overhead.
+            the journal writer thread keeps its own S for each group and publish()es it when done.
         */
         struct Stats {
             Stats();
@@ -44,6 +47,7 @@ namespace mongo {
                 std::string _asCSV();
                 std::string _CSVHeader();
                 void reset();
+                void add(const S& other); // all but _dtMillis
 
                 unsigned _commits;
                 unsigned _earlyCommits; // count of early commits from commitIfNeeded() or from getDur().commitNow()
@@ -66,8 +70,12 @@ namespace mongo {
                 int _dtMillis;
             };
             S *curr;
+
+            /** add 'delta' to curr.  for threads other than the commit thread, as it rotates. */
+            void publish(const S& delta);
         private:
             S _a,_b;
+            SimpleMutex _mutex; // held to switch curr, and to publish() to it
             unsigned long long _lastRotate;
             S* other();
         };
@@ -45,9 +45,11 @@ namespace mongo {
 
         void debugValidateAllMapsMatch();
 
-        static void WRITETODATAFILES_Impl1(const JSectHeader& h, AlignedBuilder& uncompressed) {
+        static void WRITETODATAFILES_Impl1(const JSectHeader& h, AlignedBuilder& uncompressed,
+                                           Stats::S* s) {
             LOG(3) << "journal WRITETODATAFILES 1" << endl;
-            RecoveryJob::get().processSection(&h, uncompressed.buf(), uncompressed.len(), 0);
+            s->_writeToDataFilesBytes +=
+                RecoveryJob::get().processSection(&h, uncompressed.buf(), uncompressed.len(), 0);
             LOG(3) << "journal WRITETODATAFILES 2" << endl;
         }
 
@@ -99,11 +101,11 @@ namespace mongo {
             @see https://docs.google.com/drawings/edit?id=1TklsmZzm7ohIZkwgeK6rMvsdaR13KjtJYMsfLr175Zc&hl=en
         */
 
-        void WRITETODATAFILES(const JSectHeader& h, AlignedBuilder& uncompressed) {
+        void WRITETODATAFILES(const JSectHeader& h, AlignedBuilder& uncompressed, Stats::S* s) {
             Timer t;
-            WRITETODATAFILES_Impl1(h, uncompressed);
+            WRITETODATAFILES_Impl1(h, uncompressed, s);
             long long m = t.micros();
-            stats.curr->_writeToDataFilesMicros += m;
+            s->_writeToDataFilesMicros += m;
             LOG(2) << "journal WRITETODATAFILES " << m / 1000.0 << "ms" << endl;
         }
 
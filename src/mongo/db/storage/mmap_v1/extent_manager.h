@@ -73,11 +73,16 @@ namespace mongo {
         virtual int numFiles() const = 0;
         virtual long long fileSize() const = 0;
 
-        // must call Extent::reuse on the returned extent
+        /**
+         * must call Extent::reuse on the returned extent
+         * @param smallestUseful - if not 0, a free extent anywhere from this size up to
+         *                         around 'size' is good enough (not for capped)
+         */
         virtual DiskLoc allocateExtent( OperationContext* txn,
                                         bool capped,
                                         int size,
-                                        bool enforceQuota ) = 0;
+                                        bool enforceQuota,
+                                        int smallestUseful = 0 ) = 0;
 
         /**
          * firstExt has to be == lastExt or a chain
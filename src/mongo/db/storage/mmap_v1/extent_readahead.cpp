@@ -0,0 +1,161 @@
+// extent_readahead.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/mmap_v1/extent_readahead.h"
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/server_parameters.h"
+#include "mongo/db/storage/mmap_v1/extent.h"
+#include "mongo/db/storage/mmap_v1/extent_manager.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+
+    MONGO_LOG_DEFAULT_COMPONENT_FILE(::mongo::logger::LogComponent::kStorage);
+
+    MONGO_EXPORT_SERVER_PARAMETER(extentReadaheadMaxWindow, int, 8);
+
+    namespace {
+
+        // Don't advise more than this much of any single extent; the biggest extents are ~2GB.
+        const int maxAdviseBytesPerExtent = 16 * 1024 * 1024;
+
+        AtomicUInt64 extentsAdvised;
+        AtomicUInt64 bytesAdvised;
+        AtomicUInt64 readaheadHits;
+        AtomicUInt64 readaheadMisses;
+
+        int adviseWillNeed( const Extent* e ) {
+            const char* start = reinterpret_cast<const char*>( e );
+            const int len = std::min( e->length, maxAdviseBytesPerExtent );
+#if defined(_WIN32) || defined(__sunos__)
+            return 0;
+#else
+            const size_t pageSize = ProcessInfo::getPageSize();
+            char* aligned = reinterpret_cast<char*>(
+                reinterpret_cast<size_t>( start ) & ~( pageSize - 1 ) );
+            const size_t alignedLen = len + ( start - aligned );
+            if ( madvise( aligned, alignedLen, MADV_WILLNEED ) ) {
+                LOG(1) << "madvise(MADV_WILLNEED) failed: " << errnoWithDescription();
+                return 0;
+            }
+            return len;
+#endif
+        }
+
+        /**
+         * Checks the last page we advised for 'e', the one readahead gets to last.
+         */
+        bool advisedTailInMemory( const Extent* e ) {
+            const char* start = reinterpret_cast<const char*>( e );
+            const int len = std::min( e->length, maxAdviseBytesPerExtent );
+            return ProcessInfo::blockInMemory( start + len - 1 );
+        }
+    }
+
+    ExtentReadahead::ExtentReadahead( const ExtentManager* em )
+        : _em( em ),
+          _window( 1 ),
+          _extentsEntered( 0 ) {
+    }
+
+    void ExtentReadahead::enteringExtent( const DiskLoc& extentLoc ) {
+        const int maxWindow = extentReadaheadMaxWindow;
+        if ( maxWindow <= 0 || !ProcessInfo::blockCheckSupported() )
+            return;
+
+        if ( ++_extentsEntered == 1 ) {
+            // wait until we know this is a real scan
+            return;
+        }
+
+        // Forget anything we advised that the scan skipped over (empty extents).
+        while ( !_advised.empty() && _advised.front() != extentLoc )
+            _advised.pop_front();
+
+        if ( !_advised.empty() ) {
+            _advised.pop_front();
+            if ( _advisedInMemory( _em->getExtent( extentLoc ) ) ) {
+                readaheadHits.fetchAndAdd( 1 );
+                _window = std::min( _window * 2, maxWindow );
+            }
+            else {
+                readaheadMisses.fetchAndAdd( 1 );
+                _window = std::max( _window / 2, 1 );
+            }
+        }
+
+        _adviseAhead( _advised.empty() ? extentLoc : _advised.back() );
+    }
+
+    void ExtentReadahead::_adviseAhead( const DiskLoc& from ) {
+        DiskLoc loc = _em->getExtent( from )->xnext;
+        while ( static_cast<int>( _advised.size() ) < _window && !loc.isNull() ) {
+            const Extent* e = _em->getExtent( loc );
+            const int advised = _adviseWillNeed( e );
+            if ( advised == 0 )
+                return;
+
+            extentsAdvised.fetchAndAdd( 1 );
+            bytesAdvised.fetchAndAdd( advised );
+            _advised.push_back( loc );
+            loc = e->xnext;
+        }
+    }
+
+    int ExtentReadahead::_adviseWillNeed( const Extent* e ) {
+        return adviseWillNeed( e );
+    }
+
+    bool ExtentReadahead::_advisedInMemory( const Extent* e ) {
+        return advisedTailInMemory( e );
+    }
+
+    void ExtentReadahead::appendStats( BSONObjBuilder* b ) {
+        const unsigned long long hits = readaheadHits.load();
+        const unsigned long long misses = readaheadMisses.load();
+        b->appendNumber( "extentsAdvised", static_cast<long long>( extentsAdvised.load() ) );
+        b->appendNumber( "bytesAdvised", static_cast<long long>( bytesAdvised.load() ) );
+        b->appendNumber( "hits", static_cast<long long>( hits ) );
+        b->appendNumber( "misses", static_cast<long long>( misses ) );
+        b->append( "hitRatio", hits + misses == 0 ? 0.0
+                                                  : static_cast<double>( hits ) / ( hits + misses ) );
+    }
+
+}
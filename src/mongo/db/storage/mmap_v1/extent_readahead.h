@@ -0,0 +1,111 @@
+// extent_readahead.h
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+
+#include "mongo/db/diskloc.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+    class Extent;
+    class ExtentManager;
+
+    // Upper bound on the readahead window, in extents.  0 turns readahead off.
+    extern int extentReadaheadMaxWindow;
+
+    /**
+     * Asks the OS to start reading in the extents ahead of a forward scan, so that a cold scan
+     * streams from disk instead of faulting its way through one page at a time.
+     *
+     * The window is how many extents past the current one we keep advised.  It doubles each
+     * time the scan reaches an extent we advised and finds it resident (a hit), and is halved
+     * when the advised pages were not resident by the time we got there (a miss), since then
+     * we are only adding memory pressure.
+     *
+     * Nothing is advised until the scan crosses its first extent boundary, so short scans and
+     * single extent collections never pay for it.
+     *
+     * Not thread safe, one per iterator.
+     */
+    class ExtentReadahead {
+    public:
+        explicit ExtentReadahead( const ExtentManager* em );
+
+        virtual ~ExtentReadahead() {}
+
+        /**
+         * Call when a scan moves into the extent at 'extentLoc'.
+         */
+        void enteringExtent( const DiskLoc& extentLoc );
+
+        /**
+         * Appends the process wide readahead counters.
+         */
+        static void appendStats( BSONObjBuilder* b );
+
+        int window() const { return _window; }
+
+        /**
+         * Extents advised that the scan has not reached yet.
+         */
+        size_t numAdvised() const { return _advised.size(); }
+
+    protected:
+        /**
+         * Asks the OS to read in the start of 'e'.
+         * @return the number of bytes advised, 0 if not supported
+         */
+        virtual int _adviseWillNeed( const Extent* e );
+
+        /**
+         * Whether the part of 'e' we advised was resident by the time the scan got to it.
+         */
+        virtual bool _advisedInMemory( const Extent* e );
+
+    private:
+        void _adviseAhead( const DiskLoc& from );
+
+        const ExtentManager* _em;
+
+        // number of extents to keep advised ahead of the current one
+        int _window;
+
+        // extents advised and not yet reached, in xnext order
+        std::deque<DiskLoc> _advised;
+
+        // how many extent boundaries the scan has crossed
+        int _extentsEntered;
+    };
+
+}
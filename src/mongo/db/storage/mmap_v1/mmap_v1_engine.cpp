@@ -33,13 +33,49 @@
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/operations.hpp>
 
+#include "mongo/db/commands/server_status.h"
 #include "mongo/db/storage_options.h"
+#include "mongo/db/storage/mmap_v1/extent_readahead.h"
 #include "mongo/db/storage/mmap_v1/mmap_v1_database_catalog_entry.h"
 #include "mongo/db/storage/mmap_v1/dur_recovery_unit.h"
+#include "mongo/util/file_allocator.h"
 #include "mongo/util/mmap.h"
 
 namespace mongo {
 
+    namespace {
+        class ExtentReadaheadSSS : public ServerStatusSection {
+        public:
+            ExtentReadaheadSSS() : ServerStatusSection( "extentReadahead" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(const BSONElement& configElement) const {
+                BSONObjBuilder b;
+                ExtentReadahead::appendStats( &b );
+                return b.obj();
+            }
+        } extentReadaheadSSS;
+
+        class FileAllocatorSSS : public ServerStatusSection {
+        public:
+            FileAllocatorSSS() : ServerStatusSection( "fileAllocator" ){}
+            virtual bool includeByDefault() const { return true; }
+
+            BSONObj generateSection(const BSONElement& configElement) const {
+                BSONObjBuilder b;
+                FileAllocator::get()->appendStats( &b );
+                return b.obj();
+            }
+        } fileAllocatorSSS;
+    }
+
+    MMAPV1Engine::MMAPV1Engine() {
+    }
+
+    MMAPV1Engine::MMAPV1Engine( const std::string& path )
+        : _path( path ) {
+    }
+
     MMAPV1Engine::~MMAPV1Engine() {
     }
 
@@ -48,18 +84,22 @@ namespace mongo {
     }
 
     void MMAPV1Engine::listDatabases( std::vector<std::string>* out ) const {
-        _listDatabases( storageGlobalParams.dbpath, out );
+        _listDatabases( _dbpath(), out );
     }
 
     DatabaseCatalogEntry* MMAPV1Engine::getDatabaseCatalogEntry( OperationContext* opCtx,
                                                                  const StringData& db ) {
         return new MMAPV1DatabaseCatalogEntry( opCtx,
                                                db,
-                                               storageGlobalParams.dbpath,
+                                               _dbpath(),
                                                storageGlobalParams.directoryperdb,
                                                false );
     }
 
+    const std::string& MMAPV1Engine::_dbpath() const {
+        return _path.empty() ? storageGlobalParams.dbpath : _path;
+    }
+
     void MMAPV1Engine::_listDatabases( const std::string& directory,
                                        std::vector<std::string>* out ) {
         boost::filesystem::path path( directory );
@@ -36,6 +36,15 @@ namespace mongo {
 
     class MMAPV1Engine : public StorageEngine {
     public:
+        /**
+         * Keeps its files in storageGlobalParams.dbpath, whatever that is at the time.
+         */
+        MMAPV1Engine();
+
+        /**
+         * Keeps its files in 'path' instead.
+         */
+        explicit MMAPV1Engine( const std::string& path );
         virtual ~MMAPV1Engine();
 
         RecoveryUnit* newRecoveryUnit( OperationContext* opCtx );
@@ -53,5 +62,9 @@ namespace mongo {
     private:
         static void _listDatabases( const std::string& directory,
                                     std::vector<std::string>* out );
+
+        const std::string& _dbpath() const;
+
+        const std::string _path; // empty means storageGlobalParams.dbpath
     };
 }
@@ -52,7 +52,10 @@ namespace mongo {
                                   bool directoryPerDB )
         : _dbname( dbname.toString() ),
           _path( path.toString() ),
-          _directoryPerDB( directoryPerDB ) {
+          _directoryPerDB( directoryPerDB ),
+          _growthSinceTimer( 0 ),
+          _growthRate( 0 ),
+          _preallocatedFile( 0 ) {
     }
 
     MmapV1ExtentManager::~MmapV1ExtentManager() {
@@ -64,6 +67,7 @@ namespace mongo {
             delete _files[i];
         }
         _files.clear();
+        _preallocatedFile = 0;
     }
 
     boost::filesystem::path MmapV1ExtentManager::fileName( int n ) const {
@@ -190,6 +194,40 @@ namespace mongo {
         return ret;
     }
 
+    namespace {
+        // request the next file when the last one has less room than this much growth
+        const int preallocLookaheadSecs = 10;
+    }
+
+    void MmapV1ExtentManager::_noteGrowth( OperationContext* txn, int size ) {
+        _growthSinceTimer += size;
+        long long micros = _growthTimer.micros();
+        if ( micros >= 1000 * 1000 ) {
+            double rate = _growthSinceTimer * 1000000.0 / micros;
+            _growthRate = ( _growthRate + rate ) / 2;
+            _growthSinceTimer = 0;
+            _growthTimer.reset();
+        }
+
+        if ( !storageGlobalParams.prealloc )
+            return;
+
+        int last = numFiles() - 1;
+        if ( last < 0 || _preallocatedFile > last )
+            return;
+
+        // what is left of this second counts as at least a second's worth
+        double expected = std::max( _growthRate, static_cast<double>( _growthSinceTimer ) )
+            * preallocLookaheadSecs;
+        if ( getFile( txn, last )->getHeader()->unusedLength > expected )
+            return;
+
+        LOG(1) << "preallocating " << fileName( last + 1 ).string() << ", growing "
+               << static_cast<long long>( _growthRate ) / 1024 << "KB/s";
+        getFile( txn, last + 1, 0, true );
+        _preallocatedFile = last + 1;
+    }
+
     int MmapV1ExtentManager::numFiles() const {
         return static_cast<int>( _files.size() );
     }
@@ -288,7 +326,9 @@ namespace mongo {
         for ( int i = numFiles() - 1; i >= 0; i-- ) {
             DataFile* f = getFile( txn, i );
             if ( f->getHeader()->unusedLength >= size ) {
-                return _createExtentInFile( txn, i, f, size, enforceQuota );
+                DiskLoc loc = _createExtentInFile( txn, i, f, size, enforceQuota );
+                _noteGrowth( txn, size );
+                return loc;
             }
         }
 
@@ -300,7 +340,9 @@ namespace mongo {
             DataFile* f = _addAFile( txn, size, false );
 
             if ( f->getHeader()->unusedLength >= size ) {
-                return _createExtentInFile( txn, numFiles() - 1, f, size, enforceQuota );
+                DiskLoc loc = _createExtentInFile( txn, numFiles() - 1, f, size, enforceQuota );
+                _noteGrowth( txn, size );
+                return loc;
             }
 
         }
@@ -311,7 +353,8 @@ namespace mongo {
 
     DiskLoc MmapV1ExtentManager::_allocFromFreeList( OperationContext* txn,
                                                int approxSize,
-                                               bool capped ) {
+                                               bool capped,
+                                               int smallestUseful ) {
         // setup extent constraints
 
         int low, high;
@@ -324,6 +367,8 @@ namespace mongo {
         else {
             low = (int) (approxSize * 0.8);
             high = (int) (approxSize * 1.4);
+            if ( smallestUseful > 0 && smallestUseful < low )
+                low = smallestUseful;
         }
         if ( high <= 0 ) {
             // overflowed
@@ -397,10 +442,11 @@ namespace mongo {
     DiskLoc MmapV1ExtentManager::allocateExtent( OperationContext* txn,
                                            bool capped,
                                            int size,
-                                           bool enforceQuota ) {
+                                           bool enforceQuota,
+                                           int smallestUseful ) {
 
         bool fromFreeList = true;
-        DiskLoc eloc = _allocFromFreeList( txn, size, capped );
+        DiskLoc eloc = _allocFromFreeList( txn, size, capped, smallestUseful );
         if ( eloc.isNull() ) {
             fromFreeList = false;
             eloc = _createExtent( txn, size, enforceQuota );
@@ -411,6 +457,7 @@ namespace mongo {
 
         LOG(1) << "MmapV1ExtentManager::allocateExtent"
                << " desiredSize:" << size
+               << " smallestUseful:" << smallestUseful
                << " fromFreeList: " << fromFreeList
                << " eloc: " << eloc;
 
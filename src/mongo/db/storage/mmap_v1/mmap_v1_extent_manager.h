@@ -39,6 +39,7 @@
 #include "mongo/base/string_data.h"
 #include "mongo/db/diskloc.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
@@ -98,7 +99,8 @@ namespace mongo {
         DiskLoc allocateExtent( OperationContext* txn,
                                 bool capped,
                                 int size,
-                                bool enforceQuota );
+                                bool enforceQuota,
+                                int smallestUseful = 0 );
 
         /**
          * firstExt has to be == lastExt or a chain
@@ -155,7 +157,10 @@ namespace mongo {
         /**
          * will return NULL if nothing suitable in free list
          */
-        DiskLoc _allocFromFreeList( OperationContext* txn, int approxSize, bool capped );
+        DiskLoc _allocFromFreeList( OperationContext* txn,
+                                    int approxSize,
+                                    bool capped,
+                                    int smallestUseful );
 
         /* allocate a new Extent, does not check free list
         */
@@ -163,6 +168,13 @@ namespace mongo {
 
         DataFile* _addAFile( OperationContext* txn, int sizeNeeded, bool preallocateNextFile );
 
+        /**
+         * Called when a new extent of 'size' bytes came out of the files.  Keeps track of how
+         * fast the files are growing and asks for the next file ahead of time if the last one
+         * will fill up soon, so the insert that needs it doesn't wait for it to be zeroed.
+         */
+        void _noteGrowth( OperationContext* txn, int size );
+
         DiskLoc _getFreeListStart() const;
         DiskLoc _getFreeListEnd() const;
         void _setFreeListStart( OperationContext* txn, DiskLoc loc );
@@ -189,6 +201,12 @@ namespace mongo {
         //   to others and we are in the dbholder lock then.
         std::vector<DataFile*> _files;
 
+        // for _noteGrowth
+        Timer _growthTimer;
+        long long _growthSinceTimer; // bytes
+        double _growthRate; // bytes per second, averaged over the last few seconds
+        int _preallocatedFile; // highest file number already requested
+
     };
 
 }
@@ -42,6 +42,8 @@ namespace mongo {
      */
     class RecordData {
     public:
+        RecordData(): _data(NULL), _size(0), _dataPtr() { }
+
         RecordData(const char* data, int size): _data(data), _size(size), _dataPtr() { }
 
         RecordData(const char* data, int size, const boost::shared_array<char>& dataPtr)
@@ -62,7 +64,7 @@ namespace mongo {
     private:
         const char* _data;
         int _size;
-        const boost::shared_array<char> _dataPtr;
+        boost::shared_array<char> _dataPtr;
     };
 
 } // namespace mongo
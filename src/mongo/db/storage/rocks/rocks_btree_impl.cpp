@@ -34,63 +34,48 @@
 
 #include <rocksdb/db.h>
 #include <rocksdb/iterator.h>
+#include <rocksdb/options.h>
 
 #include "mongo/db/storage/rocks/rocks_engine.h"
+#include "mongo/db/storage/rocks/rocks_index_key.h"
+#include "mongo/db/storage/rocks/rocks_indexed_write_batch.h"
 #include "mongo/db/storage/rocks/rocks_recovery_unit.h"
+#include "mongo/util/mongoutils/str.h"
 
 namespace mongo {
 
     namespace {
 
-        rocksdb::Slice singleByteSlice( "a" );
-        rocksdb::SliceParts singleByteSliceParts( &singleByteSlice, 1 );
-
-        struct IndexKey {
-            IndexKey( const BSONObj& _obj, const DiskLoc& _loc )
-                : obj( _obj ), loc( _loc ) {
-
-                if ( obj.firstElement().fieldName()[0] ) {
-                    // XXX move this to comparator
-                    // need to strip
-                    BSONObjBuilder b;
-                    BSONObjIterator i( _obj );
-                    while ( i.more() ) {
-                        BSONElement e = i.next();
-                        b.appendAs( e, "" );
-                    }
-                    obj = b.obj();
-                }
-
-                sliced[0] = rocksdb::Slice( obj.objdata(), obj.objsize() );
-                sliced[1] = rocksdb::Slice( reinterpret_cast<char*>( &loc ), sizeof( DiskLoc ) );
-            }
-
-            rocksdb::SliceParts sliceParts() const {
-                return rocksdb::SliceParts( sliced, 2 );
-            }
+        /** index keys are stored without field names */
+        BSONObj stripFieldNames( const BSONObj& obj ) {
+            if ( !obj.firstElement().fieldName()[0] )
+                return obj;
 
-            int size() const {
-                return obj.objsize() + sizeof( DiskLoc );
+            BSONObjBuilder b;
+            BSONObjIterator i( obj );
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                b.appendAs( e, "" );
             }
+            return b.obj();
+        }
 
-            string asString() const {
-                string s( size(), 1 );
-                memcpy( const_cast<char*>( s.c_str() ), sliced[0].data(), sliced[0].size() );
-                memcpy( const_cast<char*>( s.c_str() + sliced[0].size() ),
-                        sliced[1].data(), sliced[1].size() );
-                return s;
-            }
-
-            BSONObj obj;
-            DiskLoc loc;
-
-            rocksdb::Slice sliced[2];
-        };
-
+        /**
+         * Reads from a snapshot, so positions never need saving or fixing up around writes.
+         */
         class RocksCursor : public BtreeInterface::Cursor {
         public:
-            RocksCursor( rocksdb::Iterator* iterator, bool direction )
-                : _iterator( iterator ), _direction( direction ), _cached( false ) {
+            RocksCursor( const boost::shared_ptr<const rocksdb::Snapshot>& snapshot,
+                         const boost::shared_ptr<RocksIndexedWriteBatch>& batch,
+                         rocksdb::Iterator* iterator,
+                         const Ordering& ordering,
+                         bool direction )
+                : _snapshot( snapshot ),
+                  _batch( batch ),
+                  _iterator( iterator ),
+                  _ordering( ordering ),
+                  _direction( direction ),
+                  _cached( false ) {
 
                 // todo: maybe don't seek until we know we need to?
                 if ( _forward() )
@@ -119,14 +104,12 @@ namespace mongo {
             }
 
             void aboutToDeleteBucket(const DiskLoc& bucket) {
-                // don't know if I need this or not
+                // no buckets
             }
 
             bool locate(const BSONObj& key, const DiskLoc& loc) {
                 _cached = false;
-                IndexKey indexKey( key, loc );
-                string buf = indexKey.asString();
-                _iterator->Seek( buf );
+                _iterator->Seek( RocksIndexKey::make( key, _ordering, loc ) );
                 _checkStatus();
                 if ( !_iterator->Valid() )
                     return false;
@@ -177,11 +160,10 @@ namespace mongo {
             }
 
             void savePosition() {
-                invariant( !"rocksdb cursor doesn't do saving yet" );
+                // the iterator stays put on the snapshot
             }
 
             void restorePosition() {
-                invariant( !"rocksdb cursor doesn't do saving yet" );
             }
 
         private:
@@ -196,12 +178,14 @@ namespace mongo {
                 if ( _cached )
                     return;
                 _cached = true;
-                rocksdb::Slice slice = _iterator->key();
-                _cachedKey = BSONObj( slice.data() );
-                _cachedLoc = reinterpret_cast<const DiskLoc*>( slice.data() + _cachedKey.objsize() )[0];
+                _cachedKey = BSONObj( _iterator->value().data() ).getOwned();
+                _cachedLoc = RocksIndexKey::extractDiskLoc( _iterator->key() );
             }
 
+            boost::shared_ptr<const rocksdb::Snapshot> _snapshot; // outlives _iterator
+            boost::shared_ptr<RocksIndexedWriteBatch> _batch; // outlives _iterator
             scoped_ptr<rocksdb::Iterator> _iterator;
+            const Ordering _ordering;
             bool _direction;
 
             mutable bool _cached;
@@ -211,8 +195,10 @@ namespace mongo {
 
     }
 
-    RocksBtreeImpl::RocksBtreeImpl( rocksdb::DB* db, rocksdb::ColumnFamilyHandle* cf )
-        : _db( db ), _columnFamily( cf ) {
+    RocksBtreeImpl::RocksBtreeImpl( rocksdb::DB* db,
+                                    rocksdb::ColumnFamilyHandle* cf,
+                                    const Ordering& ordering )
+        : _db( db ), _columnFamily( cf ), _ordering( ordering ) {
         invariant( _db );
         invariant( _columnFamily );
     }
@@ -230,18 +216,15 @@ namespace mongo {
         RocksRecoveryUnit* ru = _getRecoveryUnit( txn );
 
         if ( !dupsAllowed ) {
-            // XXX: this is slow
-            Status status = dupKeyCheck( key, loc );
+            Status status = _dupKeyCheck( ru, key, loc );
             if ( !status.isOK() )
                 return status;
         }
 
-        IndexKey indexKey( key, loc );
-        string buf = indexKey.asString();
-
+        BSONObj stripped = stripFieldNames( key );
         ru->writeBatch()->Put( _columnFamily,
-                               indexKey.sliceParts(),
-                               singleByteSliceParts );
+                               RocksIndexKey::make( stripped, _ordering, loc ),
+                               rocksdb::Slice( stripped.objdata(), stripped.objsize() ) );
 
         return Status::OK();
     }
@@ -251,20 +234,68 @@ namespace mongo {
                                  const DiskLoc& loc) {
         RocksRecoveryUnit* ru = _getRecoveryUnit( txn );
 
-        IndexKey indexKey( key, loc );
-        string buf = indexKey.asString();
+        const std::string buf = RocksIndexKey::make( key, _ordering, loc );
 
+        // the key may have been inserted earlier in this unit of work
+        rocksdb::ReadOptions options;
+        options.snapshot = ru->snapshot().get();
         string dummy;
-        if ( !_db->KeyMayExist( rocksdb::ReadOptions(), _columnFamily, buf, &dummy ) )
+        rocksdb::Status status = ru->writeBatch()->GetFromBatchAndDB( _db,
+                                                                      options,
+                                                                      _columnFamily,
+                                                                      buf,
+                                                                      &dummy );
+        if ( status.IsNotFound() )
             return 0;
+        invariant( status.ok() );
 
         ru->writeBatch()->Delete( _columnFamily,
                                   buf );
-        return 1; // XXX: fix? does it matter since its so slow to check?
+        return 1;
     }
 
     Status RocksBtreeImpl::dupKeyCheck(const BSONObj& key, const DiskLoc& loc) {
-        // XXX: not done yet!
+        return _dupKeyCheck( NULL, key, loc );
+    }
+
+    Status RocksBtreeImpl::_dupKeyCheck( RocksRecoveryUnit* ru,
+                                         const BSONObj& key,
+                                         const DiskLoc& loc ) const {
+        const std::string prefix = RocksIndexKey::makePrefix( key, _ordering );
+
+        // a prefix seek: the bloom filters skip files without this key, and the iterator
+        // is only good for entries with it
+        rocksdb::ReadOptions options;
+        scoped_ptr<rocksdb::Iterator> it;
+        if ( ru ) {
+            options.snapshot = ru->snapshot().get();
+            it.reset( ru->writeBatch()->NewIteratorWithBase( _columnFamily,
+                                                             _db->NewIterator( options,
+                                                                               _columnFamily ) ) );
+        }
+        else {
+            it.reset( _db->NewIterator( options, _columnFamily ) );
+        }
+
+        for ( it->Seek( prefix ); it->Valid(); it->Next() ) {
+            const rocksdb::Slice current = it->key();
+            if ( current.size() != prefix.size() + RocksIndexKey::DiskLocSize ||
+                 memcmp( current.data(), prefix.data(), prefix.size() ) != 0 )
+                break;
+
+            if ( RocksIndexKey::extractDiskLoc( current ) == loc )
+                continue;
+
+            // the encoding can be equal for keys that aren't, see RocksIndexKey
+            BSONObj other( it->value().data() );
+            if ( other.woCompare( key, BSONObj(), false ) != 0 )
+                continue;
+
+            return Status( ErrorCodes::DuplicateKey,
+                           str::stream() << "E11000 duplicate key error dup key: "
+                                         << key.toString() );
+        }
+        invariant( it->status().ok() );
         return Status::OK();
     }
 
@@ -285,9 +316,29 @@ namespace mongo {
     }
 
     BtreeInterface::Cursor* RocksBtreeImpl::newCursor(int direction) const {
-        return new RocksCursor( _db->NewIterator( rocksdb::ReadOptions(),
-                                                  _columnFamily ),
-                                direction );
+        return _newCursor( RocksRecoveryUnit::newSnapshot( _db ),
+                           boost::shared_ptr<RocksIndexedWriteBatch>(),
+                           direction );
+    }
+
+    BtreeInterface::Cursor* RocksBtreeImpl::newCursor(OperationContext* txn,
+                                                      int direction) const {
+        RocksRecoveryUnit* ru = _getRecoveryUnit( txn );
+        return _newCursor( ru->snapshot(), ru->writeBatch(), direction );
+    }
+
+    BtreeInterface::Cursor* RocksBtreeImpl::_newCursor(
+                                const boost::shared_ptr<const rocksdb::Snapshot>& snapshot,
+                                const boost::shared_ptr<RocksIndexedWriteBatch>& batch,
+                                int direction ) const {
+        rocksdb::ReadOptions options;
+        options.snapshot = snapshot.get();
+        // cursors walk from key to key, which a prefix seek can't
+        options.total_order_seek = true;
+        rocksdb::Iterator* iterator = _db->NewIterator( options, _columnFamily );
+        if ( batch )
+            iterator = batch->NewIteratorWithBase( _columnFamily, iterator );
+        return new RocksCursor( snapshot, batch, iterator, _ordering, direction );
     }
 
     Status RocksBtreeImpl::initAsEmpty(OperationContext* txn) {
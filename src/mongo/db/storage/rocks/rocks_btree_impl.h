@@ -32,13 +32,17 @@
 
 #pragma once
 
+#include <boost/shared_ptr.hpp>
+
 namespace rocksdb {
     class ColumnFamilyHandle;
     class DB;
+    class Snapshot;
 }
 
 namespace mongo {
 
+    class RocksIndexedWriteBatch;
     class RocksRecoveryUnit;
 
     class RocksBtreeBuilderImpl : public BtreeBuilderInterface {
@@ -49,8 +53,12 @@ namespace mongo {
 
     class RocksBtreeImpl : public BtreeInterface {
     public:
+        /**
+         * @param ordering - of the index's key pattern, see RocksIndexKey
+         */
         RocksBtreeImpl( rocksdb::DB* db,
-                        rocksdb::ColumnFamilyHandle* cf );
+                        rocksdb::ColumnFamilyHandle* cf,
+                        const Ordering& ordering );
 
         virtual BtreeBuilderInterface* getBulkBuilder(OperationContext* txn,
                                                       bool dupsAllowed);
@@ -74,13 +82,30 @@ namespace mongo {
 
         virtual Cursor* newCursor(int direction) const;
 
+        /**
+         * Reads what txn's unit of work sees, own writes included, rather than a snapshot of
+         * its own as newCursor(int) does.
+         */
+        Cursor* newCursor(OperationContext* txn, int direction) const;
+
         virtual Status initAsEmpty(OperationContext* txn);
 
     private:
         RocksRecoveryUnit* _getRecoveryUnit( OperationContext* opCtx ) const;
 
+        /** @param ru - to see its uncommitted writes too, may be NULL */
+        Status _dupKeyCheck( RocksRecoveryUnit* ru,
+                             const BSONObj& key,
+                             const DiskLoc& loc ) const;
+
+        /** @param batch - writes to see on top of the snapshot, may be NULL */
+        Cursor* _newCursor( const boost::shared_ptr<const rocksdb::Snapshot>& snapshot,
+                            const boost::shared_ptr<RocksIndexedWriteBatch>& batch,
+                            int direction ) const;
+
         rocksdb::DB* _db;
         rocksdb::ColumnFamilyHandle* _columnFamily;
+        const Ordering _ordering;
 
     };
 }
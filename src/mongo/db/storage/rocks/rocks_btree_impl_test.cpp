@@ -75,7 +75,7 @@ namespace mongo {
         scoped_ptr<rocksdb::DB> db( getDB() );
 
         {
-            RocksBtreeImpl btree( db.get(), db->DefaultColumnFamily() );
+            RocksBtreeImpl btree( db.get(), db->DefaultColumnFamily(), Ordering::make( BSONObj() ) );
 
             BSONObj key = BSON( "" << 1 );
             DiskLoc loc( 5, 16 );
@@ -120,7 +120,7 @@ namespace mongo {
         scoped_ptr<rocksdb::DB> db( getDB() );
 
         {
-            RocksBtreeImpl btree( db.get(), db->DefaultColumnFamily() );
+            RocksBtreeImpl btree( db.get(), db->DefaultColumnFamily(), Ordering::make( BSONObj() ) );
 
             BSONObj key = BSON( "" << 1 );
             DiskLoc loc( 5, 16 );
@@ -152,7 +152,7 @@ namespace mongo {
         scoped_ptr<rocksdb::DB> db( getDB() );
 
         {
-            RocksBtreeImpl btree( db.get(), db->DefaultColumnFamily() );
+            RocksBtreeImpl btree( db.get(), db->DefaultColumnFamily(), Ordering::make( BSONObj() ) );
 
             {
                 MyOperationContext opCtx( db.get() );
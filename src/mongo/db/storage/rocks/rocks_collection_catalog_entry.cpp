@@ -40,6 +40,7 @@ namespace mongo {
     /**
      * bson schema
      * { ns: <name for sanity>,
+     *   options: <CollectionOptions, if any>,
      *   indexes : [ { spec : <bson spec>,
      *                 ready: <bool>,
      *                 head: DiskLoc,
@@ -50,12 +51,21 @@ namespace mongo {
     RocksCollectionCatalogEntry::RocksCollectionCatalogEntry( RocksEngine* engine,
                                                               const StringData& ns )
         : CollectionCatalogEntry( ns ), _engine( engine ) {
-        _metaDataKey = string("metadata-") + ns.toString();
+        _metaDataKey = metaDataKey( ns );
+    }
+
+    std::string RocksCollectionCatalogEntry::metaDataKey( const StringData& ns ) {
+        return string("metadata-") + ns.toString();
     }
 
     CollectionOptions RocksCollectionCatalogEntry::getCollectionOptions() const {
-        // todo: put more options in here?
-        return CollectionOptions();
+        MetaData md;
+        _getMetaData( &md );
+
+        CollectionOptions options;
+        Status status = options.parse( md.options );
+        invariant( status.isOK() );
+        return options;
     }
 
     // ------- indexes ----------
@@ -172,6 +182,13 @@ namespace mongo {
 
     Status RocksCollectionCatalogEntry::prepareForIndexBuild( OperationContext* txn,
                                                               const IndexDescriptor* spec ) {
+        Status status = RocksEngine::parseColumnFamilyOptions(
+                             RocksEngine::rocksOptions( spec->infoObj()["storageEngine"] ),
+                             true,
+                             NULL );
+        if ( !status.isOK() )
+            return status;
+
         boost::mutex::scoped_lock lk( _metaDataLock );
         MetaData md;
         _getMetaData_inlock( &md );
@@ -190,7 +207,7 @@ namespace mongo {
         invariant( !"ttl settings change not supported in rocks yet" );
     }
 
-    void RocksCollectionCatalogEntry::createMetaData() {
+    void RocksCollectionCatalogEntry::createMetaData( const CollectionOptions& options ) {
         string result;
         rocksdb::Status status = _engine->getDB()->Get( rocksdb::ReadOptions(),
                                                         _metaDataKey,
@@ -199,6 +216,7 @@ namespace mongo {
 
         MetaData md;
         md.ns = ns();
+        md.options = options.toBSON();
 
         BSONObj obj = md.toBSON();
         status = _engine->getDB()->Put( rocksdb::WriteOptions(),
@@ -251,6 +269,8 @@ namespace mongo {
     BSONObj RocksCollectionCatalogEntry::MetaData::toBSON() const {
         BSONObjBuilder b;
         b.append( "ns", ns );
+        if ( !options.isEmpty() )
+            b.append( "options", options );
         {
             BSONArrayBuilder arr( b.subarrayStart( "indexes" ) );
             for ( unsigned i = 0; i < indexes.size(); i++ ) {
@@ -269,6 +289,8 @@ namespace mongo {
 
     void RocksCollectionCatalogEntry::MetaData::parse( const BSONObj& obj ) {
         ns = obj["ns"].valuestrsafe();
+        if ( obj["options"].isABSONObj() )
+            options = obj["options"].Obj().getOwned();
 
         BSONElement e = obj["indexes"];
         if ( e.isABSONObj() ) {
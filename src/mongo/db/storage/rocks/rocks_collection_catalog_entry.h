@@ -31,6 +31,7 @@
 #pragma once
 
 #include "mongo/db/catalog/collection_catalog_entry.h"
+#include "mongo/db/catalog/collection_options.h"
 
 namespace mongo {
 
@@ -90,7 +91,7 @@ namespace mongo {
         // ------ internal api
 
         // called once when collection is created
-        void createMetaData();
+        void createMetaData( const CollectionOptions& options = CollectionOptions() );
 
         // when collection is dropped, call this
         // all indexes have to be dropped first
@@ -114,9 +115,13 @@ namespace mongo {
             int findIndexOffset( const StringData& name ) const;
 
             std::string ns;
+            BSONObj options; // CollectionOptions::toBSON()
             std::vector<IndexMetaData> indexes;
         };
 
+        /** where the MetaData for 'ns' is kept, in the default column family */
+        static std::string metaDataKey( const StringData& ns );
+
     private:
         bool _getMetaData( MetaData* out ) const;
         bool _getMetaData_inlock( MetaData* out ) const;
@@ -49,9 +49,14 @@ namespace mongo {
 
         invariant( type == "" ); // temp
 
-        rocksdb::ColumnFamilyHandle* cf = _engine->getIndexColumnFamily( collection->ns().ns(),
-                                                                         desc->indexName() );
-        std::auto_ptr<RocksBtreeImpl> raw( new RocksBtreeImpl( _engine->getDB(), cf ) );
+        rocksdb::ColumnFamilyHandle* cf =
+            _engine->getIndexColumnFamily( collection->ns().ns(),
+                                           desc->indexName(),
+                                           RocksEngine::rocksOptions(
+                                               desc->infoObj()["storageEngine"] ) );
+        std::auto_ptr<RocksBtreeImpl> raw( new RocksBtreeImpl( _engine->getDB(),
+                                                               cf,
+                                                               Ordering::make( desc->keyPattern() ) ) );
         return new BtreeAccessMethod( index, raw.release() );
     }
 }
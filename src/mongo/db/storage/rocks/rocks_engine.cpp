@@ -32,17 +32,23 @@
 #include "mongo/db/storage/rocks/rocks_engine.h"
 
 #include <boost/filesystem/operations.hpp>
+#include <boost/scoped_ptr.hpp>
 
 #include <rocksdb/db.h>
+#include <rocksdb/filter_policy.h>
 #include <rocksdb/slice.h>
+#include <rocksdb/slice_transform.h>
 #include <rocksdb/options.h>
+#include <rocksdb/table.h>
 
 #include "mongo/db/catalog/collection_options.h"
 #include "mongo/db/storage/rocks/rocks_collection_catalog_entry.h"
 #include "mongo/db/storage/rocks/rocks_database_catalog_entry.h"
+#include "mongo/db/storage/rocks/rocks_index_key.h"
 #include "mongo/db/storage/rocks/rocks_record_store.h"
 #include "mongo/db/storage/rocks/rocks_recovery_unit.h"
 #include "mongo/util/log.h"
+#include "mongo/util/mongoutils/str.h"
 
 #define ROCKS_TRACE log()
 
@@ -75,11 +81,21 @@ namespace mongo {
             else {
                 ROCK_STATUS_OK( status );
 
+                std::map<std::string, BSONObj> storageOptions = _loadStorageOptions( options,
+                                                                                     path );
+
                 for ( size_t i = 0; i < namespaces.size(); i++ ) {
                     std::string ns = namespaces[i];
                     bool isIndex = ns.find( '$' ) != string::npos;
-                    families.push_back( rocksdb::ColumnFamilyDescriptor( ns,
-                                                                         isIndex ? _indexOptions() : _collectionOptions() ) );
+
+                    rocksdb::ColumnFamilyOptions cfOptions;
+                    Status s = parseColumnFamilyOptions( storageOptions[ns], isIndex, &cfOptions );
+                    if ( !s.isOK() ) {
+                        // it was checked before it was stored
+                        error() << "bad rocks options stored for " << ns << ": " << s;
+                        invariant( false );
+                    }
+                    families.push_back( rocksdb::ColumnFamilyDescriptor( ns, cfOptions ) );
                 }
             }
         }
@@ -187,7 +203,8 @@ namespace mongo {
     }
 
     rocksdb::ColumnFamilyHandle* RocksEngine::getIndexColumnFamily( const StringData& ns,
-                                                                    const StringData& indexName ) {
+                                                                    const StringData& indexName,
+                                                                    const BSONObj& storageOptions ) {
         ROCKS_TRACE << "getIndexColumnFamily " << ns << "$" << indexName;
 
         boost::mutex::scoped_lock lk( _mapLock );
@@ -202,9 +219,13 @@ namespace mongo {
                 return handle.get();
         }
 
+        rocksdb::ColumnFamilyOptions cfOptions;
+        Status s = parseColumnFamilyOptions( storageOptions, true, &cfOptions );
+        invariant( s.isOK() ); // checked in prepareForIndexBuild
+
         string fullName = ns.toString() + string("$") + indexName.toString();
         rocksdb::ColumnFamilyHandle* cf;
-        rocksdb::Status status = _db->CreateColumnFamily( rocksdb::ColumnFamilyOptions(),
+        rocksdb::Status status = _db->CreateColumnFamily( cfOptions,
                                                           fullName,
                                                           &cf );
         ROCK_STATUS_OK( status );
@@ -240,10 +261,17 @@ namespace mongo {
             warning() << "RocksEngine doesn't support capped collections yet, using normal";
         }
 
+        rocksdb::ColumnFamilyOptions cfOptions;
+        Status s = parseColumnFamilyOptions( rocksOptions( options.storageEngine ),
+                                             false,
+                                             &cfOptions );
+        if ( !s.isOK() )
+            return s;
+
         boost::shared_ptr<Entry> entry( new Entry() );
 
         rocksdb::ColumnFamilyHandle* cf;
-        rocksdb::Status status = _db->CreateColumnFamily( rocksdb::ColumnFamilyOptions(),
+        rocksdb::Status status = _db->CreateColumnFamily( cfOptions,
                                                           ns.toString(),
                                                           &cf );
         ROCK_STATUS_OK( status );
@@ -251,7 +279,7 @@ namespace mongo {
         entry->cfHandle.reset( cf );
         entry->recordStore.reset( new RocksRecordStore( ns, _db, entry->cfHandle.get() ) );
         entry->collectionEntry.reset( new RocksCollectionCatalogEntry( this, ns ) );
-        entry->collectionEntry->createMetaData();
+        entry->collectionEntry->createMetaData( options );
 
         _map[ns] = entry;
         return Status::OK();
@@ -278,12 +306,165 @@ namespace mongo {
         return Status::OK();
     }
 
-    rocksdb::ColumnFamilyOptions RocksEngine::_collectionOptions() const {
-        return rocksdb::ColumnFamilyOptions();
+    BSONObj RocksEngine::rocksOptions( const BSONElement& storageEngine ) {
+        if ( !storageEngine.isABSONObj() )
+            return BSONObj();
+        return rocksOptions( storageEngine.Obj() );
+    }
+
+    BSONObj RocksEngine::rocksOptions( const BSONObj& storageEngine ) {
+        BSONElement e = storageEngine["rocks"];
+        if ( !e.isABSONObj() )
+            return BSONObj();
+        return e.Obj();
+    }
+
+    namespace {
+        struct CompressionName {
+            const char* name;
+            rocksdb::CompressionType type;
+        };
+
+        const CompressionName compressionNames[] = {
+            { "none", rocksdb::kNoCompression },
+            { "snappy", rocksdb::kSnappyCompression },
+            { "zlib", rocksdb::kZlibCompression },
+            { "bzip2", rocksdb::kBZip2Compression },
+            { "lz4", rocksdb::kLZ4Compression },
+            { "lz4hc", rocksdb::kLZ4HCCompression },
+        };
+
+        Status sizeOption( const BSONElement& e, long long min, long long max, long long* out ) {
+            if ( !e.isNumber() )
+                return Status( ErrorCodes::InvalidOptions,
+                               str::stream() << "rocks option " << e.fieldName()
+                                             << " has to be a number" );
+            long long n = e.numberLong();
+            if ( n < min || n > max )
+                return Status( ErrorCodes::InvalidOptions,
+                               str::stream() << "rocks option " << e.fieldName()
+                                             << " has to be between " << min
+                                             << " and " << max );
+            *out = n;
+            return Status::OK();
+        }
     }
 
-    rocksdb::ColumnFamilyOptions RocksEngine::_indexOptions() const {
-        return rocksdb::ColumnFamilyOptions();
+    Status RocksEngine::parseColumnFamilyOptions( const BSONObj& storageOptions,
+                                                  bool forIndex,
+                                                  rocksdb::ColumnFamilyOptions* out ) {
+        rocksdb::ColumnFamilyOptions options;
+        rocksdb::BlockBasedTableOptions tableOptions;
+
+        int bloomBitsPerKey = 0;
+        if ( forIndex ) {
+            // Bloom filters on the index key without the DiskLoc, so looking a key up skips the
+            // files that don't have it.  Whole keys get filtered too, for unindex.
+            options.prefix_extractor.reset( RocksIndexKey::newPrefixTransform() );
+            options.memtable_prefix_bloom_bits = 10 * 1024 * 1024;
+            tableOptions.whole_key_filtering = true;
+            bloomBitsPerKey = 10;
+        }
+
+        BSONObjIterator i( storageOptions );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            StringData name = e.fieldNameStringData();
+
+            if ( name == "compactionStyle" ) {
+                if ( e.type() == String && e.valueStringData() == "level" )
+                    options.compaction_style = rocksdb::kCompactionStyleLevel;
+                else if ( e.type() == String && e.valueStringData() == "universal" )
+                    options.compaction_style = rocksdb::kCompactionStyleUniversal;
+                else
+                    return Status( ErrorCodes::InvalidOptions,
+                                   "rocks compactionStyle has to be \"level\" or \"universal\"" );
+            }
+            else if ( name == "compression" ) {
+                size_t j = 0;
+                const size_t numNames = sizeof(compressionNames) / sizeof(compressionNames[0]);
+                while ( j < numNames &&
+                        !( e.type() == String && e.valueStringData() == compressionNames[j].name ) )
+                    j++;
+                if ( j == numNames )
+                    return Status( ErrorCodes::InvalidOptions,
+                                   str::stream() << "unknown rocks compression: " << e );
+                options.compression = compressionNames[j].type;
+            }
+            else if ( name == "blockSize" ) {
+                long long n;
+                Status s = sizeOption( e, 512, 64 * 1024 * 1024, &n );
+                if ( !s.isOK() )
+                    return s;
+                tableOptions.block_size = n;
+            }
+            else if ( name == "bloomBitsPerKey" ) {
+                long long n;
+                Status s = sizeOption( e, 0, 32, &n );
+                if ( !s.isOK() )
+                    return s;
+                bloomBitsPerKey = n;
+            }
+            else if ( name == "writeBufferSize" ) {
+                long long n;
+                Status s = sizeOption( e, 64 * 1024, 1024 * 1024 * 1024, &n );
+                if ( !s.isOK() )
+                    return s;
+                options.write_buffer_size = n;
+            }
+            else {
+                return Status( ErrorCodes::InvalidOptions,
+                               str::stream() << "unknown rocks option: " << name );
+            }
+        }
+
+        if ( !out )
+            return Status::OK();
+
+        if ( bloomBitsPerKey > 0 )
+            tableOptions.filter_policy.reset( rocksdb::NewBloomFilterPolicy( bloomBitsPerKey ) );
+        else
+            options.memtable_prefix_bloom_bits = 0;
+        options.table_factory.reset( rocksdb::NewBlockBasedTableFactory( tableOptions ) );
+
+        *out = options;
+        return Status::OK();
+    }
+
+    std::map<std::string, BSONObj> RocksEngine::_loadStorageOptions( const rocksdb::Options& options,
+                                                                     const std::string& path ) {
+        std::map<std::string, BSONObj> all;
+
+        // Column family options can't change once the db is open, so peek at the metadata
+        // through a read only handle on just the default column family first.
+        std::vector<rocksdb::ColumnFamilyDescriptor> families;
+        families.push_back( rocksdb::ColumnFamilyDescriptor( rocksdb::kDefaultColumnFamilyName,
+                                                             options ) );
+        std::vector<rocksdb::ColumnFamilyHandle*> handles;
+        rocksdb::DB* db;
+        rocksdb::Status status = rocksdb::DB::OpenForReadOnly( options, path, families,
+                                                               &handles, &db );
+        ROCK_STATUS_OK( status );
+        boost::scoped_ptr<rocksdb::DB> dbHolder( db );
+        boost::scoped_ptr<rocksdb::ColumnFamilyHandle> handleHolder( handles[0] );
+
+        const std::string prefix = RocksCollectionCatalogEntry::metaDataKey( "" );
+        boost::scoped_ptr<rocksdb::Iterator> it( db->NewIterator( rocksdb::ReadOptions(),
+                                                                  handles[0] ) );
+        for ( it->Seek( prefix ); it->Valid() && it->key().starts_with( prefix ); it->Next() ) {
+            RocksCollectionCatalogEntry::MetaData md;
+            md.parse( BSONObj( it->value().data() ) );
+
+            all[md.ns] = rocksOptions( md.options["storageEngine"] ).getOwned();
+            for ( size_t i = 0; i < md.indexes.size(); i++ ) {
+                const BSONObj& spec = md.indexes[i].spec;
+                all[md.ns + "$" + spec["name"].String()] =
+                    rocksOptions( spec["storageEngine"] ).getOwned();
+            }
+        }
+        ROCK_STATUS_OK( it->status() );
+
+        return all;
     }
 
 }
@@ -32,6 +32,7 @@
 #pragma once
 
 #include <list>
+#include <map>
 #include <string>
 
 #include <boost/scoped_ptr.hpp>
@@ -39,6 +40,7 @@
 #include <boost/thread/mutex.hpp>
 
 #include "mongo/base/disallow_copying.h"
+#include "mongo/db/jsobj.h"
 #include "mongo/db/storage/storage_engine.h"
 #include "mongo/util/string_map.h"
 
@@ -46,6 +48,7 @@ namespace rocksdb {
     class ColumnFamilyHandle;
     struct ColumnFamilyOptions;
     class DB;
+    struct Options;
 }
 
 namespace mongo {
@@ -98,8 +101,31 @@ namespace mongo {
 
         // will create if doesn't exist
         // collection has to exist first though
+        // @param storageOptions - as from rocksOptions(), must be valid
         rocksdb::ColumnFamilyHandle* getIndexColumnFamily( const StringData& ns,
-                                                           const StringData& indexName );
+                                                           const StringData& indexName,
+                                                           const BSONObj& storageOptions );
+
+        /**
+         * Our part of the storageEngine option for a collection or an index:
+         *     { rocks: { compactionStyle: "level"|"universal",
+         *                compression: "none"|"snappy"|"zlib"|"bzip2"|"lz4"|"lz4hc",
+         *                blockSize: <bytes>,
+         *                bloomBitsPerKey: <0 for none>,
+         *                writeBufferSize: <bytes> } }
+         * All of them are optional.
+         */
+        static BSONObj rocksOptions( const BSONElement& storageEngine );
+        static BSONObj rocksOptions( const BSONObj& storageEngine );
+
+        /**
+         * The options for a column family holding a collection or an index, with any of the
+         * above in 'storageOptions' applied.
+         * @param out - may be NULL to just check 'storageOptions'
+         */
+        static Status parseColumnFamilyOptions( const BSONObj& storageOptions,
+                                                bool forIndex,
+                                                rocksdb::ColumnFamilyOptions* out );
 
         struct Entry {
             boost::scoped_ptr<rocksdb::ColumnFamilyHandle> cfHandle;
@@ -113,8 +139,12 @@ namespace mongo {
 
     private:
 
-        rocksdb::ColumnFamilyOptions _collectionOptions() const;
-        rocksdb::ColumnFamilyOptions _indexOptions() const;
+        /**
+         * The storage options of each column family, by name.  They are in the collection
+         * metadata, which lives in the default column family.
+         */
+        static std::map<std::string, BSONObj> _loadStorageOptions( const rocksdb::Options& options,
+                                                                   const std::string& path );
 
         std::string _path;
         rocksdb::DB* _db;
@@ -282,4 +282,55 @@ namespace mongo {
 
     }
 
+    TEST( RocksEngineTest, ColumnFamilyOptions ) {
+        std::string path = "/tmp/mongo-rocks-engine-test";
+        boost::filesystem::remove_all( path );
+
+        BSONObj tuned = BSON( "rocks" << BSON( "compactionStyle" << "universal" <<
+                                               "blockSize" << 4096 ) );
+
+        {
+            RocksEngine engine( path );
+            MyOperationContext opCtx( &engine );
+
+            CollectionOptions bad;
+            ASSERT_OK( bad.parse( BSON( "storageEngine" <<
+                                        BSON( "rocks" << BSON( "compression" << "zip" ) ) ) ) );
+            ASSERT_EQUALS( ErrorCodes::InvalidOptions,
+                           engine.createCollection( &opCtx, "test.bad", bad ).code() );
+            ASSERT( !engine.getEntry( "test.bad" ) );
+
+            CollectionOptions options;
+            ASSERT_OK( options.parse( BSON( "storageEngine" << tuned ) ) );
+            ASSERT_OK( engine.createCollection( &opCtx, "test.foo", options ) );
+
+            CollectionOptions stored =
+                engine.getEntry( "test.foo" )->collectionEntry->getCollectionOptions();
+            ASSERT_EQUALS( tuned, stored.storageEngine );
+        }
+
+        {
+            // reopening has to give the column family the same options back
+            RocksEngine engine( path );
+            CollectionOptions stored =
+                engine.getEntry( "test.foo" )->collectionEntry->getCollectionOptions();
+            ASSERT_EQUALS( tuned, stored.storageEngine );
+        }
+    }
+
+    TEST( RocksEngineTest, ParseColumnFamilyOptions ) {
+        ASSERT_OK( RocksEngine::parseColumnFamilyOptions( BSONObj(), false, NULL ) );
+        ASSERT_OK( RocksEngine::parseColumnFamilyOptions( BSON( "bloomBitsPerKey" << 0 ),
+                                                          true, NULL ) );
+        ASSERT_OK( RocksEngine::parseColumnFamilyOptions( BSON( "compression" << "zlib" <<
+                                                                "writeBufferSize" << ( 1 << 20 ) ),
+                                                          false, NULL ) );
+        ASSERT_NOT_OK( RocksEngine::parseColumnFamilyOptions( BSON( "blockSize" << "big" ),
+                                                              false, NULL ) );
+        ASSERT_NOT_OK( RocksEngine::parseColumnFamilyOptions( BSON( "bloomBitsPerKey" << 100 ),
+                                                              true, NULL ) );
+        ASSERT_NOT_OK( RocksEngine::parseColumnFamilyOptions( BSON( "foo" << 1 ),
+                                                              false, NULL ) );
+    }
+
 }
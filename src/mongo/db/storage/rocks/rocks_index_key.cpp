@@ -0,0 +1,273 @@
+// rocks_index_key.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/rocks/rocks_index_key.h"
+
+#include <cstring>
+#include <limits>
+
+#include <rocksdb/slice.h>
+#include <rocksdb/slice_transform.h>
+
+
+namespace mongo {
+
+    namespace {
+
+        // every type byte is above this, so an object's end sorts before any more elements
+        const unsigned char EndOfObject = 0;
+
+        void appendUInt64( std::string* out, unsigned long long v ) {
+            for ( int shift = 56; shift >= 0; shift -= 8 )
+                out->push_back( static_cast<char>( ( v >> shift ) & 0xff ) );
+        }
+
+        void appendUInt32( std::string* out, unsigned v ) {
+            for ( int shift = 24; shift >= 0; shift -= 8 )
+                out->push_back( static_cast<char>( ( v >> shift ) & 0xff ) );
+        }
+
+        unsigned readUInt32( const char* p ) {
+            const unsigned char* u = reinterpret_cast<const unsigned char*>( p );
+            return ( unsigned( u[0] ) << 24 ) | ( unsigned( u[1] ) << 16 ) |
+                ( unsigned( u[2] ) << 8 ) | unsigned( u[3] );
+        }
+
+        // flipping the sign bit makes two's complement sort as unsigned
+        void appendInt64( std::string* out, long long v ) {
+            appendUInt64( out, static_cast<unsigned long long>( v ) ^ ( 1ULL << 63 ) );
+        }
+
+        void appendInt32( std::string* out, int v ) {
+            appendUInt32( out, static_cast<unsigned>( v ) ^ ( 1U << 31 ) );
+        }
+
+        void appendInt16( std::string* out, short v ) {
+            const unsigned u = static_cast<unsigned short>( v ) ^ ( 1U << 15 );
+            out->push_back( static_cast<char>( u >> 8 ) );
+            out->push_back( static_cast<char>( u & 0xff ) );
+        }
+
+        void appendDouble( std::string* out, double d ) {
+            if ( d != d ) {
+                // NaN is below every other number
+                appendUInt64( out, 0 );
+                return;
+            }
+            if ( d == 0 )
+                d = 0; // -0.0 == 0.0
+
+            unsigned long long bits;
+            memcpy( &bits, &d, sizeof( bits ) );
+            // negatives reverse their order, positives go above them
+            if ( bits & ( 1ULL << 63 ) )
+                bits = ~bits;
+            else
+                bits |= ( 1ULL << 63 );
+            appendUInt64( out, bits );
+        }
+
+        /**
+         * Every number is the nearest double, then how far the exact value is from it.  Only a
+         * NumberLong beyond 2^53 can be off, by at most half the spacing of doubles that big
+         * (1024), so two bytes hold the difference.
+         */
+        void appendNumber( std::string* out, const BSONElement& e ) {
+            if ( e.type() != NumberLong ) {
+                appendDouble( out, e.number() );
+                appendInt16( out, 0 );
+                return;
+            }
+
+            const long long v = e.numberLong();
+            const double d = static_cast<double>( v );
+            appendDouble( out, d );
+
+            // 2^63 itself doesn't fit in a long long, but only values just below it round to it
+            long long diff;
+            if ( d >= 9223372036854775808.0 )
+                diff = ( v - std::numeric_limits<long long>::max() ) - 1;
+            else
+                diff = v - static_cast<long long>( d );
+            appendInt16( out, static_cast<short>( diff ) );
+        }
+
+        /**
+         * 0 bytes become 0 1 and the end is 0 0, so a string sorts below any longer string it
+         * is a prefix of.
+         */
+        void appendString( std::string* out, const char* s, size_t len ) {
+            for ( size_t i = 0; i < len; i++ ) {
+                out->push_back( s[i] );
+                if ( s[i] == 0 )
+                    out->push_back( 1 );
+            }
+            out->push_back( 0 );
+            out->push_back( 0 );
+        }
+
+        void appendObject( std::string* out, const BSONObj& obj, bool withFieldNames );
+
+        void appendElement( std::string* out, const BSONElement& e, bool withFieldName ) {
+            // canonical types run from -1 (MinKey) up to 127 (MaxKey)
+            out->push_back( static_cast<char>( e.canonicalType() + 2 ) );
+
+            if ( withFieldName )
+                appendString( out, e.fieldName(), strlen( e.fieldName() ) );
+
+            switch ( e.type() ) {
+            case MinKey:
+            case MaxKey:
+            case EOO:
+            case Undefined:
+            case jstNULL:
+                break;
+            case NumberDouble:
+            case NumberInt:
+            case NumberLong:
+                appendNumber( out, e );
+                break;
+            case String:
+            case Symbol:
+            case Code:
+                appendString( out, e.valuestr(), e.valuestrsize() - 1 );
+                break;
+            case Object:
+            case Array:
+                appendObject( out, e.embeddedObject(), true );
+                break;
+            case BinData:
+                // length first, then subtype and bytes
+                appendUInt32( out, e.objsize() );
+                out->append( e.value() + 4, e.objsize() + 1 );
+                break;
+            case jstOID:
+                out->append( e.value(), 12 );
+                break;
+            case Bool:
+                out->push_back( e.boolean() ? 1 : 0 );
+                break;
+            case Date:
+                // shares a canonical type with Timestamp, but they don't compare alike
+                out->push_back( 0 );
+                appendInt64( out, e.date().millis );
+                break;
+            case Timestamp:
+                out->push_back( 1 );
+                appendUInt64( out, e.date().millis );
+                break;
+            case RegEx:
+                appendString( out, e.regex(), strlen( e.regex() ) );
+                appendString( out, e.regexFlags(), strlen( e.regexFlags() ) );
+                break;
+            case DBRef:
+                appendUInt32( out, e.valuesize() );
+                out->append( e.value(), e.valuesize() );
+                break;
+            case CodeWScope: {
+                // compared with strcmp, so only up to the first 0 counts
+                const char* code = e.codeWScopeCode();
+                const char* scope = e.codeWScopeScopeDataUnsafe();
+                appendString( out, code, strlen( code ) );
+                appendString( out, scope, strlen( scope ) );
+                break;
+            }
+            default:
+                verify( false );
+            }
+        }
+
+        void appendObject( std::string* out, const BSONObj& obj, bool withFieldNames ) {
+            BSONObjIterator it( obj );
+            while ( it.more() )
+                appendElement( out, it.next(), withFieldNames );
+            out->push_back( EndOfObject );
+        }
+
+        void appendKey( std::string* out, const BSONObj& key, const Ordering& ord ) {
+            BSONObjIterator it( key );
+            for ( int i = 0; it.more(); i++ ) {
+                const size_t start = out->size();
+                appendElement( out, it.next(), false );
+                if ( ord.get( i ) < 0 ) {
+                    // every element encoding is self delimiting, so this reverses its order
+                    for ( size_t j = start; j < out->size(); j++ )
+                        (*out)[j] = ~(*out)[j];
+                }
+            }
+        }
+
+        class IndexKeyPrefixTransform : public rocksdb::SliceTransform {
+        public:
+            virtual const char* Name() const { return "mongo.RocksIndexKeyPrefix"; }
+
+            virtual rocksdb::Slice Transform( const rocksdb::Slice& key ) const {
+                return rocksdb::Slice( key.data(), key.size() - RocksIndexKey::DiskLocSize );
+            }
+
+            virtual bool InDomain( const rocksdb::Slice& key ) const {
+                return key.size() >= RocksIndexKey::DiskLocSize;
+            }
+
+            virtual bool InRange( const rocksdb::Slice& dst ) const {
+                return true;
+            }
+        };
+
+    }
+
+    std::string RocksIndexKey::make( const BSONObj& key, const Ordering& ord, const DiskLoc& loc ) {
+        std::string out = makePrefix( key, ord );
+        appendInt32( &out, loc.a() );
+        appendInt32( &out, loc.getOfs() );
+        return out;
+    }
+
+    std::string RocksIndexKey::makePrefix( const BSONObj& key, const Ordering& ord ) {
+        std::string out;
+        out.reserve( key.objsize() + DiskLocSize );
+        appendKey( &out, key, ord );
+        return out;
+    }
+
+    DiskLoc RocksIndexKey::extractDiskLoc( const rocksdb::Slice& rocksKey ) {
+        invariant( rocksKey.size() >= DiskLocSize );
+        const char* p = rocksKey.data() + rocksKey.size() - DiskLocSize;
+        const int a = static_cast<int>( readUInt32( p ) ^ ( 1U << 31 ) );
+        const int ofs = static_cast<int>( readUInt32( p + 4 ) ^ ( 1U << 31 ) );
+        return DiskLoc( a, ofs );
+    }
+
+    rocksdb::SliceTransform* RocksIndexKey::newPrefixTransform() {
+        return new IndexKeyPrefixTransform();
+    }
+
+}
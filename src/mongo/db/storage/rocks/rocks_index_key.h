@@ -0,0 +1,77 @@
+// rocks_index_key.h
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "mongo/bson/ordering.h"
+#include "mongo/db/diskloc.h"
+#include "mongo/db/jsobj.h"
+
+namespace rocksdb {
+    class Slice;
+    class SliceTransform;
+}
+
+namespace mongo {
+
+    /**
+     * How RocksBtreeImpl lays out index entries.  The rocks key encodes the index key then the
+     * DiskLoc so that a plain memcmp orders entries the way BSONObj::woCompare (honoring the
+     * index's Ordering) and DiskLoc comparison would.  The value is the index key as BSON, so
+     * nothing has to be decoded from the rocks key but the DiskLoc.
+     *
+     * Known differences from woCompare: a NumberLong and a double compare by exact value where
+     * woCompare converts the NumberLong to a double first, and Dates sort before Timestamps
+     * rather than by value.
+     */
+    class RocksIndexKey {
+    public:
+        /** bytes the DiskLoc takes at the end of a rocks key */
+        static const size_t DiskLocSize = 8;
+
+        /** the rocks key for 'key' (field names ignored) at 'loc' */
+        static std::string make( const BSONObj& key, const Ordering& ord, const DiskLoc& loc );
+
+        /** just the part for 'key': the prefix of every entry for it */
+        static std::string makePrefix( const BSONObj& key, const Ordering& ord );
+
+        static DiskLoc extractDiskLoc( const rocksdb::Slice& rocksKey );
+
+        /**
+         * For index column families: maps a rocks key to its prefix without the DiskLoc, so
+         * bloom filters can rule out files on the index key alone.  Caller owns it.
+         */
+        static rocksdb::SliceTransform* newPrefixTransform();
+    };
+
+}
@@ -0,0 +1,160 @@
+// rocks_index_key_test.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/rocks/rocks_index_key.h"
+
+#include <limits>
+
+#include <rocksdb/slice.h>
+
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/mongoutils/str.h"
+
+using namespace mongo;
+
+namespace {
+
+    BSONObj keys[] = {
+        BSON( "" << MINKEY ),
+        BSON( "" << BSONNULL ),
+        BSON( "" << -std::numeric_limits<double>::infinity() ),
+        BSON( "" << -5.5 ),
+        BSON( "" << -5 ),
+        BSON( "" << 0 ),
+        BSON( "" << 1LL ),
+        BSON( "" << 1.5 ),
+        BSON( "" << 100 ),
+        BSON( "" << "" ),
+        BSON( "" << "a" ),
+        BSON( "" << "ab" ),
+        BSON( "" << "b" ),
+        BSON( "" << BSONObj() ),
+        BSON( "" << BSON( "a" << 1 ) ),
+        BSON( "" << BSON( "a" << 1 << "b" << 1 ) ),
+        BSON( "" << BSON( "a" << 2 ) ),
+        BSON( "" << BSON( "b" << 1 ) ),
+        BSON( "" << BSON_ARRAY( 1 << 2 ) ),
+        BSON( "" << OID( "000000000000000000000001" ) ),
+        BSON( "" << OID( "ff0000000000000000000000" ) ),
+        BSON( "" << false ),
+        BSON( "" << true ),
+        BSON( "" << Date_t( 1 ) ),
+        BSON( "" << Date_t( 2 ) ),
+        BSON( "" << MAXKEY ),
+    };
+
+    void assertSameOrder( const Ordering& ord, const BSONObj& pattern ) {
+        const int n = sizeof( keys ) / sizeof( keys[0] );
+        for ( int i = 0; i < n; i++ ) {
+            for ( int j = 0; j < n; j++ ) {
+                const int expected = keys[i].woCompare( keys[j], pattern, false );
+                const int actual = RocksIndexKey::make( keys[i], ord, DiskLoc( 1, 1 ) ).compare(
+                                   RocksIndexKey::make( keys[j], ord, DiskLoc( 1, 1 ) ) );
+                if ( ( expected < 0 ) != ( actual < 0 ) || ( expected == 0 ) != ( actual == 0 ) )
+                    FAIL( str::stream() << keys[i] << " vs " << keys[j] << ": expected "
+                                        << expected << ", got " << actual );
+            }
+        }
+    }
+
+    TEST( RocksIndexKeyTest, SortsLikeWoCompare ) {
+        assertSameOrder( Ordering::make( BSON( "a" << 1 ) ), BSON( "a" << 1 ) );
+    }
+
+    TEST( RocksIndexKeyTest, Descending ) {
+        assertSameOrder( Ordering::make( BSON( "a" << -1 ) ), BSON( "a" << -1 ) );
+    }
+
+    TEST( RocksIndexKeyTest, NumbersOfAnyTypeAreEqual ) {
+        const Ordering ord = Ordering::make( BSON( "a" << 1 ) );
+        ASSERT_EQUALS( RocksIndexKey::makePrefix( BSON( "" << 3 ), ord ),
+                       RocksIndexKey::makePrefix( BSON( "" << 3LL ), ord ) );
+        ASSERT_EQUALS( RocksIndexKey::makePrefix( BSON( "" << 3 ), ord ),
+                       RocksIndexKey::makePrefix( BSON( "" << 3.0 ), ord ) );
+        ASSERT_EQUALS( RocksIndexKey::makePrefix( BSON( "" << 0.0 ), ord ),
+                       RocksIndexKey::makePrefix( BSON( "" << -0.0 ), ord ) );
+    }
+
+    TEST( RocksIndexKeyTest, NumberLongsAreExact ) {
+        const Ordering ord = Ordering::make( BSON( "a" << 1 ) );
+        const long long big = 1LL << 53; // the first long long with no exact double neighbour
+
+        // in increasing order, whatever the nearest double is
+        const BSONObj numbers[] = {
+            BSON( "" << std::numeric_limits<long long>::min() ),
+            BSON( "" << std::numeric_limits<long long>::min() + 1 ),
+            BSON( "" << -big - 2 ),
+            BSON( "" << -big - 1 ),
+            BSON( "" << -big ),
+            BSON( "" << big ),
+            BSON( "" << big + 1 ),
+            BSON( "" << static_cast<double>( big + 2 ) ),
+            BSON( "" << big + 3 ),
+            BSON( "" << std::numeric_limits<long long>::max() - 1 ),
+            BSON( "" << std::numeric_limits<long long>::max() ),
+            BSON( "" << 9223372036854775808.0 ), // 2^63
+        };
+        const int n = sizeof( numbers ) / sizeof( numbers[0] );
+        for ( int i = 0; i + 1 < n; i++ ) {
+            ASSERT_LESS_THAN( RocksIndexKey::makePrefix( numbers[i], ord ),
+                              RocksIndexKey::makePrefix( numbers[i + 1], ord ) );
+        }
+
+        ASSERT_EQUALS( RocksIndexKey::makePrefix( BSON( "" << big ), ord ),
+                       RocksIndexKey::makePrefix( BSON( "" << static_cast<double>( big ) ),
+                                                  ord ) );
+        ASSERT_EQUALS( RocksIndexKey::makePrefix( BSON( "" << -big - 2 ), ord ),
+                       RocksIndexKey::makePrefix( BSON( "" << -static_cast<double>( big + 2 ) ),
+                                                  ord ) );
+    }
+
+    TEST( RocksIndexKeyTest, CompoundAndDiskLoc ) {
+        const Ordering ord = Ordering::make( BSON( "a" << 1 << "b" << -1 ) );
+        const BSONObj key = BSON( "" << "x" << "" << 2 );
+
+        // descending second field
+        ASSERT_LESS_THAN( RocksIndexKey::make( key, ord, DiskLoc( 1, 1 ) ),
+                          RocksIndexKey::make( BSON( "" << "x" << "" << 1 ), ord,
+                                               DiskLoc( 1, 1 ) ) );
+
+        ASSERT_LESS_THAN( RocksIndexKey::make( key, ord, DiskLoc( 0, 5 ) ),
+                          RocksIndexKey::make( key, ord, DiskLoc( 1, 1 ) ) );
+        ASSERT_LESS_THAN( RocksIndexKey::make( key, ord, DiskLoc( 1, -1 ) ),
+                          RocksIndexKey::make( key, ord, DiskLoc( 1, 1 ) ) );
+
+        const DiskLoc loc( 7, 123456 );
+        const std::string rocksKey = RocksIndexKey::make( key, ord, loc );
+        ASSERT_EQUALS( loc, RocksIndexKey::extractDiskLoc( rocksKey ) );
+        ASSERT_EQUALS( RocksIndexKey::makePrefix( key, ord ),
+                       rocksKey.substr( 0, rocksKey.size() - RocksIndexKey::DiskLocSize ) );
+    }
+
+}
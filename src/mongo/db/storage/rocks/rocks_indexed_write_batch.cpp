@@ -0,0 +1,282 @@
+// rocks_indexed_write_batch.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/rocks/rocks_indexed_write_batch.h"
+
+#include <rocksdb/db.h>
+#include <rocksdb/iterator.h>
+#include <rocksdb/slice.h>
+#include <rocksdb/options.h>
+#include <rocksdb/write_batch.h>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    namespace {
+
+        std::string joinParts( const rocksdb::SliceParts& parts ) {
+            std::string s;
+            for ( int i = 0; i < parts.num_parts; i++ )
+                s.append( parts.parts[i].data(), parts.parts[i].size() );
+            return s;
+        }
+
+        /**
+         * Merges the entries of one column family in a batch with an iterator over the db.
+         * Where both have a key the batch wins, and deleted entries hide the key.
+         *
+         * Once positioned, the source we're not on is always past the current key in the
+         * direction of travel, so Next() and Prev() only have to move the current source,
+         * unless the direction changes.
+         */
+        class BatchAndBaseIterator : public rocksdb::Iterator {
+        public:
+            BatchAndBaseIterator( const RocksIndexedWriteBatch::Entries* entries,
+                                  rocksdb::Iterator* base )
+                : _entries( entries ),
+                  _base( base ),
+                  _forward( true ),
+                  _batchValid( false ),
+                  _onBatch( false ) {
+            }
+
+            virtual bool Valid() const {
+                return _onBatch || _base->Valid();
+            }
+
+            virtual void SeekToFirst() {
+                _forward = true;
+                _base->SeekToFirst();
+                _batch = _entries->begin();
+                _batchValid = _batch != _entries->end();
+                _settle();
+            }
+
+            virtual void SeekToLast() {
+                _forward = false;
+                _base->SeekToLast();
+                _batch = _entries->end();
+                _batchValid = _batch != _entries->begin();
+                if ( _batchValid )
+                    --_batch;
+                _settle();
+            }
+
+            virtual void Seek( const rocksdb::Slice& target ) {
+                _forward = true;
+                _base->Seek( target );
+                _batch = _entries->lower_bound( target.ToString() );
+                _batchValid = _batch != _entries->end();
+                _settle();
+            }
+
+            virtual void Next() {
+                invariant( Valid() );
+                if ( !_forward ) {
+                    // position both sources just after the current key
+                    const std::string current = key().ToString();
+                    _forward = true;
+                    _base->Seek( current );
+                    if ( _base->Valid() && _base->key() == rocksdb::Slice( current ) )
+                        _base->Next();
+                    _batch = _entries->upper_bound( current );
+                    _batchValid = _batch != _entries->end();
+                }
+                else if ( _onBatch ) {
+                    _advanceBatch();
+                }
+                else {
+                    _base->Next();
+                }
+                _settle();
+            }
+
+            virtual void Prev() {
+                invariant( Valid() );
+                if ( _forward ) {
+                    // position both sources just before the current key
+                    const std::string current = key().ToString();
+                    _forward = false;
+                    _base->Seek( current );
+                    if ( _base->Valid() )
+                        _base->Prev();
+                    else
+                        _base->SeekToLast();
+                    _batch = _entries->lower_bound( current );
+                    _batchValid = _batch != _entries->begin();
+                    if ( _batchValid )
+                        --_batch;
+                }
+                else if ( _onBatch ) {
+                    _advanceBatch();
+                }
+                else {
+                    _base->Prev();
+                }
+                _settle();
+            }
+
+            virtual rocksdb::Slice key() const {
+                if ( _onBatch )
+                    return rocksdb::Slice( _batch->first );
+                return _base->key();
+            }
+
+            virtual rocksdb::Slice value() const {
+                if ( _onBatch )
+                    return rocksdb::Slice( _batch->second.value );
+                return _base->value();
+            }
+
+            virtual rocksdb::Status status() const {
+                return _base->status();
+            }
+
+        private:
+            void _advanceBatch() {
+                if ( _forward ) {
+                    ++_batch;
+                    _batchValid = _batch != _entries->end();
+                }
+                else if ( _batch == _entries->begin() ) {
+                    _batchValid = false;
+                }
+                else {
+                    --_batch;
+                }
+            }
+
+            /** picks the source with the next key, skipping deleted keys */
+            void _settle() {
+                while ( true ) {
+                    _onBatch = false;
+                    if ( !_batchValid )
+                        return;
+
+                    if ( _base->Valid() ) {
+                        int cmp = _base->key().compare( rocksdb::Slice( _batch->first ) );
+                        if ( !_forward )
+                            cmp = -cmp;
+                        if ( cmp < 0 )
+                            return;
+                        if ( cmp == 0 ) {
+                            // the batch's entry replaces this one
+                            if ( _forward )
+                                _base->Next();
+                            else
+                                _base->Prev();
+                        }
+                    }
+
+                    if ( !_batch->second.deleted ) {
+                        _onBatch = true;
+                        return;
+                    }
+                    _advanceBatch();
+                }
+            }
+
+            const RocksIndexedWriteBatch::Entries* _entries;
+            boost::scoped_ptr<rocksdb::Iterator> _base;
+
+            bool _forward;
+            RocksIndexedWriteBatch::Entries::const_iterator _batch;
+            bool _batchValid;
+            bool _onBatch;
+        };
+    }
+
+    RocksIndexedWriteBatch::RocksIndexedWriteBatch()
+        : _batch( new rocksdb::WriteBatch() ) {
+    }
+
+    RocksIndexedWriteBatch::~RocksIndexedWriteBatch() {
+    }
+
+    void RocksIndexedWriteBatch::Put( rocksdb::ColumnFamilyHandle* cf,
+                                      const rocksdb::Slice& key,
+                                      const rocksdb::Slice& value ) {
+        _batch->Put( cf, key, value );
+
+        Entry& entry = _entries[cf][key.ToString()];
+        entry.deleted = false;
+        entry.value = value.ToString();
+    }
+
+    void RocksIndexedWriteBatch::Put( rocksdb::ColumnFamilyHandle* cf,
+                                      const rocksdb::SliceParts& key,
+                                      const rocksdb::SliceParts& value ) {
+        _batch->Put( cf, key, value );
+
+        Entry& entry = _entries[cf][joinParts( key )];
+        entry.deleted = false;
+        entry.value = joinParts( value );
+    }
+
+    void RocksIndexedWriteBatch::Delete( rocksdb::ColumnFamilyHandle* cf,
+                                         const rocksdb::Slice& key ) {
+        _batch->Delete( cf, key );
+
+        Entry& entry = _entries[cf][key.ToString()];
+        entry.deleted = true;
+        entry.value.clear();
+    }
+
+    rocksdb::Status RocksIndexedWriteBatch::GetFromBatchAndDB( rocksdb::DB* db,
+                                                               const rocksdb::ReadOptions& options,
+                                                               rocksdb::ColumnFamilyHandle* cf,
+                                                               const rocksdb::Slice& key,
+                                                               std::string* value ) const {
+        std::map<rocksdb::ColumnFamilyHandle*, Entries>::const_iterator i = _entries.find( cf );
+        if ( i != _entries.end() ) {
+            Entries::const_iterator j = i->second.find( key.ToString() );
+            if ( j != i->second.end() ) {
+                if ( j->second.deleted )
+                    return rocksdb::Status::NotFound();
+                *value = j->second.value;
+                return rocksdb::Status::OK();
+            }
+        }
+        return db->Get( options, cf, key, value );
+    }
+
+    rocksdb::Iterator* RocksIndexedWriteBatch::NewIteratorWithBase( rocksdb::ColumnFamilyHandle* cf,
+                                                                    rocksdb::Iterator* base ) const {
+        std::map<rocksdb::ColumnFamilyHandle*, Entries>::const_iterator i = _entries.find( cf );
+        if ( i == _entries.end() ) {
+            // a write to cf after this won't be seen, so don't bother merging
+            return base;
+        }
+        return new BatchAndBaseIterator( &i->second, base );
+    }
+
+}
@@ -0,0 +1,111 @@
+// rocks_indexed_write_batch.h
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "mongo/base/disallow_copying.h"
+
+namespace rocksdb {
+    class ColumnFamilyHandle;
+    class DB;
+    class Iterator;
+    class Slice;
+    struct SliceParts;
+    class Status;
+    class WriteBatch;
+    struct ReadOptions;
+}
+
+namespace mongo {
+
+    /**
+     * A rocksdb::WriteBatch that keeps an index of what it holds, so reads in the same unit of
+     * work can see its writes before they are committed.  The method names follow rocksdb's.
+     *
+     * Keys are ordered bytewise, which is what every column family we create uses.
+     */
+    class RocksIndexedWriteBatch {
+        MONGO_DISALLOW_COPYING(RocksIndexedWriteBatch);
+    public:
+        RocksIndexedWriteBatch();
+        ~RocksIndexedWriteBatch();
+
+        void Put( rocksdb::ColumnFamilyHandle* cf,
+                  const rocksdb::Slice& key,
+                  const rocksdb::Slice& value );
+
+        void Put( rocksdb::ColumnFamilyHandle* cf,
+                  const rocksdb::SliceParts& key,
+                  const rocksdb::SliceParts& value );
+
+        void Delete( rocksdb::ColumnFamilyHandle* cf, const rocksdb::Slice& key );
+
+        /** what gets committed */
+        rocksdb::WriteBatch* GetWriteBatch() { return _batch.get(); }
+
+        /**
+         * Reads 'key' as it will be once this batch is committed on top of what 'options'
+         * sees in 'db'.
+         */
+        rocksdb::Status GetFromBatchAndDB( rocksdb::DB* db,
+                                           const rocksdb::ReadOptions& options,
+                                           rocksdb::ColumnFamilyHandle* cf,
+                                           const rocksdb::Slice& key,
+                                           std::string* value ) const;
+
+        /**
+         * Iterates over 'base' with this batch's writes to 'cf' laid over it.  Takes ownership
+         * of 'base'.  Writes added to the batch after this may or may not be seen.  This batch
+         * must outlive the returned iterator.
+         */
+        rocksdb::Iterator* NewIteratorWithBase( rocksdb::ColumnFamilyHandle* cf,
+                                                rocksdb::Iterator* base ) const;
+
+        /** a value, or that the key was deleted */
+        struct Entry {
+            Entry() : deleted( false ) {}
+            bool deleted;
+            std::string value;
+        };
+
+        typedef std::map<std::string, Entry> Entries;
+
+    private:
+        boost::scoped_ptr<rocksdb::WriteBatch> _batch;
+        std::map<rocksdb::ColumnFamilyHandle*, Entries> _entries;
+    };
+
+}
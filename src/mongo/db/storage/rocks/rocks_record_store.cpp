@@ -30,6 +30,7 @@
  */
 
 #include "mongo/db/operation_context.h"
+#include "mongo/db/storage/rocks/rocks_indexed_write_batch.h"
 #include "mongo/db/storage/rocks/rocks_record_store.h"
 #include "mongo/db/storage/rocks/rocks_recovery_unit.h"
 
@@ -72,12 +73,26 @@ namespace mongo {
     }
 
     RecordData RocksRecordStore::dataFor( const DiskLoc& loc) const {
+        return _get( NULL, NULL, loc );
+    }
+
+    RecordData RocksRecordStore::dataFor( OperationContext* txn, const DiskLoc& loc ) const {
+        RocksRecoveryUnit* ru = _getRecoveryUnit( txn );
+        return _get( ru->snapshot().get(), ru->writeBatch().get(), loc );
+    }
+
+    RecordData RocksRecordStore::_get( const rocksdb::Snapshot* snapshot,
+                                       const RocksIndexedWriteBatch* batch,
+                                       const DiskLoc& loc ) const {
+        rocksdb::ReadOptions options;
+        options.snapshot = snapshot;
+
         std::string value;
         rocksdb::Status status;
-        status = _db->Get( rocksdb::ReadOptions(),
-                           _columnFamily,
-                           _makeKey( loc ),
-                           &value );
+        if ( batch )
+            status = batch->GetFromBatchAndDB( _db, options, _columnFamily, _makeKey( loc ), &value );
+        else
+            status = _db->Get( options, _columnFamily, _makeKey( loc ), &value );
 
         if ( !status.ok() ) {
             if ( status.IsNotFound() )
@@ -120,7 +135,35 @@ namespace mongo {
     StatusWith<DiskLoc> RocksRecordStore::insertRecord( OperationContext* txn,
                                                         const DocWriter* doc,
                                                         bool enforceQuota ) {
-        invariant( false );
+        DiskLoc loc;
+        Status status = insertRecords( txn, &doc, 1, &loc, enforceQuota );
+        if ( !status.isOK() )
+            return StatusWith<DiskLoc>( status );
+        return StatusWith<DiskLoc>( loc );
+    }
+
+    Status RocksRecordStore::insertRecords( OperationContext* txn,
+                                            const DocWriter* const* docs,
+                                            size_t nDocs,
+                                            DiskLoc* locsOut,
+                                            bool enforceQuota ) {
+        RocksRecoveryUnit* ru = _getRecoveryUnit( txn );
+
+        // Put() copies into the batch, so one scratch buffer serves every document
+        std::vector<char> buf;
+        for ( size_t i = 0; i < nDocs; i++ ) {
+            const size_t len = docs[i]->documentSize();
+            if ( buf.size() < len )
+                buf.resize( len );
+            docs[i]->writeDocument( &buf[0] );
+
+            locsOut[i] = _nextId();
+            ru->writeBatch()->Put( _columnFamily,
+                                   _makeKey( locsOut[i] ),
+                                   rocksdb::Slice( &buf[0], len ) );
+        }
+
+        return Status::OK();
     }
 
     StatusWith<DiskLoc> RocksRecordStore::updateRecord( OperationContext* txn,
@@ -144,15 +187,21 @@ namespace mongo {
                                                 const mutablebson::DamageVector& damages ) {
         // todo: this should use the merge functionality in rocks
 
+        RocksRecoveryUnit* ru = _getRecoveryUnit( txn );
+
         rocksdb::Slice key = _makeKey( loc );
 
-        // get original value
+        // get original value, which may have been written earlier in this unit of work
+        rocksdb::ReadOptions options;
+        options.snapshot = ru->snapshot().get();
+
         std::string value;
         rocksdb::Status status;
-        status = _db->Get( rocksdb::ReadOptions(),
-                           _columnFamily,
-                           key,
-                           &value );
+        status = ru->writeBatch()->GetFromBatchAndDB( _db,
+                                                      options,
+                                                      _columnFamily,
+                                                      key,
+                                                      &value );
 
         if ( !status.ok() ) {
             if ( status.IsNotFound() )
@@ -172,11 +221,7 @@ namespace mongo {
         }
 
         // write back
-        status = _db->Put( rocksdb::WriteOptions(),
-                           _columnFamily,
-                           key,
-                           value );
-        invariant( status.ok() );
+        ru->writeBatch()->Put( _columnFamily, key, value );
         return Status::OK();
     }
 
@@ -187,7 +232,17 @@ namespace mongo {
         invariant( start == DiskLoc() );
         invariant( !tailable );
 
-        return new Iterator( this, dir );
+        return new Iterator( this,
+                             dir,
+                             RocksRecoveryUnit::newSnapshot( _db ),
+                             boost::shared_ptr<RocksIndexedWriteBatch>() );
+    }
+
+    RecordIterator* RocksRecordStore::getIterator( OperationContext* txn,
+                                                   const CollectionScanParams::Direction& dir
+                                                   ) const {
+        RocksRecoveryUnit* ru = _getRecoveryUnit( txn );
+        return new Iterator( this, dir, ru->snapshot(), ru->writeBatch() );
     }
 
 
@@ -196,7 +251,9 @@ namespace mongo {
     }
 
     std::vector<RecordIterator*> RocksRecordStore::getManyIterators() const {
-        invariant( false );
+        std::vector<RecordIterator*> out;
+        out.push_back( getIterator() );
+        return out;
     }
 
     Status RocksRecordStore::truncate( OperationContext* txn ) {
@@ -223,6 +280,23 @@ namespace mongo {
         bool valid = _db->GetProperty( _columnFamily, "rocksdb.stats", &statsString );
         invariant( valid );
         result->append( "stats", statsString );
+
+        // the numbers worth watching when tuning this collection's column family
+        static const char* const properties[] = {
+            "rocksdb.estimate-num-keys",
+            "rocksdb.cur-size-active-mem-table",
+            "rocksdb.num-immutable-mem-table",
+            "rocksdb.num-files-at-level0",
+            "rocksdb.estimate-table-readers-mem",
+        };
+        BSONObjBuilder b( result->subobjStart( "columnFamily" ) );
+        for ( size_t i = 0; i < sizeof(properties) / sizeof(properties[0]); i++ ) {
+            uint64_t value;
+            if ( _db->GetIntProperty( _columnFamily, properties[i], &value ) )
+                b.appendNumber( properties[i] + strlen( "rocksdb." ),
+                                static_cast<long long>( value ) );
+        }
+        b.done();
     }
 
     Status RocksRecordStore::touch( OperationContext* txn, BSONObjBuilder* output ) const {
@@ -251,11 +325,20 @@ namespace mongo {
     // --------
 
     RocksRecordStore::Iterator::Iterator( const RocksRecordStore* rs,
-                                          const CollectionScanParams::Direction& dir )
+                                          const CollectionScanParams::Direction& dir,
+                                          const boost::shared_ptr<const rocksdb::Snapshot>& snapshot,
+                                          const boost::shared_ptr<RocksIndexedWriteBatch>& batch )
         : _rs( rs ),
           _dir( dir ),
-          _iterator( _rs->_db->NewIterator( rocksdb::ReadOptions(),
-                                            rs->_columnFamily ) ) {
+          _snapshot( snapshot ),
+          _batch( batch ) {
+        invariant( _snapshot );
+
+        rocksdb::ReadOptions options;
+        options.snapshot = _snapshot.get();
+        rocksdb::Iterator* base = _rs->_db->NewIterator( options, rs->_columnFamily );
+        _iterator.reset( _batch ? _batch->NewIteratorWithBase( rs->_columnFamily, base ) : base );
+
         if ( _forward() )
             _iterator->SeekToFirst();
         else
@@ -269,7 +352,7 @@ namespace mongo {
     }
 
     bool RocksRecordStore::Iterator::isEOF() {
-        return !_iterator || !_iterator->Valid();
+        return !_iterator->Valid();
     }
 
     DiskLoc RocksRecordStore::Iterator::curr() {
@@ -291,22 +374,43 @@ namespace mongo {
         return toReturn;
     }
 
+    size_t RocksRecordStore::Iterator::getNextBatch( RecordLocAndData* out, size_t maxRecords ) {
+        size_t n = 0;
+        while ( n < maxRecords && !isEOF() ) {
+            // the iterator already holds the value, so skip the Get() that dataFor() would do
+            rocksdb::Slice value = _iterator->value();
+            boost::shared_array<char> data( new char[value.size()] );
+            memcpy( data.get(), value.data(), value.size() );
+
+            out[n].loc = curr();
+            out[n].data = RecordData( data.get(), value.size(), data );
+            n++;
+
+            if ( _forward() )
+                _iterator->Next();
+            else
+                _iterator->Prev();
+        }
+        _checkStatus();
+        return n;
+    }
+
     void RocksRecordStore::Iterator::invalidate(const DiskLoc& dl) {
-        _iterator.reset( NULL );
+        // the snapshot still has it
     }
 
     void RocksRecordStore::Iterator::prepareToYield() {
-        // XXX: ???
+        // nothing to save: the snapshot doesn't change while we're away
     }
 
     bool RocksRecordStore::Iterator::recoverFromYield() {
-        // XXX: ???
+        // XXX: should notice the collection being dropped
         return true;
     }
 
     RecordData RocksRecordStore::Iterator::dataFor( const DiskLoc& loc ) const {
         // XXX: use the iterator value
-        return _rs->dataFor( loc );
+        return _rs->_get( _snapshot.get(), _batch.get(), loc );
     }
 
     bool RocksRecordStore::Iterator::_forward() const {
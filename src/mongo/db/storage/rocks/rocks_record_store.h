@@ -31,6 +31,8 @@
 
 #include <string>
 
+#include <boost/shared_ptr.hpp>
+
 #include "mongo/db/structure/record_store.h"
 
 namespace rocksdb {
@@ -38,10 +40,12 @@ namespace rocksdb {
     class DB;
     class Iterator;
     class Slice;
+    class Snapshot;
 }
 
 namespace mongo {
 
+    class RocksIndexedWriteBatch;
     class RocksRecoveryUnit;
 
     class RocksRecordStore : public RecordStore {
@@ -67,6 +71,9 @@ namespace mongo {
 
         virtual RecordData dataFor( const DiskLoc& loc) const;
 
+        /** reads as txn's unit of work sees it, own writes included */
+        RecordData dataFor( OperationContext* txn, const DiskLoc& loc ) const;
+
         virtual void deleteRecord( OperationContext* txn, const DiskLoc& dl );
 
         virtual StatusWith<DiskLoc> insertRecord( OperationContext* txn,
@@ -78,6 +85,12 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota );
 
+        virtual Status insertRecords( OperationContext* txn,
+                                      const DocWriter* const* docs,
+                                      size_t nDocs,
+                                      DiskLoc* locsOut,
+                                      bool enforceQuota );
+
         virtual StatusWith<DiskLoc> updateRecord( OperationContext* txn,
                                                   const DiskLoc& oldLocation,
                                                   const char* data,
@@ -96,6 +109,14 @@ namespace mongo {
                                              CollectionScanParams::FORWARD
                                              ) const;
 
+        /**
+         * Iterates over what txn's unit of work sees, own writes included, rather than a
+         * snapshot of its own as getIterator() does.
+         */
+        RecordIterator* getIterator( OperationContext* txn,
+                                     const CollectionScanParams::Direction& dir =
+                                     CollectionScanParams::FORWARD ) const;
+
         virtual RecordIterator* getIteratorForRepair() const;
 
         virtual std::vector<RecordIterator*> getManyIterators() const;
@@ -127,13 +148,22 @@ namespace mongo {
                                               bool inclusive);
     private:
 
+        /**
+         * Reads from a snapshot taken no later than its construction, so nothing written after
+         * that is seen and nothing needs invalidating on yield.
+         */
         class Iterator : public RecordIterator {
         public:
-            Iterator( const RocksRecordStore* rs, const CollectionScanParams::Direction& dir );
+            /** @param batch - writes to see on top of the snapshot, may be NULL */
+            Iterator( const RocksRecordStore* rs,
+                      const CollectionScanParams::Direction& dir,
+                      const boost::shared_ptr<const rocksdb::Snapshot>& snapshot,
+                      const boost::shared_ptr<RocksIndexedWriteBatch>& batch );
 
             virtual bool isEOF();
             virtual DiskLoc curr();
             virtual DiskLoc getNext();
+            virtual size_t getNextBatch( RecordLocAndData* out, size_t maxRecords );
             virtual void invalidate(const DiskLoc& dl);
             virtual void prepareToYield();
             virtual bool recoverFromYield();
@@ -145,9 +175,19 @@ namespace mongo {
 
             const RocksRecordStore* _rs;
             CollectionScanParams::Direction _dir;
+            boost::shared_ptr<const rocksdb::Snapshot> _snapshot; // outlives _iterator
+            boost::shared_ptr<RocksIndexedWriteBatch> _batch; // outlives _iterator
             boost::scoped_ptr<rocksdb::Iterator> _iterator;
         };
 
+        /**
+         * @param snapshot - NULL to read the current data
+         * @param batch - uncommitted writes to read over it, may be NULL
+         */
+        RecordData _get( const rocksdb::Snapshot* snapshot,
+                         const RocksIndexedWriteBatch* batch,
+                         const DiskLoc& loc ) const;
+
         RocksRecoveryUnit* _getRecoveryUnit( OperationContext* opCtx ) const;
 
         DiskLoc _nextId();
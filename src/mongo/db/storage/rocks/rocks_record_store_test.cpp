@@ -37,6 +37,7 @@
 
 #include "mongo/db/operation_context.h"
 #include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/rocks/rocks_indexed_write_batch.h"
 #include "mongo/db/storage/rocks/rocks_record_store.h"
 #include "mongo/db/storage/rocks/rocks_recovery_unit.h"
 #include "mongo/unittest/unittest.h"
@@ -83,7 +84,7 @@ namespace mongo {
         {
             RocksRecoveryUnit ru( db.get(), false );
             ru.beginUnitOfWork();
-            ru.writeBatch()->Put( "a", "c" );
+            ru.writeBatch()->Put( db->DefaultColumnFamily(), "a", "c" );
 
             value = "x";
             db->Get( rocksdb::ReadOptions(), "a", &value );
@@ -111,7 +112,7 @@ namespace mongo {
         {
             RocksRecoveryUnit ru( db.get(), false );
             ru.beginUnitOfWork();
-            ru.writeBatch()->Put( "a", "c" );
+            ru.writeBatch()->Put( db->DefaultColumnFamily(), "a", "c" );
 
             // note: no endUnitOfWork or commitUnitOfWork
         }
@@ -337,4 +338,168 @@ namespace mongo {
         }
     }
 
+    TEST( RocksRecordStoreTest, IteratorReadsSnapshot ) {
+        scoped_ptr<rocksdb::DB> db( getDB() );
+
+        RocksRecordStore rs( "foo.bar", db.get(), db->DefaultColumnFamily() );
+        string s = "eliot was here";
+
+        DiskLoc loc;
+        {
+            MyOperationContext opCtx( db.get() );
+            WriteUnitOfWork uow( opCtx.recoveryUnit() );
+            StatusWith<DiskLoc> res = rs.insertRecord( &opCtx, s.c_str(), s.size() + 1, -1 );
+            ASSERT_OK( res.getStatus() );
+            loc = res.getValue();
+        }
+
+        scoped_ptr<RecordIterator> it( rs.getIterator() );
+
+        {
+            MyOperationContext opCtx( db.get() );
+            WriteUnitOfWork uow( opCtx.recoveryUnit() );
+            rs.deleteRecord( &opCtx, loc );
+        }
+
+        ASSERT( rs.dataFor( loc ).data() == NULL );
+
+        // deleted after the iterator was made, so still there for it
+        it->prepareToYield();
+        it->invalidate( loc );
+        ASSERT( it->recoverFromYield() );
+        ASSERT( !it->isEOF() );
+        ASSERT_EQUALS( loc, it->getNext() );
+        ASSERT_EQUALS( s, it->dataFor( loc ).data() );
+        ASSERT( it->isEOF() );
+    }
+
+    TEST( RocksRecordStoreTest, RecoveryUnitSnapshot ) {
+        scoped_ptr<rocksdb::DB> db( getDB() );
+
+        RocksRecordStore rs( "foo.bar", db.get(), db->DefaultColumnFamily() );
+        string s = "eliot was here";
+
+        MyOperationContext reader( db.get() );
+
+        DiskLoc loc;
+        {
+            MyOperationContext opCtx( db.get() );
+            WriteUnitOfWork uow( opCtx.recoveryUnit() );
+            StatusWith<DiskLoc> res = rs.insertRecord( &opCtx, s.c_str(), s.size() + 1, -1 );
+            ASSERT_OK( res.getStatus() );
+            loc = res.getValue();
+        }
+
+        {
+            // the reader's snapshot is taken on first read, after the insert
+            WriteUnitOfWork readerUow( reader.recoveryUnit() );
+            ASSERT_EQUALS( s, rs.dataFor( &reader, loc ).data() );
+
+            {
+                MyOperationContext opCtx( db.get() );
+                WriteUnitOfWork uow( opCtx.recoveryUnit() );
+                rs.deleteRecord( &opCtx, loc );
+            }
+
+            ASSERT( rs.dataFor( loc ).data() == NULL );
+            ASSERT_EQUALS( s, rs.dataFor( &reader, loc ).data() );
+        }
+
+        // the reader's unit of work is over, so it sees the delete now
+        ASSERT( rs.dataFor( &reader, loc ).data() == NULL );
+    }
+
+    TEST( RocksIndexedWriteBatchTest, IteratorMergesWithBase ) {
+        scoped_ptr<rocksdb::DB> db( getDB() );
+        rocksdb::ColumnFamilyHandle* cf = db->DefaultColumnFamily();
+
+        db->Put( rocksdb::WriteOptions(), "a", "1" );
+        db->Put( rocksdb::WriteOptions(), "c", "1" );
+        db->Put( rocksdb::WriteOptions(), "e", "1" );
+
+        RocksIndexedWriteBatch batch;
+        batch.Put( cf, "b", "2" );
+        batch.Put( cf, "c", "2" );
+        batch.Delete( cf, "e" );
+        batch.Put( cf, "f", "2" );
+
+        string value;
+        ASSERT( batch.GetFromBatchAndDB( db.get(), rocksdb::ReadOptions(), cf, "a", &value ).ok() );
+        ASSERT_EQUALS( "1", value );
+        ASSERT( batch.GetFromBatchAndDB( db.get(), rocksdb::ReadOptions(), cf, "c", &value ).ok() );
+        ASSERT_EQUALS( "2", value );
+        ASSERT( batch.GetFromBatchAndDB( db.get(), rocksdb::ReadOptions(), cf, "e",
+                                         &value ).IsNotFound() );
+
+        scoped_ptr<rocksdb::Iterator> it(
+            batch.NewIteratorWithBase( cf, db->NewIterator( rocksdb::ReadOptions(), cf ) ) );
+
+        const char* forward[] = { "a1", "b2", "c2", "f2" };
+        it->SeekToFirst();
+        for ( int i = 0; i < 4; i++ ) {
+            ASSERT( it->Valid() );
+            ASSERT_EQUALS( string( forward[i] ), it->key().ToString() + it->value().ToString() );
+            it->Next();
+        }
+        ASSERT( !it->Valid() );
+
+        it->SeekToLast();
+        for ( int i = 3; i >= 0; i-- ) {
+            ASSERT( it->Valid() );
+            ASSERT_EQUALS( string( forward[i] ), it->key().ToString() + it->value().ToString() );
+            it->Prev();
+        }
+        ASSERT( !it->Valid() );
+
+        // changing direction part way
+        it->Seek( "d" );
+        ASSERT_EQUALS( "f", it->key().ToString() );
+        it->Prev();
+        ASSERT_EQUALS( "c", it->key().ToString() );
+        it->Prev();
+        ASSERT_EQUALS( "b", it->key().ToString() );
+        it->Next();
+        ASSERT_EQUALS( "c", it->key().ToString() );
+        it->Next();
+        ASSERT_EQUALS( "f", it->key().ToString() );
+    }
+
+    TEST( RocksRecordStoreTest, ReadOwnWrites ) {
+        scoped_ptr<rocksdb::DB> db( getDB() );
+
+        RocksRecordStore rs( "foo.bar", db.get(), db->DefaultColumnFamily() );
+        string s1 = "eliot was here";
+        string s2 = "eliot was here again";
+
+        MyOperationContext opCtx( db.get() );
+        WriteUnitOfWork uow( opCtx.recoveryUnit() );
+
+        StatusWith<DiskLoc> res = rs.insertRecord( &opCtx, s1.c_str(), s1.size() + 1, -1 );
+        ASSERT_OK( res.getStatus() );
+        DiskLoc loc = res.getValue();
+
+        ASSERT( rs.dataFor( loc ).data() == NULL );
+        ASSERT_EQUALS( s1, rs.dataFor( &opCtx, loc ).data() );
+
+        res = rs.updateRecord( &opCtx, loc, s2.c_str(), s2.size() + 1, -1, NULL );
+        ASSERT_OK( res.getStatus() );
+        ASSERT_EQUALS( s2, rs.dataFor( &opCtx, loc ).data() );
+
+        {
+            scoped_ptr<RecordIterator> it( rs.getIterator( &opCtx ) );
+            ASSERT( !it->isEOF() );
+            ASSERT_EQUALS( loc, it->getNext() );
+            ASSERT_EQUALS( s2, it->dataFor( loc ).data() );
+            ASSERT( it->isEOF() );
+        }
+
+        rs.deleteRecord( &opCtx, loc );
+        ASSERT( rs.dataFor( &opCtx, loc ).data() == NULL );
+
+        {
+            scoped_ptr<RecordIterator> it( rs.getIterator( &opCtx ) );
+            ASSERT( it->isEOF() );
+        }
+    }
+
 }
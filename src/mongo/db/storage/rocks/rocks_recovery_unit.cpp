@@ -35,13 +35,26 @@
 #include <rocksdb/options.h>
 #include <rocksdb/write_batch.h>
 
+#include "mongo/db/storage/rocks/rocks_indexed_write_batch.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
+    namespace {
+        class ReleaseSnapshot {
+        public:
+            explicit ReleaseSnapshot( rocksdb::DB* db ) : _db( db ) {}
+            void operator()( const rocksdb::Snapshot* snapshot ) const {
+                _db->ReleaseSnapshot( snapshot );
+            }
+        private:
+            rocksdb::DB* _db;
+        };
+    }
+
     RocksRecoveryUnit::RocksRecoveryUnit( rocksdb::DB* db, bool defaultCommit )
         : _db( db ), _defaultCommit( defaultCommit ), _writeBatch(  ), _depth( 0 ) {
-        _writeBatch.reset( new rocksdb::WriteBatch() );
+        _writeBatch.reset( new RocksIndexedWriteBatch() );
     }
 
     RocksRecoveryUnit::~RocksRecoveryUnit() {
@@ -52,20 +65,24 @@ namespace mongo {
 
     void RocksRecoveryUnit::beginUnitOfWork() {
         if ( !_writeBatch ) {
-            _writeBatch.reset( new rocksdb::WriteBatch() );
+            _writeBatch.reset( new RocksIndexedWriteBatch() );
         }
         _depth++;
     }
     void RocksRecoveryUnit::commitUnitOfWork() {
         invariant( _writeBatch );
 
-        rocksdb::Status status = _db->Write( rocksdb::WriteOptions(), _writeBatch.get() );
+        rocksdb::Status status = _db->Write( rocksdb::WriteOptions(),
+                                             _writeBatch->GetWriteBatch() );
         if ( !status.ok() ) {
             log() << "uh oh: " << status.ToString();
             invariant( !"rocks write batch commit failed" );
         }
 
-        _writeBatch.reset( new rocksdb::WriteBatch() );
+        _writeBatch.reset( new RocksIndexedWriteBatch() );
+
+        // so reads after this see what was just written
+        _snapshot.reset();
     }
 
     void RocksRecoveryUnit::endUnitOfWork() {
@@ -90,8 +107,8 @@ namespace mongo {
     bool RocksRecoveryUnit::isCommitNeeded() const {
         return
             _writeBatch &&
-            ( _writeBatch->GetDataSize() > ( 1024 * 1024 * 50 ) ||
-              _writeBatch->Count() > 1000 );
+            ( _writeBatch->GetWriteBatch()->GetDataSize() > ( 1024 * 1024 * 50 ) ||
+              _writeBatch->GetWriteBatch()->Count() > 1000 );
     }
 
     void* RocksRecoveryUnit::writingPtr(void* data, size_t len) {
@@ -103,9 +120,20 @@ namespace mongo {
         log() << "RocksRecoveryUnit::syncDataAndTruncateJournal() does nothing";
     }
 
-    rocksdb::WriteBatch* RocksRecoveryUnit::writeBatch() {
+    const boost::shared_ptr<RocksIndexedWriteBatch>& RocksRecoveryUnit::writeBatch() {
         invariant( _writeBatch );
-        return _writeBatch.get();
+        return _writeBatch;
+    }
+
+    boost::shared_ptr<const rocksdb::Snapshot> RocksRecoveryUnit::snapshot() {
+        if ( !_snapshot )
+            _snapshot = newSnapshot( _db );
+        return _snapshot;
+    }
+
+    boost::shared_ptr<const rocksdb::Snapshot> RocksRecoveryUnit::newSnapshot( rocksdb::DB* db ) {
+        return boost::shared_ptr<const rocksdb::Snapshot>( db->GetSnapshot(),
+                                                           ReleaseSnapshot( db ) );
     }
 
 }
@@ -33,18 +33,20 @@
 #include <map>
 #include <string>
 
-#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include "mongo/base/disallow_copying.h"
 #include "mongo/db/storage/recovery_unit.h"
 
 namespace rocksdb {
     class DB;
-    class WriteBatch;
+    class Snapshot;
 }
 
 namespace mongo {
 
+    class RocksIndexedWriteBatch;
+
     class RocksRecoveryUnit : public RecoveryUnit {
         MONGO_DISALLOW_COPYING(RocksRecoveryUnit);
     public:
@@ -68,13 +70,28 @@ namespace mongo {
 
         // local api
 
-        rocksdb::WriteBatch* writeBatch();
+        /**
+         * Writes in this unit of work.  Reads that should see them go through it too.
+         * Iterators keep their reference, as the unit of work starts a new batch on commit.
+         */
+        const boost::shared_ptr<RocksIndexedWriteBatch>& writeBatch();
+
+        /**
+         * The snapshot reads in this unit of work should use.  Taken on first use and dropped
+         * when the unit of work commits, so every read until then sees the same data.
+         * Iterators hold on to their reference, so they can keep reading from it after that.
+         */
+        boost::shared_ptr<const rocksdb::Snapshot> snapshot();
+
+        /** a snapshot of 'db' that is released when the last reference goes */
+        static boost::shared_ptr<const rocksdb::Snapshot> newSnapshot( rocksdb::DB* db );
 
     private:
         rocksdb::DB* _db; // now owned
         bool _defaultCommit;
 
-        boost::scoped_ptr<rocksdb::WriteBatch> _writeBatch; // owned
+        boost::shared_ptr<RocksIndexedWriteBatch> _writeBatch;
+        boost::shared_ptr<const rocksdb::Snapshot> _snapshot;
         int _depth;
     };
 
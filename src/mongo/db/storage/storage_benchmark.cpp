@@ -0,0 +1,581 @@
+// storage_benchmark.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#include "mongo/db/storage/storage_benchmark.h"
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "mongo/bson/mutable/damage_vector.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/database.h"
+#include "mongo/db/catalog/database_holder.h"
+#include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/client.h"
+#include "mongo/db/curop.h"
+#include "mongo/db/d_concurrency.h"
+#include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_cursor.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage_options.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/log.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+
+    namespace {
+
+        const char* const workloadNames[] = {
+            "insert",
+            "pointRead",
+            "updateInPlace",
+            "updateMove",
+            "sequentialScan",
+            "indexRangeScan",
+            "delete",
+        };
+
+        const char* const indexName = "k_1";
+
+        // the largest value any numeric option takes, which bounds what the run allocates
+        const long long maxOptionValue = 16 * 1024 * 1024;
+
+        /**
+         * Like OperationContextImpl, but gets its RecoveryUnit from the engine being measured
+         * rather than from globalStorageEngine.
+         */
+        class BenchmarkOperationContext : public OperationContext {
+        public:
+            BenchmarkOperationContext( StorageEngine* engine ) {
+                _recovery.reset( engine->newRecoveryUnit( this ) );
+            }
+
+            virtual RecoveryUnit* recoveryUnit() const { return _recovery.get(); }
+
+            virtual LockState* lockState() const { return &cc().lockState(); }
+
+            virtual ProgressMeter* setMessage( const char* msg,
+                                               const std::string& name,
+                                               unsigned long long progressMeterTotal,
+                                               int secondsBetween ) {
+                return &getCurOp()->setMessage( msg, name, progressMeterTotal, secondsBetween );
+            }
+
+            virtual const char* getNS() const { return getCurOp()->getNS(); }
+
+            virtual Client* getClient() const { return &cc(); }
+
+            virtual CurOp* getCurOp() const { return cc().curop(); }
+
+            virtual void checkForInterrupt( bool heedMutex = true ) const { }
+
+            virtual Status checkForInterruptNoAssert() const { return Status::OK(); }
+
+            virtual bool isPrimaryFor( const StringData& ns ) { return true; }
+
+            virtual Transaction* getTransaction() {
+                return _tx.setTxIdOnce( (unsigned)getCurOp()->opNum() );
+            }
+
+        private:
+            boost::scoped_ptr<RecoveryUnit> _recovery;
+            Transaction _tx;
+        };
+
+        /**
+         * One run of the benchmark.  Document i is { _id: i, k: i, v: <int>, pad: <string> }
+         * and belongs to thread i % numThreads, so the threads never touch the same document.
+         */
+        class Benchmark {
+        public:
+            Benchmark( StorageEngine* engine,
+                       const StorageBenchmarkOptions& options,
+                       Collection* collection,
+                       const std::string& ns )
+                : _engine( engine ),
+                  _options( options ),
+                  _collection( collection ),
+                  _ns( ns ),
+                  _locs( options.numRecords ) {
+                BSONObj sample = _makeDoc( 0, 0 );
+                _vOffset = sample["v"].value() - sample.objdata();
+            }
+
+            /**
+             * Runs 'workload' on all the threads and appends its results to 'out'.
+             */
+            Status run( const std::string& workload, BSONObjBuilder* out ) {
+                std::vector< std::vector<int> > latencies( _options.numThreads );
+                std::vector<Status> statuses( _options.numThreads, Status::OK() );
+
+                Timer t;
+                {
+                    boost::thread_group threads;
+                    for ( int i = 0; i < _options.numThreads; i++ ) {
+                        threads.create_thread( boost::bind( &Benchmark::_thread, this,
+                                                            workload, i,
+                                                            &latencies[i], &statuses[i] ) );
+                    }
+                    threads.join_all();
+                }
+                long long micros = t.micros();
+
+                for ( size_t i = 0; i < statuses.size(); i++ ) {
+                    if ( !statuses[i].isOK() )
+                        return statuses[i];
+                }
+
+                std::vector<int> all;
+                for ( size_t i = 0; i < latencies.size(); i++ )
+                    all.insert( all.end(), latencies[i].begin(), latencies[i].end() );
+                std::sort( all.begin(), all.end() );
+
+                if ( out ) {
+                    BSONObjBuilder b( out->subobjStart( workload ) );
+                    b.appendNumber( "ops", static_cast<long long>( all.size() ) );
+                    b.appendNumber( "micros", micros );
+                    b.append( "opsPerSec",
+                              micros ? all.size() * 1000000.0 / micros : 0.0 );
+                    if ( !all.empty() ) {
+                        BSONObjBuilder lat( b.subobjStart( "latencyMicros" ) );
+                        lat.append( "min", all.front() );
+                        lat.append( "p50", _percentile( all, 50 ) );
+                        lat.append( "p95", _percentile( all, 95 ) );
+                        lat.append( "p99", _percentile( all, 99 ) );
+                        lat.append( "max", all.back() );
+                        lat.done();
+                    }
+                    b.done();
+                }
+                return Status::OK();
+            }
+
+        private:
+            static int _percentile( const std::vector<int>& sorted, int pct ) {
+                size_t i = sorted.size() * pct / 100;
+                return sorted[ std::min( i, sorted.size() - 1 ) ];
+            }
+
+            BSONObj _makeDoc( long long i, int v, int padSize = -1 ) const {
+                if ( padSize < 0 )
+                    padSize = _options.recordSize;
+                return BSON( "_id" << i << "k" << i << "v" << v
+                             << "pad" << std::string( padSize, 'x' ) );
+            }
+
+            void _thread( const std::string& workload,
+                          int threadNum,
+                          std::vector<int>* latencies,
+                          Status* status ) {
+                Client::initThread( "storagebench" );
+                try {
+                    BenchmarkOperationContext txn( _engine );
+                    PseudoRandom random( threadNum + 1 );
+                    _runThread( &txn, &random, workload, threadNum, latencies );
+                }
+                catch ( const DBException& e ) {
+                    *status = e.toStatus();
+                }
+                cc().shutdown();
+            }
+
+            /**
+             * @return the number of the 'n'th document that belongs to thread 'threadNum'
+             */
+            long long _docNum( int threadNum, long long n ) const {
+                return n * _options.numThreads + threadNum;
+            }
+
+            long long _docsForThread( int threadNum ) const {
+                long long n = _options.numRecords / _options.numThreads;
+                if ( threadNum < _options.numRecords % _options.numThreads )
+                    n++;
+                return n;
+            }
+
+            void _runThread( OperationContext* txn,
+                             PseudoRandom* random,
+                             const std::string& workload,
+                             int threadNum,
+                             std::vector<int>* latencies ) {
+                const long long numDocs = _docsForThread( threadNum );
+                if ( numDocs == 0 )
+                    return;
+
+                long long numOps = _options.numOps / _options.numThreads;
+                if ( workload == "insert" || workload == "delete" || workload == "updateMove" ) {
+                    // each of these can only be done once to a document
+                    numOps = numDocs;
+                }
+                else if ( workload == "sequentialScan" || workload == "indexRangeScan" ) {
+                    numOps = std::max( 1LL, numOps / _options.scanLength );
+                }
+                latencies->reserve( numOps );
+
+                for ( long long n = 0; n < numOps; n++ ) {
+                    long long i = workload == "insert" || workload == "delete" ||
+                                  workload == "updateMove" ?
+                        _docNum( threadNum, n ) :
+                        _docNum( threadNum, random->nextInt64( numDocs ) );
+
+                    Timer t;
+                    _runOp( txn, workload, i );
+                    latencies->push_back( t.micros() );
+                }
+            }
+
+            void _runOp( OperationContext* txn, const std::string& workload, long long i ) {
+                if ( workload == "insert" ) {
+                    Lock::DBWrite lk( txn->lockState(), _ns );
+                    WriteUnitOfWork wunit( txn->recoveryUnit() );
+                    StatusWith<DiskLoc> loc = _collection->insertDocument( txn,
+                                                                           _makeDoc( i, 0 ),
+                                                                           false );
+                    uassertStatusOK( loc.getStatus() );
+                    _locs[i] = loc.getValue();
+                    wunit.commit();
+                }
+                else if ( workload == "pointRead" ) {
+                    Lock::DBRead lk( txn->lockState(), _ns );
+                    BSONObj doc = _collection->docFor( _locs[i] );
+                    massert( 18531, "storage benchmark read the wrong document",
+                             doc["k"].numberLong() == i );
+                }
+                else if ( workload == "updateInPlace" ) {
+                    Lock::DBWrite lk( txn->lockState(), _ns );
+                    WriteUnitOfWork wunit( txn->recoveryUnit() );
+                    int v = static_cast<int>( i );
+                    mutablebson::DamageVector damages( 1 );
+                    damages[0].sourceOffset = 0;
+                    damages[0].targetOffset = _vOffset;
+                    damages[0].size = sizeof( v );
+                    uassertStatusOK( _collection->updateDocumentWithDamages(
+                                         txn, _locs[i], reinterpret_cast<const char*>( &v ),
+                                         damages ) );
+                    wunit.commit();
+                }
+                else if ( workload == "updateMove" ) {
+                    // more than twice the size can't fit in whatever padding the record had
+                    Lock::DBWrite lk( txn->lockState(), _ns );
+                    WriteUnitOfWork wunit( txn->recoveryUnit() );
+                    StatusWith<DiskLoc> loc =
+                        _collection->updateDocument( txn, _locs[i],
+                                                     _makeDoc( i, 0, 2 * _options.recordSize + 64 ),
+                                                     false, NULL );
+                    uassertStatusOK( loc.getStatus() );
+                    _locs[i] = loc.getValue();
+                    wunit.commit();
+                }
+                else if ( workload == "sequentialScan" ) {
+                    Lock::DBRead lk( txn->lockState(), _ns );
+                    boost::scoped_ptr<RecordIterator> it( _collection->getIterator( _locs[i] ) );
+                    for ( int n = 0; n < _options.scanLength && !it->isEOF(); n++ ) {
+                        DiskLoc loc = it->getNext();
+                        it->dataFor( loc );
+                    }
+                }
+                else if ( workload == "indexRangeScan" ) {
+                    Lock::DBRead lk( txn->lockState(), _ns );
+                    IndexCatalog* catalog = _collection->getIndexCatalog();
+                    IndexAccessMethod* iam =
+                        catalog->getIndex( catalog->findIndexByName( indexName ) );
+                    CursorOptions cursorOptions;
+                    cursorOptions.direction = CursorOptions::INCREASING;
+                    cursorOptions.numWanted = _options.scanLength;
+                    IndexCursor* raw;
+                    uassertStatusOK( iam->newCursor( cursorOptions, &raw ) );
+                    boost::scoped_ptr<IndexCursor> cursor( raw );
+                    uassertStatusOK( cursor->seek( BSON( "" << i ) ) );
+                    for ( int n = 0; n < _options.scanLength && !cursor->isEOF(); n++ ) {
+                        cursor->getValue();
+                        cursor->next();
+                    }
+                }
+                else if ( workload == "delete" ) {
+                    Lock::DBWrite lk( txn->lockState(), _ns );
+                    WriteUnitOfWork wunit( txn->recoveryUnit() );
+                    _collection->deleteDocument( txn, _locs[i] );
+                    wunit.commit();
+                }
+                else {
+                    invariant( false );
+                }
+            }
+
+            StorageEngine* _engine;
+            const StorageBenchmarkOptions& _options;
+            Collection* _collection;
+            const std::string _ns;
+            int _vOffset; // where the value of "v" is in each document
+
+            // where each document is, by document number
+            // each thread only touches its own documents, under the database lock
+            std::vector<DiskLoc> _locs;
+        };
+
+    } // namespace
+
+    StorageBenchmarkOptions::StorageBenchmarkOptions()
+        : numRecords( 10000 ),
+          recordSize( 128 ),
+          numOps( 10000 ),
+          numThreads( 1 ),
+          scanLength( 100 ) {
+    }
+
+    const std::vector<std::string>& StorageBenchmarkOptions::allWorkloads() {
+        static const std::vector<std::string> all(
+            workloadNames, workloadNames + sizeof( workloadNames ) / sizeof( workloadNames[0] ) );
+        return all;
+    }
+
+    StatusWith<StorageBenchmarkOptions> StorageBenchmarkOptions::parse( const BSONObj& obj ) {
+        StorageBenchmarkOptions options;
+
+        BSONObjIterator i( obj );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            StringData name = e.fieldNameStringData();
+
+            if ( name == "workloads" ) {
+                if ( e.type() != Array )
+                    return StatusWith<StorageBenchmarkOptions>( ErrorCodes::BadValue,
+                                                                "workloads must be an array" );
+                const std::vector<std::string>& all = allWorkloads();
+                BSONObjIterator j( e.Obj() );
+                while ( j.more() ) {
+                    std::string w = j.next().str();
+                    if ( std::find( all.begin(), all.end(), w ) == all.end() )
+                        return StatusWith<StorageBenchmarkOptions>(
+                            ErrorCodes::BadValue, str::stream() << "unknown workload: " << w );
+                    options.workloads.push_back( w );
+                }
+                continue;
+            }
+
+            if ( name != "numRecords" && name != "recordSize" && name != "numOps" &&
+                 name != "numThreads" && name != "scanLength" )
+                continue;
+
+            if ( !e.isNumber() )
+                return StatusWith<StorageBenchmarkOptions>(
+                    ErrorCodes::BadValue, str::stream() << name << " must be a number" );
+
+            // checked before anything is sized by it
+            if ( e.numberDouble() < 1 || e.numberDouble() > maxOptionValue )
+                return StatusWith<StorageBenchmarkOptions>(
+                    ErrorCodes::BadValue, str::stream() << name << " out of range" );
+
+            long long n = e.numberLong();
+            if ( name == "numRecords" )
+                options.numRecords = n;
+            else if ( name == "recordSize" )
+                options.recordSize = static_cast<int>( n );
+            else if ( name == "numOps" )
+                options.numOps = n;
+            else if ( name == "numThreads" )
+                options.numThreads = static_cast<int>( n );
+            else
+                options.scanLength = static_cast<int>( n );
+        }
+
+        if ( options.numThreads > 1024 )
+            return StatusWith<StorageBenchmarkOptions>( ErrorCodes::BadValue,
+                                                        "numThreads out of range" );
+
+        return StatusWith<StorageBenchmarkOptions>( options );
+    }
+
+    namespace {
+
+        /**
+         * Creates the collection in 'db', runs the workloads against it and drops it.
+         */
+        Status runWorkloads( BenchmarkOperationContext* txn,
+                             StorageEngine* engine,
+                             Database* db,
+                             const StorageBenchmarkOptions& options,
+                             BSONObjBuilder* out ) {
+            const std::string ns = db->name() + ".bench";
+            const std::vector<std::string>& workloads = options.workloads.empty() ?
+                StorageBenchmarkOptions::allWorkloads() : options.workloads;
+
+            Collection* collection;
+            {
+                Lock::DBWrite lk( txn->lockState(), ns );
+                WriteUnitOfWork wunit( txn->recoveryUnit() );
+                if ( db->getCollection( txn, ns ) )
+                    uassertStatusOK( db->dropCollection( txn, ns ) );
+                collection = db->createCollection( txn, ns );
+                Status status = collection->getIndexCatalog()->createIndex(
+                    txn,
+                    BSON( "ns" << ns << "key" << BSON( "k" << 1 ) << "name" << indexName ),
+                    false );
+                if ( !status.isOK() )
+                    return status;
+                wunit.commit();
+            }
+
+            Benchmark benchmark( engine, options, collection, ns );
+
+            // everything else works on the documents "insert" loads, so load them anyway
+            Status status = Status::OK();
+            if ( std::find( workloads.begin(), workloads.end(), "insert" ) == workloads.end() )
+                status = benchmark.run( "insert", NULL );
+
+            for ( size_t i = 0; i < workloads.size() && status.isOK(); i++ ) {
+                if ( workloads[i] == "delete" )
+                    continue;
+                log() << "storage benchmark: running " << workloads[i] << " on " << ns;
+                status = benchmark.run( workloads[i], out );
+            }
+
+            // it empties the collection, so goes last
+            if ( status.isOK() &&
+                 std::find( workloads.begin(), workloads.end(), "delete" ) != workloads.end() ) {
+                log() << "storage benchmark: running delete on " << ns;
+                status = benchmark.run( "delete", out );
+            }
+
+            {
+                Lock::DBWrite lk( txn->lockState(), ns );
+                WriteUnitOfWork wunit( txn->recoveryUnit() );
+                Status dropStatus = db->dropCollection( txn, ns );
+                if ( status.isOK() )
+                    status = dropStatus;
+                wunit.commit();
+            }
+            return status;
+        }
+
+    } // namespace
+
+    Status runStorageBenchmark( StorageEngine* engine,
+                                const std::string& dbName,
+                                const StorageBenchmarkOptions& options,
+                                BSONObjBuilder* out ) {
+        BenchmarkOperationContext txn( engine );
+        const bool isGlobal = ( engine == globalStorageEngine );
+
+        Database* db;
+        boost::scoped_ptr<Database> ownedDb;
+        {
+            Lock::GlobalWrite lk( txn.lockState() );
+            if ( isGlobal ) {
+                // Open it through the DatabaseHolder, so a client that uses it meanwhile gets
+                // this Database rather than mapping the files a second time.  Never take over
+                // a database someone else made, since it is all dropped at the end.
+                std::vector<std::string> existing;
+                engine->listDatabases( &existing );
+                if ( dbHolder().get( &txn, dbName ) ||
+                     std::find( existing.begin(), existing.end(), dbName ) != existing.end() )
+                    return Status( ErrorCodes::NamespaceExists,
+                                   str::stream() << "database " << dbName << " already exists" );
+                bool justCreated;
+                db = dbHolder().getOrCreate( &txn, dbName, justCreated );
+            }
+            else {
+                // Like repairDatabase's temporary database, this one isn't in the
+                // DatabaseHolder, which only knows about globalStorageEngine.
+                ownedDb.reset( new Database( &txn, dbName,
+                                             engine->getDatabaseCatalogEntry( &txn, dbName ) ) );
+                db = ownedDb.get();
+            }
+        }
+
+        Status status = Status::OK();
+        try {
+            status = runWorkloads( &txn, engine, db, options, out );
+        }
+        catch ( const DBException& e ) {
+            status = e.toStatus();
+        }
+
+        Lock::GlobalWrite lk( txn.lockState() );
+        if ( isGlobal ) {
+            Client::Context ctx( &txn, dbName );
+            WriteUnitOfWork wunit( txn.recoveryUnit() );
+            dropDatabase( &txn, ctx.db() );
+            wunit.commit();
+        }
+        else {
+            // as Database::closeDatabase does, flush before the files go away
+            txn.recoveryUnit()->commitIfNeeded( true );
+            ownedDb.reset();
+        }
+        return status;
+    }
+
+    Status runStorageBenchmark( const std::string& engineName,
+                                const StorageBenchmarkOptions& options,
+                                BSONObjBuilder* out ) {
+        const StorageEngine::Factory* factory = StorageEngine::getFactory( engineName );
+        if ( !factory )
+            return Status( ErrorCodes::BadValue,
+                           str::stream() << "unknown storage engine: " << engineName );
+
+        StorageEngine* engine = globalStorageEngine;
+        boost::scoped_ptr<StorageEngine> ownedEngine;
+        boost::filesystem::path path( storageGlobalParams.dbpath );
+        path /= "_storagebench_" + engineName;
+        if ( engineName != storageGlobalParams.engine ) {
+            StorageGlobalParams params = storageGlobalParams;
+            // anything left there is from a run that didn't finish
+            boost::filesystem::remove_all( path );
+            boost::filesystem::create_directories( path );
+            params.dbpath = path.string();
+            ownedEngine.reset( factory->create( params ) );
+            engine = ownedEngine.get();
+        }
+
+        out->append( "engine", engineName );
+        out->appendNumber( "numRecords", options.numRecords );
+        out->append( "recordSize", options.recordSize );
+        out->appendNumber( "numOps", options.numOps );
+        out->append( "numThreads", options.numThreads );
+        out->append( "scanLength", options.scanLength );
+
+        BSONObjBuilder workloads( out->subobjStart( "workloads" ) );
+        Status status = runStorageBenchmark( engine, "storagebench", options, &workloads );
+        workloads.done();
+
+        if ( ownedEngine ) {
+            ownedEngine.reset();
+            boost::filesystem::remove_all( path );
+        }
+        return status;
+    }
+}
@@ -0,0 +1,93 @@
+// storage_benchmark.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects for
+*    all of the code used other than as permitted herein. If you modify file(s)
+*    with this exception, you may extend this exception to your version of the
+*    file(s), but you are not obligated to do so. If you do not wish to do so,
+*    delete this exception statement from your version. If you delete this
+*    exception statement from all source files in the program, then also delete
+*    it in the license file.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/db/jsobj.h"
+
+namespace mongo {
+
+    class StorageEngine;
+
+    /**
+     * What runStorageBenchmark should do.  The defaults are small enough for a test run.
+     */
+    struct StorageBenchmarkOptions {
+        StorageBenchmarkOptions();
+
+        /**
+         * Reads options from a document such as
+         *   { numRecords: 100000, recordSize: 512, numOps: 100000, numThreads: 4,
+         *     scanLength: 100, workloads: [ "insert", "pointRead" ] }
+         * Fields that are left out keep their defaults.
+         */
+        static StatusWith<StorageBenchmarkOptions> parse( const BSONObj& obj );
+
+        /**
+         * the names of all the workloads, in the order they run in
+         */
+        static const std::vector<std::string>& allWorkloads();
+
+        long long numRecords; // documents loaded by "insert", the rest work on these
+        int recordSize; // bytes of padding in each document
+        long long numOps; // operations for each of the point workloads
+        int numThreads; // the documents are split between the threads
+        int scanLength; // records or keys read by each scan operation
+        std::vector<std::string> workloads; // empty means all of them
+    };
+
+    /**
+     * Loads a collection with an index on a fresh database in 'engine' and times the
+     * "insert", "pointRead", "updateInPlace", "updateMove", "sequentialScan", "indexRangeScan"
+     * and "delete" workloads against it, in that order.  Everything goes through Collection,
+     * so indexes are maintained as they would be for a client, and each operation takes the
+     * database lock on its own.  For each workload, 'out' gets
+     *   { ops, micros, opsPerSec, latencyMicros: { min, p50, p95, p99, max } }
+     * The database is dropped afterwards.  On globalStorageEngine it is opened through the
+     * DatabaseHolder, and NamespaceExists is returned if 'dbName' is already there.
+     */
+    Status runStorageBenchmark( StorageEngine* engine,
+                                const std::string& dbName,
+                                const StorageBenchmarkOptions& options,
+                                BSONObjBuilder* out );
+
+    /**
+     * Runs the benchmark against the engine registered as 'engineName'.  That is the global
+     * storage engine if it is the one this server runs on, otherwise a new one, which keeps
+     * its files in a subdirectory of the dbpath that is removed afterwards.
+     */
+    Status runStorageBenchmark( const std::string& engineName,
+                                const StorageBenchmarkOptions& options,
+                                BSONObjBuilder* out );
+}
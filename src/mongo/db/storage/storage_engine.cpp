@@ -42,6 +42,25 @@ namespace mongo {
 
     namespace {
         std::map<std::string,const StorageEngine::Factory*> factorys;
+
+        class MMAPV1Factory : public StorageEngine::Factory {
+        public:
+            virtual ~MMAPV1Factory(){}
+            virtual StorageEngine* create( const StorageGlobalParams& params ) const {
+                // the tools change storageGlobalParams.dbpath after the global engine is made
+                if ( params.dbpath == storageGlobalParams.dbpath )
+                    return new MMAPV1Engine();
+                return new MMAPV1Engine( params.dbpath );
+            }
+        };
+
+        class Heap1Factory : public StorageEngine::Factory {
+        public:
+            virtual ~Heap1Factory(){}
+            virtual StorageEngine* create( const StorageGlobalParams& params ) const {
+                return new Heap1Engine();
+            }
+        };
     } // namespace
 
     void StorageEngine::registerFactory( const std::string& name,
@@ -50,21 +69,39 @@ namespace mongo {
         factorys[name] = factory;
     }
 
-    MONGO_INITIALIZER(StorageEngineInit) (InitializerContext* context) {
-        if ( storageGlobalParams.engine == "mmapv1" ) {
-            globalStorageEngine = new MMAPV1Engine();
-        }
-        else if ( storageGlobalParams.engine == "heap1" ) {
-            globalStorageEngine = new Heap1Engine();
+    const StorageEngine::Factory* StorageEngine::getFactory( const std::string& name ) {
+        std::map<std::string,const StorageEngine::Factory*>::const_iterator i =
+            factorys.find( name );
+        if ( i == factorys.end() )
+            return NULL;
+        return i->second;
+    }
+
+    void StorageEngine::listFactories( std::vector<std::string>* out ) {
+        for ( std::map<std::string,const StorageEngine::Factory*>::const_iterator i =
+                  factorys.begin();
+              i != factorys.end();
+              ++i ) {
+            out->push_back( i->first );
         }
-        else {
-            const StorageEngine::Factory* factory = factorys[storageGlobalParams.engine];
-            if ( !factory ) {
-                error() << "unknown storage engine: " << storageGlobalParams.engine;
-                return Status( ErrorCodes::BadValue, "unknown storage engine" );
-            }
-            globalStorageEngine = factory->create( storageGlobalParams );
+    }
+
+    MONGO_INITIALIZER_GENERAL(BuiltinStorageEnginesInit,
+                              MONGO_DEFAULT_PREREQUISITES,
+                              ("StorageEngineInit") )(InitializerContext* context ) {
+        StorageEngine::registerFactory( "mmapv1", new MMAPV1Factory() );
+        StorageEngine::registerFactory( "heap1", new Heap1Factory() );
+        return Status::OK();
+    }
+
+    MONGO_INITIALIZER(StorageEngineInit) (InitializerContext* context) {
+        const StorageEngine::Factory* factory =
+            StorageEngine::getFactory( storageGlobalParams.engine );
+        if ( !factory ) {
+            error() << "unknown storage engine: " << storageGlobalParams.engine;
+            return Status( ErrorCodes::BadValue, "unknown storage engine" );
         }
+        globalStorageEngine = factory->create( storageGlobalParams );
         return Status::OK();
     }
 }
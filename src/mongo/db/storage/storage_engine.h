@@ -73,6 +73,16 @@ namespace mongo {
         };
 
         static void registerFactory( const std::string& name, const Factory* factory );
+
+        /**
+         * @return the factory registered under 'name', or NULL if there isn't one
+         */
+        static const Factory* getFactory( const std::string& name );
+
+        /**
+         * fills 'out' with the names of all registered factories, in name order
+         */
+        static void listFactories( std::vector<std::string>* out );
     };
 
     // TODO: this is temporary
@@ -109,6 +109,100 @@ namespace mongo {
     };
 
 
+    /**
+     * Keys sharing a long prefix can all be found after a bulk build, and again after inserting
+     * and removing more of them one at a time.
+     */
+    template<class OnDiskFormat>
+    class BuildThenModifyWithSharedPrefix {
+    public:
+        BuildThenModifyWithSharedPrefix() : _helper(BSON( "a" << 1 )) {
+        }
+
+        void run() {
+            OperationContextNoop txn;
+            Builder* builder = _helper.btree.newBuilder(&txn, false);
+
+            // Every other key goes in through the builder.
+            for ( int i = 0; i < nKeys; i += 2 ) {
+                ASSERT_OK( builder->addKey( key( i ), loc( i ) ) );
+            }
+            builder->commit( false );
+            delete builder;
+            assertKeys( 0, 2 );
+
+            for ( int i = 1; i < nKeys; i += 2 ) {
+                ASSERT_OK( _helper.btree.insert( &txn, key( i ), loc( i ), true ) );
+            }
+            assertKeys( 0, 1 );
+
+            for ( int i = 0; i < nKeys; i += 3 ) {
+                ASSERT( _helper.btree.unindex( &txn, key( i ), loc( i ) ) );
+            }
+            for ( int i = 0; i < nKeys; ++i ) {
+                if ( i % 3 == 0 ) {
+                    continue;
+                }
+                int pos;
+                DiskLoc bucketLoc;
+                ASSERT( _helper.btree.locate( key( i ), loc( i ), 1, &pos, &bucketLoc ) );
+            }
+            long long unused = 0;
+            ASSERT_EQUALS( nKeys - ( nKeys + 2 ) / 3,
+                           _helper.btree.fullValidate( &unused, true, false, 0 ) );
+        }
+
+    private:
+        typedef typename BtreeLogic<OnDiskFormat>::Builder Builder;
+
+        static const int nKeys = 3000;
+
+        static BSONObj key( int i ) {
+            return BSON( "a" << "users/profiles/settings/" + bigNumString( i, 16 ) );
+        }
+
+        static DiskLoc loc( int i ) {
+            return DiskLoc( 0, 16 * ( i + 1 ) );
+        }
+
+        void assertKeys( int start, int step ) {
+            for ( int i = start; i < nKeys; i += step ) {
+                int pos;
+                DiskLoc bucketLoc;
+                ASSERT( _helper.btree.locate( key( i ), loc( i ), 1, &pos, &bucketLoc ) );
+                // Index keys come back without field names.
+                ASSERT_EQUALS( 0, key( i ).woCompare( _helper.btree.getKey( bucketLoc, pos ),
+                                                      BSONObj(),
+                                                      false ) );
+            }
+        }
+
+        BtreeLogicTestHelper<OnDiskFormat> _helper;
+    };
+
+    /**
+     * The same keys take up fewer buckets when prefix compressed.
+     */
+    TEST( BtreeBuilderV2, PrefixCompressionUsesFewerBuckets ) {
+        OperationContextNoop txn;
+        BtreeLogicTestHelper<BtreeLayoutV1> v1(BSON( "a" << 1 ));
+        BtreeLogicTestHelper<BtreeLayoutV2> v2(BSON( "a" << 1 ));
+        scoped_ptr<BtreeLogic<BtreeLayoutV1>::Builder> b1(v1.btree.newBuilder(&txn, false));
+        scoped_ptr<BtreeLogic<BtreeLayoutV2>::Builder> b2(v2.btree.newBuilder(&txn, false));
+
+        for ( int i = 0; i < 5000; ++i ) {
+            BSONObj key = BSON( "a" << "users/profiles/settings/" + bigNumString( i, 16 ) );
+            ASSERT_OK( b1->addKey( key, DiskLoc( 0, 16 * ( i + 1 ) ) ) );
+            ASSERT_OK( b2->addKey( key, DiskLoc( 0, 16 * ( i + 1 ) ) ) );
+        }
+        b1->commit( false );
+        b2->commit( false );
+
+        long long unused = 0;
+        ASSERT_EQUALS( 5000, v2.btree.fullValidate( &unused, true, false, 0 ) );
+        ASSERT_LESS_THAN( v2.recordStore.numRecords(), v1.recordStore.numRecords() );
+    }
+
     //
     // TEST SUITE DEFINITION
     //
@@ -124,10 +218,12 @@ namespace mongo {
 
             add< InterruptCommit<OnDiskFormat> >( false );
             add< InterruptCommit<OnDiskFormat> >( true );
+            add< BuildThenModifyWithSharedPrefix<OnDiskFormat> >();
         }
     };
 
-    // Test suite for both V0 and V1
+    // Test suite for V0, V1 and V2
     static BtreeBuilderTestSuite<BtreeLayoutV0> SUITE_V0("BtreeBuilderTests V0");
     static BtreeBuilderTestSuite<BtreeLayoutV1> SUITE_V1("BtreeBuilderTests V1");
+    static BtreeBuilderTestSuite<BtreeLayoutV2> SUITE_V2("BtreeBuilderTests V2");
 } // namespace mongo
@@ -245,14 +245,21 @@ namespace mongo {
                                                          indexName,
                                                          bucketDeletion);
         }
-        else {
-            invariant(1 == version);
+        else if (1 == version) {
             return new BtreeInterfaceImpl<BtreeLayoutV1>(headManager,
                                                          recordStore,
                                                          ordering,
                                                          indexName,
                                                          bucketDeletion);
         }
+        else {
+            invariant(2 == version);
+            return new BtreeInterfaceImpl<BtreeLayoutV2>(headManager,
+                                                         recordStore,
+                                                         ordering,
+                                                         indexName,
+                                                         bucketDeletion);
+        }
     }
 
 }  // namespace mongo
@@ -71,6 +71,7 @@ namespace mongo {
         _first = _cur = _logic->_addBucket(txn);
         _b = _getModifiableBucket(_cur);
         _committed = false;
+        _repacked = false;
     }
 
     template <class BtreeLayout>
@@ -100,7 +101,17 @@ namespace mongo {
             }
         }
 
-        if (!_logic->_pushBack(_b, loc, *key, DiskLoc())) {
+        bool added = _logic->_pushBack(_b, loc, *key, DiskLoc());
+        if (!added && BtreeLayout::MaxPrefixLen > 0 && !_repacked) {
+            // Keys added since the bucket was started were stored whole.  Once it is full,
+            // re-encode them against their common prefix, which may leave room for more.
+            int unused = 0;
+            _logic->_packReadyForMod(_b, unused);
+            _repacked = true;
+            added = _logic->_pushBack(_b, loc, *key, DiskLoc());
+        }
+
+        if (!added) {
             // bucket was full
             newBucket();
             _logic->pushBack(_b, loc, *key, DiskLoc());
@@ -129,6 +140,7 @@ namespace mongo {
         _b->parent = newBucketLoc;
         _cur = newBucketLoc;
         _b = _getModifiableBucket(_cur);
+        _repacked = false;
     }
 
     template <class BtreeLayout>
@@ -156,9 +168,10 @@ namespace mongo {
                 }
 
                 BucketType* x = _getModifiableBucket(xloc);
-                KeyDataType k;
+                // Copy the key out first, it may not be stored contiguously in 'x'.
+                const KeyDataOwnedType k(getFullKey(x, x->n - 1).data);
                 DiskLoc r;
-                _logic->popBack(x, &r, &k);
+                _logic->popBack(x, &r);
                 bool keepX = (x->n != 0);
                 DiskLoc keepLoc = keepX ? xloc : x->nextChild;
 
@@ -345,18 +358,15 @@ namespace mongo {
      * does not bother returning that value.
      */
     template <class BtreeLayout>
-    void BtreeLogic<BtreeLayout>::popBack(BucketType* bucket,
-                                          DiskLoc* recordLocOut,
-                                          KeyDataType *keyDataOut) {
+    void BtreeLogic<BtreeLayout>::popBack(BucketType* bucket, DiskLoc* recordLocOut) {
 
         massert(17435,  "n==0 in btree popBack()", bucket->n > 0 );
 
         invariant(getKeyHeader(bucket, bucket->n - 1).isUsed());
 
-        FullKey kn = getFullKey(bucket, bucket->n - 1);
+        const KeyHeaderType& kn = getKeyHeader(bucket, bucket->n - 1);
         *recordLocOut = kn.recordLoc;
-        keyDataOut->assign(kn.data);
-        int keysize = kn.data.dataSize();
+        int keysize = BtreeLayout::storedKeySize(bucket, kn);
 
         massert(17436, "rchild not null in btree popBack()", bucket->nextChild.isNull());
 
@@ -364,9 +374,7 @@ namespace mongo {
         // full.
         bucket->nextChild = kn.prevChildBucket;
         bucket->n--;
-        // This is risky because the key we are returning points to this unalloc'ed memory,
-        // and we are assuming that the last key points to the last allocated
-        // bson region.
+        // We are assuming that the last key points to the last allocated bson region.
         bucket->emptySize += sizeof(KeyHeaderType);
         _unalloc(bucket, keysize);
     }
@@ -380,7 +388,7 @@ namespace mongo {
                                              const KeyDataType& key,
                                              const DiskLoc prevChild) {
 
-        int bytesNeeded = key.dataSize() + sizeof(KeyHeaderType);
+        int bytesNeeded = _keyDataSize(bucket, key) + sizeof(KeyHeaderType);
         if (bytesNeeded > bucket->emptySize) {
             return false;
         }
@@ -401,13 +409,79 @@ namespace mongo {
         KeyHeaderType& kn = getKeyHeader(bucket, bucket->n++);
         kn.prevChildBucket = prevChild;
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short)_alloc(bucket, key.dataSize()));
-        short ofs = kn.keyDataOfs();
-        char *p = dataAt(bucket, ofs);
-        memcpy(p, key.data(), key.dataSize());
+        _writeKeyData(bucket, &kn, key);
         return true;
     }
 
+    /**
+     * Bytes of key data 'key' would take up if written to 'bucket' now, which is less than its
+     * dataSize() if it shares leading bytes with the bucket's key prefix.
+     */
+    template <class BtreeLayout>
+    int BtreeLogic<BtreeLayout>::_keyDataSize(const BucketType* bucket, const KeyDataType& key) {
+        return key.dataSize()
+             - BtreeLayout::sharedPrefixLen(bucket, key.data(), key.dataSize());
+    }
+
+    /**
+     * Allocates _keyDataSize() bytes for 'key' and points 'kn' at them.  Space must be available.
+     */
+    template <class BtreeLayout>
+    void BtreeLogic<BtreeLayout>::_writeKeyData(BucketType* bucket,
+                                                KeyHeaderType* kn,
+                                                const KeyDataType& key) {
+        int shared = BtreeLayout::sharedPrefixLen(bucket, key.data(), key.dataSize());
+        int size = key.dataSize() - shared;
+        short ofs = static_cast<short>(_alloc(bucket, size));
+        BtreeLayout::setKeyData(kn, ofs, shared, size);
+        memcpy(dataAt(bucket, ofs), key.data() + shared, size);
+    }
+
+    /**
+     * Picks the key prefix a packed 'bucket' should be encoded with, copies it to 'prefixOut' and
+     * returns its length.  The candidates are the bucket's current prefix and the leading bytes of
+     * its first key; whichever stores the keys in fewer bytes wins, so packing never grows a
+     * bucket.
+     */
+    template <class BtreeLayout>
+    int BtreeLogic<BtreeLayout>::_choosePrefix(const BucketType* bucket, char* prefixOut) {
+        if (BtreeLayout::MaxPrefixLen == 0 || bucket->n == 0) {
+            return 0;
+        }
+
+        const FullKey first = getFullKey(bucket, 0);
+        const char* current = BtreeLayout::prefixData(bucket);
+        const int currentLen = BtreeLayout::prefixLen(bucket);
+        const int firstLen = std::min(first.data.dataSize(),
+                                      static_cast<int>(BtreeLayout::MaxPrefixLen));
+
+        // Extending a prefix by a byte costs one byte and saves one for each key that shares it,
+        // so a prefix taken from the first key pays off up to the longest match any other key has
+        // with it.
+        int sharedCurrent = commonPrefixLen(current, first.data.data(),
+                                            std::min(currentLen, first.data.dataSize()));
+        int savedFirst = 0;
+        int firstLenUsed = 0;
+        for (int i = 1; i < bucket->n; ++i) {
+            FullKey k = getFullKey(bucket, i);
+            sharedCurrent += commonPrefixLen(current, k.data.data(),
+                                             std::min(currentLen, k.data.dataSize()));
+            int matched = commonPrefixLen(first.data.data(), k.data.data(),
+                                          std::min(firstLen, k.data.dataSize()));
+            savedFirst += matched;
+            firstLenUsed = std::max(firstLenUsed, matched);
+        }
+        int savedCurrent = sharedCurrent - currentLen;
+
+        if (savedCurrent >= savedFirst) {
+            memcpy(prefixOut, current, currentLen);
+            return currentLen;
+        }
+
+        memcpy(prefixOut, first.data.data(), firstLenUsed);
+        return firstLenUsed;
+    }
+
     /**
      * Durability note:
      *
@@ -430,9 +504,11 @@ namespace mongo {
         invariant(bucket->n < 1024);
         invariant(keypos >= 0 && keypos <= bucket->n);
 
-        int bytesNeeded = key.dataSize() + sizeof(KeyHeaderType);
+        int bytesNeeded = _keyDataSize(bucket, key) + sizeof(KeyHeaderType);
         if (bytesNeeded > bucket->emptySize) {
             _pack(txn, bucket, bucketLoc, keypos);
+            // Packing may have changed the key prefix.
+            bytesNeeded = _keyDataSize(bucket, key) + sizeof(KeyHeaderType);
             if (bytesNeeded > bucket->emptySize) {
                 return false;
             }
@@ -464,10 +540,12 @@ namespace mongo {
         KeyHeaderType& kn = getKeyHeader(bucket, keypos);
         kn.prevChildBucket.Null();
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short) _alloc(bucket, key.dataSize()));
-        char *p = dataAt(bucket, kn.keyDataOfs());
-        txn->recoveryUnit()->writingPtr(p, key.dataSize());
-        memcpy(p, key.data(), key.dataSize());
+        int keySize = bytesNeeded - sizeof(KeyHeaderType);
+        // Declare that we will write the key data where _writeKeyData() allocates it.
+        txn->recoveryUnit()->writingPtr(dataAt(bucket, totalDataSize(bucket)
+                                                       - bucket->topSize - keySize),
+                                        keySize);
+        _writeKeyData(bucket, &kn, key);
         return true;
     }
 
@@ -476,7 +554,7 @@ namespace mongo {
      * creation of an empty bucket.
      */
     template <class BtreeLayout>
-    bool BtreeLogic<BtreeLayout>::mayDropKey(BucketType* bucket, int index, int refPos) {
+    bool BtreeLogic<BtreeLayout>::mayDropKey(const BucketType* bucket, int index, int refPos) {
         return index > 0
             && (index != refPos)
             && getKeyHeader(bucket, index).isUnused()
@@ -484,8 +562,10 @@ namespace mongo {
     }
 
     template <class BtreeLayout>
-    int BtreeLogic<BtreeLayout>::_packedDataSize(BucketType* bucket, int refPos) {
-        if (bucket->flags & Packed) {
+    int BtreeLogic<BtreeLayout>::_packedDataSize(const BucketType* bucket, int refPos) {
+        // Prefix compressed keys are counted at full size.  They may be re-encoded against a
+        // different prefix when moved, and this is the size they can't exceed after that.
+        if ((bucket->flags & Packed) && BtreeLayout::MaxPrefixLen == 0) {
             return BtreeLayout::BucketSize - bucket->emptySize - BucketType::HeaderSize;
         }
 
@@ -512,7 +592,8 @@ namespace mongo {
 
         invariant(getBucket(thisLoc) == bucket);
 
-        if (bucket->flags & Packed) {
+        // A packed bucket may still compress better under a new key prefix.
+        if ((bucket->flags & Packed) && BtreeLayout::MaxPrefixLen == 0) {
             return;
         }
 
@@ -524,15 +605,10 @@ namespace mongo {
      */
     template <class BtreeLayout>
     void BtreeLogic<BtreeLayout>::_packReadyForMod(BucketType* bucket, int &refPos) {
-        if (bucket->flags & Packed) {
+        if ((bucket->flags & Packed) && BtreeLayout::MaxPrefixLen == 0) {
             return;
         }
 
-        int tdz = totalDataSize(bucket);
-        char temp[BtreeLayout::BucketSize];
-        int ofs = tdz;
-        bucket->topSize = 0;
-
         int i = 0;
         for (int j = 0; j < bucket->n; j++) {
             if (mayDropKey(bucket, j, refPos)) {
@@ -547,13 +623,6 @@ namespace mongo {
                 }
                 getKeyHeader(bucket, i) = getKeyHeader(bucket, j);
             }
-
-            short ofsold = getKeyHeader(bucket, i).keyDataOfs();
-            int sz = getFullKey(bucket, i).data.dataSize();
-            ofs -= sz;
-            bucket->topSize += sz;
-            memcpy(temp + ofs, dataAt(bucket, ofsold), sz);
-            getKeyHeader(bucket, i).setKeyDataOfsSavingUse(ofs);
             ++i;
         }
 
@@ -562,8 +631,37 @@ namespace mongo {
         }
 
         bucket->n = i;
+
+        // Key data is read from the old layout until it is all copied, so the new prefix goes in
+        // the header last.
+        char prefix[BtreeLayout::MaxPrefixLen + 1];
+        int prefixLen = _choosePrefix(bucket, prefix);
+
+        int tdz = totalDataSize(bucket);
+        char temp[BtreeLayout::BucketSize];
+        int ofs = tdz;
+        bucket->topSize = 0;
+
+        // The prefix sits above the keys so the last key stays lowest, as popBack() expects.
+        ofs -= prefixLen;
+        bucket->topSize += prefixLen;
+        memcpy(temp + ofs, prefix, prefixLen);
+        short prefixOfs = ofs;
+
+        for (i = 0; i < bucket->n; i++) {
+            FullKey k = getFullKey(bucket, i);
+            int shared = commonPrefixLen(prefix, k.data.data(),
+                                         std::min(prefixLen, k.data.dataSize()));
+            int sz = k.data.dataSize() - shared;
+            ofs -= sz;
+            bucket->topSize += sz;
+            memcpy(temp + ofs, k.data.data() + shared, sz);
+            BtreeLayout::setKeyData(&getKeyHeader(bucket, i), ofs, shared, sz);
+        }
+
         int dataUsed = tdz - ofs;
         memcpy(bucket->data + ofs, temp + ofs, dataUsed);
+        BtreeLayout::setPrefix(bucket, prefixOfs, prefixLen);
 
         bucket->emptySize = tdz - dataUsed - bucket->n * sizeof(KeyHeaderType);
         {
@@ -611,7 +709,8 @@ namespace mongo {
                            / (keypos == bucket->n ? 10 : 2);
 
         for (int i = bucket->n - 1; i > -1; --i) {
-            rightSize += getFullKey(bucket, i).data.dataSize() + sizeof(KeyHeaderType);
+            rightSize += BtreeLayout::storedKeySize(bucket, getKeyHeader(bucket, i))
+                       + sizeof(KeyHeaderType);
             if (rightSize > rightSizeLimit) {
                 split = i;
                 break;
@@ -648,10 +747,24 @@ namespace mongo {
         KeyHeaderType &kn = getKeyHeader(bucket, i);
         kn.recordLoc = recordLoc;
         kn.prevChildBucket = prevChildBucket;
-        short ofs = (short) _alloc(bucket, key.dataSize());
-        kn.setKeyDataOfs(ofs);
-        char *p = dataAt(bucket, ofs);
-        memcpy(p, key.data(), key.dataSize());
+        _writeKeyData(bucket, &kn, key);
+    }
+
+    /**
+     * Gives an empty 'bucket' the key prefix of 'source', so keys moved over from 'source' take
+     * up no more room than they did there.
+     */
+    template <class BtreeLayout>
+    void BtreeLogic<BtreeLayout>::_copyPrefix(BucketType* bucket, const BucketType* source) {
+        invariant(bucket->n == 0);
+        int len = BtreeLayout::prefixLen(source);
+        if (len == 0) {
+            return;
+        }
+
+        short ofs = static_cast<short>(_alloc(bucket, len));
+        memcpy(dataAt(bucket, ofs), BtreeLayout::prefixData(source), len);
+        BtreeLayout::setPrefix(bucket, ofs, len);
     }
 
     template <class BtreeLayout>
@@ -1484,12 +1597,14 @@ namespace mongo {
         const BucketType* r = childForPos(bucket, leftIndex + 1);
 
         int KNS = sizeof(KeyHeaderType);
-        int rightSizeLimit = ( l->topSize
-                             + l->n * KNS
+
+        // Keys below are counted at full size, so prefix compressed children must be as well.
+        int lSize = BtreeLayout::MaxPrefixLen > 0 ? _packedDataSize(l, 0) : l->topSize + l->n * KNS;
+        int rSize = BtreeLayout::MaxPrefixLen > 0 ? _packedDataSize(r, 0) : r->topSize + r->n * KNS;
+        int rightSizeLimit = ( lSize
                              + getFullKey(bucket, leftIndex).data.dataSize()
                              + KNS
-                             + r->topSize
-                             + r->n * KNS ) / 2;
+                             + rSize ) / 2;
 
         // This constraint should be ensured by only calling this function
         // if we go below the low water mark.
@@ -1613,6 +1728,15 @@ namespace mongo {
             return false;
         }
 
+        // Prefix compressed children may hold more keys than fit in a bucket uncompressed, and
+        // moved keys are re-encoded against the prefix of the bucket they land in.  The sizes
+        // balancing relies on only hold if both children would fit uncompressed.
+        if (_packedDataSize(childForPos(bucket, leftIndex), 0) > BtreeLayout::BucketBodySize
+            || _packedDataSize(childForPos(bucket, leftIndex + 1), 0)
+                > BtreeLayout::BucketBodySize) {
+            return false;
+        }
+
         doBalanceChildren(txn, btreemod(txn, bucket), bucketLoc, leftIndex);
         return true;
     }
@@ -1762,12 +1886,13 @@ namespace mongo {
             return true;
         }
 
-        BucketType* pm = btreemod(txn, getBucket(bucket->parent));
-        if (mayBalanceRight) {
+        if (mayBalanceRight && canMergeChildren(p, bucket->parent, parentIdx)) {
+            BucketType* pm = btreemod(txn, getBucket(bucket->parent));
             doMergeChildren(txn, pm, bucket->parent, parentIdx);
             return true;
         }
-        else if (mayBalanceLeft) {
+        else if (mayBalanceLeft && canMergeChildren(p, bucket->parent, parentIdx - 1)) {
+            BucketType* pm = btreemod(txn, getBucket(bucket->parent));
             doMergeChildren(txn, pm, bucket->parent, parentIdx - 1);
             return true;
         }
@@ -1914,6 +2039,7 @@ namespace mongo {
         int split = splitPos(bucket, keypos);
         DiskLoc rLoc = _addBucket(txn);
         BucketType* r = btreemod(txn, getBucket(rLoc));
+        _copyPrefix(r, bucket);
 
         for (int i = split + 1; i < bucket->n; i++) {
             FullKey kn = getFullKey(bucket, i);
@@ -2049,7 +2175,9 @@ namespace mongo {
             return BSONObj();
         }
         else {
-            return getFullKey(bucket, keyOffset).data.toBson();
+            BSONObj key = getFullKey(bucket, keyOffset).data.toBson();
+            // A reassembled key only lives as long as its FullKey.
+            return BtreeLayout::MaxPrefixLen > 0 ? key.getOwned() : key;
         }
     }
 
@@ -2481,4 +2609,7 @@ namespace mongo {
     template struct FixedWidthKey<DiskLoc56Bit>;
     template class BtreeLogic<BtreeLayoutV1>;
 
+    // V2 format.
+    template class BtreeLogic<BtreeLayoutV2>;
+
 }  // namespace mongo
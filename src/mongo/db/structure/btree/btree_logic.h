@@ -123,6 +123,8 @@ namespace mongo {
             DiskLoc _first;
             BucketType* _b;
             bool _committed;
+            // Whether _b was re-encoded under a common key prefix since it was started.
+            bool _repacked;
             bool _dupsAllowed;
             long long _numAdded;
             auto_ptr<KeyDataOwnedType> _keyLast;
@@ -244,7 +246,14 @@ namespace mongo {
                 : header(getKeyHeader(bucket, i)),
                   prevChildBucket(header.prevChildBucket),
                   recordLoc(header.recordLoc),
-                  data(bucket->data + header.keyDataOfs()) { }
+                  data(_reader.read(bucket, header)) { }
+
+            FullKey(const FullKey& other)
+                : header(other.header),
+                  prevChildBucket(header.prevChildBucket),
+                  recordLoc(header.recordLoc),
+                  _reader(other._reader),
+                  data(_reader.rebase(other._reader, other.data.data())) { }
 
             // This is actually a reference to something on-disk.
             const KeyHeaderType& header;
@@ -253,7 +262,13 @@ namespace mongo {
             const LocType& prevChildBucket;
             const LocType& recordLoc;
 
-            // This is *not* memory-mapped but its members point to something on-disk.
+        private:
+            // Holds the key if the layout has to reassemble it, so must be initialized first.
+            typename BtreeLayout::KeyReader _reader;
+
+        public:
+            // This is *not* memory-mapped but its members point to something on-disk, or into
+            // '_reader' for prefix compressed layouts.
             KeyDataType data;
         };
 
@@ -283,11 +298,19 @@ namespace mongo {
 
         static void _delKeyAtPos(BucketType* bucket, int keypos, bool mayEmpty = false);
 
-        static void popBack(BucketType* bucket, DiskLoc* recordLocOut, KeyDataType *keyDataOut);
+        static void popBack(BucketType* bucket, DiskLoc* recordLocOut);
+
+        static bool mayDropKey(const BucketType* bucket, int index, int refPos);
+
+        static int _packedDataSize(const BucketType* bucket, int refPos);
+
+        static int _keyDataSize(const BucketType* bucket, const KeyDataType& key);
+
+        static void _writeKeyData(BucketType* bucket, KeyHeaderType* kn, const KeyDataType& key);
 
-        static bool mayDropKey(BucketType* bucket, int index, int refPos);
+        static int _choosePrefix(const BucketType* bucket, char* prefixOut);
 
-        static int _packedDataSize(BucketType* bucket, int refPos);
+        static void _copyPrefix(BucketType* bucket, const BucketType* source);
 
         static void setPacked(BucketType* bucket);
 
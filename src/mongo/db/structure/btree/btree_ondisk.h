@@ -327,11 +327,126 @@ namespace mongo {
         sizeof(BtreeBucketV1) - sizeof(reinterpret_cast<BtreeBucketV1*>(NULL)->data) 
                 == BtreeBucketV1::HeaderSize);
 
+    /**
+     * V2 buckets prefix compress their keys.  The header is the same as V1 plus the location of a
+     * run of bytes, stored in the body like any other key data, that keys in the bucket may start
+     * with.  Each key then only stores the part of its data past the bytes it shares with this
+     * prefix.
+     */
+    struct BtreeBucketV2 {
+        /** Parent bucket of this bucket, which isNull() for the root bucket. */
+        DiskLoc56Bit parent;
+
+        /** Given that there are n keys, this is the n index child. */
+        DiskLoc56Bit nextChild;
+
+        unsigned short flags;
+
+        /** Size of the empty region. */
+        unsigned short emptySize;
+
+        /** Size used for key storage, including the prefix and storage of old keys. */
+        unsigned short topSize;
+
+        /* Number of keys in the bucket. */
+        unsigned short n;
+
+        /** Offset within the body of the shared key prefix. */
+        unsigned short prefixOfs;
+
+        /** Length of the shared key prefix, zero if there is none. */
+        unsigned short prefixLen;
+
+        /* Beginning of the bucket's body */
+        char data[4];
+
+        // Precalculated size constants
+        enum { HeaderSize = 26 };
+    };
+
+    // BtreeBucketV2 is part of the on-disk format, so it should never be changed
+    BOOST_STATIC_ASSERT(
+        sizeof(BtreeBucketV2) - sizeof(reinterpret_cast<BtreeBucketV2*>(NULL)->data) 
+                == BtreeBucketV2::HeaderSize);
+
+    /**
+     * The fixed width data component of a key within a V2 bucket.  In addition to the V1 fields
+     * it records how many leading bytes of the key are taken from the bucket's prefix and how many
+     * bytes follow at keyDataOfs().
+     */
+    struct FixedWidthKeyV2 : public FixedWidthKey<DiskLoc56Bit> {
+        unsigned char _shared;
+
+        unsigned short _suffixLen;
+
+        int sharedPrefixLen() const { return _shared; }
+
+        int suffixLen() const { return _suffixLen; }
+    };
+
+    BOOST_STATIC_ASSERT(sizeof(FixedWidthKeyV2) == sizeof(FixedWidthKey<DiskLoc56Bit>) + 3);
+
     enum Flags {
         Packed = 1
     };
 
-    struct BtreeLayoutV0 {
+    /**
+     * Returns the number of leading bytes 'a' and 'b' have in common, looking at no more than
+     * 'maxLen' bytes.
+     */
+    inline int commonPrefixLen(const char* a, const char* b, int maxLen) {
+        int i = 0;
+        while (i < maxLen && a[i] == b[i]) {
+            ++i;
+        }
+        return i;
+    }
+
+    /**
+     * Key storage for the layouts that keep every key whole in the bucket body.  BtreeLogic goes
+     * through these hooks for anything that depends on how key data is stored.
+     */
+    template <class BucketType, class FixedWidthKeyType, class KeyType>
+    struct WholeKeyStorage {
+        // Keys never share a bucket prefix.
+        enum { MaxPrefixLen = 0 };
+
+        /**
+         * Produces the data of a key in a bucket.  Whole keys are read right where they are.
+         */
+        class KeyReader {
+        public:
+            const char* read(const BucketType* bucket, const FixedWidthKeyType& kn) {
+                return bucket->data + kn.keyDataOfs();
+            }
+
+            /** Key data read by 'other' stays valid in a copy. */
+            const char* rebase(const KeyReader& other, const char* keyData) const {
+                return keyData;
+            }
+        };
+
+        static int prefixLen(const BucketType* bucket) { return 0; }
+
+        static const char* prefixData(const BucketType* bucket) { return NULL; }
+
+        static void setPrefix(BucketType* bucket, short ofs, int len) { }
+
+        static int sharedPrefixLen(const BucketType* bucket, const char* keyData, int keySize) {
+            return 0;
+        }
+
+        static void setKeyData(FixedWidthKeyType* kn, short ofs, int shared, int storedSize) {
+            kn->setKeyDataOfs(ofs);
+        }
+
+        /** Bytes of key data 'kn' occupies in the body of 'bucket'. */
+        static int storedKeySize(const BucketType* bucket, const FixedWidthKeyType& kn) {
+            return KeyType(bucket->data + kn.keyDataOfs()).dataSize();
+        }
+    };
+
+    struct BtreeLayoutV0 : public WholeKeyStorage<BtreeBucketV0, FixedWidthKey<DiskLoc>, KeyBson> {
         typedef FixedWidthKey<DiskLoc> FixedWidthKeyType;
         typedef DiskLoc LocType;
         typedef KeyBson KeyType;
@@ -357,7 +472,8 @@ namespace mongo {
         }
     };
 
-    struct BtreeLayoutV1 {
+    struct BtreeLayoutV1
+        : public WholeKeyStorage<BtreeBucketV1, FixedWidthKey<DiskLoc56Bit>, KeyV1> {
         typedef FixedWidthKey<DiskLoc56Bit> FixedWidthKeyType;
         typedef KeyV1 KeyType;
         typedef KeyV1Owned KeyOwnedType;
@@ -376,6 +492,89 @@ namespace mongo {
         static void initBucket(BucketType* bucket) { }
     };
 
+    /**
+     * V1 keys in prefix compressed buckets.  Buckets are the same size as V1 and keys compare the
+     * same way, so a bucket holds more keys whenever they have leading bytes in common.
+     */
+    struct BtreeLayoutV2 {
+        typedef FixedWidthKeyV2 FixedWidthKeyType;
+        typedef KeyV1 KeyType;
+        typedef KeyV1Owned KeyOwnedType;
+        typedef DiskLoc56Bit LocType;
+        typedef BtreeBucketV2 BucketType;
+
+        enum { BucketSize = 8192 - 16,  // The -16 is to leave room for the Record header
+               BucketBodySize = BucketSize - BucketType::HeaderSize 
+        };
+
+        static const int KeyMax = 1024;
+
+        // Bound by the width of FixedWidthKeyV2::_shared.
+        enum { MaxPrefixLen = 255 };
+
+        // A sentinel value sometimes used to identify a deallocated bucket.
+        static const unsigned short INVALID_N_SENTINEL = 0xffff;
+
+        static void initBucket(BucketType* bucket) {
+            bucket->prefixOfs = 0;
+            bucket->prefixLen = 0;
+        }
+
+        /**
+         * Reassembles a key from the bucket prefix and its stored suffix.  Keys that share
+         * nothing with the prefix are read in place.
+         */
+        class KeyReader {
+        public:
+            const char* read(const BucketType* bucket, const FixedWidthKeyType& kn) {
+                const char* suffix = bucket->data + kn.keyDataOfs();
+                int shared = kn.sharedPrefixLen();
+                if (0 == shared) {
+                    return suffix;
+                }
+                memcpy(_buf, bucket->data + bucket->prefixOfs, shared);
+                memcpy(_buf + shared, suffix, kn.suffixLen());
+                return _buf;
+            }
+
+            /** Key data read by 'other' may live in its buffer, which was copied to ours. */
+            const char* rebase(const KeyReader& other, const char* keyData) const {
+                return keyData == other._buf ? _buf : keyData;
+            }
+
+        private:
+            char _buf[KeyMax];
+        };
+
+        static int prefixLen(const BucketType* bucket) { return bucket->prefixLen; }
+
+        static const char* prefixData(const BucketType* bucket) {
+            return bucket->data + bucket->prefixOfs;
+        }
+
+        static void setPrefix(BucketType* bucket, short ofs, int len) {
+            invariant(len <= MaxPrefixLen);
+            bucket->prefixOfs = ofs;
+            bucket->prefixLen = len;
+        }
+
+        static int sharedPrefixLen(const BucketType* bucket, const char* keyData, int keySize) {
+            return commonPrefixLen(prefixData(bucket),
+                                   keyData,
+                                   std::min(keySize, static_cast<int>(bucket->prefixLen)));
+        }
+
+        static void setKeyData(FixedWidthKeyType* kn, short ofs, int shared, int storedSize) {
+            kn->setKeyDataOfs(ofs);
+            kn->_shared = static_cast<unsigned char>(shared);
+            kn->_suffixLen = static_cast<unsigned short>(storedSize);
+        }
+
+        static int storedKeySize(const BucketType* bucket, const FixedWidthKeyType& kn) {
+            return kn.suffixLen();
+        }
+    };
+
 #pragma pack()
 
 }  // namespace mongo
@@ -243,4 +243,8 @@ namespace mongo {
     // V1 format.
     template struct BtreeLogicTestHelper<BtreeLayoutV1>;
     template class ArtificialTreeBuilder<BtreeLayoutV1>;
+
+    // V2 format.
+    template struct BtreeLogicTestHelper<BtreeLayoutV2>;
+    template class ArtificialTreeBuilder<BtreeLayoutV2>;
 }
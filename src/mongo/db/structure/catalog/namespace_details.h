@@ -161,8 +161,13 @@ namespace mongo {
     public:
         void setMaxCappedDocs( OperationContext* txn, long long max );
 
+        // must match RecordStoreV1Base::UserFlags
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+            Flag_CompressRecords = 1 << 1,
+            Flag_MayHaveCompressedRecords = 1 << 2,
+            Flag_RecordChecksums = 1 << 3,
+            Flag_MayHaveRecordChecksums = 1 << 4
         };
 
         IndexDetails& idx(int idxNo, bool missingExpected = false );
@@ -96,6 +96,34 @@ namespace mongo {
             MultiIndexBlock* _multiIndexBlock;
         };
 
+        /**
+         * For online compaction, where the indexes stay in place: the notifier has already
+         * unindexed the old location, this indexes the new one.
+         */
+        class MoveCompactAdaptor : public RecordStoreCompactAdaptor {
+        public:
+            MoveCompactAdaptor(OperationContext* txn, IndexCatalog* indexCatalog)
+                : _txn( txn ),
+                  _indexCatalog( indexCatalog ) {
+            }
+
+            virtual bool isDataValid( const RecordData& recData ) {
+                return recData.toBson().valid();
+            }
+
+            virtual size_t dataSize( const RecordData& recData ) {
+                return recData.toBson().objsize();
+            }
+
+            virtual void inserted( const RecordData& recData, const DiskLoc& newLocation ) {
+                _indexCatalog->indexRecord( _txn, recData.toBson(), newLocation );
+            }
+
+        private:
+            OperationContext* _txn;
+            IndexCatalog* _indexCatalog;
+        };
+
     }
 
 
@@ -164,4 +192,24 @@ namespace mongo {
         return StatusWith<CompactStats>( stats );
     }
 
+    StatusWith<bool> Collection::compactIncremental( OperationContext* txn,
+                                                     const CompactOptions* compactOptions,
+                                                     int maxRecords,
+                                                     CompactStats* stats ) {
+        if ( _indexCatalog.numIndexesInProgress() )
+            return StatusWith<bool>( ErrorCodes::BadValue,
+                                     "cannot compact when indexes in progress" );
+
+        MoveCompactAdaptor adaptor( txn, &_indexCatalog );
+
+        // we are our own UpdateMoveNotifier: moved documents are unindexed and cursors on them
+        // invalidated, just as when an update moves them
+        return _recordStore->compactIncremental( txn, &adaptor, this, compactOptions,
+                                                 maxRecords, stats );
+    }
+
+    void Collection::abortCompactIncremental( OperationContext* txn ) {
+        _recordStore->abortCompactIncremental( txn );
+    }
+
 }  // namespace mongo
@@ -0,0 +1,96 @@
+// deleted_record_index.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/structure/deleted_record_index.h"
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    void DeletedRecordIndex::clear() {
+        _bySize.clear();
+        _prev.clear();
+    }
+
+    void DeletedRecordIndex::add( const DiskLoc& loc, int len, const DiskLoc& prev ) {
+        _bySize.insert( std::make_pair( len, loc ) );
+        _prev[loc] = prev;
+    }
+
+    void DeletedRecordIndex::addHead( const DiskLoc& loc, int len, const DiskLoc& oldHead ) {
+        add( loc, len, DiskLoc() );
+
+        // oldHead may not be indexed if its list changed behind our back; don't remember it
+        PrevMap::iterator it = _prev.find( oldHead );
+        if ( it != _prev.end() )
+            it->second = loc;
+    }
+
+    void DeletedRecordIndex::remove( const DiskLoc& loc, int len,
+                                     const DiskLoc& prev, const DiskLoc& next ) {
+        _bySize.erase( std::make_pair( len, loc ) );
+        _prev.erase( loc );
+
+        PrevMap::iterator it = _prev.find( next );
+        if ( it != _prev.end() )
+            it->second = prev;
+    }
+
+    void DeletedRecordIndex::removeLengths( int minLen, int maxLen ) {
+        invariant( minLen <= maxLen );
+        BySize::iterator begin = _bySize.lower_bound( std::make_pair( minLen, DiskLoc() ) );
+        BySize::iterator end = begin;
+        while ( end != _bySize.end() && end->first <= maxLen ) {
+            _prev.erase( end->second );
+            ++end;
+        }
+        _bySize.erase( begin, end );
+    }
+
+    bool DeletedRecordIndex::findBestFit( int len, DiskLoc* loc, int* foundLen,
+                                          DiskLoc* prev ) const {
+        // DiskLoc() sorts before every real DiskLoc
+        BySize::const_iterator it = _bySize.lower_bound( std::make_pair( len, DiskLoc() ) );
+        if ( it == _bySize.end() )
+            return false;
+
+        PrevMap::const_iterator p = _prev.find( it->second );
+        invariant( p != _prev.end() );
+
+        *foundLen = it->first;
+        *loc = it->second;
+        *prev = p->second;
+        return true;
+    }
+
+}
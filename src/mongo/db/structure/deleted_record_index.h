@@ -0,0 +1,99 @@
+// deleted_record_index.h
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <map>
+#include <set>
+#include <utility>
+
+#include "mongo/base/disallow_copying.h"
+#include "mongo/db/diskloc.h"
+
+namespace mongo {
+
+    /**
+     * In-memory index of the deleted records on a SimpleRecordStoreV1's deleted lists, so that
+     * allocation can find the best fitting record without walking the lists on disk.
+     *
+     * For every deleted record it keeps the length and the record in front of it on its list,
+     * which is what unlinking it needs.  It knows nothing about buckets or the records
+     * themselves; the owner mirrors every change it makes to the lists, and since the lists
+     * stay authoritative, checks an entry against them before trusting it.
+     *
+     * Not thread safe.  Owners serialize access through their own locking.
+     */
+    class DeletedRecordIndex {
+        MONGO_DISALLOW_COPYING( DeletedRecordIndex );
+    public:
+        DeletedRecordIndex() { }
+
+        size_t size() const { return _bySize.size(); }
+
+        void clear();
+
+        /**
+         * 'loc' follows 'prev' on its list, or is its head if 'prev' is null.  For filling the
+         * index from a walk of a list.
+         */
+        void add( const DiskLoc& loc, int len, const DiskLoc& prev );
+
+        /**
+         * 'loc' was pushed onto the front of its list, in front of 'oldHead'.
+         */
+        void addHead( const DiskLoc& loc, int len, const DiskLoc& oldHead );
+
+        /**
+         * 'loc' was unlinked from between 'prev' and 'next'.  Either may be null.
+         */
+        void remove( const DiskLoc& loc, int len, const DiskLoc& prev, const DiskLoc& next );
+
+        /**
+         * Forgets every record of length in [minLen, maxLen], for re-adding them from disk.
+         */
+        void removeLengths( int minLen, int maxLen );
+
+        /**
+         * Finds the smallest record of at least 'len' bytes, preferring the lowest DiskLoc
+         * among equal lengths so that allocations tend to go forward in the files.
+         * @return false if there is none
+         */
+        bool findBestFit( int len, DiskLoc* loc, int* foundLen, DiskLoc* prev ) const;
+
+    private:
+        typedef std::set< std::pair<int, DiskLoc> > BySize;
+        typedef std::map<DiskLoc, DiskLoc> PrevMap;
+
+        BySize _bySize;
+        PrevMap _prev;
+    };
+
+}
@@ -0,0 +1,120 @@
+// deleted_record_index_test.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/structure/deleted_record_index.h"
+
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    TEST( DeletedRecordIndex, FindBestFitTakesSmallestThenLowestLoc ) {
+        DeletedRecordIndex index;
+        ASSERT_EQUALS( index.size(), 0U );
+
+        DiskLoc loc;
+        DiskLoc prev;
+        int len;
+        ASSERT_FALSE( index.findBestFit( 100, &loc, &len, &prev ) );
+
+        // one list: (0,3000) -> (0,2000) -> (0,1000) -> (1,500)
+        index.add( DiskLoc(0, 3000), 200, DiskLoc() );
+        index.add( DiskLoc(0, 2000), 120, DiskLoc(0, 3000) );
+        index.add( DiskLoc(0, 1000), 120, DiskLoc(0, 2000) );
+        index.add( DiskLoc(1, 500), 90, DiskLoc(0, 1000) );
+        ASSERT_EQUALS( index.size(), 4U );
+
+        ASSERT( index.findBestFit( 100, &loc, &len, &prev ) );
+        ASSERT_EQUALS( loc, DiskLoc(0, 1000) );
+        ASSERT_EQUALS( len, 120 );
+        ASSERT_EQUALS( prev, DiskLoc(0, 2000) );
+
+        ASSERT( index.findBestFit( 90, &loc, &len, &prev ) );
+        ASSERT_EQUALS( loc, DiskLoc(1, 500) );
+
+        ASSERT( index.findBestFit( 200, &loc, &len, &prev ) );
+        ASSERT_EQUALS( loc, DiskLoc(0, 3000) );
+        ASSERT( prev.isNull() );
+
+        ASSERT_FALSE( index.findBestFit( 201, &loc, &len, &prev ) );
+    }
+
+    TEST( DeletedRecordIndex, TracksPredecessors ) {
+        DeletedRecordIndex index;
+
+        // (0,1000) -> (0,2000)
+        index.add( DiskLoc(0, 1000), 100, DiskLoc() );
+        index.add( DiskLoc(0, 2000), 100, DiskLoc(0, 1000) );
+
+        // (0,500) -> (0,1000) -> (0,2000)
+        index.addHead( DiskLoc(0, 500), 100, DiskLoc(0, 1000) );
+
+        DiskLoc loc;
+        DiskLoc prev;
+        int len;
+        ASSERT( index.findBestFit( 100, &loc, &len, &prev ) );
+        ASSERT_EQUALS( loc, DiskLoc(0, 500) );
+        ASSERT( prev.isNull() );
+
+        // (0,500) -> (0,2000)
+        index.remove( DiskLoc(0, 1000), 100, DiskLoc(0, 500), DiskLoc(0, 2000) );
+
+        // (0,2000)
+        index.remove( DiskLoc(0, 500), 100, DiskLoc(), DiskLoc(0, 2000) );
+        ASSERT( index.findBestFit( 100, &loc, &len, &prev ) );
+        ASSERT_EQUALS( loc, DiskLoc(0, 2000) );
+        ASSERT( prev.isNull() );
+        ASSERT_EQUALS( index.size(), 1U );
+    }
+
+    TEST( DeletedRecordIndex, RemoveLengths ) {
+        DeletedRecordIndex index;
+        index.add( DiskLoc(0, 1000), 50, DiskLoc() );
+        index.add( DiskLoc(0, 2000), 64, DiskLoc() );
+        index.add( DiskLoc(0, 3000), 127, DiskLoc(0, 2000) );
+        index.add( DiskLoc(0, 4000), 128, DiskLoc() );
+
+        index.removeLengths( 64, 127 );
+        ASSERT_EQUALS( index.size(), 2U );
+
+        DiskLoc loc;
+        DiskLoc prev;
+        int len;
+        ASSERT( index.findBestFit( 51, &loc, &len, &prev ) );
+        ASSERT_EQUALS( loc, DiskLoc(0, 4000) );
+
+        index.clear();
+        ASSERT_EQUALS( index.size(), 0U );
+        ASSERT_FALSE( index.findBestFit( 1, &loc, &len, &prev ) );
+    }
+
+}
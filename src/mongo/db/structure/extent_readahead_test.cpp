@@ -0,0 +1,275 @@
+// extent_readahead_test.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/storage/mmap_v1/extent_readahead.h"
+
+#include "mongo/db/operation_context_noop.h"
+#include "mongo/db/storage/mmap_v1/extent.h"
+#include "mongo/db/structure/record_store_v1_test_help.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/processinfo.h"
+
+using namespace mongo;
+
+namespace {
+
+    /**
+     * Records what would have been advised and lets the test decide whether an advised extent
+     * was resident when the scan arrived.
+     */
+    class TestReadahead : public ExtentReadahead {
+    public:
+        explicit TestReadahead( const ExtentManager* em )
+            : ExtentReadahead( em ),
+              resident( true ),
+              adviseSupported( true ) {
+        }
+
+        bool resident;
+        bool adviseSupported;
+        std::vector<DiskLoc> adviseCalls;
+
+    protected:
+        virtual int _adviseWillNeed( const Extent* e ) {
+            if ( !adviseSupported )
+                return 0;
+            adviseCalls.push_back( e->myLoc );
+            return e->length;
+        }
+
+        virtual bool _advisedInMemory( const Extent* e ) {
+            return resident;
+        }
+    };
+
+    /**
+     * Sets extentReadaheadMaxWindow for the lifetime of the object, even if an assertion fails.
+     */
+    class MaxWindowSetting {
+    public:
+        explicit MaxWindowSetting( int maxWindow ) : _old( extentReadaheadMaxWindow ) {
+            extentReadaheadMaxWindow = maxWindow;
+        }
+        ~MaxWindowSetting() {
+            extentReadaheadMaxWindow = _old;
+        }
+    private:
+        int _old;
+    };
+
+    /**
+     * Allocates 'n' extents chained along xnext, the way a collection's extent list is.
+     */
+    std::vector<DiskLoc> makeExtentChain( DummyExtentManager* em, int n ) {
+        OperationContextNoop txn;
+        std::vector<DiskLoc> locs;
+        for ( int i = 0; i < n; i++ ) {
+            locs.push_back( em->allocateExtent( &txn, false, 4096, false ) );
+            if ( i > 0 ) {
+                em->getExtent( locs[i - 1] )->xnext = locs[i];
+                em->getExtent( locs[i] )->xprev = locs[i - 1];
+            }
+        }
+        return locs;
+    }
+
+    TEST( ExtentReadahead, NothingAdvisedInFirstExtent ) {
+        if ( !ProcessInfo::blockCheckSupported() )
+            return;
+
+        MaxWindowSetting setting( 8 );
+        DummyExtentManager em;
+        std::vector<DiskLoc> ext = makeExtentChain( &em, 4 );
+
+        TestReadahead ra( &em );
+        ra.enteringExtent( ext[0] );
+        ASSERT_EQUALS( 0U, ra.adviseCalls.size() );
+        ASSERT_EQUALS( 0U, ra.numAdvised() );
+        ASSERT_EQUALS( 1, ra.window() );
+    }
+
+    TEST( ExtentReadahead, AdvisesNextExtentAtFirstBoundary ) {
+        if ( !ProcessInfo::blockCheckSupported() )
+            return;
+
+        MaxWindowSetting setting( 8 );
+        DummyExtentManager em;
+        std::vector<DiskLoc> ext = makeExtentChain( &em, 4 );
+
+        TestReadahead ra( &em );
+        ra.enteringExtent( ext[0] );
+        ra.enteringExtent( ext[1] );
+        ASSERT_EQUALS( 1U, ra.adviseCalls.size() );
+        ASSERT_EQUALS( ext[2], ra.adviseCalls[0] );
+        ASSERT_EQUALS( 1U, ra.numAdvised() );
+        ASSERT_EQUALS( 1, ra.window() );
+    }
+
+    TEST( ExtentReadahead, HitsDoubleWindowUpToMax ) {
+        if ( !ProcessInfo::blockCheckSupported() )
+            return;
+
+        MaxWindowSetting setting( 4 );
+        DummyExtentManager em;
+        std::vector<DiskLoc> ext = makeExtentChain( &em, 20 );
+
+        TestReadahead ra( &em );
+        ra.enteringExtent( ext[0] );
+        ra.enteringExtent( ext[1] ); // advises 2
+
+        ra.enteringExtent( ext[2] ); // hit, advises 3,4
+        ASSERT_EQUALS( 2, ra.window() );
+        ASSERT_EQUALS( 2U, ra.numAdvised() );
+
+        ra.enteringExtent( ext[3] ); // hit, advises 5,6,7
+        ASSERT_EQUALS( 4, ra.window() );
+        ASSERT_EQUALS( 4U, ra.numAdvised() );
+
+        ra.enteringExtent( ext[4] ); // hit, capped at 4, advises 8
+        ASSERT_EQUALS( 4, ra.window() );
+        ASSERT_EQUALS( 4U, ra.numAdvised() );
+
+        // every extent is advised once, in order
+        ASSERT_EQUALS( 7U, ra.adviseCalls.size() );
+        for ( size_t i = 0; i < ra.adviseCalls.size(); i++ ) {
+            ASSERT_EQUALS( ext[i + 2], ra.adviseCalls[i] );
+        }
+    }
+
+    TEST( ExtentReadahead, MissesHalveWindow ) {
+        if ( !ProcessInfo::blockCheckSupported() )
+            return;
+
+        MaxWindowSetting setting( 8 );
+        DummyExtentManager em;
+        std::vector<DiskLoc> ext = makeExtentChain( &em, 20 );
+
+        TestReadahead ra( &em );
+        ra.enteringExtent( ext[0] );
+        ra.enteringExtent( ext[1] );
+        ra.enteringExtent( ext[2] );
+        ra.enteringExtent( ext[3] );
+        ASSERT_EQUALS( 4, ra.window() );
+        ASSERT_EQUALS( 4U, ra.numAdvised() ); // 4,5,6,7
+
+        ra.resident = false;
+        ra.enteringExtent( ext[4] ); // miss, window 2, already 3 ahead so nothing new
+        ASSERT_EQUALS( 2, ra.window() );
+        ASSERT_EQUALS( 3U, ra.numAdvised() );
+        ASSERT_EQUALS( 6U, ra.adviseCalls.size() );
+
+        ra.enteringExtent( ext[5] ); // miss, window 1
+        ASSERT_EQUALS( 1, ra.window() );
+
+        ra.enteringExtent( ext[6] ); // miss, never goes below 1
+        ASSERT_EQUALS( 1, ra.window() );
+        ASSERT_EQUALS( 1U, ra.numAdvised() );
+        ASSERT_EQUALS( 6U, ra.adviseCalls.size() );
+
+        ra.enteringExtent( ext[7] ); // miss, advises 8
+        ASSERT_EQUALS( 1U, ra.numAdvised() );
+        ASSERT_EQUALS( 7U, ra.adviseCalls.size() );
+        ASSERT_EQUALS( ext[8], ra.adviseCalls.back() );
+    }
+
+    TEST( ExtentReadahead, SkippedExtentsAreForgotten ) {
+        if ( !ProcessInfo::blockCheckSupported() )
+            return;
+
+        MaxWindowSetting setting( 8 );
+        DummyExtentManager em;
+        std::vector<DiskLoc> ext = makeExtentChain( &em, 10 );
+
+        TestReadahead ra( &em );
+        ra.enteringExtent( ext[0] );
+        ra.enteringExtent( ext[1] );
+        ra.enteringExtent( ext[2] ); // hit, advised 3,4
+        ASSERT_EQUALS( 2U, ra.numAdvised() );
+
+        // 3 was empty, the scan went straight to 4: that still counts as a hit
+        ra.enteringExtent( ext[4] );
+        ASSERT_EQUALS( 4, ra.window() );
+        ASSERT_EQUALS( 4U, ra.numAdvised() ); // 5,6,7,8
+
+        // jumping past everything advised is neither a hit nor a miss, we start over from there
+        ra.enteringExtent( ext[9] );
+        ASSERT_EQUALS( 4, ra.window() );
+        ASSERT_EQUALS( 0U, ra.numAdvised() );
+    }
+
+    TEST( ExtentReadahead, StopsAtLastExtent ) {
+        if ( !ProcessInfo::blockCheckSupported() )
+            return;
+
+        MaxWindowSetting setting( 8 );
+        DummyExtentManager em;
+        std::vector<DiskLoc> ext = makeExtentChain( &em, 3 );
+
+        TestReadahead ra( &em );
+        ra.enteringExtent( ext[0] );
+        ra.enteringExtent( ext[1] );
+        ra.enteringExtent( ext[2] );
+        ASSERT_EQUALS( 2, ra.window() );
+        ASSERT_EQUALS( 0U, ra.numAdvised() );
+        ASSERT_EQUALS( 1U, ra.adviseCalls.size() );
+    }
+
+    TEST( ExtentReadahead, ZeroMaxWindowTurnsItOff ) {
+        MaxWindowSetting setting( 0 );
+        DummyExtentManager em;
+        std::vector<DiskLoc> ext = makeExtentChain( &em, 4 );
+
+        TestReadahead ra( &em );
+        for ( size_t i = 0; i < ext.size(); i++ ) {
+            ra.enteringExtent( ext[i] );
+        }
+        ASSERT_EQUALS( 0U, ra.adviseCalls.size() );
+        ASSERT_EQUALS( 0U, ra.numAdvised() );
+    }
+
+    TEST( ExtentReadahead, UnsupportedAdviceAdvisesNothing ) {
+        if ( !ProcessInfo::blockCheckSupported() )
+            return;
+
+        MaxWindowSetting setting( 8 );
+        DummyExtentManager em;
+        std::vector<DiskLoc> ext = makeExtentChain( &em, 4 );
+
+        TestReadahead ra( &em );
+        ra.adviseSupported = false;
+        for ( size_t i = 0; i < ext.size(); i++ ) {
+            ra.enteringExtent( ext[i] );
+        }
+        ASSERT_EQUALS( 0U, ra.numAdvised() );
+        ASSERT_EQUALS( 1, ra.window() );
+    }
+
+}
@@ -0,0 +1,140 @@
+// heap_slab_allocator.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/structure/heap_slab_allocator.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/structure/record_store_v1_base.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+
+    const int HeapSlabAllocator::SlabSize = 1024 * 1024;
+    const int HeapSlabAllocator::MaxSlabbedSize = 64 * 1024;
+
+    HeapSlabAllocator::HeapSlabAllocator()
+        : _slabBytes( 0 ),
+          _bytesInUse( 0 ),
+          _bytesRequested( 0 ),
+          _largeBytes( 0 ),
+          _largeAllocations( 0 ) {
+    }
+
+    HeapSlabAllocator::~HeapSlabAllocator() {
+        for ( size_t i = 0; i < _slabs.size(); i++ )
+            std::free( _slabs[i] );
+    }
+
+    int HeapSlabAllocator::blockSize( int size ) {
+        // multiples of 8 quantize to multiples of 8, which keeps every block aligned
+        return RecordStoreV1Base::quantizeAllocationSpace( ( size + 7 ) & ~7 );
+    }
+
+    char* HeapSlabAllocator::allocate( int size ) {
+        invariant( size > 0 );
+        _bytesRequested += size;
+
+        const int block = blockSize( size );
+        if ( block > MaxSlabbedSize ) {
+            char* p = static_cast<char*>( std::malloc( size ) );
+            if ( !p )
+                msgasserted( 18526, "out of memory allocating heap record" );
+            _largeBytes += size;
+            _largeAllocations++;
+            return p;
+        }
+
+        SizeClass& sizeClass = _classes[block];
+        if ( !sizeClass.freeList )
+            _addSlab( block, &sizeClass );
+
+        char* p = sizeClass.freeList;
+        memcpy( &sizeClass.freeList, p, sizeof( char* ) );
+        sizeClass.blocksInUse++;
+        _bytesInUse += block;
+        return p;
+    }
+
+    void HeapSlabAllocator::free( char* p, int size ) {
+        _bytesRequested -= size;
+
+        const int block = blockSize( size );
+        if ( block > MaxSlabbedSize ) {
+            std::free( p );
+            _largeBytes -= size;
+            _largeAllocations--;
+            return;
+        }
+
+        std::map<int, SizeClass>::iterator it = _classes.find( block );
+        invariant( it != _classes.end() );
+        SizeClass& sizeClass = it->second;
+        memcpy( p, &sizeClass.freeList, sizeof( char* ) );
+        sizeClass.freeList = p;
+        sizeClass.blocksInUse--;
+        _bytesInUse -= block;
+    }
+
+    void HeapSlabAllocator::_addSlab( int block, SizeClass* sizeClass ) {
+        const int numBlocks = sizeClass->nextSlabBlocks;
+        char* slab = static_cast<char*>( std::malloc( numBlocks * block ) );
+        if ( !slab )
+            msgasserted( 18527, "out of memory allocating heap slab" );
+        _slabs.push_back( slab );
+        _slabBytes += numBlocks * block;
+
+        if ( numBlocks * 2 * block <= SlabSize )
+            sizeClass->nextSlabBlocks = numBlocks * 2;
+
+        // thread the new blocks onto the free list in address order
+        for ( int i = numBlocks - 1; i >= 0; i-- ) {
+            char* p = slab + i * block;
+            memcpy( p, &sizeClass->freeList, sizeof( char* ) );
+            sizeClass->freeList = p;
+        }
+    }
+
+    void HeapSlabAllocator::appendStats( BSONObjBuilder* b, double scale ) const {
+        b->appendNumber( "bytesRequested", static_cast<long long>( _bytesRequested / scale ) );
+        b->appendNumber( "slabBytes", static_cast<long long>( _slabBytes / scale ) );
+        b->appendNumber( "slabBytesInUse", static_cast<long long>( _bytesInUse / scale ) );
+        b->appendNumber( "numSlabs", static_cast<long long>( _slabs.size() ) );
+        b->appendNumber( "numSizeClasses", static_cast<long long>( _classes.size() ) );
+        b->appendNumber( "largeAllocations", _largeAllocations );
+        b->appendNumber( "largeBytes", static_cast<long long>( _largeBytes / scale ) );
+    }
+
+}
@@ -0,0 +1,114 @@
+// heap_slab_allocator.h
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+#include "mongo/base/disallow_copying.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /**
+     * Hands out memory for in-memory records and index keys from large slabs instead of one
+     * heap allocation each.
+     *
+     * Requests are rounded up to the same size classes the mmap_v1 record store uses for
+     * allocations, RecordStoreV1Base::quantizeAllocationSpace(), i.e. 1/16th steps within each
+     * of the RecordStoreV1Base::bucketSizes.  Every size class carves blocks out of its own
+     * slabs and keeps freed blocks on a free list for reuse.  Slabs start small and double up
+     * to SlabSize so that small collections stay small.  Slabs are only released when the
+     * allocator is destroyed.
+     *
+     * Requests larger than MaxSlabbedSize go straight to the system allocator.
+     *
+     * Not thread safe.  Owners serialize access through their own locking.
+     */
+    class HeapSlabAllocator {
+        MONGO_DISALLOW_COPYING( HeapSlabAllocator );
+    public:
+        static const int SlabSize;
+        static const int MaxSlabbedSize;
+
+        HeapSlabAllocator();
+        ~HeapSlabAllocator();
+
+        /**
+         * @return at least 'size' bytes, 8 byte aligned
+         */
+        char* allocate( int size );
+
+        /**
+         * @param size - must be the size 'p' was allocate()d with
+         */
+        void free( char* p, int size );
+
+        /**
+         * @return the size of the block allocate( size ) hands out
+         */
+        static int blockSize( int size );
+
+        long long bytesRequested() const { return _bytesRequested; }
+
+        /**
+         * @return everything held from the system allocator, including free blocks
+         */
+        long long bytesReserved() const { return _slabBytes + _largeBytes; }
+
+        void appendStats( BSONObjBuilder* b, double scale ) const;
+
+    private:
+        struct SizeClass {
+            SizeClass() : freeList( NULL ), nextSlabBlocks( 16 ), blocksInUse( 0 ) {}
+
+            // free blocks are chained through their first 8 bytes
+            char* freeList;
+            int nextSlabBlocks;
+            long long blocksInUse;
+        };
+
+        void _addSlab( int blockSize, SizeClass* sizeClass );
+
+        std::map<int, SizeClass> _classes; // by block size
+        std::vector<char*> _slabs;
+
+        long long _slabBytes;
+        long long _bytesInUse; // block sizes of live slab allocations
+        long long _bytesRequested;
+        long long _largeBytes;
+        long long _largeAllocations;
+    };
+
+}
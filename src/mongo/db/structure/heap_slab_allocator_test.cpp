@@ -0,0 +1,105 @@
+// heap_slab_allocator_test.cpp
+
+/**
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/db/structure/heap_slab_allocator.h"
+
+#include <cstring>
+#include <set>
+
+#include "mongo/unittest/unittest.h"
+
+using namespace mongo;
+
+namespace {
+
+    TEST( HeapSlabAllocator, BlockSizeIsAlignedAndQuantized ) {
+        ASSERT_EQUALS( HeapSlabAllocator::blockSize( 1 ), 8 );
+        ASSERT_EQUALS( HeapSlabAllocator::blockSize( 33 ), 40 );
+        ASSERT_EQUALS( HeapSlabAllocator::blockSize( 1000 ), 1024 );
+        ASSERT_EQUALS( HeapSlabAllocator::blockSize( 10001 ), 10240 );
+    }
+
+    TEST( HeapSlabAllocator, ReusesFreedBlocks ) {
+        HeapSlabAllocator allocator;
+
+        char* a = allocator.allocate( 100 );
+        char* b = allocator.allocate( 100 );
+        ASSERT( a != b );
+        ASSERT_EQUALS( reinterpret_cast<size_t>( a ) % 8, 0U );
+        memset( a, 'a', 100 );
+        memset( b, 'b', 100 );
+
+        const long long reserved = allocator.bytesReserved();
+        allocator.free( a, 100 );
+        ASSERT_EQUALS( allocator.bytesRequested(), 100 );
+
+        // same size class, so the freed block comes back without a new slab
+        char* c = allocator.allocate( 97 );
+        ASSERT_EQUALS( c, a );
+        ASSERT_EQUALS( allocator.bytesReserved(), reserved );
+        ASSERT_EQUALS( b[99], 'b' );
+
+        allocator.free( b, 100 );
+        allocator.free( c, 97 );
+        ASSERT_EQUALS( allocator.bytesRequested(), 0 );
+    }
+
+    TEST( HeapSlabAllocator, SlabsGrowPerSizeClass ) {
+        HeapSlabAllocator allocator;
+        std::set<char*> blocks;
+        for ( int i = 0; i < 1000; i++ ) {
+            char* p = allocator.allocate( 64 );
+            ASSERT( blocks.insert( p ).second );
+            memset( p, i & 0xff, 64 );
+        }
+
+        // slabs double from 16 blocks, so 1000 blocks take far fewer than 1000 allocations
+        const long long reserved = allocator.bytesReserved();
+        ASSERT_GREATER_THAN_OR_EQUALS( reserved, 1000 * 64 );
+        ASSERT_LESS_THAN( reserved, 2 * 1000 * 64 + 16 * 64 );
+
+        for ( std::set<char*>::const_iterator it = blocks.begin(); it != blocks.end(); ++it )
+            allocator.free( *it, 64 );
+        ASSERT_EQUALS( allocator.bytesRequested(), 0 );
+        ASSERT_EQUALS( allocator.bytesReserved(), reserved );
+    }
+
+    TEST( HeapSlabAllocator, LargeAllocationsBypassSlabs ) {
+        HeapSlabAllocator allocator;
+        const int size = HeapSlabAllocator::MaxSlabbedSize * 2;
+        char* p = allocator.allocate( size );
+        memset( p, 'x', size );
+        ASSERT_EQUALS( allocator.bytesReserved(), size );
+        allocator.free( p, size );
+        ASSERT_EQUALS( allocator.bytesReserved(), 0 );
+    }
+
+}
@@ -30,8 +30,24 @@
 
 #include "mongo/db/structure/record_store.h"
 
+#include "mongo/util/mongoutils/str.h"
+
 namespace mongo {
 
+    size_t RecordIterator::getNextBatch( RecordLocAndData* out, size_t maxRecords ) {
+        size_t n = 0;
+        while ( n < maxRecords ) {
+            // no isEOF() check: tailable iterators can produce more after reaching EOF
+            DiskLoc loc = getNext();
+            if ( loc.isNull() )
+                break;
+            out[n].loc = loc;
+            out[n].data = dataFor( loc );
+            n++;
+        }
+        return n;
+    }
+
     RecordStore::RecordStore( const StringData& ns )
         : _ns( ns.toString() ) {
     }
@@ -39,4 +55,38 @@ namespace mongo {
     RecordStore::~RecordStore() {
     }
 
+    Status RecordStore::insertRecords( OperationContext* txn,
+                                       const DocWriter* const* docs,
+                                       size_t nDocs,
+                                       DiskLoc* locsOut,
+                                       bool enforceQuota ) {
+        for ( size_t i = 0; i < nDocs; i++ ) {
+            StatusWith<DiskLoc> loc = insertRecord( txn, docs[i], enforceQuota );
+            if ( !loc.isOK() )
+                return loc.getStatus();
+            locsOut[i] = loc.getValue();
+        }
+        return Status::OK();
+    }
+
+    StatusWith<bool> RecordStore::compactIncremental( OperationContext* txn,
+                                                      RecordStoreCompactAdaptor* adaptor,
+                                                      UpdateMoveNotifier* notifier,
+                                                      const CompactOptions* options,
+                                                      int maxRecords,
+                                                      CompactStats* stats ) {
+        return StatusWith<bool>( ErrorCodes::IllegalOperation,
+                                 mongoutils::str::stream() << "online compact not supported by "
+                                                           << name() );
+    }
+
+    StatusWith<bool> RecordStore::scrubRecords( OperationContext* txn,
+                                                int maxRecords,
+                                                ScrubState* state,
+                                                std::vector<DiskLoc>* corrupt ) const {
+        return StatusWith<bool>( ErrorCodes::IllegalOperation,
+                                 mongoutils::str::stream() << "record checksums not supported by "
+                                                           << name() );
+    }
+
 }
@@ -50,6 +50,7 @@ namespace mongo {
     class RecordStoreCompactAdaptor;
     class RecordStore;
 
+    struct ScrubState;
     struct ValidateResults;
     class ValidateAdaptor;
 
@@ -76,6 +77,14 @@ namespace mongo {
                                                size_t oldSize ) = 0;
     };
 
+    /**
+     * A record and where it lives, as produced by RecordIterator::getNextBatch.
+     */
+    struct RecordLocAndData {
+        DiskLoc loc;
+        RecordData data;
+    };
+
     /**
      * A RecordIterator provides an interface for walking over a RecordStore.
      * The details of navigating the collection's structure are below this interface.
@@ -94,6 +103,11 @@ namespace mongo {
         // from the collection.  Returns DiskLoc() if isEOF.
         virtual DiskLoc getNext() = 0;
 
+        // Fill 'out' with up to 'maxRecords' records as if by repeated getNext()/dataFor() and
+        // return how many were filled.  Returns fewer than 'maxRecords' only once getNext()
+        // would return DiskLoc().  The data has the same lifetime as dataFor() results.
+        virtual size_t getNextBatch( RecordLocAndData* out, size_t maxRecords );
+
         // Can only be called after prepareToYield and before recoverFromYield.
         virtual void invalidate(const DiskLoc& dl) = 0;
 
@@ -150,6 +164,19 @@ namespace mongo {
                                                   const DocWriter* doc,
                                                   bool enforceQuota ) = 0;
 
+        /**
+         * Inserts nDocs documents in a single call so implementations can amortize allocation
+         * and write intents across the whole batch.
+         * @param locsOut - must have room for nDocs entries, filled in the same order as docs
+         * @return the first failure, if any. Documents before the failing one stay inserted.
+         * The default implementation calls insertRecord once per document.
+         */
+        virtual Status insertRecords( OperationContext* txn,
+                                      const DocWriter* const* docs,
+                                      size_t nDocs,
+                                      DiskLoc* locsOut,
+                                      bool enforceQuota );
+
         /**
          * @param notifier - this is called if the document is moved
          *                   it is to be called after the document has been written to new
@@ -217,6 +244,29 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats ) = 0;
 
+        /**
+         * Online alternative to compact(): does a bounded step of moving records out of the
+         * end of the store into free space elsewhere, releasing the space they leave.  The
+         * caller holds its locks for one step at a time and calls again until done.
+         * @param notifier - told before each record moves, as for updateRecord()
+         * @param adaptor - checks each record and is told where it moved to
+         * @param maxRecords - moves at most this many records
+         * @return true once there is nothing left worth doing
+         * The default implementation fails with IllegalOperation.
+         */
+        virtual StatusWith<bool> compactIncremental( OperationContext* txn,
+                                                     RecordStoreCompactAdaptor* adaptor,
+                                                     UpdateMoveNotifier* notifier,
+                                                     const CompactOptions* options,
+                                                     int maxRecords,
+                                                     CompactStats* stats );
+
+        /**
+         * Called when online compaction stops before compactIncremental() returned true, on
+         * error or interrupt, so that space set aside for the step in progress is usable again.
+         */
+        virtual void abortCompactIncremental( OperationContext* txn ) {}
+
         /**
          * @param full - does more checks
          * @param scanData - scans each document
@@ -229,6 +279,20 @@ namespace mongo {
                                  ValidateAdaptor* adaptor,
                                  ValidateResults* results, BSONObjBuilder* output ) const = 0;
 
+        /**
+         * Checks the stored checksums of a bounded number of records, carrying on from where
+         * 'state' got to.  The caller holds its locks for one call at a time, so records
+         * inserted or deleted in between may be missed until the next pass.
+         * @param maxRecords - checks at most this many records
+         * @param corrupt - records whose data doesn't match their checksum are added to this
+         * @return true once the pass over the store is done
+         * The default implementation fails with IllegalOperation.
+         */
+        virtual StatusWith<bool> scrubRecords( OperationContext* txn,
+                                               int maxRecords,
+                                               ScrubState* state,
+                                               std::vector<DiskLoc>* corrupt ) const;
+
         /**
          * @param scaleSize - amount by which to scale size metrics
          * appends any custom stats from the RecordStore or other unique stats
@@ -262,6 +326,17 @@ namespace mongo {
         virtual void inserted( const RecordData& recData, const DiskLoc& newLocation ) = 0;
     };
 
+    /**
+     * Progress of a RecordStore::scrubRecords pass.  Start a pass with a default constructed one.
+     */
+    struct ScrubState {
+        ScrubState() : recordsChecked( 0 ), recordsWithoutChecksum( 0 ), mismatches( 0 ) {}
+        DiskLoc next; // where the next call starts, null at the start of a pass
+        long long recordsChecked;
+        long long recordsWithoutChecksum;
+        long long mismatches;
+    };
+
     struct ValidateResults {
         ValidateResults() {
             valid = true;
@@ -60,6 +60,13 @@ namespace mongo {
         }
     }
 
+    HeapRecordStore::~HeapRecordStore() {
+        // returns any allocations too large for a slab, slabs go with _allocator
+        for (Records::const_iterator it = _records.begin(); it != _records.end(); ++it) {
+            freeRecord(reinterpret_cast<HeapRecord*>(it->second));
+        }
+    }
+
     const char* HeapRecordStore::name() const { return "heap"; }
 
     RecordData HeapRecordStore::dataFor( const DiskLoc& loc ) const {
@@ -69,13 +76,24 @@ namespace mongo {
     HeapRecordStore::HeapRecord* HeapRecordStore::recordFor(const DiskLoc& loc) const {
         Records::const_iterator it = _records.find(loc);
         invariant(it != _records.end());
-        return reinterpret_cast<HeapRecord*>(it->second.get());
+        return reinterpret_cast<HeapRecord*>(it->second);
+    }
+
+    HeapRecordStore::HeapRecord* HeapRecordStore::allocRecord(int lengthWithHeaders) {
+        HeapRecord* rec = reinterpret_cast<HeapRecord*>(_allocator.allocate(lengthWithHeaders));
+        rec->lengthWithHeaders() = lengthWithHeaders;
+        return rec;
+    }
+
+    void HeapRecordStore::freeRecord(HeapRecord* rec) {
+        _allocator.free(reinterpret_cast<char*>(rec), rec->lengthWithHeaders());
     }
 
     void HeapRecordStore::deleteRecord(OperationContext* txn, const DiskLoc& loc) {
         HeapRecord* rec = recordFor(loc);
         _dataSize -= rec->netLength();
         invariant(_records.erase(loc) == 1);
+        freeRecord(rec);
     }
 
     bool HeapRecordStore::cappedAndNeedDelete() const {
@@ -116,14 +134,11 @@ namespace mongo {
         }
 
         // TODO padding?
-        const int lengthWithHeaders = len + HeapRecord::HeaderSize;
-        boost::shared_array<char> buf(new char[lengthWithHeaders]);
-        HeapRecord* rec = reinterpret_cast<HeapRecord*>(buf.get());
-        rec->lengthWithHeaders() = lengthWithHeaders;
+        HeapRecord* rec = allocRecord(len + HeapRecord::HeaderSize);
         memcpy(rec->data(), data, len);
 
         const DiskLoc loc = allocateLoc();
-        _records[loc] = buf;
+        _records[loc] = reinterpret_cast<char*>(rec);
         _dataSize += len;
 
         cappedDeleteAsNeeded(txn);
@@ -143,14 +158,11 @@ namespace mongo {
         }
 
         // TODO padding?
-        const int lengthWithHeaders = len + HeapRecord::HeaderSize;
-        boost::shared_array<char> buf(new char[lengthWithHeaders]);
-        HeapRecord* rec = reinterpret_cast<HeapRecord*>(buf.get());
-        rec->lengthWithHeaders() = lengthWithHeaders;
+        HeapRecord* rec = allocRecord(len + HeapRecord::HeaderSize);
         doc->writeDocument(rec->data());
 
         const DiskLoc loc = allocateLoc();
-        _records[loc] = buf;
+        _records[loc] = reinterpret_cast<char*>(rec);
         _dataSize += len;
 
         cappedDeleteAsNeeded(txn);
@@ -158,6 +170,32 @@ namespace mongo {
         return StatusWith<DiskLoc>(loc);
     }
 
+    Status HeapRecordStore::insertRecords(OperationContext* txn,
+                                          const DocWriter* const* docs,
+                                          size_t nDocs,
+                                          DiskLoc* locsOut,
+                                          bool enforceQuota) {
+        if (_isCapped) {
+            // each insert may need to delete older records first
+            return RecordStore::insertRecords(txn, docs, nDocs, locsOut, enforceQuota);
+        }
+
+        // new locs always sort after existing ones, so append with an end() hint
+        for (size_t i = 0; i < nDocs; i++) {
+            const int len = docs[i]->documentSize();
+            HeapRecord* rec = allocRecord(len + HeapRecord::HeaderSize);
+            docs[i]->writeDocument(rec->data());
+
+            const DiskLoc loc = allocateLoc();
+            _records.insert(_records.end(),
+                            Records::value_type(loc, reinterpret_cast<char*>(rec)));
+            _dataSize += len;
+            locsOut[i] = loc;
+        }
+
+        return Status::OK();
+    }
+
     StatusWith<DiskLoc> HeapRecordStore::updateRecord(OperationContext* txn,
                                                       const DiskLoc& oldLocation,
                                                       const char* data,
@@ -184,13 +222,11 @@ namespace mongo {
         // If the length of the new data exceeds the size of the old Record, we need to allocate
         // a new Record, and delete the old one
 
-        const int lengthWithHeaders = len + HeapRecord::HeaderSize;
-        boost::shared_array<char> buf(new char[lengthWithHeaders]);
-        HeapRecord* rec = reinterpret_cast<HeapRecord*>(buf.get());
-        rec->lengthWithHeaders() = lengthWithHeaders;
+        HeapRecord* rec = allocRecord(len + HeapRecord::HeaderSize);
         memcpy(rec->data(), data, len);
 
-        _records[oldLocation] = buf;
+        _records[oldLocation] = reinterpret_cast<char*>(rec);
+        freeRecord(oldRecord);
         _dataSize += len - oldLen;
 
         cappedDeleteAsNeeded(txn);
@@ -244,6 +280,9 @@ namespace mongo {
     }
 
     Status HeapRecordStore::truncate(OperationContext* txn) {
+        for (Records::const_iterator it = _records.begin(); it != _records.end(); ++it) {
+            freeRecord(reinterpret_cast<HeapRecord*>(it->second));
+        }
         _records.clear();
         _dataSize = 0;
         return Status::OK();
@@ -255,8 +294,10 @@ namespace mongo {
         Records::iterator it = inclusive ? _records.lower_bound(end)
                                          : _records.upper_bound(end);
         while(it != _records.end()) {
-            _dataSize -= reinterpret_cast<HeapRecord*>(it->second.get())->netLength();
+            HeapRecord* rec = reinterpret_cast<HeapRecord*>(it->second);
+            _dataSize -= rec->netLength();
             _records.erase(it++);
+            freeRecord(rec);
         }
     }
 
@@ -280,7 +321,7 @@ namespace mongo {
         results->valid = true;
         if (scanData && full) {
             for (Records::const_iterator it = _records.begin(); it != _records.end(); ++it) {
-                HeapRecord* rec = reinterpret_cast<HeapRecord*>(it->second.get());
+                HeapRecord* rec = reinterpret_cast<HeapRecord*>(it->second);
                 size_t dataSize;
                 const Status status = adaptor->validate(rec->toRecordData(), &dataSize);
                 if (!status.isOK()) {
@@ -298,7 +339,9 @@ namespace mongo {
     }
     
     void HeapRecordStore::appendCustomStats( BSONObjBuilder* result, double scale ) const {
-        result->append( "note", "HeapRecordStore has no cusom stats yet" );
+        BSONObjBuilder allocatorStats( result->subobjStart( "slabAllocator" ) );
+        _allocator.appendStats( &allocatorStats, scale );
+        allocatorStats.done();
     }
 
     Status HeapRecordStore::touch(OperationContext* txn, BSONObjBuilder* output) const {
@@ -321,8 +364,7 @@ namespace mongo {
 
     int64_t HeapRecordStore::storageSize(BSONObjBuilder* extraInfo, int infoLevel) const {
         // Note: not making use of extraInfo or infoLevel since we don't have extents
-        const int64_t recordOverhead = numRecords() * HeapRecord::HeaderSize;
-        return _dataSize + recordOverhead;
+        return _allocator.bytesReserved();
     }
 
     DiskLoc HeapRecordStore::allocateLoc() {
@@ -391,6 +433,23 @@ namespace mongo {
         return out;
     }
 
+    size_t HeapRecordIterator::getNextBatch(RecordLocAndData* out, size_t maxRecords) {
+        if (_tailable) {
+            // getNext() knows how to resume from _lastLoc
+            return RecordIterator::getNextBatch(out, maxRecords);
+        }
+
+        // read the records straight out of the map rather than looking each one up again
+        size_t n = 0;
+        for (; n < maxRecords && _it != _records.end(); ++_it, ++n) {
+            out[n].loc = _it->first;
+            out[n].data =
+                reinterpret_cast<const HeapRecordStore::HeapRecord*>(_it->second)
+                    ->toRecordData();
+        }
+        return n;
+    }
+
     void HeapRecordIterator::invalidate(const DiskLoc& loc) {
         if (_rs.isCapped()) {
             // Capped iterators die on invalidation rather than advancing.
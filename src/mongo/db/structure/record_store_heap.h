@@ -30,10 +30,10 @@
 
 #pragma once
 
-#include <boost/shared_array.hpp>
 #include <map>
 
 #include "mongo/db/structure/capped_callback.h"
+#include "mongo/db/structure/heap_slab_allocator.h"
 #include "mongo/db/structure/record_store.h"
 
 namespace mongo {
@@ -52,6 +52,8 @@ namespace mongo {
                                  int64_t cappedMaxDocs = -1,
                                  CappedDocumentDeleteCallback* cappedDeleteCallback = NULL);
 
+        virtual ~HeapRecordStore();
+
         virtual const char* name() const;
 
         virtual RecordData dataFor( const DiskLoc& loc ) const;
@@ -66,6 +68,12 @@ namespace mongo {
         virtual StatusWith<DiskLoc> insertRecord( OperationContext* txn,
                                                   const DocWriter* doc,
                                                   bool enforceQuota );
+
+        virtual Status insertRecords( OperationContext* txn,
+                                      const DocWriter* const* docs,
+                                      size_t nDocs,
+                                      DiskLoc* locsOut,
+                                      bool enforceQuota );
                                                   
         virtual StatusWith<DiskLoc> updateRecord( OperationContext* txn,
                                                   const DiskLoc& oldLocation,
@@ -140,12 +148,15 @@ namespace mongo {
 
         virtual HeapRecord* recordFor( const DiskLoc& loc ) const;
 
+        friend class HeapRecordIterator;
+
     public:
         //
         // Not in RecordStore interface
         //
 
-        typedef std::map<DiskLoc, boost::shared_array<char> > Records;
+        // values are HeapRecords, allocated from _allocator
+        typedef std::map<DiskLoc, char*> Records;
 
         bool isCapped() const { return _isCapped; }
         void setCappedDeleteCallback(CappedDocumentDeleteCallback* cb) { _cappedDeleteCallback = cb; }
@@ -154,6 +165,8 @@ namespace mongo {
 
     private:
         DiskLoc allocateLoc();
+        HeapRecord* allocRecord(int lengthWithHeaders);
+        void freeRecord(HeapRecord* rec);
         bool cappedAndNeedDelete() const;
         void cappedDeleteAsNeeded(OperationContext* txn);
 
@@ -164,6 +177,7 @@ namespace mongo {
         CappedDocumentDeleteCallback* _cappedDeleteCallback;
         int64_t _dataSize;
 
+        HeapSlabAllocator _allocator;
         Records _records;
         int64_t _nextId;
     };
@@ -181,6 +195,8 @@ namespace mongo {
 
         virtual DiskLoc getNext();
 
+        virtual size_t getNextBatch( RecordLocAndData* out, size_t maxRecords );
+
         virtual void invalidate(const DiskLoc& dl);
 
         virtual void prepareToYield();
@@ -31,11 +31,14 @@
 #include "mongo/db/structure/record_store_v1_base.h"
 
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/namespace_string.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/structure/record_store_v1_repair_iterator.h"
+#include "mongo/util/compress.h"
+#include "mongo/util/crc32c.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/timer.h"
 #include "mongo/util/touch_pages.h"
@@ -56,6 +59,30 @@ namespace mongo {
         0x200000, 0x400000, 0x1000000,            // 2M,   4M,   16M (see above)
      };
 
+    /* Upper bound on the space insertRecords() requests from a single allocation.  Larger
+       batches are split into several groups so they don't force oversized extents.
+    */
+    const int RecordStoreV1Base::MaxBatchAllocationSize = 1024 * 1024;
+
+    const int RecordStoreV1Base::MinCompressedRecordSize = 256;
+
+    /* A record with a checksum ends with this, in the last bytes of its allocation, so any
+       space between the data and the checksum is ordinary padding.  The magic number tells
+       records with a checksum from those without.  It has no zero bytes, so a BSON document
+       (which ends with one) that runs into it can't leave it intact.
+    */
+    namespace {
+        struct RecordChecksum {
+            int dataLength;
+            uint32_t crc;
+            uint32_t magic;
+        };
+
+        BOOST_STATIC_ASSERT( 12 == sizeof(RecordChecksum) );
+
+        const uint32_t RecordChecksumMagic = 0x43524331;
+    }
+
 
     RecordStoreV1Base::RecordStoreV1Base( const StringData& ns,
                                           RecordStoreV1MetaData* details,
@@ -101,7 +128,119 @@ namespace mongo {
     }
 
     RecordData RecordStoreV1Base::dataFor( const DiskLoc& loc ) const {
-        return recordFor(loc)->toRecordData();
+        return _recordData( recordFor( loc ) );
+    }
+
+    /* A compressed record's data starts with the negated length of the snappy block that
+       follows it.  BSON sizes are positive, so raw and compressed records can be told apart and
+       a collection can hold both.
+    */
+    bool RecordStoreV1Base::_isCompressed( const Record* rec ) {
+        int header;
+        memcpy( &header, rec->data(), sizeof( header ) );
+        return header < 0 && header >= -( rec->netLength() - static_cast<int>( sizeof( header ) ) );
+    }
+
+    RecordData RecordStoreV1Base::_recordData( const Record* rec ) const {
+        if ( !( _details->userFlags() & ( Flag_CompressRecords | Flag_MayHaveCompressedRecords ) ) ||
+             !_isCompressed( rec ) ) {
+            return rec->toRecordData();
+        }
+
+        int header;
+        memcpy( &header, rec->data(), sizeof( header ) );
+        const char* compressed = rec->data() + sizeof( header );
+        const size_t compressedLength = -header;
+
+        size_t length;
+        if ( !uncompressedLength( compressed, compressedLength, &length ) ||
+             length > static_cast<size_t>( BSONObjMaxInternalSize ) ) {
+            msgasserted( 18528, str::stream() << "corrupt compressed record in " << _ns );
+        }
+
+        boost::shared_array<char> buf( new char[length] );
+        if ( !rawUncompress( compressed, compressedLength, buf.get() ) )
+            msgasserted( 18529, str::stream() << "corrupt compressed record in " << _ns );
+
+        return RecordData( buf.get(), length, buf );
+    }
+
+    bool RecordStoreV1Base::_compressRecord( const char* data, int len, std::string* out ) const {
+        if ( len < MinCompressedRecordSize || !_details->isUserFlagSet( Flag_CompressRecords ) )
+            return false;
+
+        int header;
+        out->resize( sizeof( header ) + maxCompressedLength( len ) );
+        size_t compressedLength;
+        rawCompress( data, len, &(*out)[sizeof( header )], &compressedLength );
+
+        // saving less than an eighth isn't worth decompressing on every read
+        if ( sizeof( header ) + compressedLength > static_cast<size_t>( len - len / 8 ) )
+            return false;
+
+        header = -static_cast<int>( compressedLength );
+        memcpy( &(*out)[0], &header, sizeof( header ) );
+        out->resize( sizeof( header ) + compressedLength );
+        return true;
+    }
+
+    int RecordStoreV1Base::_checksumSpace() const {
+        return _details->isUserFlagSet( Flag_RecordChecksums ) ? sizeof( RecordChecksum ) : 0;
+    }
+
+    void RecordStoreV1Base::_setChecksum( OperationContext* txn, Record* r, int dataLength ) {
+        if ( !_details->isUserFlagSet( Flag_MayHaveRecordChecksums ) )
+            return;
+
+        const int checksumOfs = r->netLength() - static_cast<int>( sizeof( RecordChecksum ) );
+        if ( checksumOfs < 0 )
+            return;
+        RecordChecksum* checksum = reinterpret_cast<RecordChecksum*>( r->data() + checksumOfs );
+
+        if ( dataLength <= checksumOfs && _details->isUserFlagSet( Flag_RecordChecksums ) ) {
+            checksum = txn->recoveryUnit()->writing( checksum );
+            checksum->dataLength = dataLength;
+            checksum->crc = crc32c( r->data(), dataLength );
+            checksum->magic = RecordChecksumMagic;
+        }
+        else if ( dataLength <= r->netLength() - static_cast<int>( sizeof( checksum->magic ) ) &&
+                  checksum->magic == RecordChecksumMagic ) {
+            // the data no longer matches whatever checksum the record had
+            *txn->recoveryUnit()->writing( &checksum->magic ) = 0;
+        }
+    }
+
+    void RecordStoreV1Base::_refreshChecksum( OperationContext* txn, Record* r ) {
+        if ( !_details->isUserFlagSet( Flag_MayHaveRecordChecksums ) )
+            return;
+
+        const int checksumOfs = r->netLength() - static_cast<int>( sizeof( RecordChecksum ) );
+        if ( checksumOfs < 0 )
+            return;
+        const RecordChecksum* checksum =
+            reinterpret_cast<const RecordChecksum*>( r->data() + checksumOfs );
+
+        // a checksum that is already wrong stays wrong, for the scrubber to find
+        if ( checksum->magic == RecordChecksumMagic &&
+             checksum->dataLength >= 0 && checksum->dataLength <= checksumOfs ) {
+            _setChecksum( txn, r, checksum->dataLength );
+        }
+    }
+
+    RecordStoreV1Base::ChecksumState RecordStoreV1Base::_checkChecksum( const Record* r ) const {
+        const int checksumOfs = r->netLength() - static_cast<int>( sizeof( RecordChecksum ) );
+        if ( checksumOfs < 0 )
+            return ChecksumMissing;
+        const RecordChecksum* checksum =
+            reinterpret_cast<const RecordChecksum*>( r->data() + checksumOfs );
+
+        if ( checksum->magic != RecordChecksumMagic )
+            return ChecksumMissing;
+        if ( checksum->dataLength < 0 || checksum->dataLength > checksumOfs )
+            return ChecksumMismatch;
+        if ( crc32c( r->data(), checksum->dataLength ) != checksum->crc )
+            return ChecksumMismatch;
+        return ChecksumOk;
     }
 
     Record* RecordStoreV1Base::recordFor( const DiskLoc& loc ) const {
@@ -218,7 +357,16 @@ namespace mongo {
             return StatusWith<DiskLoc>( ErrorCodes::InvalidLength,
                                         "record has to be >= 4 bytes" );
         }
-        int lenWHdr = docSize + Record::HeaderSize;
+
+        if ( docSize >= MinCompressedRecordSize &&
+             _details->isUserFlagSet( Flag_CompressRecords ) ) {
+            // the document has to be written out before it can be compressed
+            std::string buf( docSize, '\0' );
+            doc->writeDocument( &buf[0] );
+            return insertRecord( txn, buf.data(), docSize, enforceQuota );
+        }
+
+        int lenWHdr = docSize + Record::HeaderSize + _checksumSpace();
         if ( doc->addPadding() )
             lenWHdr = getRecordAllocationSize( lenWHdr );
 
@@ -231,6 +379,7 @@ namespace mongo {
 
         r = reinterpret_cast<Record*>( txn->recoveryUnit()->writingPtr(r, lenWHdr) );
         doc->writeDocument( r->data() );
+        _setChecksum( txn, r, docSize );
 
         _addRecordToRecListInExtent(txn, r, loc.getValue());
 
@@ -242,6 +391,126 @@ namespace mongo {
     }
 
 
+    Status RecordStoreV1Base::insertRecords( OperationContext* txn,
+                                             const DocWriter* const* docs,
+                                             size_t nDocs,
+                                             DiskLoc* locsOut,
+                                             bool enforceQuota ) {
+        if ( _details->isUserFlagSet( Flag_CompressRecords ) ) {
+            // compressed sizes aren't known up front, so keep the one at a time path
+            return RecordStore::insertRecords( txn, docs, nDocs, locsOut, enforceQuota );
+        }
+
+        std::vector<int> lengths;
+        Status status = _recordGroupLengths( docs, nDocs, &lengths );
+        if ( !status.isOK() )
+            return status;
+
+        size_t first = 0;
+        while ( first < nDocs ) {
+            // take as many following documents as fit in one allocation
+            size_t end = first + 1;
+            int totalLength = lengths[first];
+            while ( end < nDocs && totalLength + lengths[end] <= MaxBatchAllocationSize ) {
+                totalLength += lengths[end];
+                end++;
+            }
+
+            status = _insertRecordGroup( txn,
+                                         docs + first,
+                                         &lengths[first],
+                                         end - first,
+                                         totalLength,
+                                         locsOut + first,
+                                         enforceQuota );
+            if ( !status.isOK() )
+                return status;
+
+            first = end;
+        }
+
+        return Status::OK();
+    }
+
+    Status RecordStoreV1Base::_recordGroupLengths( const DocWriter* const* docs,
+                                                   size_t nDocs,
+                                                   std::vector<int>* lengths ) const {
+        lengths->resize( nDocs );
+        for ( size_t i = 0; i < nDocs; i++ ) {
+            int docSize = docs[i]->documentSize();
+            if ( docSize < 4 ) {
+                return Status( ErrorCodes::InvalidLength, "record has to be >= 4 bytes" );
+            }
+            int lenWHdr = docSize + Record::HeaderSize + _checksumSpace();
+            if ( docs[i]->addPadding() )
+                lenWHdr = getRecordAllocationSize( lenWHdr );
+            // keep each record in the group 4 byte aligned, like both allocRecord()s
+            (*lengths)[i] = ( lenWHdr + 3 ) & ~3;
+        }
+        return Status::OK();
+    }
+
+    Status RecordStoreV1Base::_insertRecordGroup( OperationContext* txn,
+                                                  const DocWriter* const* docs,
+                                                  const int* lengths,
+                                                  size_t nDocs,
+                                                  int totalLength,
+                                                  DiskLoc* locsOut,
+                                                  bool enforceQuota ) {
+        StatusWith<DiskLoc> loc = allocRecord( txn, totalLength, enforceQuota );
+        if ( !loc.isOK() )
+            return loc.getStatus();
+
+        const DiskLoc start = loc.getValue();
+        Record* firstRecord = recordFor( start );
+        const int regionLength = firstRecord->lengthWithHeaders();
+        fassert( 18525, regionLength >= totalLength );
+        const int extentOfs = firstRecord->extentOfs();
+
+        // a single write intent covers the headers and data of every record in the group
+        char* region = reinterpret_cast<char*>( txn->recoveryUnit()->writingPtr( firstRecord,
+                                                                                 totalLength ) );
+
+        Record* prev = NULL;
+        int ofs = 0;
+        for ( size_t i = 0; i < nDocs; i++ ) {
+            Record* r = reinterpret_cast<Record*>( region + ofs );
+            const DiskLoc recLoc( start.a(), start.getOfs() + ofs );
+
+            // the last record gets any slack the allocator left over
+            r->lengthWithHeaders() = ( i == nDocs - 1 ) ? regionLength - ofs : lengths[i];
+            r->extentOfs() = extentOfs;
+            docs[i]->writeDocument( r->data() );
+            _setChecksum( txn, r, docs[i]->documentSize() );
+
+            if ( !prev ) {
+                _addRecordToRecListInExtent( txn, r, recLoc );
+            }
+            else {
+                // already covered by the intent above
+                prev->nextOfs() = recLoc.getOfs();
+                r->prevOfs() = locsOut[i - 1].getOfs();
+                r->nextOfs() = DiskLoc::NullOfs;
+            }
+
+            locsOut[i] = recLoc;
+            prev = r;
+            ofs += lengths[i];
+            _paddingFits( txn );
+        }
+
+        if ( nDocs > 1 ) {
+            Extent* e = _getExtent( _getExtentLocForRecord( start ) );
+            *txn->recoveryUnit()->writing( &e->lastRecord ) = locsOut[nDocs - 1];
+        }
+
+        _details->incrementStats( txn,
+                                  regionLength - static_cast<int>( nDocs ) * Record::HeaderSize,
+                                  nDocs );
+
+        return Status::OK();
+    }
+
     StatusWith<DiskLoc> RecordStoreV1Base::insertRecord( OperationContext* txn,
                                                          const char* data,
                                                          int len,
@@ -251,6 +520,12 @@ namespace mongo {
                                         "record has to be >= 4 bytes" );
         }
 
+        std::string compressed;
+        if ( _compressRecord( data, len, &compressed ) ) {
+            data = compressed.data();
+            len = compressed.size();
+        }
+
         StatusWith<DiskLoc> status = _insertRecord( txn, data, len, enforceQuota );
         if ( status.isOK() )
             _paddingFits( txn );
@@ -263,7 +538,7 @@ namespace mongo {
                                                           int len,
                                                           bool enforceQuota ) {
 
-        int lenWHdr = getRecordAllocationSize( len + Record::HeaderSize );
+        int lenWHdr = getRecordAllocationSize( len + Record::HeaderSize + _checksumSpace() );
         fassert( 17208, lenWHdr >= ( len + Record::HeaderSize ) );
 
         StatusWith<DiskLoc> loc = allocRecord( txn, lenWHdr, enforceQuota );
@@ -276,6 +551,7 @@ namespace mongo {
         // copy the data
         r = reinterpret_cast<Record*>( txn->recoveryUnit()->writingPtr(r, lenWHdr) );
         memcpy( r->data(), data, len );
+        _setChecksum( txn, r, len );
 
         _addRecordToRecListInExtent(txn, r, loc.getValue());
 
@@ -291,10 +567,18 @@ namespace mongo {
                                                          bool enforceQuota,
                                                          UpdateMoveNotifier* notifier ) {
         Record* oldRecord = recordFor( oldLocation );
+
+        std::string compressed;
+        if ( _compressRecord( data, dataSize, &compressed ) ) {
+            data = compressed.data();
+            dataSize = compressed.size();
+        }
+
         if ( oldRecord->netLength() >= dataSize ) {
             // we fit
             _paddingFits( txn );
             memcpy( txn->recoveryUnit()->writingPtr( oldRecord->data(), dataSize ), data, dataSize );
+            _setChecksum( txn, oldRecord, dataSize );
             return StatusWith<DiskLoc>( oldLocation );
         }
 
@@ -313,10 +597,11 @@ namespace mongo {
 
         // insert worked, so we delete old record
         if ( notifier ) {
+            const RecordData oldData = _recordData( oldRecord );
             Status moveStatus = notifier->recordStoreGoingToMove( txn,
                                                                   oldLocation,
-                                                                  oldRecord->data(),
-                                                                  oldRecord->netLength() );
+                                                                  oldData.data(),
+                                                                  oldData.size() );
             if ( !moveStatus.isOK() )
                 return StatusWith<DiskLoc>( moveStatus );
         }
@@ -331,9 +616,40 @@ namespace mongo {
                                                  const DiskLoc& loc,
                                                  const char* damageSource,
                                                  const mutablebson::DamageVector& damages ) {
+        Record* rec = recordFor( loc );
+
+        if ( ( _details->userFlags() & ( Flag_CompressRecords | Flag_MayHaveCompressedRecords ) ) &&
+             _isCompressed( rec ) ) {
+            // the damage offsets are into the decompressed document, so apply them to a copy
+            // and write the whole record back
+            const RecordData oldData = _recordData( rec );
+            std::string doc( oldData.data(), oldData.size() );
+            for ( size_t i = 0; i < damages.size(); i++ ) {
+                const mutablebson::DamageEvent& event = damages[i];
+                memcpy( &doc[event.targetOffset],
+                        damageSource + event.sourceOffset,
+                        event.size );
+            }
+
+            std::string compressed;
+            const std::string& newData = _compressRecord( doc.data(), doc.size(), &compressed )
+                                             ? compressed
+                                             : doc;
+            if ( static_cast<int>( newData.size() ) > rec->netLength() ) {
+                return Status( ErrorCodes::CannotUpdateInPlace,
+                               "compressed record no longer fits in place" );
+            }
+
+            _paddingFits( txn );
+            memcpy( txn->recoveryUnit()->writingPtr( rec->data(), newData.size() ),
+                    newData.data(),
+                    newData.size() );
+            _setChecksum( txn, rec, newData.size() );
+            return Status::OK();
+        }
+
         _paddingFits( txn );
 
-        Record* rec = recordFor( loc );
         char* root = rec->data();
 
         // All updates were in place. Apply them via durability and writing pointer.
@@ -345,6 +661,8 @@ namespace mongo {
             std::memcpy(targetPtr, sourcePtr, where->size);
         }
 
+        _refreshChecksum( txn, rec );
+
         return Status::OK();
     }
 
@@ -435,11 +753,13 @@ namespace mongo {
 
     void RecordStoreV1Base::increaseStorageSize( OperationContext* txn,
                                                  int size,
-                                                 bool enforceQuota ) {
+                                                 bool enforceQuota,
+                                                 int smallestUseful ) {
         DiskLoc eloc = _extentManager->allocateExtent( txn,
                                                        isCapped(),
                                                        size,
-                                                       enforceQuota );
+                                                       enforceQuota,
+                                                       smallestUseful );
 
         Extent *e = _extentManager->getExtent( eloc );
         invariant( e );
@@ -473,6 +793,77 @@ namespace mongo {
         addDeletedRec(txn, emptyLoc);
     }
 
+    DiskLoc RecordStoreV1Base::_scrubResumePoint( const DiskLoc& loc ) const {
+        bool lost = loc.isNull();
+        DiskLoc extLoc = _details->firstExtent();
+        while ( !extLoc.isNull() ) {
+            const Extent* e = _getExtent( extLoc );
+            const int extEnd = extLoc.getOfs() + e->length;
+
+            if ( !lost &&
+                 loc.a() == extLoc.a() &&
+                 loc.getOfs() > extLoc.getOfs() &&
+                 loc.getOfs() + Record::HeaderSize <= extEnd ) {
+                // 'loc' is in this extent.  It still holds a record if the record before it
+                // (or the extent, for the first one) still points to it.
+                const Record* r = recordFor( loc );
+                const int prevOfs = r->prevOfs();
+                if ( r->extentOfs() == extLoc.getOfs() ) {
+                    if ( prevOfs == DiskLoc::NullOfs ) {
+                        if ( e->firstRecord == loc )
+                            return loc;
+                    }
+                    else if ( prevOfs > extLoc.getOfs() &&
+                              prevOfs + Record::HeaderSize <= extEnd &&
+                              recordFor( DiskLoc( loc.a(), prevOfs ) )->nextOfs() ==
+                                  loc.getOfs() ) {
+                        return loc;
+                    }
+                }
+
+                // deleted since the last call: start this extent again
+                lost = true;
+            }
+
+            if ( lost && !e->firstRecord.isNull() )
+                return e->firstRecord;
+
+            extLoc = e->xnext;
+        }
+
+        // either at the end, or the extent was freed
+        return DiskLoc();
+    }
+
+    StatusWith<bool> RecordStoreV1Base::scrubRecords( OperationContext* txn,
+                                                      int maxRecords,
+                                                      ScrubState* state,
+                                                      std::vector<DiskLoc>* corrupt ) const {
+        if ( !_details->isUserFlagSet( Flag_MayHaveRecordChecksums ) )
+            return StatusWith<bool>( true );
+
+        DiskLoc loc = _scrubResumePoint( state->next );
+        for ( int n = 0; n < maxRecords && !loc.isNull(); n++ ) {
+            switch ( _checkChecksum( recordFor( loc ) ) ) {
+            case ChecksumMissing:
+                state->recordsWithoutChecksum++;
+                break;
+            case ChecksumOk:
+                state->recordsChecked++;
+                break;
+            case ChecksumMismatch:
+                state->recordsChecked++;
+                state->mismatches++;
+                corrupt->push_back( loc );
+                break;
+            }
+            loc = getNextRecord( loc );
+        }
+
+        state->next = loc;
+        return StatusWith<bool>( loc.isNull() );
+    }
+
     Status RecordStoreV1Base::validate( OperationContext* txn,
                                         bool full, bool scanData,
                                         ValidateAdaptor* adaptor,
@@ -624,6 +1015,9 @@ namespace mongo {
                 long long nlen = 0;
                 long long bsonLen = 0;
                 int outOfOrder = 0;
+                long long nChecksumMismatch = 0;
+                const bool checkChecksums =
+                    full && _details->isUserFlagSet( Flag_MayHaveRecordChecksums );
                 DiskLoc cl_last;
 
                 scoped_ptr<RecordIterator> iterator( getIterator( DiskLoc(),
@@ -659,9 +1053,15 @@ namespace mongo {
                         ++nPowerOf2QuantizedSize;
                     }
 
+                    if ( checkChecksums && _checkChecksum( r ) == ChecksumMismatch ) {
+                        if ( nChecksumMismatch == 0 ) // only log once;
+                            log() << "Record checksum mismatch in " << _ns << " at " << cl;
+                        nChecksumMismatch++;
+                    }
+
                     if (full){
                         size_t dataSize = 0;
-                        const Status status = adaptor->validate( r->toRecordData(), &dataSize );
+                        const Status status = adaptor->validate( _recordData( r ), &dataSize );
                         if (!status.isOK()) {
                             results->valid = false;
                             if (nInvalid == 0) // only log once;
@@ -690,6 +1090,15 @@ namespace mongo {
                     output->append("invalidObjects", nInvalid);
                 }
 
+                if ( checkChecksums ) {
+                    output->appendNumber( "checksumMismatches", nChecksumMismatch );
+                    if ( nChecksumMismatch > 0 ) {
+                        results->valid = false;
+                        results->errors.push_back( str::stream() << nChecksumMismatch
+                                                   << " records don't match their checksums" );
+                    }
+                }
+
                 output->appendNumber("nQuantizedSize", nQuantizedSize);
                 output->appendNumber("nPowerOf2QuantizedSize", nPowerOf2QuantizedSize);
                 output->appendNumber("bytesWithHeaders", len);
@@ -952,6 +1361,32 @@ namespace mongo {
             return Status::OK();
         }
 
+        if ( str::equals( "recordChecksums", option.fieldName() ) ) {
+            // btree buckets are written in place by the index code, bypassing the checksums
+            if ( !NamespaceString::normal( _ns ) )
+                return Status( ErrorCodes::BadValue,
+                               str::stream() << "recordChecksums not supported on " << _ns );
+
+            bool oldChecksums = _details->isUserFlagSet( Flag_RecordChecksums );
+            bool newChecksums = option.trueValue();
+
+            if ( oldChecksums != newChecksums ) {
+                info->appendBool( "recordChecksums_old", oldChecksums );
+
+                if ( newChecksums ) {
+                    _details->setUserFlag( txn, Flag_MayHaveRecordChecksums );
+                    _details->setUserFlag( txn, Flag_RecordChecksums );
+                }
+                else {
+                    _details->clearUserFlag( txn, Flag_RecordChecksums );
+                }
+
+                info->appendBool( "recordChecksums_new", newChecksums );
+            }
+
+            return Status::OK();
+        }
+
         return Status( ErrorCodes::InvalidOptions,
                        str::stream() << "no such option: " << option.fieldName() );
     }
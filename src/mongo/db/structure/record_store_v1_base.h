@@ -105,8 +105,35 @@ namespace mongo {
 
         static const int bucketSizes[];
 
+        static const int MaxBatchAllocationSize;
+
+        // records smaller than this are never compressed
+        static const int MinCompressedRecordSize;
+
         enum UserFlags {
-            Flag_UsePowerOf2Sizes = 1 << 0
+            Flag_UsePowerOf2Sizes = 1 << 0,
+
+            // new and rewritten records are snappy compressed, see compressRecords in
+            // SimpleRecordStoreV1::setCustomOption
+            Flag_CompressRecords = 1 << 1,
+
+            // set along with Flag_CompressRecords and never cleared, since records written
+            // while compression was on stay compressed until they are rewritten
+            Flag_MayHaveCompressedRecords = 1 << 2,
+
+            // new and rewritten records end with a crc32c of their data, see recordChecksums
+            // in RecordStoreV1Base::setCustomOption
+            Flag_RecordChecksums = 1 << 3,
+
+            // set along with Flag_RecordChecksums and never cleared, since writes to records
+            // that have a checksum have to keep it correct
+            Flag_MayHaveRecordChecksums = 1 << 4
+        };
+
+        enum ChecksumState {
+            ChecksumMissing, // the record has no checksum
+            ChecksumOk,
+            ChecksumMismatch
         };
 
         // ------------
@@ -129,6 +156,9 @@ namespace mongo {
 
         virtual int64_t storageSize( BSONObjBuilder* extraInfo = NULL, int level = 0 ) const;
 
+        /**
+         * Compressed records are returned decompressed, in memory owned by the RecordData.
+         */
         virtual RecordData dataFor( const DiskLoc& loc ) const;
 
         void deleteRecord( OperationContext* txn,
@@ -143,6 +173,16 @@ namespace mongo {
                                           const DocWriter* doc,
                                           bool enforceQuota );
 
+        /**
+         * Non-capped stores carve runs of consecutive documents out of a single allocation.
+         * Capped stores insert one at a time since allocation may wrap around.
+         */
+        virtual Status insertRecords( OperationContext* txn,
+                                      const DocWriter* const* docs,
+                                      size_t nDocs,
+                                      DiskLoc* locsOut,
+                                      bool enforceQuota );
+
         virtual StatusWith<DiskLoc> updateRecord( OperationContext* txn,
                                                   const DiskLoc& oldLocation,
                                                   const char* data,
@@ -157,7 +197,19 @@ namespace mongo {
 
         virtual RecordIterator* getIteratorForRepair() const;
 
-        void increaseStorageSize( OperationContext* txn, int size, bool enforceQuota );
+        /**
+         * Adds an extent of about 'size' bytes.
+         * @param smallestUseful - see ExtentManager::allocateExtent
+         */
+        void increaseStorageSize( OperationContext* txn,
+                                  int size,
+                                  bool enforceQuota,
+                                  int smallestUseful = 0 );
+
+        virtual StatusWith<bool> scrubRecords( OperationContext* txn,
+                                               int maxRecords,
+                                               ScrubState* state,
+                                               std::vector<DiskLoc>* corrupt ) const;
 
         virtual Status validate( OperationContext* txn,
                                  bool full, bool scanData,
@@ -206,6 +258,48 @@ namespace mongo {
 
         virtual Record* recordFor( const DiskLoc& loc ) const;
 
+        /**
+         * @return the data in 'rec', decompressing it if needed
+         */
+        RecordData _recordData( const Record* rec ) const;
+
+        /**
+         * @return true if 'rec' holds a compressed record.  Only meaningful for records of a
+         *         store with Flag_MayHaveCompressedRecords set.
+         */
+        static bool _isCompressed( const Record* rec );
+
+        /**
+         * If this store compresses records and compressing 'len' bytes of 'data' saves enough
+         * space, puts the compressed record into 'out' and returns true.
+         */
+        bool _compressRecord( const char* data, int len, std::string* out ) const;
+
+        /**
+         * @return the extra space to allocate for a checksum with each new record
+         */
+        int _checksumSpace() const;
+
+        /**
+         * To be called after the first 'dataLength' bytes of 'r' have been written.  Checksums
+         * them if this store checksums records and there is room, otherwise makes sure 'r'
+         * isn't left with an old checksum that no longer matches.
+         */
+        void _setChecksum( OperationContext* txn, Record* r, int dataLength );
+
+        /**
+         * Recomputes the checksum of 'r', if it has one, after its data changed in place.
+         */
+        void _refreshChecksum( OperationContext* txn, Record* r );
+
+        ChecksumState _checkChecksum( const Record* r ) const;
+
+        /**
+         * @return 'loc' if it still holds a record of this store, else the first record of the
+         *         extent 'loc' is in or of any later extent, else a null DiskLoc.
+         */
+        DiskLoc _scrubResumePoint( const DiskLoc& loc ) const;
+
         const DeletedRecord* deletedRecordFor( const DiskLoc& loc ) const;
 
         virtual bool isCapped() const = 0;
@@ -254,6 +348,27 @@ namespace mongo {
                                            int len,
                                            bool enforceQuota );
 
+        /**
+         * internal
+         * the allocation size of each doc's record in a group for _insertRecordGroup
+         */
+        Status _recordGroupLengths( const DocWriter* const* docs,
+                                    size_t nDocs,
+                                    std::vector<int>* lengths ) const;
+
+        /**
+         * internal
+         * allocates one region of totalLength bytes and splits it into one record per doc.
+         * lengths are the per record allocation sizes, which must sum to totalLength.
+         */
+        Status _insertRecordGroup( OperationContext* txn,
+                                   const DocWriter* const* docs,
+                                   const int* lengths,
+                                   size_t nDocs,
+                                   int totalLength,
+                                   DiskLoc* locsOut,
+                                   bool enforceQuota );
+
         scoped_ptr<RecordStoreV1MetaData> _details;
         ExtentManager* _extentManager;
         bool _isSystemIndexes;
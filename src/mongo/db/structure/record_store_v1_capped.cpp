@@ -215,6 +215,70 @@ namespace mongo {
         return StatusWith<DiskLoc>( loc );
     }
 
+    Status CappedRecordStoreV1::insertRecords( OperationContext* txn,
+                                               const DocWriter* const* docs,
+                                               size_t nDocs,
+                                               DiskLoc* locsOut,
+                                               bool enforceQuota ) {
+        if ( _details->isUserFlagSet( Flag_CompressRecords ) )
+            return RecordStore::insertRecords( txn, docs, nDocs, locsOut, enforceQuota );
+
+        std::vector<int> lengths;
+        Status status = _recordGroupLengths( docs, nDocs, &lengths );
+        if ( !status.isOK() )
+            return status;
+
+        size_t first = 0;
+        while ( first < nDocs ) {
+            const int room = _appendRoom();
+            const long long docsRoom = _details->maxCappedDocs() - _details->numRecords();
+
+            size_t end = first;
+            int totalLength = 0;
+            while ( end < nDocs &&
+                    static_cast<long long>( end - first ) < docsRoom &&
+                    totalLength + lengths[end] <= std::min( room, MaxBatchAllocationSize ) ) {
+                totalLength += lengths[end];
+                end++;
+            }
+
+            if ( end == first ) {
+                StatusWith<DiskLoc> loc = insertRecord( txn, docs[first], enforceQuota );
+                if ( !loc.isOK() )
+                    return loc.getStatus();
+                locsOut[first] = loc.getValue();
+                first++;
+                continue;
+            }
+
+            status = _insertRecordGroup( txn,
+                                         docs + first,
+                                         &lengths[first],
+                                         end - first,
+                                         totalLength,
+                                         locsOut + first,
+                                         enforceQuota );
+            if ( !status.isOK() )
+                return status;
+
+            first = end;
+        }
+
+        return Status::OK();
+    }
+
+    int CappedRecordStoreV1::_appendRoom() const {
+        if ( !cappedLastDelRecLastExtent().isValid() )
+            return 0; // still setting up the deleted list
+
+        const DiskLoc& first = cappedFirstDeletedInCurExtent();
+        if ( first.isNull() || !inCapExtent( first ) )
+            return 0;
+
+        // __capAlloc leaves room for a deleted record after what it hands out
+        return std::max( drec( first )->lengthWithHeaders() - 24, 0 );
+    }
+
     Status CappedRecordStoreV1::truncate(OperationContext* txn) {
         setLastDelRecLastExtent( txn, DiskLoc() );
         setListOfAllDeletedRecords( txn, DiskLoc() );
@@ -53,6 +53,17 @@ namespace mongo {
 
         virtual Status truncate(OperationContext* txn);
 
+        /**
+         * Appends runs of documents that fit in the free space at the insert point as one
+         * allocation.  Documents that need older ones deleted first, or the insert point to
+         * wrap around, go in one at a time as usual.
+         */
+        virtual Status insertRecords( OperationContext* txn,
+                                      const DocWriter* const* docs,
+                                      size_t nDocs,
+                                      DiskLoc* locsOut,
+                                      bool enforceQuota );
+
         /**
          * Truncate documents newer than the document at 'end' from the capped
          * collection.  The collection cannot be completely emptied using this
@@ -123,6 +134,12 @@ namespace mongo {
 
         void _maybeComplain( int len ) const;
 
+        /**
+         * How much allocRecord() can take right now without deleting anything or leaving the
+         * cap extent: what is left of the first deleted record there.
+         */
+        int _appendRoom() const;
+
         // -- end copy from cap.cpp --
 
         CappedDocumentDeleteCallback* _deleteCallback;
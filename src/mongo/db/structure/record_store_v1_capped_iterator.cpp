@@ -109,6 +109,20 @@ namespace mongo {
         return ret;
     }
 
+    size_t CappedRecordStoreV1Iterator::getNextBatch( RecordLocAndData* out, size_t maxRecords ) {
+        size_t n = 0;
+        while ( n < maxRecords ) {
+            // qualified calls skip virtual dispatch; getNext() handles wraparound and tailing
+            DiskLoc loc = CappedRecordStoreV1Iterator::getNext();
+            if ( loc.isNull() )
+                break;
+            out[n].loc = loc;
+            out[n].data = CappedRecordStoreV1Iterator::dataFor( loc );
+            n++;
+        }
+        return n;
+    }
+
     void CappedRecordStoreV1Iterator::invalidate(const DiskLoc& dl) {
         if ((_tailable && _curr.isNull() && dl == _prev) || (dl == _curr)) {
             // In the _tailable case, we're about to kill the DiskLoc that we're tailing.  Nothing
@@ -57,6 +57,7 @@ namespace mongo {
         virtual bool isEOF();
         virtual DiskLoc getNext();
         virtual DiskLoc curr();
+        virtual size_t getNextBatch( RecordLocAndData* out, size_t maxRecords );
 
         virtual void invalidate(const DiskLoc& dl);
         virtual void prepareToYield();
@@ -225,6 +225,103 @@ namespace {
         }
     }
 
+    class BatchDocWriter : public DocWriter {
+    public:
+        BatchDocWriter( int size ) : _size( size ) {}
+        virtual void writeDocument( char* buf ) const { memset( buf, 'x', _size ); }
+        virtual size_t documentSize() const { return _size; }
+        virtual bool addPadding() const { return false; }
+    private:
+        int _size;
+    };
+
+    /**
+     * A batch that fits before the end of the cap extent is appended as one allocation.
+     */
+    TEST(CappedRecordStoreV1, InsertRecordsAppendsTogether) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( true, 0 );
+        DummyCappedDocumentDeleteCallback cb;
+        CappedRecordStoreV1 rs(&txn, &cb, "test.foo", md, &em, false);
+
+        {
+            LocAndSize records[] = {
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 1000},
+                {}
+            };
+            md->setCapExtent(&txn, DiskLoc(0, 0));
+            md->setCapFirstNewRecord(&txn, DiskLoc().setInvalid());
+            initializeV1RS(&txn, records, drecs, &em, md);
+        }
+
+        BatchDocWriter doc( 100 - Record::HeaderSize );
+        const DocWriter* docs[] = { &doc, &doc, &doc };
+        DiskLoc locs[3];
+        ASSERT_OK( rs.insertRecords( &txn, docs, 3, locs, false ) );
+        ASSERT_EQUALS( DiskLoc(0, 1000), locs[0] );
+        ASSERT_EQUALS( DiskLoc(0, 1100), locs[1] );
+        ASSERT_EQUALS( DiskLoc(0, 1200), locs[2] );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(0, 1200), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1300), 700},
+                {}
+            };
+            assertStateV1RS(recs, drecs, &em, md);
+            ASSERT_EQUALS(md->capExtent(), DiskLoc(0, 0));
+            ASSERT_EQUALS(md->capFirstNewRecord(), DiskLoc().setInvalid()); // unlooped
+        }
+    }
+
+    /**
+     * Documents that need old ones deleted go in one at a time, like insertRecord.
+     */
+    TEST(CappedRecordStoreV1, InsertRecordsWrapsAround) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( true, 0 );
+        DummyCappedDocumentDeleteCallback cb;
+        CappedRecordStoreV1 rs(&txn, &cb, "test.foo", md, &em, false);
+
+        {
+            LocAndSize records[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(0, 1200), 100},
+                {DiskLoc(0, 1300), 100},
+                {DiskLoc(0, 1400), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1500), 50},
+                {}
+            };
+            md->setCapExtent(&txn, DiskLoc(0, 0));
+            md->setCapFirstNewRecord(&txn, DiskLoc().setInvalid()); // unlooped
+            initializeV1RS(&txn, records, drecs, &em, md);
+        }
+
+        BatchDocWriter doc( 100 - Record::HeaderSize );
+        const DocWriter* docs[] = { &doc, &doc };
+        DiskLoc locs[2];
+        ASSERT_OK( rs.insertRecords( &txn, docs, 2, locs, false ) );
+        ASSERT_EQUALS( DiskLoc(0, 1000), locs[0] );
+        ASSERT_EQUALS( DiskLoc(0, 1100), locs[1] );
+        ASSERT_EQUALS( 4, md->numRecords() );
+        ASSERT_EQUALS( 3U, cb.deleted.size() );
+        ASSERT_EQUALS( md->capFirstNewRecord(), DiskLoc(0, 1000) );
+    }
+
     /**
      * Current code always tries to leave 24 bytes to create a DeletedRecord.
      */
@@ -40,6 +40,7 @@
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/operation_context.h"
+#include "mongo/db/server_parameters.h"
 #include "mongo/db/structure/record_store_v1_simple_iterator.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
@@ -50,9 +51,30 @@ namespace mongo {
 
     MONGO_LOG_DEFAULT_COMPONENT_FILE(::mongo::logger::LogComponent::kStorage);
 
+    MONGO_EXPORT_SERVER_PARAMETER(mmapv1FreeSpaceIndex, bool, true);
+
+    MONGO_EXPORT_SERVER_PARAMETER(mmapv1AdaptiveExtentSize, bool, true);
+
+    // An extent sized by growth holds about this many seconds of inserts...
+    static const int extentGrowthSecs = 60;
+
+    // ...but is never more than this many times the followupSize().
+    static const int maxExtentGrowthFactor = 16;
+
+    // A collection whose deleted lists hold more records than this walks them instead of
+    // indexing them (an entry costs about 100 bytes).
+    static const size_t maxIndexedDeletedRecords = 512 * 1024;
+
+    // ...and tries again after this many allocations.
+    static const int allocsBeforeIndexRetry = 10000;
+
     static Counter64 freelistAllocs;
     static Counter64 freelistBucketExhausted;
     static Counter64 freelistIterations;
+    static Counter64 freelistLongWalks;
+    static Counter64 freelistIndexAllocs;
+    static Counter64 freelistIndexBuilds;
+    static Counter64 freelistIndexResyncs;
 
     static ServerStatusMetricField<Counter64> dFreelist1( "storage.freelist.search.requests",
                                                           &freelistAllocs );
@@ -63,12 +85,33 @@ namespace mongo {
     static ServerStatusMetricField<Counter64> dFreelist3( "storage.freelist.search.scanned",
                                                           &freelistIterations );
 
+    // searches that gave up on a bucket after 30 links
+    static ServerStatusMetricField<Counter64> dFreelist4( "storage.freelist.search.longWalks",
+                                                          &freelistLongWalks );
+
+    static ServerStatusMetricField<Counter64> dFreelist5( "storage.freelist.index.requests",
+                                                          &freelistIndexAllocs );
+
+    static ServerStatusMetricField<Counter64> dFreelist6( "storage.freelist.index.builds",
+                                                          &freelistIndexBuilds );
+
+    static ServerStatusMetricField<Counter64> dFreelist7( "storage.freelist.index.bucketResyncs",
+                                                          &freelistIndexResyncs );
+
     SimpleRecordStoreV1::SimpleRecordStoreV1( OperationContext* txn,
                                               const StringData& ns,
                                               RecordStoreV1MetaData* details,
                                               ExtentManager* em,
                                               bool isSystemIndexes )
-        : RecordStoreV1Base( ns, details, em, isSystemIndexes ) {
+        : RecordStoreV1Base( ns, details, em, isSystemIndexes ),
+          _freeSpaceBuilt( false ),
+          _allocsBeforeRebuild( 0 ),
+          _drainingExtentLength( 0 ),
+          _extentTimerValid( false ),
+          _growthRate( 0 ),
+          _extentsAdded( 0 ),
+          _extentsSizedByGrowth( 0 ),
+          _lastExtentRequested( 0 ) {
 
         invariant( !details->isCapped() );
         _normalCollection = NamespaceString::normal( ns );
@@ -82,99 +125,220 @@ namespace mongo {
     SimpleRecordStoreV1::~SimpleRecordStoreV1() {
     }
 
-    DiskLoc SimpleRecordStoreV1::_allocFromExistingExtents( OperationContext* txn,
-                                                            int lenToAlloc ) {
-        // align size up to a multiple of 4
-        lenToAlloc = (lenToAlloc + (4-1)) & ~(4-1);
+    static void checkDeletedListLink( const StringData& ns, int b, int chain, const DiskLoc& cur ) {
+        int fileNumber = cur.a();
+        int fileOffset = cur.getOfs();
+        if (fileNumber < -1 || fileNumber >= 100000 || fileOffset < 0) {
+            StringBuilder sb;
+            sb << "Deleted record list corrupted in collection " << ns
+               << ", bucket " << b
+               << ", link number " << chain
+               << ", invalid link is " << cur.toString()
+               << ", throwing Fatal Assertion";
+            log() << sb.str() << endl;
+            fassertFailed(16469);
+        }
+    }
 
-        freelistAllocs.increment();
-        DiskLoc loc;
-        {
-            DiskLoc *prev = 0;
-            DiskLoc *bestprev = 0;
-            DiskLoc bestmatch;
-            int bestmatchlen = INT_MAX; // sentinel meaning we haven't found a record big enough
-            int b = bucket(lenToAlloc);
-            DiskLoc cur = _details->deletedListEntry(b);
-            int extra = 5; // look for a better fit, a little.
-            int chain = 0;
-            while ( 1 ) {
-                { // defensive check
-                    int fileNumber = cur.a();
-                    int fileOffset = cur.getOfs();
-                    if (fileNumber < -1 || fileNumber >= 100000 || fileOffset < 0) {
-                        StringBuilder sb;
-                        sb << "Deleted record list corrupted in collection " << _ns
-                           << ", bucket " << b
-                           << ", link number " << chain
-                           << ", invalid link is " << cur.toString()
-                           << ", throwing Fatal Assertion";
-                        log() << sb.str() << endl;
-                        fassertFailed(16469);
-                    }
-                }
-                if ( cur.isNull() ) {
-                    // move to next bucket.  if we were doing "extra", just break
-                    if ( bestmatchlen < INT_MAX )
-                        break;
+    void SimpleRecordStoreV1::_dropFreeSpaceIndex() {
+        _freeSpace.clear();
+        _freeSpaceBuilt = false;
+    }
 
-                    if ( chain > 0 ) {
-                        // if we looked at things in the right bucket, but they were not suitable
-                        freelistBucketExhausted.increment();
-                    }
+    void SimpleRecordStoreV1::_resyncFreeSpaceBucket( int b ) {
+        const int minLen = b == 0 ? 0 : bucketSizes[b - 1];
+        const int maxLen = b == MaxBucket ? INT_MAX : bucketSizes[b] - 1;
+        _freeSpace.removeLengths( minLen, maxLen );
+
+        DiskLoc prev;
+        int chain = 0;
+        for ( DiskLoc cur = _details->deletedListEntry(b); !cur.isNull(); ) {
+            checkDeletedListLink( _ns, b, chain, cur );
+            DeletedRecord* r = drec(cur);
+            _freeSpace.add( cur, r->lengthWithHeaders(), prev );
+            prev = cur;
+            cur = r->nextDeleted();
+            chain++;
+        }
+        freelistIterations.increment( chain );
+    }
 
-                    b++;
-                    if ( b > MaxBucket ) {
-                        // out of space. alloc a new extent.
-                        freelistIterations.increment( 1 + chain );
-                        return DiskLoc();
-                    }
-                    cur = _details->deletedListEntry(b);
-                    prev = 0;
-                    continue;
-                }
-                DeletedRecord *r = drec(cur);
-                if ( r->lengthWithHeaders() >= lenToAlloc &&
-                     r->lengthWithHeaders() < bestmatchlen ) {
-                    bestmatchlen = r->lengthWithHeaders();
-                    bestmatch = cur;
-                    bestprev = prev;
-                    if (r->lengthWithHeaders() == lenToAlloc)
-                        // exact match, stop searching
-                        break;
-                }
-                if ( bestmatchlen < INT_MAX && --extra <= 0 )
+    bool SimpleRecordStoreV1::_buildFreeSpaceIndex() {
+        freelistIndexBuilds.increment();
+        _freeSpace.clear();
+        for ( int b = 0; b <= MaxBucket; b++ ) {
+            _resyncFreeSpaceBucket( b );
+            if ( _freeSpace.size() > maxIndexedDeletedRecords ) {
+                LOG(1) << _ns << ": too many deleted records to index, walking the deleted lists";
+                _dropFreeSpaceIndex();
+                _allocsBeforeRebuild = allocsBeforeIndexRetry;
+                return false;
+            }
+        }
+        _freeSpaceBuilt = true;
+        return true;
+    }
+
+    bool SimpleRecordStoreV1::_unlinkFromFreeSpaceIndex( OperationContext* txn,
+                                                         int lenToAlloc,
+                                                         DiskLoc* out ) {
+        if ( !mmapv1FreeSpaceIndex ) {
+            // don't leave a stale index behind in case it is turned back on
+            _dropFreeSpaceIndex();
+            return false;
+        }
+
+        if ( !_drainingExtent.isNull() ) {
+            // its free space is on the lists but mustn't be handed out, which the index can't
+            // tell; the lists are walked until the extent is freed or compaction stops
+            _dropFreeSpaceIndex();
+            return false;
+        }
+
+        if ( !_freeSpaceBuilt ) {
+            if ( _allocsBeforeRebuild > 0 ) {
+                _allocsBeforeRebuild--;
+                return false;
+            }
+            if ( !_buildFreeSpaceIndex() )
+                return false;
+        }
+
+        freelistIndexAllocs.increment();
+
+        // each bucket is re-read at most once, after which its entries match the list
+        for ( int attempt = 0; attempt <= Buckets; attempt++ ) {
+            DiskLoc loc;
+            DiskLoc prev;
+            int len;
+            if ( !_freeSpace.findBestFit( lenToAlloc, &loc, &len, &prev ) ) {
+                // out of space. alloc a new extent.
+                *out = DiskLoc();
+                return true;
+            }
+
+            const int b = bucket(len);
+            DeletedRecord* r = drec(loc);
+            const bool linked =
+                r->lengthWithHeaders() == len &&
+                r->extentOfs() < loc.getOfs() &&
+                ( prev.isNull() ?
+                  _details->deletedListEntry(b) == loc :
+                  drec(prev)->nextDeleted() == loc );
+            if ( !linked ) {
+                freelistIndexResyncs.increment();
+                _resyncFreeSpaceBucket( b );
+                continue;
+            }
+
+            // unlink ourself from the deleted list
+            const DiskLoc next = r->nextDeleted();
+            if ( prev.isNull() ) {
+                _details->setDeletedListEntry(txn, b, next);
+            }
+            else {
+                *txn->recoveryUnit()->writing(&drec(prev)->nextDeleted()) = next;
+            }
+            *txn->recoveryUnit()->writing(&r->nextDeleted()) = DiskLoc().setInvalid(); // defensive.
+            _freeSpace.remove( loc, len, prev, next );
+
+            freelistIterations.increment();
+            *out = loc;
+            return true;
+        }
+
+        // shouldn't get here; start over with the lists
+        warning() << _ns << ": deleted record index out of sync, rebuilding";
+        _dropFreeSpaceIndex();
+        return false;
+    }
+
+    DiskLoc SimpleRecordStoreV1::_unlinkFromDeletedLists( OperationContext* txn,
+                                                          int lenToAlloc ) {
+        DiskLoc *prev = 0;
+        DiskLoc *bestprev = 0;
+        DiskLoc bestmatch;
+        int bestmatchlen = INT_MAX; // sentinel meaning we haven't found a record big enough
+        int b = bucket(lenToAlloc);
+        DiskLoc cur = _details->deletedListEntry(b);
+        int extra = 5; // look for a better fit, a little.
+        int chain = 0;
+        while ( 1 ) {
+            checkDeletedListLink( _ns, b, chain, cur ); // defensive check
+            if ( cur.isNull() ) {
+                // move to next bucket.  if we were doing "extra", just break
+                if ( bestmatchlen < INT_MAX )
                     break;
-                if ( ++chain > 30 && b <= MaxBucket ) {
-                    // too slow, force move to next bucket to grab a big chunk
-                    //b++;
-                    freelistIterations.increment( chain );
-                    chain = 0;
-                    cur.Null();
+
+                if ( chain > 0 ) {
+                    // if we looked at things in the right bucket, but they were not suitable
+                    freelistBucketExhausted.increment();
                 }
-                else {
-                    cur = r->nextDeleted();
-                    prev = &r->nextDeleted();
+
+                b++;
+                if ( b > MaxBucket ) {
+                    // out of space. alloc a new extent.
+                    freelistIterations.increment( 1 + chain );
+                    return DiskLoc();
                 }
+                cur = _details->deletedListEntry(b);
+                prev = 0;
+                continue;
             }
-
-            // unlink ourself from the deleted list
-            DeletedRecord *bmr = drec(bestmatch);
-            if ( bestprev ) {
-                *txn->recoveryUnit()->writing(bestprev) = bmr->nextDeleted();
+            DeletedRecord *r = drec(cur);
+            if ( r->lengthWithHeaders() >= lenToAlloc &&
+                 r->lengthWithHeaders() < bestmatchlen &&
+                 !_inDrainingExtent( cur ) ) {
+                bestmatchlen = r->lengthWithHeaders();
+                bestmatch = cur;
+                bestprev = prev;
+                if (r->lengthWithHeaders() == lenToAlloc)
+                    // exact match, stop searching
+                    break;
+            }
+            if ( bestmatchlen < INT_MAX && --extra <= 0 )
+                break;
+            if ( ++chain > 30 && b <= MaxBucket ) {
+                // too slow, force move to next bucket to grab a big chunk
+                //b++;
+                freelistLongWalks.increment();
+                freelistIterations.increment( chain );
+                chain = 0;
+                cur.Null();
             }
             else {
-                // should be the front of a free-list
-                int myBucket = bucket(bmr->lengthWithHeaders());
-                invariant( _details->deletedListEntry(myBucket) == bestmatch );
-                _details->setDeletedListEntry(txn, myBucket, bmr->nextDeleted());
+                cur = r->nextDeleted();
+                prev = &r->nextDeleted();
             }
-            *txn->recoveryUnit()->writing(&bmr->nextDeleted()) = DiskLoc().setInvalid(); // defensive.
-            invariant(bmr->extentOfs() < bestmatch.getOfs());
+        }
 
-            freelistIterations.increment( 1 + chain );
-            loc = bestmatch;
+        // unlink ourself from the deleted list
+        DeletedRecord *bmr = drec(bestmatch);
+        if ( bestprev ) {
+            *txn->recoveryUnit()->writing(bestprev) = bmr->nextDeleted();
+        }
+        else {
+            // should be the front of a free-list
+            int myBucket = bucket(bmr->lengthWithHeaders());
+            invariant( _details->deletedListEntry(myBucket) == bestmatch );
+            _details->setDeletedListEntry(txn, myBucket, bmr->nextDeleted());
         }
+        *txn->recoveryUnit()->writing(&bmr->nextDeleted()) = DiskLoc().setInvalid(); // defensive.
+        invariant(bmr->extentOfs() < bestmatch.getOfs());
+
+        freelistIterations.increment( 1 + chain );
+        return bestmatch;
+    }
+
+    DiskLoc SimpleRecordStoreV1::_allocFromExistingExtents( OperationContext* txn,
+                                                            int lenToAlloc ) {
+        // align size up to a multiple of 4
+        lenToAlloc = (lenToAlloc + (4-1)) & ~(4-1);
+
+        freelistAllocs.increment();
+        DiskLoc loc;
+        if ( !_unlinkFromFreeSpaceIndex( txn, lenToAlloc, &loc ) )
+            loc = _unlinkFromDeletedLists( txn, lenToAlloc );
 
         if ( loc.isNull() )
             return loc;
@@ -225,6 +389,36 @@ namespace mongo {
 
     }
 
+    int SimpleRecordStoreV1::_nextExtentSize( int lengthWithHeaders, int* smallestUseful ) {
+        int size = _extentManager->followupSize( lengthWithHeaders, _details->lastExtentSize() );
+        *smallestUseful = 0;
+
+        if ( _extentTimerValid ) {
+            // the last extent is full, this is how fast it filled up
+            double secs = std::max( _extentTimer.micros() / 1000000.0, 0.001 );
+            double rate = _details->lastExtentSize() / secs;
+            _growthRate = _growthRate > 0 ? ( _growthRate + rate ) / 2 : rate;
+        }
+        _extentTimer.reset();
+        _extentTimerValid = true;
+        _extentsAdded++;
+
+        if ( mmapv1AdaptiveExtentSize && _growthRate > 0 ) {
+            long long wanted = static_cast<long long>( _growthRate * extentGrowthSecs );
+            wanted = std::min( wanted, static_cast<long long>( size ) * maxExtentGrowthFactor );
+            wanted = std::min( wanted, static_cast<long long>( _extentManager->maxSize() ) );
+            if ( wanted > size ) {
+                // anything free that the fixed formula would have asked for will do as well
+                *smallestUseful = size;
+                size = _extentManager->quantizeExtentSize( static_cast<int>( wanted ) );
+                _extentsSizedByGrowth++;
+            }
+        }
+
+        _lastExtentRequested = size;
+        return size;
+    }
+
     StatusWith<DiskLoc> SimpleRecordStoreV1::allocRecord( OperationContext* txn,
                                                           int lengthWithHeaders,
                                                           bool enforceQuota ) {
@@ -234,10 +428,9 @@ namespace mongo {
 
         LOG(1) << "allocating new extent";
 
-        increaseStorageSize( txn,
-                             _extentManager->followupSize( lengthWithHeaders,
-                                                           _details->lastExtentSize()),
-                             enforceQuota );
+        int smallestUseful;
+        int extentSize = _nextExtentSize( lengthWithHeaders, &smallestUseful );
+        increaseStorageSize( txn, extentSize, enforceQuota, smallestUseful );
 
         loc = _allocFromExistingExtents( txn, lengthWithHeaders );
         if ( !loc.isNull() ) {
@@ -276,8 +469,17 @@ namespace mongo {
         DEBUGGING log() << "TEMP: add deleted rec " << dloc.toString() << ' ' << hex << d->extentOfs() << endl;
 
         int b = bucket(d->lengthWithHeaders());
-        *txn->recoveryUnit()->writing(&d->nextDeleted()) = _details->deletedListEntry(b);
+        const DiskLoc oldHead = _details->deletedListEntry(b);
+        *txn->recoveryUnit()->writing(&d->nextDeleted()) = oldHead;
         _details->setDeletedListEntry(txn, b, dloc);
+
+        if ( _freeSpaceBuilt ) {
+            _freeSpace.addHead( dloc, d->lengthWithHeaders(), oldHead );
+            if ( _freeSpace.size() > maxIndexedDeletedRecords ) {
+                _dropFreeSpaceIndex();
+                _allocsBeforeRebuild = allocsBeforeIndexRetry;
+            }
+        }
     }
 
     RecordIterator* SimpleRecordStoreV1::getIterator( const DiskLoc& start, bool tailable,
@@ -304,8 +506,8 @@ namespace mongo {
         /**
          * param allocationSize - allocation size WITH header
          */
-        CompactDocWriter( const Record* rec, unsigned dataSize, size_t allocationSize )
-            : _rec( rec ),
+        CompactDocWriter( const char* data, unsigned dataSize, size_t allocationSize )
+            : _data( data ),
               _dataSize( dataSize ),
               _allocationSize( allocationSize ) {
         }
@@ -313,7 +515,7 @@ namespace mongo {
         virtual ~CompactDocWriter() {}
 
         virtual void writeDocument( char* buf ) const {
-            memcpy( buf, _rec->data(), _dataSize );
+            memcpy( buf, _data, _dataSize );
         }
 
         virtual size_t documentSize() const {
@@ -325,11 +527,38 @@ namespace mongo {
         }
 
     private:
-        const Record* _rec;
+        const char* _data;
         size_t _dataSize;
         size_t _allocationSize;
     };
 
+    unsigned SimpleRecordStoreV1::_compactedRecordSize( const CompactOptions* compactOptions,
+                                                        const Record* recOld,
+                                                        unsigned docSize ) const {
+        unsigned lenWHdr = docSize + Record::HeaderSize + _checksumSpace();
+        unsigned lenWPadding = lenWHdr;
+
+        switch( compactOptions->paddingMode ) {
+        case CompactOptions::NONE:
+            if ( _details->isUserFlagSet(Flag_UsePowerOf2Sizes) )
+                lenWPadding = quantizePowerOf2AllocationSpace(lenWPadding);
+            break;
+        case CompactOptions::PRESERVE:
+            // if we are preserving the padding, the record should not change size
+            // unless it was compressed into less space than the document needs
+            lenWPadding = std::max( static_cast<unsigned>( recOld->lengthWithHeaders() ),
+                                    lenWHdr );
+            break;
+        case CompactOptions::MANUAL:
+            lenWPadding = compactOptions->computeRecordSize(lenWPadding);
+            if (lenWPadding < lenWHdr || lenWPadding > BSONObjMaxUserSize / 2 ) {
+                lenWPadding = lenWHdr;
+            }
+            break;
+        }
+        return lenWPadding - _checksumSpace();
+    }
+
     void SimpleRecordStoreV1::_compactExtent(OperationContext* txn,
                                              const DiskLoc diskloc,
                                              int extentNumber,
@@ -369,7 +598,7 @@ namespace mongo {
             if( !L.isNull() ) {
                 while( 1 ) {
                     Record *recOld = recordFor(L);
-                    RecordData oldData = recOld->toRecordData();
+                    RecordData oldData = _recordData( recOld );
                     L = getNextRecordInExtent(L);
 
                     if ( compactOptions->validateDocuments && !adaptor->isDataValid( oldData ) ) {
@@ -385,27 +614,11 @@ namespace mongo {
                         oldObjSize += docSize;
                         oldObjSizeWithPadding += recOld->netLength();
 
-                        unsigned lenWHdr = docSize + Record::HeaderSize;
-                        unsigned lenWPadding = lenWHdr;
-
-                        switch( compactOptions->paddingMode ) {
-                        case CompactOptions::NONE:
-                            if ( _details->isUserFlagSet(Flag_UsePowerOf2Sizes) )
-                                lenWPadding = quantizePowerOf2AllocationSpace(lenWPadding);
-                            break;
-                        case CompactOptions::PRESERVE:
-                            // if we are preserving the padding, the record should not change size
-                            lenWPadding = recOld->lengthWithHeaders();
-                            break;
-                        case CompactOptions::MANUAL:
-                            lenWPadding = compactOptions->computeRecordSize(lenWPadding);
-                            if (lenWPadding < lenWHdr || lenWPadding > BSONObjMaxUserSize / 2 ) {
-                                lenWPadding = lenWHdr;
-                            }
-                            break;
-                        }
-
-                        CompactDocWriter writer( recOld, dataSize, lenWPadding );
+                        unsigned lenWPadding = _compactedRecordSize( compactOptions,
+                                                                     recOld,
+                                                                     docSize );
+
+                        CompactDocWriter writer( oldData.data(), dataSize, lenWPadding );
                         StatusWith<DiskLoc> status = insertRecord( txn, &writer, false );
                         uassertStatusOK( status.getStatus() );
                         datasize += recordFor( status.getValue() )->netLength();
@@ -471,6 +684,8 @@ namespace mongo {
 
         log() << "compact orphan deleted lists" << endl;
         _details->orphanDeletedList(txn);
+        _dropFreeSpaceIndex();
+        _drainingExtent.Null(); // compacted with the rest
 
         // Start over from scratch with our extent sizing and growth
         _details->setLastExtentSize( txn, 0 );
@@ -501,4 +716,198 @@ namespace mongo {
         return Status::OK();
     }
 
+    bool SimpleRecordStoreV1::_inDrainingExtent( const DiskLoc& loc ) const {
+        return !_drainingExtent.isNull() &&
+            loc.a() == _drainingExtent.a() &&
+            loc.getOfs() > _drainingExtent.getOfs() &&
+            loc.getOfs() < _drainingExtent.getOfs() + _drainingExtentLength;
+    }
+
+    bool SimpleRecordStoreV1::_startDrainingExtent( OperationContext* txn ) {
+        const DiskLoc extLoc = _details->lastExtent();
+        if ( extLoc.isNull() || extLoc == _details->firstExtent() )
+            return false;
+
+        Extent* e = _getExtent( extLoc );
+        e->assertOk();
+
+        long long liveBytes = 0;
+        for ( DiskLoc L = e->firstRecord; !L.isNull(); L = getNextRecordInExtent( L ) )
+            liveBytes += recordFor( L )->lengthWithHeaders();
+
+        _drainingExtent = extLoc;
+        _drainingExtentLength = e->length;
+
+        long long freeBytes = 0; // outside the extent
+        for ( int b = 0; b <= MaxBucket; b++ ) {
+            int chain = 0;
+            for ( DiskLoc cur = _details->deletedListEntry(b); !cur.isNull(); ) {
+                checkDeletedListLink( _ns, b, chain++, cur );
+                const DeletedRecord* d = drec(cur);
+                if ( !_inDrainingExtent( cur ) )
+                    freeBytes += d->lengthWithHeaders();
+                cur = d->nextDeleted();
+            }
+        }
+
+        // leave some room for records that won't fit the holes exactly
+        if ( freeBytes < liveBytes + liveBytes / 8 ) {
+            LOG(1) << "compact " << _ns << ": " << freeBytes << " bytes free outside extent "
+                   << extLoc << " holding " << liveBytes << " bytes, not emptying it";
+            _drainingExtent.Null();
+            return false;
+        }
+
+        _dropFreeSpaceIndex();
+
+        log() << "compact " << _ns << ": emptying extent " << extLoc << " holding "
+              << liveBytes << " bytes";
+        return true;
+    }
+
+    void SimpleRecordStoreV1::_freeDrainedExtent( OperationContext* txn ) {
+        Extent* e = _getExtent( _drainingExtent );
+        invariant( e->firstRecord.isNull() );
+
+        // its free space comes off the lists in the same unit of work as the extent goes away
+        for ( int b = 0; b <= MaxBucket; b++ ) {
+            DiskLoc prev;
+            for ( DiskLoc cur = _details->deletedListEntry(b); !cur.isNull(); ) {
+                DeletedRecord* d = drec(cur);
+                const DiskLoc next = d->nextDeleted();
+                if ( !_inDrainingExtent( cur ) )
+                    prev = cur;
+                else if ( prev.isNull() )
+                    _details->setDeletedListEntry( txn, b, next );
+                else
+                    *txn->recoveryUnit()->writing(&drec(prev)->nextDeleted()) = next;
+                cur = next;
+            }
+        }
+
+        const DiskLoc prev = e->xprev;
+        const DiskLoc next = e->xnext;
+        if ( prev.isNull() )
+            _details->setFirstExtent( txn, next );
+        else
+            *txn->recoveryUnit()->writing(&_getExtent( prev )->xnext) = next;
+        if ( next.isNull() )
+            _details->setLastExtent( txn, prev );
+        else
+            *txn->recoveryUnit()->writing(&_getExtent( next )->xprev) = prev;
+
+        log() << "compact " << _ns << ": freeing extent " << _drainingExtent;
+        _extentManager->freeExtent( txn, _drainingExtent );
+        _drainingExtent.Null();
+    }
+
+    StatusWith<bool> SimpleRecordStoreV1::compactIncremental( OperationContext* txn,
+                                                              RecordStoreCompactAdaptor* adaptor,
+                                                              UpdateMoveNotifier* notifier,
+                                                              const CompactOptions* options,
+                                                              int maxRecords,
+                                                              CompactStats* stats ) {
+        if ( _drainingExtent.isNull() && !_startDrainingExtent( txn ) )
+            return StatusWith<bool>( true );
+
+        Extent* e = _getExtent( _drainingExtent );
+        DiskLoc L = e->firstRecord;
+        for ( int n = 0; n < maxRecords && !L.isNull(); n++ ) {
+            const DiskLoc oldLoc = L;
+            Record* recOld = recordFor( oldLoc );
+            const RecordData oldData = _recordData( recOld );
+            L = getNextRecordInExtent( oldLoc );
+
+            if ( options->validateDocuments && !adaptor->isDataValid( oldData ) ) {
+                // unlike compact(), don't drop it: the collection stays in use
+                stats->corruptDocuments++;
+                return StatusWith<bool>( ErrorCodes::InternalError,
+                                         str::stream() << "compact: invalid document at "
+                                                       << oldLoc.toString() << " in " << _ns
+                                                       << ", run validate" );
+            }
+
+            // same order as an update that moves: new copy, notify, index it, delete the old
+            const unsigned dataSize = adaptor->dataSize( oldData );
+            CompactDocWriter writer( oldData.data(),
+                                     dataSize,
+                                     _compactedRecordSize( options, recOld, dataSize ) );
+            StatusWith<DiskLoc> newLoc = insertRecord( txn, &writer, false );
+            if ( !newLoc.isOK() )
+                return StatusWith<bool>( newLoc.getStatus() );
+            invariant( !_inDrainingExtent( newLoc.getValue() ) );
+
+            Status moveStatus = notifier->recordStoreGoingToMove( txn,
+                                                                  oldLoc,
+                                                                  oldData.data(),
+                                                                  oldData.size() );
+            if ( !moveStatus.isOK() )
+                return StatusWith<bool>( moveStatus );
+
+            adaptor->inserted( dataFor( newLoc.getValue() ), newLoc.getValue() );
+            deleteRecord( txn, oldLoc );
+            stats->recordsMoved++;
+        }
+
+        if ( e->firstRecord.isNull() ) {
+            _freeDrainedExtent( txn );
+            stats->extentsFreed++;
+        }
+
+        return StatusWith<bool>( false );
+    }
+
+    void SimpleRecordStoreV1::abortCompactIncremental( OperationContext* txn ) {
+        if ( _drainingExtent.isNull() )
+            return;
+
+        log() << "compact " << _ns << ": stopped emptying extent " << _drainingExtent;
+
+        // its free space never left the deleted lists
+        _drainingExtent.Null();
+    }
+
+    void SimpleRecordStoreV1::appendCustomStats( BSONObjBuilder* result, double scale ) const {
+        RecordStoreV1Base::appendCustomStats( result, scale );
+
+        BSONObjBuilder b( result->subobjStart( "extentSizing" ) );
+        b.appendBool( "adaptive", mmapv1AdaptiveExtentSize );
+        b.append( "growthRate", _growthRate / scale ); // per second
+        b.appendNumber( "extentsAdded", _extentsAdded );
+        b.appendNumber( "extentsSizedByGrowth", _extentsSizedByGrowth );
+        b.append( "lastExtentRequested", _lastExtentRequested / scale );
+        b.done();
+    }
+
+    Status SimpleRecordStoreV1::setCustomOption( OperationContext* txn,
+                                                 const BSONElement& option,
+                                                 BSONObjBuilder* info ) {
+        if ( str::equals( "compressRecords", option.fieldName() ) ) {
+            if ( !_normalCollection )
+                return Status( ErrorCodes::BadValue,
+                               str::stream() << "compressRecords not supported on " << _ns );
+
+            bool oldCompress = _details->isUserFlagSet( Flag_CompressRecords );
+            bool newCompress = option.trueValue();
+
+            if ( oldCompress != newCompress ) {
+                info->appendBool( "compressRecords_old", oldCompress );
+
+                if ( newCompress ) {
+                    _details->setUserFlag( txn, Flag_MayHaveCompressedRecords );
+                    _details->setUserFlag( txn, Flag_CompressRecords );
+                }
+                else {
+                    _details->clearUserFlag( txn, Flag_CompressRecords );
+                }
+
+                info->appendBool( "compressRecords_new", newCompress );
+            }
+
+            return Status::OK();
+        }
+
+        return RecordStoreV1Base::setCustomOption( txn, option, info );
+    }
+
 }
@@ -30,13 +30,23 @@
 
 #pragma once
 
+#include <vector>
+
 #include "mongo/db/diskloc.h"
+#include "mongo/db/structure/deleted_record_index.h"
 #include "mongo/db/structure/record_store_v1_base.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
     class SimpleRecordStoreV1Iterator;
 
+    // server parameter: allocate through an in-memory index of the deleted lists
+    extern bool mmapv1FreeSpaceIndex;
+
+    // server parameter: size new extents by how fast the collection grows
+    extern bool mmapv1AdaptiveExtentSize;
+
     // used by index and original collections
     class SimpleRecordStoreV1 : public RecordStoreV1Base {
     public:
@@ -67,6 +77,35 @@ namespace mongo {
                                 const CompactOptions* options,
                                 CompactStats* stats );
 
+        /**
+         * Empties the last extent into free space in the others, one batch of records at a
+         * time, then frees it.  Starts on an extent only if the others have room for its
+         * records.
+         */
+        virtual StatusWith<bool> compactIncremental( OperationContext* txn,
+                                                     RecordStoreCompactAdaptor* adaptor,
+                                                     UpdateMoveNotifier* notifier,
+                                                     const CompactOptions* options,
+                                                     int maxRecords,
+                                                     CompactStats* stats );
+
+        /**
+         * Puts the free space of the extent being emptied back on the deleted lists and stops
+         * emptying it.
+         */
+        virtual void abortCompactIncremental( OperationContext* txn );
+
+        /**
+         * Handles compressRecords in addition to the RecordStoreV1Base options.  Turning it
+         * off only affects records written afterwards.
+         */
+        virtual Status setCustomOption( OperationContext* txn,
+                                        const BSONElement& option,
+                                        BSONObjBuilder* info = NULL );
+
+        /** adds how the last extents were sized */
+        virtual void appendCustomStats( BSONObjBuilder* result, double scale ) const;
+
     protected:
         virtual bool isCapped() const { return false; }
 
@@ -80,6 +119,31 @@ namespace mongo {
         DiskLoc _allocFromExistingExtents( OperationContext* txn,
                                            int lengthWithHeaders );
 
+        /**
+         * The size of the next extent: the usual followupSize(), or more if the last extent
+         * filled up fast enough that the collection will soon need that much anyway.
+         * @param smallestUseful - set to the smallest free extent worth taking instead
+         */
+        int _nextExtentSize( int lengthWithHeaders, int* smallestUseful );
+
+        /**
+         * Unlinks the best fitting deleted record for 'lenToAlloc' using _freeSpace, building
+         * it first if needed.
+         * @return false if the index can't be used and the lists have to be walked instead
+         */
+        bool _unlinkFromFreeSpaceIndex( OperationContext* txn, int lenToAlloc, DiskLoc* out );
+
+        /** unlinks a deleted record for 'lenToAlloc' found by walking the deleted lists */
+        DiskLoc _unlinkFromDeletedLists( OperationContext* txn, int lenToAlloc );
+
+        /** @return false if the index got too big and was dropped */
+        bool _buildFreeSpaceIndex();
+
+        /** re-reads the deleted list of bucket 'b' into _freeSpace */
+        void _resyncFreeSpaceBucket( int b );
+
+        void _dropFreeSpaceIndex();
+
         void _compactExtent(OperationContext* txn,
                             const DiskLoc diskloc,
                             int extentNumber,
@@ -87,8 +151,52 @@ namespace mongo {
                             const CompactOptions* compactOptions,
                             CompactStats* stats );
 
+        /**
+         * the allocation size compaction gives 'docSize' bytes of data now in 'recOld', less
+         * the checksum space that insertRecord() adds back
+         */
+        unsigned _compactedRecordSize( const CompactOptions* compactOptions,
+                                       const Record* recOld,
+                                       unsigned docSize ) const;
+
+        /**
+         * Picks the extent for compactIncremental() to empty.  Its free space stays on the
+         * deleted lists, but allocation passes it over from then on.
+         * @return false if no extent is worth emptying
+         */
+        bool _startDrainingExtent( OperationContext* txn );
+
+        /**
+         * unlinks the emptied _drainingExtent's free space from the deleted lists and the
+         * extent from the extent list, and frees it
+         */
+        void _freeDrainedExtent( OperationContext* txn );
+
+        bool _inDrainingExtent( const DiskLoc& loc ) const;
+
         bool _normalCollection;
 
+        // Mirror of the deleted lists, built at the first allocation.  Write units of work that
+        // roll back can change the lists behind its back, so entries are checked against the
+        // lists before use, and a bucket whose entries don't match is read again.
+        DeletedRecordIndex _freeSpace;
+        bool _freeSpaceBuilt;
+        int _allocsBeforeRebuild; // walk the lists this many times after the index got too big
+
+        // The extent compactIncremental() is emptying, if any.  Nothing on disk says so: its
+        // deleted records stay on the lists and allocation skips them, so if the store is
+        // closed or the server goes down part way, the extent is just in use again.
+        DiskLoc _drainingExtent;
+        int _drainingExtentLength;
+
+        // Growth history for _nextExtentSize(), only since the store was opened.
+        Timer _extentTimer; // since the last extent was added
+        bool _extentTimerValid;
+        double _growthRate; // bytes per second filling new extents, decayed
+        long long _extentsAdded;
+        long long _extentsSizedByGrowth;
+        int _lastExtentRequested;
+
         friend class SimpleRecordStoreV1Iterator;
     };
 
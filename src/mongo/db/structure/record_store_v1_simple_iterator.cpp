@@ -31,6 +31,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/storage/mmap_v1/extent.h"
 #include "mongo/db/storage/mmap_v1/extent_manager.h"
+#include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/structure/record_store_v1_simple.h"
 
 namespace mongo {
@@ -42,7 +43,10 @@ namespace mongo {
     SimpleRecordStoreV1Iterator::SimpleRecordStoreV1Iterator(const SimpleRecordStoreV1* collection,
                                                              const DiskLoc& start,
                                                              const CollectionScanParams::Direction& dir)
-        : _curr(start), _recordStore(collection), _direction(dir) {
+        : _curr(start),
+          _recordStore(collection),
+          _direction(dir),
+          _readahead(collection->_extentManager) {
 
         if (_curr.isNull()) {
 
@@ -81,6 +85,10 @@ namespace mongo {
                 _curr = e->lastRecord;
             }
         }
+
+        if (CollectionScanParams::FORWARD == _direction && !_curr.isNull()) {
+            _readahead.enteringExtent( _recordStore->_getExtentLocForRecord( _curr ) );
+        }
     }
 
     bool SimpleRecordStoreV1Iterator::isEOF() {
@@ -94,15 +102,46 @@ namespace mongo {
 
         // Move to the next thing.
         if (!isEOF()) {
-            if (CollectionScanParams::FORWARD == _direction) {
+            _advance( _recordStore->recordFor( _curr ) );
+        }
+
+        return ret;
+    }
+
+    void SimpleRecordStoreV1Iterator::_advance( const Record* rec ) {
+        // Stay within the extent using the header we already have in hand, and only go through
+        // the record store to cross into the next extent.
+        if (CollectionScanParams::FORWARD == _direction) {
+            if (rec->nextOfs() != DiskLoc::NullOfs) {
+                _curr = DiskLoc( _curr.a(), rec->nextOfs() );
+            }
+            else {
                 _curr = _recordStore->getNextRecord( _curr );
+                if (!_curr.isNull()) {
+                    _readahead.enteringExtent( _recordStore->_getExtentLocForRecord( _curr ) );
+                }
+            }
+        }
+        else {
+            if (rec->prevOfs() != DiskLoc::NullOfs) {
+                _curr = DiskLoc( _curr.a(), rec->prevOfs() );
             }
             else {
                 _curr = _recordStore->getPrevRecord( _curr );
             }
         }
+    }
 
-        return ret;
+    size_t SimpleRecordStoreV1Iterator::getNextBatch( RecordLocAndData* out, size_t maxRecords ) {
+        size_t n = 0;
+        while ( n < maxRecords && !_curr.isNull() ) {
+            const Record* rec = _recordStore->recordFor( _curr );
+            out[n].loc = _curr;
+            out[n].data = _recordStore->_recordData( rec );
+            n++;
+            _advance( rec );
+        }
+        return n;
     }
 
     void SimpleRecordStoreV1Iterator::invalidate(const DiskLoc& dl) {
@@ -28,10 +28,12 @@
 
 #pragma once
 
+#include "mongo/db/storage/mmap_v1/extent_readahead.h"
 #include "mongo/db/structure/record_store.h"
 
 namespace mongo {
 
+    class Record;
     class SimpleRecordStoreV1;
 
     /**
@@ -39,6 +41,8 @@ namespace mongo {
      * The collection must exist when the constructor is called.
      *
      * If start is not DiskLoc(), the iteration begins at that DiskLoc.
+     *
+     * Forward iteration reads ahead of itself, see ExtentReadahead.
      */
     class SimpleRecordStoreV1Iterator : public RecordIterator {
     public:
@@ -50,6 +54,7 @@ namespace mongo {
         virtual bool isEOF();
         virtual DiskLoc getNext();
         virtual DiskLoc curr();
+        virtual size_t getNextBatch( RecordLocAndData* out, size_t maxRecords );
 
         virtual void invalidate(const DiskLoc& dl);
         virtual void prepareToYield();
@@ -58,12 +63,19 @@ namespace mongo {
         virtual RecordData dataFor( const DiskLoc& loc ) const;
 
     private:
+        /**
+         * Moves _curr past 'rec', which must be the record at _curr.
+         */
+        void _advance( const Record* rec );
+
         // The result returned on the next call to getNext().
         DiskLoc _curr;
 
         const SimpleRecordStoreV1* _recordStore;
 
         CollectionScanParams::Direction _direction;
+
+        ExtentReadahead _readahead;
     };
 
 }  // namespace mongo
@@ -30,6 +30,8 @@
 
 #include "mongo/db/structure/record_store_v1_simple.h"
 
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/jsobj.h"
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/storage/mmap_v1/record.h"
 #include "mongo/db/structure/record_store_v1_test_help.h"
@@ -43,6 +45,17 @@ namespace {
     // Should be in BSS so unused portions should be free.
     char zeros[20*1024*1024] = {};
 
+    /**
+     * Turns off the deleted record index, for tests of how the deleted lists are walked.
+     */
+    class WalkDeletedLists {
+    public:
+        WalkDeletedLists() : _old( mmapv1FreeSpaceIndex ) { mmapv1FreeSpaceIndex = false; }
+        ~WalkDeletedLists() { mmapv1FreeSpaceIndex = _old; }
+    private:
+        bool _old;
+    };
+
     TEST( SimpleRecordStoreV1, quantizeAllocationSpaceSimple ) {
         ASSERT_EQUALS(RecordStoreV1Base::quantizeAllocationSpace(33),       36);
         ASSERT_EQUALS(RecordStoreV1Base::quantizeAllocationSpace(1000),     1024);
@@ -452,6 +465,212 @@ namespace {
         ASSERT_EQUALS( string("abc"), string(recordData.data()) );
     }
 
+    /**
+     * Compressible records are stored compressed and read back decompressed.
+     */
+    TEST( SimpleRecordStoreV1, CompressedRecords ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md =
+            new DummyRecordStoreV1MetaData( false, RecordStoreV1Base::Flag_CompressRecords );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        const BSONObj doc = BSON( "n" << 1 << "s" << string( 2000, 'a' ) );
+        StatusWith<DiskLoc> result = rs.insertRecord( &txn, doc.objdata(), doc.objsize(), false );
+        ASSERT_OK( result.getStatus() );
+        const DiskLoc loc = result.getValue();
+        ASSERT_LESS_THAN( md->dataSize(), doc.objsize() / 2 );
+        ASSERT( rs.dataFor( loc ).isOwned() );
+        ASSERT_EQUALS( doc, rs.dataFor( loc ).toBson() );
+
+        // damages apply to the decompressed document
+        const BSONObj two = BSON( "" << 2 );
+        mutablebson::DamageVector damages;
+        mutablebson::DamageEvent damage;
+        damage.sourceOffset = two.firstElement().value() - two.objdata();
+        damage.targetOffset = doc["n"].value() - doc.objdata();
+        damage.size = 4;
+        damages.push_back( damage );
+        ASSERT_OK( rs.updateWithDamages( &txn, loc, two.objdata(), damages ) );
+        ASSERT_EQUALS( BSON( "n" << 2 << "s" << string( 2000, 'a' ) ),
+                       rs.dataFor( loc ).toBson() );
+
+        // damages that make the record incompressible can't be applied where it is
+        string noise;
+        unsigned seed = 1;
+        for ( int i = 0; i < 1000; i++ ) {
+            seed = seed * 1103515245 + 12345;
+            noise.push_back( static_cast<char>( 'a' + ( seed >> 16 ) % 26 ) );
+        }
+        damage.sourceOffset = 0;
+        damage.targetOffset = doc["s"].valuestr() - doc.objdata();
+        damage.size = noise.size();
+        damages.clear();
+        damages.push_back( damage );
+        ASSERT_EQUALS( ErrorCodes::CannotUpdateInPlace,
+                       rs.updateWithDamages( &txn, loc, noise.data(), damages ).code() );
+        ASSERT_EQUALS( BSON( "n" << 2 << "s" << string( 2000, 'a' ) ),
+                       rs.dataFor( loc ).toBson() );
+
+        const BSONObj bigger = BSON( "n" << 3 << "s" << string( 4000, 'b' ) );
+        result = rs.updateRecord( &txn, loc, bigger.objdata(), bigger.objsize(), false, NULL );
+        ASSERT_OK( result.getStatus() );
+        ASSERT_EQUALS( bigger, rs.dataFor( result.getValue() ).toBson() );
+
+        // small records aren't worth compressing
+        const BSONObj small = BSON( "n" << 4 );
+        result = rs.insertRecord( &txn, small.objdata(), small.objsize(), false );
+        ASSERT_OK( result.getStatus() );
+        ASSERT( !rs.dataFor( result.getValue() ).isOwned() );
+        ASSERT_EQUALS( small, rs.dataFor( result.getValue() ).toBson() );
+    }
+
+    /**
+     * Writes keep a record's checksum up to date, and scrubRecords() finds a record whose data
+     * has changed behind the store's back.
+     */
+    TEST( SimpleRecordStoreV1, RecordChecksums ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        const BSONObj before = BSON( "n" << 0 );
+        ASSERT_OK( rs.insertRecord( &txn, before.objdata(), before.objsize(), false ).getStatus() );
+
+        BSONObjBuilder info;
+        ASSERT_OK( rs.setCustomOption( &txn, BSON( "recordChecksums" << true ).firstElement(),
+                                       &info ) );
+        ASSERT( md->isUserFlagSet( RecordStoreV1Base::Flag_MayHaveRecordChecksums ) );
+
+        const BSONObj doc = BSON( "n" << 1 << "s" << string( 100, 'a' ) );
+        StatusWith<DiskLoc> result = rs.insertRecord( &txn, doc.objdata(), doc.objsize(), false );
+        ASSERT_OK( result.getStatus() );
+        const DiskLoc loc = result.getValue();
+        ASSERT_EQUALS( doc, rs.dataFor( loc ).toBson() );
+
+        const BSONObj two = BSON( "" << 2 );
+        mutablebson::DamageVector damages;
+        mutablebson::DamageEvent damage;
+        damage.sourceOffset = two.firstElement().value() - two.objdata();
+        damage.targetOffset = doc["n"].value() - doc.objdata();
+        damage.size = 4;
+        damages.push_back( damage );
+        ASSERT_OK( rs.updateWithDamages( &txn, loc, two.objdata(), damages ) );
+
+        ScrubState state;
+        std::vector<DiskLoc> corrupt;
+        StatusWith<bool> done = rs.scrubRecords( &txn, 10, &state, &corrupt );
+        ASSERT_OK( done.getStatus() );
+        ASSERT( done.getValue() );
+        ASSERT_EQUALS( 1, state.recordsChecked );
+        ASSERT_EQUALS( 1, state.recordsWithoutChecksum );
+        ASSERT_EQUALS( 0, state.mismatches );
+
+        em.recordForV1( loc )->data()[20] ^= 0x4;
+
+        state = ScrubState();
+        done = rs.scrubRecords( &txn, 10, &state, &corrupt );
+        ASSERT_OK( done.getStatus() );
+        ASSERT( done.getValue() );
+        ASSERT_EQUALS( 1, state.mismatches );
+        ASSERT_EQUALS( 1U, corrupt.size() );
+        ASSERT_EQUALS( loc, corrupt[0] );
+    }
+
+    /**
+     * A pass that loses its place because the record it was going to check next was deleted
+     * goes back to the start of that extent.
+     */
+    TEST( SimpleRecordStoreV1, ScrubRecordsResumesAfterDelete ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md =
+            new DummyRecordStoreV1MetaData( false, RecordStoreV1Base::Flag_RecordChecksums |
+                                                   RecordStoreV1Base::Flag_MayHaveRecordChecksums );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        DiskLoc locs[3];
+        for ( int i = 0; i < 3; i++ ) {
+            const BSONObj doc = BSON( "n" << i );
+            StatusWith<DiskLoc> result =
+                rs.insertRecord( &txn, doc.objdata(), doc.objsize(), false );
+            ASSERT_OK( result.getStatus() );
+            locs[i] = result.getValue();
+        }
+
+        ScrubState state;
+        std::vector<DiskLoc> corrupt;
+        StatusWith<bool> done = rs.scrubRecords( &txn, 1, &state, &corrupt );
+        ASSERT_OK( done.getStatus() );
+        ASSERT( !done.getValue() );
+        ASSERT_EQUALS( locs[1], state.next );
+
+        rs.deleteRecord( &txn, locs[1] );
+
+        done = rs.scrubRecords( &txn, 10, &state, &corrupt );
+        ASSERT_OK( done.getStatus() );
+        ASSERT( done.getValue() );
+        ASSERT_EQUALS( 3, state.recordsChecked );
+        ASSERT_EQUALS( 0, state.mismatches );
+        ASSERT( corrupt.empty() );
+    }
+
+    class BatchDocWriter : public DocWriter {
+    public:
+        BatchDocWriter( int size ) : _size( size ) {}
+        virtual void writeDocument( char* buf ) const { memset( buf, 'x', _size ); }
+        virtual size_t documentSize() const { return _size; }
+        virtual bool addPadding() const { return false; }
+    private:
+        int _size;
+    };
+
+    /**
+     * A batch insert carves all of its records out of a single deleted record, in order.
+     */
+    TEST( SimpleRecordStoreV1, InsertRecordsSharesOneAllocation ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 1000},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        BatchDocWriter writer( 100 - Record::HeaderSize );
+        const DocWriter* docs[] = { &writer, &writer, &writer };
+        DiskLoc locs[3];
+        ASSERT_OK( rs.insertRecords( &txn, docs, 3, locs, false ) );
+
+        ASSERT_EQUALS( DiskLoc(0, 1000), locs[0] );
+        ASSERT_EQUALS( DiskLoc(0, 1100), locs[1] );
+        ASSERT_EQUALS( DiskLoc(0, 1200), locs[2] );
+        ASSERT_EQUALS( 3, md->numRecords() );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 1100), 100},
+                {DiskLoc(0, 1200), 120}, // 300 is quantized to 320, the last record gets the rest
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1320), 680},
+                {}
+            };
+            assertStateV1RS(recs, drecs, &em, md);
+        }
+    }
+
     // ----------------
 
     /**
@@ -507,6 +726,7 @@ namespace {
      * WARNING: this test depends on magic numbers inside RSV1Simple::_allocFromExistingExtents.
      */
     TEST( SimpleRecordStoreV1, InsertLooksForBetterMatchUpTo5Links ) {
+        WalkDeletedLists walk;
         OperationContextNoop txn;
         DummyExtentManager em;
         DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
@@ -559,6 +779,7 @@ namespace {
      * WARNING: this test depends on magic numbers inside RSV1Simple::_allocFromExistingExtents.
      */
     TEST( SimpleRecordStoreV1, InsertLooksForMatchUpTo31Links ) {
+        WalkDeletedLists walk;
         OperationContextNoop txn;
         DummyExtentManager em;
         DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
@@ -669,6 +890,7 @@ namespace {
      * WARNING: this test depends on magic numbers inside RSV1Simple::_allocFromExistingExtents.
      */
     TEST( SimpleRecordStoreV1, InsertLooksForMatchUpTo31LinksEvenIfFoundOversizedFit ) {
+        WalkDeletedLists walk;
         OperationContextNoop txn;
         DummyExtentManager em;
         DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
@@ -772,4 +994,385 @@ namespace {
             assertStateV1RS(recs, drecs, &em, md);
         }
     }
+
+    /**
+     * With the deleted record index, inserts take the smallest deleted record that fits, however
+     * far down its list it is.
+     */
+    TEST( SimpleRecordStoreV1, FreeSpaceIndexTakesBestFit ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000),  75}, // too small
+                {DiskLoc(0, 1100),  95}, // 2nd insert: lowest DiskLoc of the best fits left
+                {DiskLoc(0, 1200),  75},
+                {DiskLoc(0, 1300),  95}, // 3rd insert
+                {DiskLoc(0, 1400),  75},
+                {DiskLoc(0, 1500),  80}, // exact match. taken by 1st insert
+                {DiskLoc(0, 1600), 140}, // bigger bucket. never needed
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        rs.insertRecord(&txn, zeros, 80 - Record::HeaderSize, false);
+        rs.insertRecord(&txn, zeros, 80 - Record::HeaderSize, false);
+        rs.insertRecord(&txn, zeros, 80 - Record::HeaderSize, false);
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1500), 80},
+                {DiskLoc(0, 1100), 95},
+                {DiskLoc(0, 1300), 95},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000),  75},
+                {DiskLoc(0, 1200),  75},
+                {DiskLoc(0, 1400),  75},
+                {DiskLoc(0, 1600), 140},
+                {}
+            };
+            assertStateV1RS(recs, drecs, &em, md);
+        }
+    }
+
+    /**
+     * The deleted record index follows records deleted after it is built, and doesn't hand out
+     * records that left the deleted lists behind its back.
+     */
+    TEST( SimpleRecordStoreV1, FreeSpaceIndexFollowsDeletedLists ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 2000), 100},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        StatusWith<DiskLoc> result = rs.insertRecord(&txn, zeros, 100 - Record::HeaderSize, false);
+        ASSERT_OK( result.getStatus() );
+        ASSERT_EQUALS( DiskLoc(0, 1000), result.getValue() );
+
+        // a deleted record is available again right away
+        rs.deleteRecord( &txn, result.getValue() );
+        result = rs.insertRecord(&txn, zeros, 100 - Record::HeaderSize, false);
+        ASSERT_OK( result.getStatus() );
+        ASSERT_EQUALS( DiskLoc(0, 1000), result.getValue() );
+
+        // as if the unit of work that put (0, 2000) on the list had rolled back
+        md->setDeletedListEntry( &txn, RecordStoreV1Base::bucket(100), DiskLoc() );
+        result = rs.insertRecord(&txn, zeros, 100 - Record::HeaderSize, false);
+        ASSERT_OK( result.getStatus() );
+        ASSERT_NOT_EQUALS( DiskLoc(0, 2000), result.getValue() );
+    }
+
+    /**
+     * Sets mmapv1AdaptiveExtentSize for the lifetime of the object, even if an assertion fails.
+     */
+    class AdaptiveExtentSizeSetting {
+    public:
+        explicit AdaptiveExtentSizeSetting( bool adaptive ) : _old( mmapv1AdaptiveExtentSize ) {
+            mmapv1AdaptiveExtentSize = adaptive;
+        }
+        ~AdaptiveExtentSizeSetting() {
+            mmapv1AdaptiveExtentSize = _old;
+        }
+    private:
+        bool _old;
+    };
+
+    /**
+     * Inserts into a new store until it has two extents and returns the size of the second.
+     */
+    int secondExtentSize( bool adaptive ) {
+        AdaptiveExtentSizeSetting setting( adaptive );
+
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        while ( em.numFiles() < 2 )
+            ASSERT_OK( rs.insertRecord( &txn, zeros, 1000, false ).getStatus() );
+
+        BSONObjBuilder stats;
+        rs.appendCustomStats( &stats, 1 );
+        BSONObj statsObj = stats.obj();
+        BSONObj sizing = statsObj["extentSizing"].Obj();
+        ASSERT_EQUALS( 2, sizing["extentsAdded"].numberLong() );
+        ASSERT_EQUALS( adaptive ? 1 : 0, sizing["extentsSizedByGrowth"].numberLong() );
+
+        return md->lastExtentSize();
+    }
+
+    /**
+     * An extent that fills up right away makes the next one bigger than the fixed formula
+     * would.
+     */
+    TEST( SimpleRecordStoreV1, ExtentSizeFollowsGrowth ) {
+        ASSERT_GREATER_THAN( secondExtentSize( true ), secondExtentSize( false ) );
+    }
+
+    class RecordMoves : public UpdateMoveNotifier, public RecordStoreCompactAdaptor {
+    public:
+        virtual Status recordStoreGoingToMove( OperationContext* txn,
+                                               const DiskLoc& oldLocation,
+                                               const char* oldBuffer,
+                                               size_t oldSize ) {
+            from.push_back( oldLocation );
+            return Status::OK();
+        }
+        virtual bool isDataValid( const RecordData& recData ) { return true; }
+        virtual size_t dataSize( const RecordData& recData ) { return recData.size(); }
+        virtual void inserted( const RecordData& recData, const DiskLoc& newLocation ) {
+            to.push_back( newLocation );
+        }
+
+        std::vector<DiskLoc> from;
+        std::vector<DiskLoc> to;
+    };
+
+    TEST( SimpleRecordStoreV1, CompactIncrementalEmptiesLastExtent ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(1, 1000), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 2000), 100},
+                {DiskLoc(0, 2000), 200},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        CompactOptions options;
+        CompactStats stats;
+        RecordMoves moves;
+
+        StatusWith<bool> done = rs.compactIncremental( &txn, &moves, &moves, &options, 10, &stats );
+        ASSERT_OK( done.getStatus() );
+        ASSERT_FALSE( done.getValue() );
+
+        ASSERT_EQUALS( 1U, moves.from.size() );
+        ASSERT_EQUALS( DiskLoc(1, 1000), moves.from[0] );
+        ASSERT_EQUALS( 1U, moves.to.size() );
+        ASSERT_EQUALS( DiskLoc(0, 2000), moves.to[0] );
+        ASSERT_EQUALS( 1, stats.recordsMoved );
+        ASSERT_EQUALS( 1, stats.extentsFreed );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 2000), 104}, // quantized, as it split a bigger hole
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 2104), 96},
+                {}
+            };
+            assertStateV1RS(recs, drecs, &em, md);
+        }
+
+        // only one extent left, nothing to do
+        done = rs.compactIncremental( &txn, &moves, &moves, &options, 10, &stats );
+        ASSERT_OK( done.getStatus() );
+        ASSERT_TRUE( done.getValue() );
+    }
+
+    /**
+     * Online compaction stopped part way through an extent leaves its free space usable,
+     * including records deleted from it in the meantime.
+     */
+    TEST( SimpleRecordStoreV1, CompactIncrementalAbortRelinksFreeSpace ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 1100), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 2000), 100},
+                {DiskLoc(0, 2000), 400},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        CompactOptions options;
+        CompactStats stats;
+        RecordMoves moves;
+
+        StatusWith<bool> done = rs.compactIncremental( &txn, &moves, &moves, &options, 1, &stats );
+        ASSERT_OK( done.getStatus() );
+        ASSERT_FALSE( done.getValue() );
+        ASSERT_EQUALS( 1, stats.recordsMoved );
+        ASSERT_EQUALS( 0, stats.extentsFreed );
+
+        // a delete while the extent is being emptied, then the compact gets killed
+        rs.deleteRecord( &txn, DiskLoc(1, 1100) );
+        rs.abortCompactIncremental( &txn );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 2000), 104},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 1100), 100},
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 2000), 100},
+                {DiskLoc(0, 2104), 296},
+                {}
+            };
+            assertStateV1RS(recs, drecs, &em, md);
+        }
+
+        // nothing is held back anymore: a record can go in the extent again
+        StatusWith<DiskLoc> result = rs.insertRecord( &txn, zeros, 100 - Record::HeaderSize,
+                                                      false );
+        ASSERT_OK( result.getStatus() );
+        ASSERT_EQUALS( 1, result.getValue().a() );
+    }
+
+    /**
+     * Nothing but the open store knows an extent is being emptied, so reopening the store part
+     * way through finds all of its free space on the deleted lists.
+     */
+    TEST( SimpleRecordStoreV1, CompactIncrementalReopenKeepsFreeSpace ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        DummyRecordStoreV1MetaData* reopenedMd = NULL;
+
+        {
+            SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 1100), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 2000), 100},
+                {DiskLoc(0, 2000), 400},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+
+            CompactOptions options;
+            CompactStats stats;
+            RecordMoves moves;
+            StatusWith<bool> done = rs.compactIncremental( &txn, &moves, &moves, &options, 1,
+                                                           &stats );
+            ASSERT_OK( done.getStatus() );
+            ASSERT_FALSE( done.getValue() );
+            ASSERT_EQUALS( 0, stats.extentsFreed );
+
+            rs.deleteRecord( &txn, DiskLoc(1, 1100) );
+
+            // the store goes away without abortCompactIncremental(), as in a restart
+            reopenedMd = new DummyRecordStoreV1MetaData( *md );
+        }
+
+        SimpleRecordStoreV1 rs( &txn, "test.foo", reopenedMd, &em, false );
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 2000), 104},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 1100), 100},
+                {DiskLoc(1, 1000), 100},
+                {DiskLoc(1, 2000), 100},
+                {DiskLoc(0, 2104), 296},
+                {}
+            };
+            assertStateV1RS(recs, drecs, &em, reopenedMd);
+        }
+
+        // and compacting again takes the extent and its free space away together
+        CompactOptions options;
+        CompactStats stats;
+        RecordMoves moves;
+        StatusWith<bool> done = rs.compactIncremental( &txn, &moves, &moves, &options, 10, &stats );
+        ASSERT_OK( done.getStatus() );
+        ASSERT_FALSE( done.getValue() );
+        ASSERT_EQUALS( 0, stats.recordsMoved );
+        ASSERT_EQUALS( 1, stats.extentsFreed );
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(0, 2000), 104},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(0, 2104), 296},
+                {}
+            };
+            assertStateV1RS(recs, drecs, &em, reopenedMd);
+        }
+    }
+
+    TEST( SimpleRecordStoreV1, CompactIncrementalNeedsRoomElsewhere ) {
+        OperationContextNoop txn;
+        DummyExtentManager em;
+        DummyRecordStoreV1MetaData* md = new DummyRecordStoreV1MetaData( false, 0 );
+        SimpleRecordStoreV1 rs( &txn, "test.foo", md, &em, false );
+
+        {
+            LocAndSize recs[] = {
+                {DiskLoc(0, 1000), 100},
+                {DiskLoc(1, 1000), 100},
+                {}
+            };
+            LocAndSize drecs[] = {
+                {DiskLoc(1, 2000), 100},
+                {}
+            };
+            initializeV1RS(&txn, recs, drecs, &em, md);
+        }
+
+        CompactOptions options;
+        CompactStats stats;
+        RecordMoves moves;
+
+        StatusWith<bool> done = rs.compactIncremental( &txn, &moves, &moves, &options, 10, &stats );
+        ASSERT_OK( done.getStatus() );
+        ASSERT_TRUE( done.getValue() );
+        ASSERT_EQUALS( 0, stats.recordsMoved );
+        ASSERT_EQUALS( DiskLoc(1, 0), md->lastExtent() );
+    }
 }
@@ -217,7 +217,8 @@ namespace mongo {
     DiskLoc DummyExtentManager::allocateExtent( OperationContext* txn,
                                                 bool capped,
                                                 int size,
-                                                bool enforceQuota ) {
+                                                bool enforceQuota,
+                                                int smallestUseful ) {
         size = quantizeExtentSize( size );
 
         ExtentInfo info;
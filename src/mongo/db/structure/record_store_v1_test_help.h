@@ -122,7 +122,8 @@ namespace mongo {
         virtual DiskLoc allocateExtent( OperationContext* txn,
                                         bool capped,
                                         int size,
-                                        bool enforceQuota );
+                                        bool enforceQuota,
+                                        int smallestUseful = 0 );
 
         virtual void freeExtents( OperationContext* txn,
                                   DiskLoc firstExt, DiskLoc lastExt );
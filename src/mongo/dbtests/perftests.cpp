@@ -44,6 +44,8 @@
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/storage/mmap_v1/durable_mapped_file.h"
 #include "mongo/db/storage/mmap_v1/dur_stats.h"
+#include "mongo/db/storage/storage_benchmark.h"
+#include "mongo/db/storage/storage_engine.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
 #include "mongo/db/structure/btree/key.h"
@@ -1319,6 +1321,35 @@ namespace PerfTests {
     };
 #endif
 
+    /**
+     * Runs the storage engine benchmark against every registered engine, with sizes small
+     * enough for a test run, so the numbers can be compared side by side.
+     */
+    class StorageEngines {
+    public:
+        void run() {
+            StorageBenchmarkOptions options;
+            options.numRecords = 2000;
+            options.numOps = 2000;
+            options.numThreads = 2;
+
+            vector<string> engines;
+            StorageEngine::listFactories( &engines );
+            for ( size_t i = 0; i < engines.size(); i++ ) {
+                BSONObjBuilder b;
+                ASSERT_OK( runStorageBenchmark( engines[i], options, &b ) );
+                BSONObj results = b.obj();
+                cout << results.jsonString( Strict, 1 ) << endl;
+
+                BSONObj workloads = results["workloads"].Obj();
+                ASSERT_EQUALS( StorageBenchmarkOptions::allWorkloads().size(),
+                               static_cast<size_t>( workloads.nFields() ) );
+                ASSERT_EQUALS( options.numRecords, workloads["insert"]["ops"].numberLong() );
+                ASSERT_EQUALS( options.numRecords, workloads["delete"]["ops"].numberLong() );
+            }
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "perf" ) { }
@@ -1406,6 +1437,7 @@ namespace PerfTests {
                 add< Update1 >();
                 add< MoreIndexes<Update1> >();
                 add< InsertBig >();
+                add< StorageEngines >();
                 add< FailPointTest<false, false> >();
                 add< FailPointTest<true, false> >();
                 add< FailPointTest<true, true> >();
@@ -39,6 +39,8 @@
 #include "mongo/db/json.h"
 #include "mongo/db/operation_context_impl.h"
 #include "mongo/db/query/get_executor.h"
+#include "mongo/db/query/index_stats.h"
+#include "mongo/db/query/plan_ranker.h"
 #include "mongo/db/query/qlog.h"
 #include "mongo/db/query/query_knobs.h"
 #include "mongo/db/query/query_planner.h"
@@ -723,6 +725,187 @@ namespace PlanRankingTests {
         }
     };
 
+    /**
+     * Plans queries as the runner would and prunes the solutions with the index statistics.
+     */
+    class PlanRankingPruneTestBase : public PlanRankingTestBase {
+    protected:
+        void plan(Collection* collection, CanonicalQuery* cq, vector<QuerySolution*>* out) {
+            QueryPlannerParams plannerParams;
+            fillOutPlannerParams(collection, cq, &plannerParams);
+            ASSERT(QueryPlanner::plan(*cq, plannerParams, out).isOK());
+        }
+
+        bool solutionExists(const string& solnJson, const vector<QuerySolution*>& solutions) {
+            for (size_t i = 0; i < solutions.size(); ++i) {
+                if (QueryPlannerTestLib::solutionMatches(solnJson, solutions[i]->root.get())) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void deleteSolutions(vector<QuerySolution*>* solutions) {
+            for (size_t i = 0; i < solutions->size(); ++i) {
+                delete (*solutions)[i];
+            }
+            solutions->clear();
+        }
+    };
+
+    /**
+     * Candidates that the index statistics say will do far more work than the cheapest one
+     * are dropped before they're run.
+     */
+    class PlanRankingPruneByCost : public PlanRankingPruneTestBase {
+    public:
+        void run() {
+            // 'a' is very selective, 'b' is not.
+            for (int i = 0; i < 1000; ++i) {
+                insert(BSON("a" << i << "b" << i % 2));
+            }
+
+            addIndex(BSON("a" << 1));
+            addIndex(BSON("b" << 1));
+
+            CanonicalQuery* rawCq;
+            ASSERT(CanonicalQuery::canonicalize(ns, fromjson("{a: 5, b: 1}"), &rawCq).isOK());
+            auto_ptr<CanonicalQuery> cq(rawCq);
+
+            Client::ReadContext ctx(&_txn, ns);
+            Collection* collection = ctx.ctx().db()->getCollection(&_txn, ns);
+            IndexStatsCache* stats = collection->infoCache()->getIndexStats();
+
+            // Nothing is pruned until the indexes are analyzed.
+            vector<QuerySolution*> solutions;
+            plan(collection, cq.get(), &solutions);
+            ASSERT_GREATER_THAN(solutions.size(), 1U);
+            PlanRanker::pruneByCost(*stats, collection->numRecords(), &solutions);
+            ASSERT_GREATER_THAN(solutions.size(), 1U);
+            deleteSolutions(&solutions);
+
+            // The same statistics the analyze command would gather.
+            IndexStatsBuilder aStats(BSON("a" << 1), 10);
+            for (int i = 0; i < 1000; ++i) {
+                aStats.addKey(BSON("" << i));
+            }
+            stats->add(aStats.done(1000));
+
+            IndexStatsBuilder bStats(BSON("b" << 1), 10);
+            for (int i = 0; i < 1000; ++i) {
+                bStats.addKey(BSON("" << i / 500));
+            }
+            stats->add(bStats.done(1000));
+
+            // Only the plan using 'a' is left to run.
+            plan(collection, cq.get(), &solutions);
+            PlanRanker::pruneByCost(*stats, collection->numRecords(), &solutions);
+            ASSERT_EQUALS(1U, solutions.size());
+            ASSERT(QueryPlannerTestLib::solutionMatches(
+                        "{fetch: {node: {ixscan: {pattern: {a: 1}}}}}",
+                        solutions[0]->root.get()));
+            deleteSolutions(&solutions);
+        }
+    };
+
+    /**
+     * A value inserted since the indexes were analyzed isn't in the histogram.  The plan
+     * looking it up mustn't be estimated to cost nothing, which would prune every other plan.
+     */
+    class PlanRankingPruneByCostValueNotInHistogram : public PlanRankingPruneTestBase {
+    public:
+        void run() {
+            for (int i = 0; i < 1000; ++i) {
+                insert(BSON("a" << i << "b" << i));
+            }
+
+            addIndex(BSON("a" << 1));
+            addIndex(BSON("b" << 1));
+
+            Client::ReadContext ctx(&_txn, ns);
+            Collection* collection = ctx.ctx().db()->getCollection(&_txn, ns);
+            IndexStatsCache* stats = collection->infoCache()->getIndexStats();
+
+            IndexStatsBuilder aStats(BSON("a" << 1), 10);
+            IndexStatsBuilder bStats(BSON("b" << 1), 10);
+            for (int i = 0; i < 1000; ++i) {
+                aStats.addKey(BSON("" << i));
+                bStats.addKey(BSON("" << i));
+            }
+            stats->add(aStats.done(1000));
+            stats->add(bStats.done(1000));
+
+            CanonicalQuery* rawCq;
+            ASSERT(CanonicalQuery::canonicalize(ns, fromjson("{a: 5000, b: 7}"), &rawCq).isOK());
+            auto_ptr<CanonicalQuery> cq(rawCq);
+
+            // Both indexes look at about one key, so nothing is pruned.
+            vector<QuerySolution*> solutions;
+            plan(collection, cq.get(), &solutions);
+            size_t numSolutions = solutions.size();
+            ASSERT_GREATER_THAN(numSolutions, 1U);
+            PlanRanker::pruneByCost(*stats, collection->numRecords(), &solutions);
+            ASSERT_EQUALS(numSolutions, solutions.size());
+            ASSERT(solutionExists("{fetch: {node: {ixscan: {pattern: {a: 1}}}}}", solutions));
+            ASSERT(solutionExists("{fetch: {node: {ixscan: {pattern: {b: 1}}}}}", solutions));
+            deleteSolutions(&solutions);
+        }
+    };
+
+    /**
+     * Only the leading field of a compound index is estimated, which says nothing of how much
+     * the bounds on the other fields narrow the scan.  So a plan like that isn't pruned.
+     */
+    class PlanRankingPruneByCostCompoundBounds : public PlanRankingPruneTestBase {
+    public:
+        void run() {
+            // 'a' alone is not selective, 'a' and 'c' together are.
+            for (int i = 0; i < 1000; ++i) {
+                insert(BSON("a" << i % 2 << "c" << i << "b" << i % 50));
+            }
+
+            addIndex(BSON("a" << 1 << "c" << 1));
+            addIndex(BSON("b" << 1));
+
+            Client::ReadContext ctx(&_txn, ns);
+            Collection* collection = ctx.ctx().db()->getCollection(&_txn, ns);
+            IndexStatsCache* stats = collection->infoCache()->getIndexStats();
+
+            IndexStatsBuilder acStats(BSON("a" << 1 << "c" << 1), 10);
+            for (int a = 0; a < 2; ++a) {
+                for (int i = a; i < 1000; i += 2) {
+                    acStats.addKey(BSON("" << a << "" << i));
+                }
+            }
+            stats->add(acStats.done(1000));
+
+            IndexStatsBuilder bStats(BSON("b" << 1), 10);
+            for (int b = 0; b < 50; ++b) {
+                for (int i = 0; i < 20; ++i) {
+                    bStats.addKey(BSON("" << b));
+                }
+            }
+            stats->add(bStats.done(1000));
+
+            CanonicalQuery* rawCq;
+            ASSERT(CanonicalQuery::canonicalize(ns, fromjson("{a: 1, c: 7, b: 7}"),
+                                                &rawCq).isOK());
+            auto_ptr<CanonicalQuery> cq(rawCq);
+
+            // {a: 1} alone would be estimated at 500 keys against 20 for {b: 7}, but nothing
+            // that scans {a: 1, c: 1} is pruned.
+            vector<QuerySolution*> solutions;
+            plan(collection, cq.get(), &solutions);
+            size_t numSolutions = solutions.size();
+            ASSERT_GREATER_THAN(numSolutions, 1U);
+            PlanRanker::pruneByCost(*stats, collection->numRecords(), &solutions);
+            ASSERT_EQUALS(numSolutions, solutions.size());
+            ASSERT(solutionExists("{fetch: {node: {ixscan: {pattern: {a: 1, c: 1}}}}}",
+                                  solutions));
+            deleteSolutions(&solutions);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "query_plan_ranking" ) {}
@@ -744,6 +927,9 @@ namespace PlanRankingTests {
             // add<PlanRankingChooseBetweenIxisectPlans>();
             add<PlanRankingAvoidBlockingSort>();
             add<PlanRankingWorkPlansLongEnough>();
+            add<PlanRankingPruneByCost>();
+            add<PlanRankingPruneByCostValueNotInHistogram>();
+            add<PlanRankingPruneByCostCompoundBounds>();
         }
     } planRankingAll;
 
@@ -34,6 +34,7 @@
 #include "mongo/db/catalog/collection.h"
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/instance.h"
 #include "mongo/db/json.h"
@@ -315,12 +316,19 @@ namespace QueryStageCollectionScan {
 
     class QueryStageCollectionScanBase {
     public:
-        QueryStageCollectionScanBase() : _client(&_txn) {
+        /**
+         * @param padBytes - makes each document this much bigger
+         */
+        QueryStageCollectionScanBase(int padBytes = 0) : _client(&_txn) {
             Client::WriteContext ctx(&_txn, ns());
 
+            const string pad(padBytes, 'x');
             for (int i = 0; i < numObj(); ++i) {
                 BSONObjBuilder bob;
                 bob.append("foo", i);
+                if (padBytes > 0) {
+                    bob.append("pad", pad);
+                }
                 _client.insert(ns(), bob.obj());
             }
             ctx.commit();
@@ -624,6 +632,108 @@ namespace QueryStageCollectionScan {
         }
     };
 
+    //
+    // A parallel scan returns the same documents as a serial one, in no particular order.
+    //
+
+    // Documents big enough that the test collections span several extents, so a parallel scan
+    // gets more than one iterator.
+    static const int kParallelPadBytes = 1000;
+
+    class QueryStageCollscanParallel : public QueryStageCollectionScanBase {
+    public:
+        QueryStageCollscanParallel() : QueryStageCollectionScanBase(kParallelPadBytes) { }
+
+        void run() {
+            ASSERT_EQUALS(numObj(), countParallel(BSONObj()));
+            ASSERT_EQUALS(25, countParallel(BSON("foo" << BSON("$lt" << 25))));
+            ASSERT_EQUALS(1, countParallel(BSON("foo" << 7)));
+        }
+
+    private:
+        int countParallel(const BSONObj& filterObj) {
+            Client::ReadContext ctx(&_txn, ns());
+
+            CollectionScanParams params;
+            params.collection = ctx.ctx().db()->getCollection( &_txn, ns() );
+
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(filterObj);
+            verify(swme.isOK());
+            auto_ptr<MatchExpression> filterExpr(swme.getValue());
+
+            WorkingSet* ws = new WorkingSet();
+            ParallelCollectionScan* ps =
+                new ParallelCollectionScan(params, ws, filterExpr.get(), 4);
+            PlanExecutor runner(ws, ps, params.collection);
+
+            set<int> seen;
+            for (BSONObj obj; Runner::RUNNER_ADVANCED == runner.getNext(&obj, NULL); ) {
+                // Each document comes back exactly once.
+                ASSERT(seen.insert(obj["foo"].numberInt()).second);
+                ASSERT(filterExpr->matchesBSON(obj));
+            }
+            ASSERT_GREATER_THAN(ps->numIterators(), 1U);
+            return seen.size();
+        }
+    };
+
+    //
+    // A document deleted while the parallel scan is yielded is not returned, even if it was
+    // already read into a batch.
+    //
+
+    class QueryStageCollscanParallelInvalidate : public QueryStageCollectionScanBase {
+    public:
+        QueryStageCollscanParallelInvalidate()
+            : QueryStageCollectionScanBase(kParallelPadBytes) { }
+
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+            Collection* coll = ctx.ctx().db()->getCollection(&_txn, ns());
+
+            vector<DiskLoc> locs;
+            getLocs(coll, CollectionScanParams::FORWARD, &locs);
+
+            CollectionScanParams params;
+            params.collection = coll;
+
+            WorkingSet ws;
+            scoped_ptr<ParallelCollectionScan> scan(
+                new ParallelCollectionScan(params, &ws, NULL, 4));
+
+            set<int> seen;
+            while (seen.size() < 10) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan->work(&id);
+                ASSERT_NOT_EQUALS(PlanStage::IS_EOF, state);
+                if (PlanStage::ADVANCED == state) {
+                    seen.insert(ws.get(id)->obj["foo"].numberInt());
+                }
+            }
+
+            // Remove the last document in the collection, which hasn't been returned yet.
+            int removed = coll->docFor(locs.back())["foo"].numberInt();
+            ASSERT_EQUALS(0U, seen.count(removed));
+            scan->prepareToYield();
+            scan->invalidate(locs.back(), INVALIDATION_DELETION);
+            remove(coll->docFor(locs.back()));
+            scan->recoverFromYield();
+
+            while (!scan->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                PlanStage::StageState state = scan->work(&id);
+                if (PlanStage::ADVANCED == state) {
+                    ASSERT(seen.insert(ws.get(id)->obj["foo"].numberInt()).second);
+                }
+            }
+            ctx.commit();
+
+            ASSERT_GREATER_THAN(scan->numIterators(), 1U);
+            ASSERT_EQUALS(0U, seen.count(removed));
+            ASSERT_EQUALS(static_cast<size_t>(numObj() - 1), seen.size());
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite( "QueryStageCollectionScan" ) {}
@@ -654,6 +764,8 @@ namespace QueryStageCollectionScan {
             add<QueryStageCollscanObjectsInOrderBackward>();
             add<QueryStageCollscanInvalidateUpcomingObject>();
             add<QueryStageCollscanInvalidateUpcomingObjectBackward>();
+            add<QueryStageCollscanParallel>();
+            add<QueryStageCollscanParallelInvalidate>();
         }
     } all;
 
@@ -38,6 +38,7 @@
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/operation_context_impl.h"
+#include "mongo/db/query/index_bounds_builder.h"
 #include "mongo/db/catalog/collection.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/util/fail_point.h"
@@ -636,6 +637,99 @@ namespace QueryStageCount {
         }
     };
 
+    //
+    // Count over bounds with several intervals, skipping the keys between them
+    //
+    class QueryStageCountMultiInterval : public CountBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+
+            for (int i = 0; i < 20; ++i) {
+                insert(BSON("a" << i));
+            }
+            // Matches both {a: 3} and {a: 12} but must only be counted once.
+            insert(BSON("a" << BSON_ARRAY(3 << 12)));
+            addIndex(BSON("a" << 1));
+            ctx.commit();
+
+            // a in {3, 5} or 10 <= a < 13
+            CountParams params;
+            params.descriptor = getIndex(ctx.ctx().db(), BSON("a" << 1));
+            params.useBounds = true;
+            OrderedIntervalList oil("a");
+            oil.intervals.push_back(Interval(BSON("" << 3 << "" << 3), true, true));
+            oil.intervals.push_back(Interval(BSON("" << 5 << "" << 5), true, true));
+            oil.intervals.push_back(Interval(BSON("" << 10 << "" << 13), true, false));
+            params.bounds.fields.push_back(oil);
+
+            WorkingSet ws;
+            Count count(params, &ws);
+
+            int numCounted = runCount(&count);
+            ASSERT_EQUALS(6, numCounted);
+        }
+    };
+
+    //
+    // Keys that don't match the filter aren't counted, and yielding part way through doesn't
+    // lose our place in the bounds
+    //
+    class QueryStageCountFilterOnKey : public CountBase {
+    public:
+        void run() {
+            Client::WriteContext ctx(&_txn, ns());
+
+            for (int i = 0; i < 10; ++i) {
+                for (int j = 0; j < 10; ++j) {
+                    insert(BSON("a" << i << "b" << j));
+                }
+            }
+            addIndex(BSON("a" << 1 << "b" << 1));
+            ctx.commit();
+
+            // a in {2, 4, 6}, all values of b
+            CountParams params;
+            params.descriptor = getIndex(ctx.ctx().db(), BSON("a" << 1 << "b" << 1));
+            params.useBounds = true;
+            OrderedIntervalList oilA("a");
+            oilA.intervals.push_back(Interval(BSON("" << 2 << "" << 2), true, true));
+            oilA.intervals.push_back(Interval(BSON("" << 4 << "" << 4), true, true));
+            oilA.intervals.push_back(Interval(BSON("" << 6 << "" << 6), true, true));
+            params.bounds.fields.push_back(oilA);
+            OrderedIntervalList oilB("b");
+            oilB.intervals.push_back(IndexBoundsBuilder::allValues());
+            params.bounds.fields.push_back(oilB);
+
+            // Only odd values of b.
+            StatusWithMatchExpression swme = MatchExpressionParser::parse(
+                BSON("b" << BSON("$mod" << BSON_ARRAY(2 << 1))));
+            ASSERT(swme.isOK());
+            auto_ptr<MatchExpression> filter(swme.getValue());
+            params.filter = filter.get();
+
+            WorkingSet ws;
+            Count count(params, &ws);
+            WorkingSetID wsid;
+
+            int numCounted = 0;
+            PlanStage::StageState countState;
+            while (numCounted < 7) {
+                countState = count.work(&wsid);
+                if (PlanStage::ADVANCED == countState) numCounted++;
+            }
+
+            count.prepareToYield();
+            count.recoverFromYield();
+
+            while (PlanStage::IS_EOF != countState) {
+                countState = count.work(&wsid);
+                if (PlanStage::ADVANCED == countState) numCounted++;
+            }
+            ASSERT_EQUALS(15, numCounted);
+        }
+    };
+
     class All : public Suite {
     public:
         All() : Suite("query_stage_count") { }
@@ -652,6 +746,8 @@ namespace QueryStageCount {
             add<QueryStageCountInsertNewDocsDuringYield>();
             add<QueryStageCountBecomesMultiKeyDuringYield>();
             add<QueryStageCountUnusedKeys>();
+            add<QueryStageCountMultiInterval>();
+            add<QueryStageCountFilterOnKey>();
         }
     }  queryStageCountAll;
 
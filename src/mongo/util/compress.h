@@ -44,6 +44,11 @@ namespace mongo {
         char* compressed,
         size_t* compressed_length);
 
+    bool uncompressedLength(const char* compressed, size_t compressed_length, size_t* result);
+
+    // 'uncompressed' must have room for uncompressedLength() bytes
+    bool rawUncompress(const char* compressed, size_t compressed_length, char* uncompressed);
+
 }
 
 
@@ -0,0 +1,171 @@
+// @file crc32c.cpp
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#include "mongo/util/crc32c.h"
+
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#include <nmmintrin.h>
+#define MONGO_CRC32C_MSVC_SSE42
+#elif defined(__GNUC__) && defined(__x86_64__)
+#include <cpuid.h>
+#define MONGO_CRC32C_GCC_SSE42
+#endif
+
+namespace mongo {
+
+namespace {
+
+    const uint32_t Polynomial = 0x82F63B78; // Castagnoli, bit reversed
+
+    /* Tables for the software version, which works on 8 bytes at a time ("slicing by 8").
+       table[0] is the usual byte at a time table; table[k] advances a byte k more places.
+    */
+    class SoftwareTables {
+    public:
+        SoftwareTables() {
+            for ( uint32_t i = 0; i < 256; i++ ) {
+                uint32_t c = i;
+                for ( int bit = 0; bit < 8; bit++ )
+                    c = ( c & 1 ) ? ( c >> 1 ) ^ Polynomial : c >> 1;
+                table[0][i] = c;
+            }
+            for ( uint32_t i = 0; i < 256; i++ ) {
+                for ( int k = 1; k < 8; k++ )
+                    table[k][i] = ( table[k - 1][i] >> 8 ) ^ table[0][table[k - 1][i] & 0xff];
+            }
+        }
+
+        uint32_t table[8][256];
+    };
+
+    const SoftwareTables softwareTables;
+
+    inline uint32_t load32( const unsigned char* p ) {
+        return p[0] | ( p[1] << 8 ) | ( p[2] << 16 ) | ( static_cast<uint32_t>( p[3] ) << 24 );
+    }
+
+    uint32_t crc32cSoftware( uint32_t c, const unsigned char* p, size_t length ) {
+        const uint32_t (*t)[256] = softwareTables.table;
+
+        while ( length >= 8 ) {
+            const uint32_t lo = load32( p ) ^ c;
+            const uint32_t hi = load32( p + 4 );
+            c = t[7][lo & 0xff] ^ t[6][( lo >> 8 ) & 0xff] ^
+                t[5][( lo >> 16 ) & 0xff] ^ t[4][lo >> 24] ^
+                t[3][hi & 0xff] ^ t[2][( hi >> 8 ) & 0xff] ^
+                t[1][( hi >> 16 ) & 0xff] ^ t[0][hi >> 24];
+            p += 8;
+            length -= 8;
+        }
+
+        while ( length > 0 ) {
+            c = t[0][( c ^ *p ) & 0xff] ^ ( c >> 8 );
+            p++;
+            length--;
+        }
+
+        return c;
+    }
+
+#if defined(MONGO_CRC32C_MSVC_SSE42) || defined(MONGO_CRC32C_GCC_SSE42)
+
+    bool cpuHasSSE42() {
+#if defined(MONGO_CRC32C_MSVC_SSE42)
+        int info[4];
+        __cpuid( info, 1 );
+        return info[2] & ( 1 << 20 );
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if ( !__get_cpuid( 1, &eax, &ebx, &ecx, &edx ) )
+            return false;
+        return ecx & ( 1 << 20 );
+#endif
+    }
+
+    /* Only called when cpuHasSSE42().  The instruction is used through inline assembly rather
+       than the intrinsics so that the rest of the build doesn't need -msse4.2.
+    */
+    uint32_t crc32cHardware( uint32_t crc, const unsigned char* p, size_t length ) {
+        uint64_t c = crc;
+        while ( length >= 8 ) {
+            uint64_t word;
+            memcpy( &word, p, sizeof( word ) );
+#if defined(MONGO_CRC32C_MSVC_SSE42)
+            c = _mm_crc32_u64( c, word );
+#else
+            asm( "crc32q %1, %0" : "+r" ( c ) : "rm" ( word ) );
+#endif
+            p += 8;
+            length -= 8;
+        }
+
+        uint32_t c32 = static_cast<uint32_t>( c );
+        while ( length > 0 ) {
+#if defined(MONGO_CRC32C_MSVC_SSE42)
+            c32 = _mm_crc32_u8( c32, *p );
+#else
+            asm( "crc32b %1, %0" : "+r" ( c32 ) : "rm" ( *p ) );
+#endif
+            p++;
+            length--;
+        }
+
+        return c32;
+    }
+
+    const bool useHardware = cpuHasSSE42();
+
+#else
+
+    const bool useHardware = false;
+
+    uint32_t crc32cHardware( uint32_t crc, const unsigned char* p, size_t length ) {
+        return crc32cSoftware( crc, p, length );
+    }
+
+#endif
+
+} // namespace
+
+    uint32_t crc32c( const void* data, size_t length, uint32_t crc ) {
+        const unsigned char* p = static_cast<const unsigned char*>( data );
+        if ( useHardware )
+            return ~crc32cHardware( ~crc, p, length );
+        return ~crc32cSoftware( ~crc, p, length );
+    }
+
+    bool crc32cIsHardwareAccelerated() {
+        return useHardware;
+    }
+
+}
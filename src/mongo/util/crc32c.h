@@ -0,0 +1,51 @@
+// @file crc32c.h
+
+/**
+*    Copyright (C) 2014 MongoDB Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+*    As a special exception, the copyright holders give permission to link the
+*    code of portions of this program with the OpenSSL library under certain
+*    conditions as described in each individual source file and distribute
+*    linked combinations including the program with the OpenSSL library. You
+*    must comply with the GNU Affero General Public License in all respects
+*    for all of the code used other than as permitted herein. If you modify
+*    file(s) with this exception, you may extend this exception to your
+*    version of the file(s), but you are not obligated to do so. If you do not
+*    wish to do so, delete this exception statement from your version. If you
+*    delete this exception statement from all source files in the program,
+*    then also delete it in the license file.
+*/
+
+#pragma once
+
+#include <cstddef>
+
+#include "mongo/platform/cstdint.h"
+
+namespace mongo {
+
+    /**
+     * CRC-32C (Castagnoli) of 'length' bytes at 'data'.  Pass a previous result as 'crc' to
+     * continue it: crc32c(b, nb, crc32c(a, na)) is the checksum of a followed by b.
+     * Uses the SSE4.2 crc32 instruction when the cpu has it.
+     */
+    uint32_t crc32c( const void* data, size_t length, uint32_t crc = 0 );
+
+    /**
+     * @return true if crc32c() is using the cpu's crc32 instruction
+     */
+    bool crc32cIsHardwareAccelerated();
+
+}
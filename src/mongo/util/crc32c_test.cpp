@@ -0,0 +1,76 @@
+/*
+ *    Copyright (C) 2014 MongoDB Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the GNU Affero General Public License in all respects
+ *    for all of the code used other than as permitted herein. If you modify
+ *    file(s) with this exception, you may extend this exception to your
+ *    version of the file(s), but you are not obligated to do so. If you do not
+ *    wish to do so, delete this exception statement from your version. If you
+ *    delete this exception statement from all source files in the program,
+ *    then also delete it in the license file.
+ */
+
+#include "mongo/util/crc32c.h"
+
+#include <string>
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+    uint32_t crcOf( const std::string& s ) {
+        return crc32c( s.data(), s.size() );
+    }
+
+    TEST( Crc32c, KnownValues ) {
+        ASSERT_EQUALS( 0U, crcOf( "" ) );
+        ASSERT_EQUALS( 0xE3069283U, crcOf( "123456789" ) );
+        ASSERT_EQUALS( 0x8A9136AAU, crcOf( std::string( 32, '\0' ) ) );
+        ASSERT_EQUALS( 0x62A8AB43U, crcOf( std::string( 32, '\xff' ) ) );
+    }
+
+    /**
+     * Any split of the input, at any alignment, gives the same result when continued.
+     */
+    TEST( Crc32c, Continues ) {
+        std::string data;
+        for ( int i = 0; i < 100; i++ )
+            data += static_cast<char>( i * 7 + 3 );
+
+        const uint32_t whole = crcOf( data );
+        for ( size_t start = 0; start < 9; start++ ) {
+            for ( size_t split = start; split <= data.size(); split += 5 ) {
+                const uint32_t head = crc32c( data.data() + start, split - start );
+                const uint32_t tail = crc32c( data.data() + split, data.size() - split, head );
+                ASSERT_EQUALS( crcOf( data.substr( start ) ), tail );
+            }
+        }
+        ASSERT_NOT_EQUALS( whole, crcOf( data.substr( 1 ) ) );
+    }
+
+    TEST( Crc32c, DetectsFlippedBit ) {
+        std::string data( 1000, 'x' );
+        const uint32_t before = crcOf( data );
+        data[517] ^= 0x10;
+        ASSERT_NOT_EQUALS( before, crcOf( data ) );
+    }
+
+} // namespace
+} // namespace mongo
@@ -49,6 +49,7 @@
 #   include <io.h>
 #endif
 
+#include "mongo/db/jsobj.h"
 #include "mongo/platform/posix_fadvise.h"
 #include "mongo/stdx/functional.h"
 #include "mongo/util/concurrency/thread_name.h"
@@ -97,12 +98,24 @@ namespace mongo {
     }
 
     FileAllocator::FileAllocator()
-        : _pendingMutex("FileAllocator"), _failed() {
+        : _pendingMutex("FileAllocator"),
+          _numThreads(0), _filesAllocated(0), _allocationMicros(0), _waits(0), _waitMicros(0),
+          _failed() {
     }
 
 
-    void FileAllocator::start() {
-        boost::thread t( stdx::bind( &FileAllocator::run , this ) );
+    void FileAllocator::start( int numThreads ) {
+        {
+            // initialize unique temporary file name counter
+            // TODO: SERVER-6055 -- Unify temporary file name selection
+            SimpleMutex::scoped_lock lk(_uniqueNumberMutex);
+            _uniqueNumber = curTimeMicros64();
+        }
+        if ( numThreads < 1 )
+            numThreads = 1;
+        _numThreads = numThreads;
+        for ( int i = 0; i < numThreads; i++ )
+            boost::thread t( stdx::bind( &FileAllocator::run , this ) );
     }
 
     void FileAllocator::requestAllocation( const string &name, long &size ) {
@@ -129,20 +142,23 @@ namespace mongo {
         }
         checkFailure();
         _pendingSize[ name ] = size;
-        if ( _pending.size() == 0 )
-            _pending.push_back( name );
-        else if ( _pending.front() != name ) {
+        if ( _allocating.count( name ) == 0 ) {
+            // ahead of anything no worker has started on yet
             _pending.remove( name );
-            list< string >::iterator i = _pending.begin();
-            ++i;
-            _pending.insert( i, name );
+            _pending.push_front( name );
         }
         _pendingUpdated.notify_all();
+
+        if ( !inProgress( name ) )
+            return;
+
+        Timer t;
+        _waits++;
         while( inProgress( name ) ) {
             checkFailure();
             _pendingUpdated.wait( lk.boost() );
         }
-
+        _waitMicros += t.micros();
     }
 
     void FileAllocator::waitUntilFinished() const {
@@ -194,11 +210,13 @@ namespace mongo {
 #endif
 
 #if defined(__linux__)
-        int ret = posix_fallocate(fd,0,size);
+        // Not posix_fallocate: where the filesystem can't do it, glibc emulates it by writing
+        // every block, and we would rather zero fill below.
+        int ret = fallocate(fd,0,0,size);
         if ( ret == 0 )
             return;
 
-        log() << "FileAllocator: posix_fallocate failed: " << errnoWithDescription( ret ) << " falling back" << endl;
+        log() << "FileAllocator: fallocate failed: " << errnoWithDescription() << " falling back" << endl;
 #endif
 
         off_t filelen = lseek( fd, 0, SEEK_END );
@@ -246,6 +264,18 @@ namespace mongo {
         return _failed;
     }
 
+    void FileAllocator::appendStats( BSONObjBuilder* b ) const {
+        scoped_lock lk( _pendingMutex );
+        b->append( "threads", _numThreads );
+        b->appendNumber( "pending", static_cast<long long>( _pending.size() ) );
+        b->appendNumber( "allocating", static_cast<long long>( _allocating.size() ) );
+        b->appendNumber( "filesAllocated", _filesAllocated );
+        b->appendNumber( "allocationMicros", _allocationMicros );
+        b->appendNumber( "waits", _waits );
+        b->appendNumber( "waitMicros", _waitMicros );
+        b->appendBool( "failed", _failed );
+    }
+
     void FileAllocator::checkFailure() {
         if (_failed) {
             // we want to log the problem (diskfull.js expects it) but we do not want to dump a stack tracke
@@ -269,6 +299,18 @@ namespace mongo {
         return false;
     }
 
+    // caller must hold _pendingMutex lock.
+    bool FileAllocator::nextPending( string* name, long* size ) const {
+        for( list< string >::const_iterator i = _pending.begin(); i != _pending.end(); ++i ) {
+            if ( _allocating.count( *i ) == 0 ) {
+                *name = *i;
+                *size = _pendingSize[ *i ];
+                return true;
+            }
+        }
+        return false;
+    }
+
     string FileAllocator::makeTempFileName( boost::filesystem::path root ) {
         while( 1 ) {
             boost::filesystem::path p = root / "_tmp";
@@ -292,108 +334,104 @@ namespace mongo {
 
     void FileAllocator::run( FileAllocator * fa ) {
         setThreadName( "FileAllocator" );
-        {
-            // initialize unique temporary file name counter
-            // TODO: SERVER-6055 -- Unify temporary file name selection
-            SimpleMutex::scoped_lock lk(_uniqueNumberMutex);
-            _uniqueNumber = curTimeMicros64();
-        }
         while( 1 ) {
+            string name;
+            long size = 0;
             {
                 scoped_lock lk( fa->_pendingMutex );
-                if ( fa->_pending.size() == 0 )
+                while ( !fa->nextPending( &name, &size ) )
                     fa->_pendingUpdated.wait( lk.boost() );
+                fa->_allocating.insert( name );
             }
-            while( 1 ) {
-                string name;
-                long size = 0;
-                {
-                    scoped_lock lk( fa->_pendingMutex );
-                    if ( fa->_pending.size() == 0 )
-                        break;
-                    name = fa->_pending.front();
-                    size = fa->_pendingSize[ name ];
-                }
 
-                string tmp;
-                long fd = 0;
-                try {
-                    log() << "allocating new datafile " << name << ", filling with zeroes..." << endl;
-                    
-                    boost::filesystem::path parent = ensureParentDirCreated(name);
-                    tmp = fa->makeTempFileName( parent );
-                    ensureParentDirCreated(tmp);
+            string tmp;
+            long fd = 0;
+            Timer t;
+            try {
+                log() << "allocating new datafile " << name << ", filling with zeroes..." << endl;
+                
+                boost::filesystem::path parent = ensureParentDirCreated(name);
+                tmp = fa->makeTempFileName( parent );
+                ensureParentDirCreated(tmp);
 
 #if defined(_WIN32)
-                    fd = _open( tmp.c_str(), _O_RDWR | _O_CREAT | O_NOATIME, _S_IREAD | _S_IWRITE );
+                fd = _open( tmp.c_str(), _O_RDWR | _O_CREAT | O_NOATIME, _S_IREAD | _S_IWRITE );
 #else
-                    fd = open(tmp.c_str(), O_CREAT | O_RDWR | O_NOATIME, S_IRUSR | S_IWUSR);
+                fd = open(tmp.c_str(), O_CREAT | O_RDWR | O_NOATIME, S_IRUSR | S_IWUSR);
 #endif
-                    if ( fd < 0 ) {
-                        log() << "FileAllocator: couldn't create " << name << " (" << tmp << ") " << errnoWithDescription() << endl;
-                        uasserted(10439, "");
-                    }
+                if ( fd < 0 ) {
+                    log() << "FileAllocator: couldn't create " << name << " (" << tmp << ") " << errnoWithDescription() << endl;
+                    uasserted(10439, "");
+                }
 
 #if defined(POSIX_FADV_DONTNEED)
-                    if( posix_fadvise(fd, 0, size, POSIX_FADV_DONTNEED) ) {
-                        log() << "warning: posix_fadvise fails " << name << " (" << tmp << ") " << errnoWithDescription() << endl;
-                    }
+                if( posix_fadvise(fd, 0, size, POSIX_FADV_DONTNEED) ) {
+                    log() << "warning: posix_fadvise fails " << name << " (" << tmp << ") " << errnoWithDescription() << endl;
+                }
 #endif
 
-                    Timer t;
+                Timer fillTimer;
+
+                /* make sure the file is the full desired length */
+                ensureLength( fd , size );
+
+                close( fd );
+                fd = 0;
 
-                    /* make sure the file is the full desired length */
-                    ensureLength( fd , size );
+                if( rename(tmp.c_str(), name.c_str()) ) {
+                    const string& errStr = errnoWithDescription();
+                    const string& errMessage = str::stream()
+                            << "error: couldn't rename " << tmp
+                            << " to " << name << ' ' << errStr;
+                    msgasserted(13653, errMessage);
+                }
+                flushMyDirectory(name);
+
+                log() << "done allocating datafile " << name << ", "
+                      << "size: " << size/1024/1024 << "MB, "
+                      << " took " << ((double)fillTimer.millis())/1000.0 << " secs"
+                      << endl;
 
+                // no longer in a failed state. allow new writers.
+                fa->_failed = false;
+            }
+            catch ( const std::exception& e ) {
+                log() << "error: failed to allocate new file: " << name
+                      << " size: " << size << ' ' << e.what()
+                      << ".  will try again in 10 seconds" << endl;
+                if ( fd > 0 )
                     close( fd );
-                    fd = 0;
-
-                    if( rename(tmp.c_str(), name.c_str()) ) {
-                        const string& errStr = errnoWithDescription();
-                        const string& errMessage = str::stream()
-                                << "error: couldn't rename " << tmp
-                                << " to " << name << ' ' << errStr;
-                        msgasserted(13653, errMessage);
-                    }
-                    flushMyDirectory(name);
-
-                    log() << "done allocating datafile " << name << ", "
-                          << "size: " << size/1024/1024 << "MB, "
-                          << " took " << ((double)t.millis())/1000.0 << " secs"
-                          << endl;
-
-                    // no longer in a failed state. allow new writers.
-                    fa->_failed = false;
+                try {
+                    if ( ! tmp.empty() )
+                        boost::filesystem::remove( tmp );
+                    boost::filesystem::remove( name );
+                } catch ( const std::exception& e ) {
+                    log() << "error removing files: " << e.what() << endl;
                 }
-                catch ( const std::exception& e ) {
-                    log() << "error: failed to allocate new file: " << name
-                          << " size: " << size << ' ' << e.what()
-                          << ".  will try again in 10 seconds" << endl;
-                    if ( fd > 0 )
-                        close( fd );
-                    try {
-                        if ( ! tmp.empty() )
-                            boost::filesystem::remove( tmp );
-                        boost::filesystem::remove( name );
-                    } catch ( const std::exception& e ) {
-                        log() << "error removing files: " << e.what() << endl;
-                    }
+                {
                     scoped_lock lk( fa->_pendingMutex );
                     fa->_failed = true;
                     // not erasing from pending
                     fa->_pendingUpdated.notify_all();
-                    
-                    
-                    sleepsecs(10);
-                    continue;
                 }
 
-                {
-                    scoped_lock lk( fa->_pendingMutex );
-                    fa->_pendingSize.erase( name );
-                    fa->_pending.pop_front();
-                    fa->_pendingUpdated.notify_all();
-                }
+                sleepsecs(10);
+
+                // give it back, this or another worker will try again
+                scoped_lock lk( fa->_pendingMutex );
+                fa->_allocating.erase( name );
+                fa->_pendingUpdated.notify_all();
+                continue;
+            }
+
+            {
+                scoped_lock lk( fa->_pendingMutex );
+                fa->_filesAllocated++;
+                fa->_allocationMicros += t.micros();
+                fa->_allocating.erase( name );
+                fa->_pendingSize.erase( name );
+                fa->_pending.remove( name );
+                fa->_pendingUpdated.notify_all();
             }
         }
     }
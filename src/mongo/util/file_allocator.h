@@ -30,6 +30,7 @@
 #include "mongo/pch.h"
 
 #include <list>
+#include <set>
 #include <boost/filesystem/path.hpp>
 #include <boost/thread/condition.hpp>
 
@@ -37,6 +38,8 @@
 
 namespace mongo {
 
+    class BSONObjBuilder;
+
     /*
      * Handles allocation of contiguous files on disk.  Allocation may be
      * requested asynchronously or synchronously.
@@ -49,7 +52,11 @@ namespace mongo {
          * size specified per file will be used.
         */
     public:
-        void start();
+        /**
+         * Starts numThreads workers, so that many files can be allocated at once, e.g. when
+         * several databases grow together.
+         */
+        void start( int numThreads = 1 );
 
         /**
          * May be called if file exists. If file exists, or its allocation has
@@ -70,6 +77,9 @@ namespace mongo {
 
         static void ensureLength(int fd, long size);
 
+        /** for serverStatus: how much allocating, and how long callers waited for it */
+        void appendStats( BSONObjBuilder* b ) const;
+
         /** @return the singleton */
         static FileAllocator * get();
         
@@ -86,6 +96,10 @@ namespace mongo {
         // caller must hold pendingMutex_ lock.
         bool inProgress( const std::string &name ) const;
 
+        // caller must hold pendingMutex_ lock.  The first pending file no worker has
+        // picked up yet, false if there is none.
+        bool nextPending( std::string* name, long* size ) const;
+
         /** called from the worked thread */
         static void run( FileAllocator * fa );
 
@@ -98,6 +112,16 @@ namespace mongo {
         std::list< std::string > _pending;
         mutable std::map< std::string, long > _pendingSize;
 
+        // the part of _pending that workers are allocating right now
+        std::set< std::string > _allocating;
+
+        // stats, under _pendingMutex
+        int _numThreads;
+        long long _filesAllocated;
+        long long _allocationMicros;
+        long long _waits;
+        long long _waitMicros;
+
         // unique number for temporary files
         static unsigned long long _uniqueNumber;
 